@@ -0,0 +1,34 @@
+using System;
+
+namespace Benchmarks {
+
+    class Node {
+        public int Value;
+        public Node Next;
+
+        public Node(int value, Node next) {
+            this.Value = value;
+            this.Next = next;
+        }
+    }
+
+    // Object allocation churn. Kept small enough to fit the heap as long as nothing gets collected
+    static class Allocation {
+
+        static void Main() {
+            int total = 0;
+            for (int round = 0; round < 100; round++) {
+                Node list = null;
+                for (int i = 0; i < 200; i++)
+                    list = new Node(i, list);
+
+                for (Node node = list; node != null; node = node.Next)
+                    total += node.Value;
+            }
+
+            Console.WriteLine(total);
+        }
+
+    }
+
+}
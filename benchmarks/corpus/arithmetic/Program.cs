@@ -0,0 +1,18 @@
+using System;
+
+namespace Benchmarks {
+
+    // Tight integer loop without calls or memory accesses
+    static class Arithmetic {
+
+        static void Main() {
+            int sum = 0;
+            for (int i = 0; i < 2000000; i++)
+                sum += (i * 3) ^ (i >> 1);
+
+            Console.WriteLine(sum);
+        }
+
+    }
+
+}
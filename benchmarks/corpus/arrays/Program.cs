@@ -0,0 +1,24 @@
+using System;
+
+namespace Benchmarks {
+
+    // Element loads and stores with bounds checks on a single dimensional array
+    static class Arrays {
+
+        static void Main() {
+            int[] values = new int[1000];
+            for (int i = 0; i < values.Length; i++)
+                values[i] = i;
+
+            long sum = 0;
+            for (int round = 0; round < 1000; round++) {
+                for (int i = 0; i < values.Length; i++)
+                    sum += values[i];
+            }
+
+            Console.WriteLine(sum);
+        }
+
+    }
+
+}
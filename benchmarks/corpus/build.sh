@@ -0,0 +1,13 @@
+#!/bin/sh
+# Rebuilds the prebuilt benchmark assemblies in bin/. Only needed after changing one of the workloads,
+# building the benchmark harness itself doesn't require a .NET SDK
+set -e
+
+cd "$(dirname "$0")"
+DOTNET="${DOTNET:-dotnet}"
+
+for project in */*.csproj; do
+    name="$(basename "$project" .csproj)"
+    "$DOTNET" build "$project" -c Release -o "obj/out/$name" --nologo -v quiet
+    cp "obj/out/$name/$name.dll" "obj/out/$name/$name.pdb" bin/
+done
@@ -0,0 +1,28 @@
+using System;
+
+namespace Benchmarks {
+
+    // Bulk array operations and math that run as intrinsics instead of calls
+    static class Bulk {
+
+        static void Main() {
+            double[] source = new double[4096];
+            double[] destination = new double[4096];
+            byte[] bytes = new byte[32768];
+
+            double sum = 0;
+            for (int round = 0; round < 5000; round++) {
+                Array.Fill(source, Math.Sqrt(round));
+                Array.Copy(source, 0, destination, 1, 4095);
+                Buffer.BlockCopy(destination, 0, bytes, 0, bytes.Length);
+                Array.Clear(source);
+
+                sum = sum + Math.Floor(destination[4095]) + bytes[7];
+            }
+
+            Console.WriteLine(sum);
+        }
+
+    }
+
+}
@@ -0,0 +1,98 @@
+using System;
+
+namespace Benchmarks {
+
+    // Call overhead without any branches: each level calls the one below it twice, 2^20 calls in total
+    static class Calls {
+
+        static int Level0(int x) {
+            return x;
+        }
+
+        static int Level1(int x) {
+            return Level0(x) + Level0(x + 1);
+        }
+
+        static int Level2(int x) {
+            return Level1(x) + Level1(x + 1);
+        }
+
+        static int Level3(int x) {
+            return Level2(x) + Level2(x + 1);
+        }
+
+        static int Level4(int x) {
+            return Level3(x) + Level3(x + 1);
+        }
+
+        static int Level5(int x) {
+            return Level4(x) + Level4(x + 1);
+        }
+
+        static int Level6(int x) {
+            return Level5(x) + Level5(x + 1);
+        }
+
+        static int Level7(int x) {
+            return Level6(x) + Level6(x + 1);
+        }
+
+        static int Level8(int x) {
+            return Level7(x) + Level7(x + 1);
+        }
+
+        static int Level9(int x) {
+            return Level8(x) + Level8(x + 1);
+        }
+
+        static int Level10(int x) {
+            return Level9(x) + Level9(x + 1);
+        }
+
+        static int Level11(int x) {
+            return Level10(x) + Level10(x + 1);
+        }
+
+        static int Level12(int x) {
+            return Level11(x) + Level11(x + 1);
+        }
+
+        static int Level13(int x) {
+            return Level12(x) + Level12(x + 1);
+        }
+
+        static int Level14(int x) {
+            return Level13(x) + Level13(x + 1);
+        }
+
+        static int Level15(int x) {
+            return Level14(x) + Level14(x + 1);
+        }
+
+        static int Level16(int x) {
+            return Level15(x) + Level15(x + 1);
+        }
+
+        static int Level17(int x) {
+            return Level16(x) + Level16(x + 1);
+        }
+
+        static int Level18(int x) {
+            return Level17(x) + Level17(x + 1);
+        }
+
+        static int Level19(int x) {
+            return Level18(x) + Level18(x + 1);
+        }
+
+        static int Level20(int x) {
+            return Level19(x) + Level19(x + 1);
+        }
+
+        static void Main() {
+            Console.WriteLine(Level20(1));
+        }
+
+    }
+
+}
@@ -0,0 +1,45 @@
+using System;
+using System.Collections.Generic;
+
+namespace Benchmarks {
+
+    // Adds, indexing and lookups on the generic collections
+    static class Collections {
+
+        static void Main() {
+            var values = new List<int>();
+            for (int i = 0; i < 50000; i++)
+                values.Add(i);
+
+            long sum = 0;
+            for (int round = 0; round < 20; round++) {
+                for (int i = 0; i < values.Count; i++)
+                    sum += values[i];
+            }
+
+            var squares = new Dictionary<int, int>();
+            for (int i = 0; i < 5000; i++)
+                squares[i] = i + i;
+
+            int found = 0;
+            for (int round = 0; round < 20; round++) {
+                for (int i = 0; i < 10000; i++) {
+                    if (squares.ContainsKey(i))
+                        found++;
+                }
+            }
+
+            var pending = new Queue<int>();
+            for (int i = 0; i < 100000; i++) {
+                pending.Enqueue(i);
+                if (pending.Count > 100)
+                    sum += pending.Dequeue();
+            }
+
+            Console.WriteLine(sum);
+            Console.WriteLine(found);
+        }
+
+    }
+
+}
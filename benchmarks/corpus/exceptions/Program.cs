@@ -0,0 +1,44 @@
+using System;
+
+namespace Benchmarks {
+
+    // Throwing and catching framework exceptions, by their own type and by one of their bases
+    static class Exceptions {
+
+        static int Check(int value) {
+            if (value % 7 == 0)
+                throw new ArgumentOutOfRangeException("value", "Multiples of seven aren't allowed");
+            if (value % 5 == 0)
+                throw new InvalidOperationException();
+            if (value % 3 == 0)
+                throw new ArgumentException("Multiples of three aren't allowed");
+            if (value % 11 == 0)
+                throw new InvalidOperationException("Multiples of eleven aren't allowed", new Exception());
+
+            return value;
+        }
+
+        static void Main() {
+            int outOfRange = 0, invalid = 0, argument = 0, sum = 0;
+
+            for (int i = 0; i < 20000; i++) {
+                try {
+                    sum += Check(i);
+                } catch (ArgumentOutOfRangeException) {
+                    outOfRange++;
+                } catch (ArgumentException) {
+                    argument++;
+                } catch (SystemException) {
+                    invalid++;
+                }
+            }
+
+            Console.WriteLine(outOfRange);
+            Console.WriteLine(argument);
+            Console.WriteLine(invalid);
+            Console.WriteLine(sum);
+        }
+
+    }
+
+}
@@ -0,0 +1,21 @@
+using System;
+
+namespace Benchmarks {
+
+    // Call overhead: argument passing, return values and deep recursion
+    static class Fib {
+
+        static int Calculate(int n) {
+            if (n < 2)
+                return n;
+
+            return Calculate(n - 1) + Calculate(n - 2);
+        }
+
+        static void Main() {
+            Console.WriteLine(Calculate(25));
+        }
+
+    }
+
+}
@@ -0,0 +1,27 @@
+using System;
+
+namespace Benchmarks {
+
+    class Counter {
+        public int Count;
+        public long Total;
+    }
+
+    // Loads and stores of instance and static fields
+    static class Fields {
+        static int s_iterations;
+        static Counter s_counter = new Counter();
+
+        static void Main() {
+            Counter counter = s_counter;
+            for (s_iterations = 0; s_iterations < 1000000; s_iterations++) {
+                counter.Count++;
+                counter.Total += counter.Count;
+            }
+
+            Console.WriteLine(counter.Total);
+        }
+
+    }
+
+}
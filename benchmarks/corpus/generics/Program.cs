@@ -0,0 +1,63 @@
+using System;
+using System.Collections.Generic;
+
+namespace Benchmarks {
+
+    // Generic methods and types of the program itself, instantiated over value and reference types
+    static class Generics {
+
+        sealed class Buffer<T> {
+            public T[] Fill(T value, int count) {
+                T[] values = new T[count];
+                for (int i = 0; i < values.Length; i++)
+                    values[i] = value;
+                return values;
+            }
+
+            public List<T> Collect(T[] values) {
+                var list = new List<T>();
+                for (int i = 0; i < values.Length; i++)
+                    list.Add(values[i]);
+                return list;
+            }
+        }
+
+        static T Identity<T>(T value) {
+            return value;
+        }
+
+        static T Choose<T>(bool first, T a, T b) {
+            return first ? a : b;
+        }
+
+        static int Count<T>(T[] values) {
+            return Identity(values).Length;
+        }
+
+        static void Main() {
+            long sum = 0;
+            for (int i = 0; i < 200000; i++)
+                sum += Identity(i) + Choose(i < 100000, 1L, 2L);
+
+            int length = 0;
+            string text = "generic";
+            for (int i = 0; i < 200000; i++)
+                length += Choose(i < 50000, text, "shared").Length;
+
+            var numbers = new Buffer<int>();
+            var words = new Buffer<string>();
+            int counted = 0;
+            for (int round = 0; round < 200; round++) {
+                counted += Count(numbers.Fill(round, 100));
+                counted += numbers.Collect(numbers.Fill(round, 50)).Count;
+                counted += words.Collect(words.Fill(text, 50)).Count;
+            }
+
+            Console.WriteLine(sum);
+            Console.WriteLine(length);
+            Console.WriteLine(counted);
+        }
+
+    }
+
+}
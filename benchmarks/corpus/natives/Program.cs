@@ -0,0 +1,18 @@
+using System;
+
+namespace Benchmarks {
+
+    // Calls into methods that are implemented natively by the interpreter
+    static class Natives {
+
+        static void Main() {
+            int result = 0;
+            for (int i = 0; i < 500000; i++)
+                result = Math.Max(result, Math.Abs(i - 250000));
+
+            Console.WriteLine(result);
+        }
+
+    }
+
+}
@@ -0,0 +1,31 @@
+using System;
+using System.Text;
+
+namespace Benchmarks {
+
+    // Building a large string with StringBuilder and searching through the result
+    static class StringBuilding {
+
+        static void Main() {
+            var builder = new StringBuilder();
+            for (int i = 0; i < 20000; i++) {
+                builder.Append(i);
+                builder.Append(',');
+            }
+
+            string text = builder.ToString();
+
+            int found = 0;
+            for (int round = 0; round < 200; round++) {
+                if (text.IndexOf("19999,") >= 0)
+                    found++;
+                if (text.IndexOf('x') >= 0)
+                    found++;
+            }
+
+            Console.WriteLine($"{found} matches in {text.Length} characters");
+        }
+
+    }
+
+}
@@ -0,0 +1,17 @@
+using System;
+
+namespace Benchmarks {
+
+    // Console output of literals and numbers through the native bindings
+    static class Strings {
+
+        static void Main() {
+            for (int i = 0; i < 100000; i++) {
+                Console.Write("Line ");
+                Console.WriteLine(i);
+            }
+        }
+
+    }
+
+}
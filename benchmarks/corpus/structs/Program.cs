@@ -0,0 +1,60 @@
+using System;
+
+namespace Benchmarks {
+
+    // Structs passed, returned and stored by value in locals, fields and arrays
+    static class Structs {
+
+        struct Vec2 {
+            public double X;
+            public double Y;
+
+            public Vec2(double x, double y) {
+                X = x;
+                Y = y;
+            }
+
+            public Vec2 Add(Vec2 other) {
+                return new Vec2(X + other.X, Y + other.Y);
+            }
+        }
+
+        struct Particle {
+            public Vec2 Position;
+            public Vec2 Velocity;
+            public int Bounces;
+        }
+
+        static void Main() {
+            var particles = new Particle[256];
+            for (int i = 0; i < particles.Length; i++)
+                particles[i].Velocity = new Vec2(i, 1);
+
+            for (int step = 0; step < 1000; step++) {
+                for (int i = 0; i < particles.Length; i++) {
+                    Particle particle = particles[i];
+                    particle.Position = particle.Position.Add(particle.Velocity);
+                    if (particle.Position.Y > 500) {
+                        particle.Position = new Vec2(particle.Position.X, 0);
+                        particle.Bounces++;
+                    }
+
+                    particles[i] = particle;
+                }
+            }
+
+            Vec2 total = default;
+            int bounces = 0;
+            for (int i = 0; i < particles.Length; i++) {
+                total = total.Add(particles[i].Position);
+                bounces += particles[i].Bounces;
+            }
+
+            Console.WriteLine(total.X);
+            Console.WriteLine(total.Y);
+            Console.WriteLine(bounces);
+        }
+
+    }
+
+}
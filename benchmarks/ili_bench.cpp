@@ -0,0 +1,344 @@
+#include "types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <spawn.h>
+    #include <sys/wait.h>
+
+    extern char **environ;
+#endif
+
+// Runs the interpreter on every assembly of the benchmark corpus and reports how long each one took.
+// Every run is a fresh process, so the numbers include starting up and loading the assembly
+
+#if !defined(ILI_BENCH_INTERPRETER)
+    #define ILI_BENCH_INTERPRETER "CSharpInterpreter"
+#endif
+
+#if !defined(ILI_BENCH_CORPUS)
+    #define ILI_BENCH_CORPUS "benchmarks/corpus"     // Where CMake copies the assemblies to, relative to the build directory
+#endif
+
+struct Options {
+    std::string interpreter = ILI_BENCH_INTERPRETER;
+    std::string corpus = ILI_BENCH_CORPUS;
+    std::string jsonPath;
+    std::string filter;
+    std::vector<std::string> interpreterArguments;
+    u32 warmupRuns = 2;
+    u32 repetitions = 10;
+    bool perfCounters = false;
+};
+
+struct Result {
+    std::string name;
+    int exitCode = 0;
+    std::vector<double> samples;    // Milliseconds
+    std::map<std::string, std::vector<double>> counters;    // Hardware counters and derived metrics of every timed run
+
+    bool failed() const { return this->exitCode != 0; }
+};
+
+// Returns the exit code of the interpreter, 128 + the signal number if it crashed or -1 if it couldn't be started
+static int runInterpreter(const Options &options, const std::vector<std::string> &interpreterArguments, const std::string &assembly, double &milliseconds) {
+    auto start = std::chrono::steady_clock::now();
+
+#if defined(_WIN32)
+    std::string command = "\"" + options.interpreter + "\"";
+    for (auto &argument : interpreterArguments)
+        command += " \"" + argument + "\"";
+    command += " \"" + assembly + "\" > NUL 2>&1";
+
+    int exitCode = std::system(command.c_str());
+#else
+    std::vector<char*> arguments;
+    arguments.push_back(const_cast<char*>(options.interpreter.c_str()));
+    for (auto &argument : interpreterArguments)
+        arguments.push_back(const_cast<char*>(argument.c_str()));
+    arguments.push_back(const_cast<char*>(assembly.c_str()));
+    arguments.push_back(nullptr);
+
+    // Everything the program or the interpreter prints would only distort the measurement
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_addopen(&fileActions, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&fileActions, 2, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid;
+    int spawnResult = posix_spawn(&pid, options.interpreter.c_str(), &fileActions, nullptr, arguments.data(), environ);
+    posix_spawn_file_actions_destroy(&fileActions);
+
+    if (spawnResult != 0)
+        return -1;
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0)
+        return -1;
+
+    int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : WIFSIGNALED(status) ? 128 + WTERMSIG(status) : -1;
+#endif
+
+    auto end = std::chrono::steady_clock::now();
+    milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    return exitCode;
+}
+
+// The interpreter writes its counters as a flat JSON object with one "name": number pair per line
+static bool readPerfCounters(const std::string &path, std::map<std::string, std::vector<double>> &counters) {
+    FILE *file = std::fopen(path.c_str(), "r");
+    if (file == nullptr)
+        return false;
+
+    char line[256];
+    char name[128];
+    double value;
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        if (std::sscanf(line, " \"%127[^\"]\": %lf", name, &value) == 2)
+            counters[name].push_back(value);
+    }
+
+    std::fclose(file);
+
+    return true;
+}
+
+// Linear interpolation between the closest ranks of the sorted samples
+static double getPercentile(const std::vector<double> &sortedSamples, double percentile) {
+    if (sortedSamples.empty())
+        return 0;
+
+    double rank = percentile / 100.0 * (sortedSamples.size() - 1);
+    size_t lower = static_cast<size_t>(rank);
+    size_t upper = std::min(lower + 1, sortedSamples.size() - 1);
+
+    return sortedSamples[lower] + (sortedSamples[upper] - sortedSamples[lower]) * (rank - lower);
+}
+
+static double getMean(const std::vector<double> &samples) {
+    double sum = 0;
+    for (double sample : samples)
+        sum += sample;
+
+    return samples.empty() ? 0 : sum / samples.size();
+}
+
+static double getStandardDeviation(const std::vector<double> &samples) {
+    if (samples.size() < 2)
+        return 0;
+
+    double mean = getMean(samples);
+    double sum = 0;
+    for (double sample : samples)
+        sum += (sample - mean) * (sample - mean);
+
+    return std::sqrt(sum / (samples.size() - 1));
+}
+
+static std::string escapeJSON(const std::string &string) {
+    std::string escaped;
+    for (char character : string) {
+        if (character == '"' || character == '\\')
+            escaped += '\\';
+
+        if (static_cast<unsigned char>(character) < 0x20) {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", character);
+            escaped += buffer;
+        } else {
+            escaped += character;
+        }
+    }
+
+    return escaped;
+}
+
+static bool writeJSON(const Options &options, const std::vector<Result> &results) {
+    FILE *file = std::fopen(options.jsonPath.c_str(), "w");
+    if (file == nullptr)
+        return false;
+
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"interpreter\": \"%s\",\n", escapeJSON(options.interpreter).c_str());
+    std::fprintf(file, "  \"warmup_runs\": %u,\n", options.warmupRuns);
+    std::fprintf(file, "  \"repetitions\": %u,\n", options.repetitions);
+    std::fprintf(file, "  \"unit\": \"ms\",\n");
+    std::fprintf(file, "  \"workloads\": [\n");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        auto &result = results[i];
+
+        std::fprintf(file, "    {\n");
+        std::fprintf(file, "      \"name\": \"%s\",\n", escapeJSON(result.name).c_str());
+        std::fprintf(file, "      \"status\": \"%s\",\n", result.failed() ? "failed" : "ok");
+        std::fprintf(file, "      \"exit_code\": %d", result.exitCode);
+
+        if (!result.failed()) {
+            auto sorted = result.samples;
+            std::sort(sorted.begin(), sorted.end());
+
+            std::fprintf(file, ",\n      \"min\": %.3f,\n", sorted.front());
+            std::fprintf(file, "      \"median\": %.3f,\n", getPercentile(sorted, 50));
+            std::fprintf(file, "      \"p90\": %.3f,\n", getPercentile(sorted, 90));
+            std::fprintf(file, "      \"p99\": %.3f,\n", getPercentile(sorted, 99));
+            std::fprintf(file, "      \"max\": %.3f,\n", sorted.back());
+            std::fprintf(file, "      \"mean\": %.3f,\n", getMean(sorted));
+            std::fprintf(file, "      \"stddev\": %.3f,\n", getStandardDeviation(sorted));
+            std::fprintf(file, "      \"samples\": [");
+            for (size_t sample = 0; sample < result.samples.size(); sample++)
+                std::fprintf(file, "%s%.3f", sample == 0 ? "" : ", ", result.samples[sample]);
+            std::fprintf(file, "]");
+
+            if (!result.counters.empty()) {
+                std::fprintf(file, ",\n      \"counters\": {");
+                for (auto it = result.counters.begin(); it != result.counters.end(); ++it) {
+                    auto sortedValues = it->second;
+                    std::sort(sortedValues.begin(), sortedValues.end());
+
+                    std::fprintf(file, "%s\n        \"%s\": %.4f", it == result.counters.begin() ? "" : ",", escapeJSON(it->first).c_str(), getPercentile(sortedValues, 50));
+                }
+                std::fprintf(file, "\n      }");
+            }
+        }
+
+        std::fprintf(file, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+
+    return true;
+}
+
+static void printUsage(const char *name) {
+    std::printf("Usage: %s [options] [-- interpreter arguments]\n", name);
+    std::printf("  --interpreter <path>   Interpreter executable (default %s)\n", ILI_BENCH_INTERPRETER);
+    std::printf("  --corpus <directory>   Directory containing the workload assemblies (default %s)\n", ILI_BENCH_CORPUS);
+    std::printf("  --filter <text>        Only run workloads whose name contains the text\n");
+    std::printf("  --warmup <n>           Untimed runs before measuring (default 2)\n");
+    std::printf("  --repetitions <n>      Timed runs per workload (default 10)\n");
+    std::printf("  --json <path>          Write the results as JSON\n");
+    std::printf("  --perf-counters        Also collect hardware performance counters of every timed run\n");
+}
+
+int main(int argc, char **argv) {
+    Options options;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--interpreter") == 0 && i + 1 < argc)
+            options.interpreter = argv[++i];
+        else if (std::strcmp(argv[i], "--corpus") == 0 && i + 1 < argc)
+            options.corpus = argv[++i];
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            options.filter = argv[++i];
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            options.warmupRuns = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+            options.repetitions = std::max<u32>(1, std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            options.jsonPath = argv[++i];
+        else if (std::strcmp(argv[i], "--perf-counters") == 0)
+            options.perfCounters = true;
+        else if (std::strcmp(argv[i], "--") == 0) {
+            options.interpreterArguments.assign(argv + i + 1, argv + argc);
+            break;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::filesystem::path> assemblies;
+    std::error_code error;
+    for (auto &entry : std::filesystem::directory_iterator(options.corpus, error)) {
+        if (entry.path().extension() == ".dll" && entry.path().stem().string().find(options.filter) != std::string::npos)
+            assemblies.push_back(entry.path());
+    }
+
+    if (error || assemblies.empty()) {
+        std::fprintf(stderr, "No workloads found in %s\n", options.corpus.c_str());
+        return 1;
+    }
+
+    std::sort(assemblies.begin(), assemblies.end());
+
+    std::printf("%-16s %10s %10s %10s %10s %10s%s\n", "workload", "median", "p90", "p99", "min", "max", options.perfCounters ? "        IPC   instrs/IL" : "");
+
+    // Counting costs a little, so the counters are only read during the timed runs
+    auto countersPath = (std::filesystem::temp_directory_path() / ("ili_bench_counters_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".json")).string();
+    auto countingArguments = options.interpreterArguments;
+    countingArguments.insert(countingArguments.begin(), { "--perf-counters", countersPath });
+
+    std::vector<Result> results;
+    for (auto &assembly : assemblies) {
+        Result result;
+        result.name = assembly.stem().string();
+
+        double milliseconds;
+        for (u32 run = 0; run < options.warmupRuns + options.repetitions && !result.failed(); run++) {
+            bool timed = run >= options.warmupRuns;
+            bool counting = timed && options.perfCounters;
+
+            if (counting)
+                std::filesystem::remove(countersPath, error);
+
+            result.exitCode = runInterpreter(options, counting ? countingArguments : options.interpreterArguments, assembly.string(), milliseconds);
+
+            if (timed)
+                result.samples.push_back(milliseconds);
+            if (counting && !result.failed())
+                readPerfCounters(countersPath, result.counters);
+        }
+
+        if (result.failed()) {
+            std::printf("%-16s failed with exit code %d\n", result.name.c_str(), result.exitCode);
+        } else {
+            auto sorted = result.samples;
+            std::sort(sorted.begin(), sorted.end());
+
+            std::printf("%-16s %8.2fms %8.2fms %8.2fms %8.2fms %8.2fms", result.name.c_str(),
+                        getPercentile(sorted, 50), getPercentile(sorted, 90), getPercentile(sorted, 99), sorted.front(), sorted.back());
+
+            if (options.perfCounters) {
+                for (auto name : { "instructions_per_cycle", "instructions_per_il_instruction" }) {
+                    auto values = result.counters[name];
+                    std::sort(values.begin(), values.end());
+
+                    if (values.empty())
+                        std::printf(" %11s", "-");
+                    else
+                        std::printf(" %11.2f", getPercentile(values, 50));
+                }
+            }
+
+            std::printf("\n");
+        }
+
+        std::fflush(stdout);
+        results.push_back(std::move(result));
+    }
+
+    if (!options.jsonPath.empty() && !writeJSON(options, results)) {
+        std::fprintf(stderr, "Cannot write %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+
+    if (options.perfCounters)
+        std::filesystem::remove(countersPath, error);
+
+    // Every workload in the corpus is expected to run, one that doesn't fails the whole benchmark
+    bool anyFailed = std::any_of(results.begin(), results.end(), [](const Result &result) { return result.failed(); });
+
+    return anyFailed ? 1 : 0;
+}
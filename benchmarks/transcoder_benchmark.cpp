@@ -0,0 +1,89 @@
+#include "transcoder.hpp"
+
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <locale>
+#include <string>
+#include <vector>
+
+// Compares the transcoder kernels against the std::wstring_convert based conversion strings used to go through
+
+using namespace ili;
+
+static std::u16string makeText(const std::u16string &chunk, size_t length) {
+    std::u16string text;
+    while (text.size() < length)
+        text += chunk;
+
+    text.resize(length);
+
+    // Don't cut a surrogate pair in half
+    if (!text.empty() && text.back() >= 0xD800 && text.back() <= 0xDBFF)
+        text.back() = u'.';
+
+    return text;
+}
+
+template<typename Function>
+static double measure(size_t iterations, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        function();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static void benchmark(const char *name, const std::u16string &text, size_t iterations) {
+    std::string utf8 = Transcoder::toUTF8(text);
+    std::string utf8Buffer(Transcoder::getMaxUTF8Size(text.size()), '\0');
+    std::u16string utf16Buffer(Transcoder::getMaxUTF16Size(utf8.size()), u'\0');
+    volatile size_t sink = 0;
+
+    std::printf("%s (%zu UTF-16 code units, %zu UTF-8 bytes)\n", name, text.size(), utf8.size());
+
+    double toUTF8Baseline = measure(iterations, [&] {
+        std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> conversion;
+        sink = sink + conversion.to_bytes(text.data(), text.data() + text.size()).size();
+    });
+    double toUTF16Baseline = measure(iterations, [&] {
+        std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> conversion;
+        sink = sink + conversion.from_bytes(utf8.data(), utf8.data() + utf8.size()).size();
+    });
+
+    std::printf("  %-14s %12.1f ns %12.1f ns\n", "wstring_convert", toUTF8Baseline, toUTF16Baseline);
+
+    for (auto kernel : { TranscodeKernel::Scalar, TranscodeKernel::SSE2, TranscodeKernel::AVX2 }) {
+        if (!Transcoder::forceKernel(kernel))
+            continue;
+
+        if (Transcoder::toUTF8(text) != utf8 || Transcoder::toUTF16(utf8) != text) {
+            std::printf("  %-14s produced wrong output!\n", Transcoder::getKernelName(kernel));
+            continue;
+        }
+
+        double toUTF8 = measure(iterations, [&] { sink = sink + Transcoder::utf16ToUTF8(text.data(), text.size(), utf8Buffer.data()); });
+        double toUTF16 = measure(iterations, [&] { sink = sink + Transcoder::utf8ToUTF16(utf8.data(), utf8.size(), utf16Buffer.data()); });
+
+        std::printf("  %-14s %12.1f ns %12.1f ns   (%.1fx / %.1fx)\n", Transcoder::getKernelName(kernel), toUTF8, toUTF16, toUTF8Baseline / toUTF8, toUTF16Baseline / toUTF16);
+    }
+
+    std::printf("\n");
+}
+
+int main() {
+    const std::u16string ascii = u"The quick brown fox jumps over the lazy dog. 0123456789 {}[]();:,.<>/?\n";
+    const std::u16string mixed = u"Grüße aus Zürich, привет мир, こんにちは世界 😀 and some plain ASCII words in between. ";
+
+    std::printf("%-16s %15s %15s\n", "", "UTF-16 -> UTF-8", "UTF-8 -> UTF-16");
+
+    for (size_t length : { 16, 256, 16384 }) {
+        size_t iterations = 4'000'000 / length + 1000;
+
+        benchmark(("ASCII, " + std::to_string(length)).c_str(), makeText(ascii, length), iterations);
+        benchmark(("Mixed, " + std::to_string(length)).c_str(), makeText(mixed, length), iterations);
+    }
+
+    return 0;
+}
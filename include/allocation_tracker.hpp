@@ -0,0 +1,84 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace ili {
+
+    struct Context;
+
+    enum class AllocationKind : u8 {
+        Internal,       // Runtime data structures living on the managed heap
+        Object,         // Instance of a TypeDef
+        String,
+        Array,          // Typed by the element type
+        List,           // Elements of a List<T> or Queue<T>
+        HashTable       // Entries of a Dictionary<TKey,TValue> or HashSet<T>
+    };
+
+    // Records what gets allocated on the managed heap and from where. With a sample interval, only about one
+    // allocation every that many bytes is recorded and weighted so the totals remain unbiased estimates
+    class AllocationTracker {
+    public:
+        struct AllocationStats {
+            double count = 0;
+            double bytes = 0;
+        };
+
+        AllocationTracker(Context &ctx, u64 sampleInterval = 0);
+
+        void recordAllocation(AllocationKind kind, u32 typeToken, size_t size) {
+            if (this->m_sampleInterval == 0) {
+                this->record(kind, typeToken, size, 1.0);
+            } else if (size < this->m_bytesUntilSample) {
+                this->m_bytesUntilSample -= size;
+            } else {
+                this->m_bytesUntilSample = this->getNextSampleInterval();
+
+                // Larger allocations are more likely to be picked, they stand for fewer unsampled ones
+                this->record(kind, typeToken, size, 1.0 / (1.0 - std::exp(-double(std::max<size_t>(size, 1)) / double(this->m_sampleInterval))));
+            }
+
+            if (this->m_censusRequested.load(std::memory_order_relaxed)) [[unlikely]]
+                this->writeRequestedCensus();
+        }
+
+        // Asks for a heap census to be written to <prefix>.census.<n>.txt at the next allocation. Safe to call
+        // from a signal handler
+        void requestCensus();
+        void setCensusPrefix(const std::string &prefix);
+
+        std::string getTypeName(AllocationKind kind, u32 typeToken);
+
+        bool writeReport(const std::string &path);
+        bool writeHeapCensus(const std::string &path);
+
+    private:
+        static u64 getTypeKey(AllocationKind kind, u32 typeToken) { return (u64(kind) << 32) | typeToken; }
+
+        void record(AllocationKind kind, u32 typeToken, size_t size, double weight);
+        u64 getNextSampleInterval();
+        void writeRequestedCensus();
+
+        Context &m_ctx;
+
+        u64 m_sampleInterval;
+        u64 m_bytesUntilSample = 0;
+        std::mt19937_64 m_random;
+
+        std::unordered_map<u64, AllocationStats> m_types;                      // Kind << 32 | type token
+        std::map<std::pair<u64, u64>, AllocationStats> m_sites;                // (Method token << 32 | IL offset, type key)
+
+        std::string m_censusPrefix = "heap";
+        u32 m_numCensuses = 0;
+        std::atomic<bool> m_censusRequested = false;
+    };
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace ili {
+
+    // Layout of a single dimensional, zero based array on the managed heap. The elements follow the header
+    // directly and are 8 byte aligned
+    typedef struct PACKED {
+        u32 length;
+        u32 elementTypeToken;       // TypeDef, TypeRef or TypeSpec the array was created with
+        u16 elementSize;            // In bytes, structs are stored inline
+        Type elementType;           // How elements are represented on the evaluation stack
+        bool elementUnsigned;       // Elements smaller than 4 bytes get zero instead of sign extended
+        u8 padding[3];
+    } array_object_t;
+    static_assert(sizeof(array_object_t) == 0x10, "array_object_t size invalid!");
+
+    struct Context;
+    struct GenericContext;
+    struct ValueLayout;
+    struct TypeLayout;
+
+    struct ArrayLayout {
+        array_object_t header;              // Of an empty array
+        const TypeLayout *elementLayout;    // Struct elements only
+    };
+
+    class Arrays {
+    public:
+        static array_object_t* create(Context &ctx, u32 elementTypeToken, u32 length, const GenericContext *genericContext = nullptr);
+
+        static u8* getData(array_object_t *array);
+        static u8* getElement(array_object_t *array, u32 index);
+
+        static bool hasElementLayout(const array_object_t *array, const ValueLayout &value);
+    };
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "types.hpp"
+#include "mapped_file.hpp"
+
+#include <string>
+#include <span>
+
+namespace ili {
+
+    typedef struct PACKED {
+        char magic[4];              // ILIC
+        u32 version;
+        u8 mvid[16];
+        u64 fileHash;
+        u64 fileSize;
+
+        u32 tablesOffset;           // cache_table_descriptor_t[64]
+        u32 methodBodiesOffset;     // method_body_t[MethodDef rows], zeroed if not decoded yet
+        u32 methodOwnersOffset;     // u32[MethodDef rows]
+        u32 objectSizesOffset;      // u32[TypeDef rows], DLL::UnknownObjectSize if not laid out yet
+        u32 memberRefNamesOffset;   // u32[MemberRef rows], offsets into the name pool
+        u32 namePoolOffset;
+        u32 namePoolSize;
+    } cache_header_t;
+
+    typedef struct PACKED {
+        u32 offset;                 // Offset of the first row from the start of the DLL file
+        u32 rowSize;
+        u32 numRows;
+    } cache_table_descriptor_t;
+    static_assert(sizeof(cache_table_descriptor_t) == 0x0C, "cache_table_descriptor_t size invalid!");
+
+    typedef struct PACKED {
+        u32 codeOffset;             // Offset of the first IL instruction from the start of the DLL file
+        u32 codeSize;
+        u16 maxStack;
+        u16 flags;
+        u32 localVarSigToken;
+    } method_body_t;
+    static_assert(sizeof(method_body_t) == 0x10, "method_body_t size invalid!");
+
+    class DLL;
+
+    // Keeps what the DLL derives from the metadata tables between runs: table locations, method headers, object sizes
+    // and MemberRef names. Verified methods and full type layouts aren't stored and get rebuilt on every run
+    class Cache {
+    public:
+        static constexpr u32 Version = 5;
+
+        // An empty path disables the cache, nothing gets loaded or stored
+        explicit Cache(std::string path);
+
+        bool load(u64 fileHash, u64 fileSize);
+        void store(DLL &dll, std::span<const method_body_t> methodBodies, std::span<const u32> objectSizes);
+
+        bool isLoaded();
+        const cache_header_t* getHeader();
+        const cache_table_descriptor_t* getTableDescriptors();
+        const method_body_t* getMethodBodies();
+        const u32* getMethodOwners();
+        const u32* getObjectSizes();
+        const u32* getMemberRefNameOffsets();
+        const char* getNamePool();
+
+    private:
+        std::string m_path;
+        MappedFile m_file;
+        const cache_header_t *m_header = nullptr;
+
+        bool isSectionValid(u32 offset, u64 size);
+
+        template<typename T>
+        const T* getSection(u32 offset);
+    };
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace ili {
+
+    // Elements of a List<T> or Queue<T>, the collection object itself only holds a pointer to this. Lives on the
+    // managed heap so references in it are found by snapshots. The elements follow the header directly and are
+    // 8 byte aligned, vacated reference slots are zeroed so they don't keep objects reachable
+    typedef struct PACKED {
+        u32 count;
+        u32 capacity;
+        u32 head;                   // Queue<T> only, index of the first element. Elements wrap around the end
+        bool references;            // Whether the elements are references, so snapshots can relocate them
+        u8 padding[3];
+    } list_storage_t;
+    static_assert(sizeof(list_storage_t) == 0x10, "list_storage_t size invalid!");
+
+    // Open addressing hash table behind a Dictionary<TKey,TValue> or HashSet<T>. The header is followed by a state
+    // byte for every slot, then the keys and then the values, each array starting 8 byte aligned
+    typedef struct PACKED {
+        u32 count;
+        u32 capacity;               // Always a power of two
+        u32 used;                   // Slots that aren't empty, including the ones of removed entries
+        u8 keySize;
+        u8 valueSize;
+        bool referenceKeys;
+        bool referenceValues;
+    } hash_table_t;
+    static_assert(sizeof(hash_table_t) == 0x10, "hash_table_t size invalid!");
+
+    enum class SlotState : u8 {
+        Empty,
+        Full,
+        Removed
+    };
+
+    struct Context;
+
+    class Collections {
+    public:
+        static list_storage_t* createList(Context &ctx, u32 elementSize, u32 capacity, bool references);
+        static u8* getElements(list_storage_t *list);
+        // Makes room for at least capacity elements, moving the list if it can't grow in place. Queues get unwrapped
+        static void reserve(Context &ctx, list_storage_t *&list, u32 elementSize, u32 capacity);
+
+        static hash_table_t* createHashTable(Context &ctx, u8 keySize, u8 valueSize, u32 capacity, bool referenceKeys, bool referenceValues);
+        static SlotState* getStates(hash_table_t *table);
+        static u8* getKeys(hash_table_t *table);
+        static u8* getValues(hash_table_t *table);
+        // Whether another entry can be added without going over the maximum load factor
+        static bool hasRoom(hash_table_t *table);
+    };
+
+}
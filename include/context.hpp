@@ -5,10 +5,18 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
-#include <list>
+#include <algorithm>
+#include <vector>
 #include <functional>
 #include <cstring>
+#include <type_traits>
 #include "logger.hpp"
+#include "strings.hpp"
+#include "arrays.hpp"
+#include "output.hpp"
+#include "allocation_tracker.hpp"
+#include "metrics.hpp"
+#include "value_types.hpp"
 
 namespace ili {
 
@@ -24,28 +32,82 @@ namespace ili {
     struct HeapReference {
         u8 *heapPointer;
         size_t size;
+        AllocationKind kind;
+        u32 typeToken;
+        const TypeLayout *layout;   // Of generic instantiations and struct array elements, whose layout the type token
+                                    // alone doesn't tell
     };
 
     class Method;
     class DLL;
+    class Preparer;
+    class Profiler;
+    class Sampler;
+    struct PreparedMethod;
+
+    // Selects which copy of the interpreter loop runs. Every mode except None also counts executed instructions
+    enum class ProfilingMode : u8 {
+        None,
+        Counting,           // Nothing but the instruction count, e.g. for the hardware counters
+        Instrumenting,      // Every instruction and call is timed by the Profiler
+        StackWalking        // Frames keep their program counter up to date for the Sampler and the AllocationTracker
+    };
+
+    // A method that's currently being executed. Lives on the stack between the method's arguments and its locals
+    // and is linked up so the call stack can be walked, even from inside a signal handler
+    struct InterpreterFrame {
+        InterpreterFrame *caller;
+        u32 methodToken;
+        const u8 *code;
+        const u8 *programCounter;   // Start of the instruction that's being executed, only kept up to date while stack walking
+
+        PreparedMethod *method;
+        const u8 *returnAddress;    // Where the caller continues once this method returns
+        u8 *arguments;
+        Type *argumentTypes;
+    };
 
 
     struct Context {
         DLL *dll = nullptr;
+        Preparer *preparer = nullptr;
+        Profiler *profiler = nullptr;       // Only set while profiling
+        Sampler *sampler = nullptr;
+        AllocationTracker *allocationTracker = nullptr;
+        Metrics *metrics = nullptr;
+        ProfilingMode profilingMode = ProfilingMode::None;
+        u64 executedInstructions = 0;
+        InterpreterFrame *currentFrame = nullptr;
 
         u8 *heap = nullptr;
-        std::list<HeapReference> heapReferences;
+        size_t heapSize = 0;
+        std::vector<HeapReference> heapReferences;     // In the order of their addresses, the heap only grows
+
+        std::vector<Variable<u64>> statics;
+        std::vector<string_object_t*> internedStrings;      // Indexed by #US heap offset
+        std::unordered_map<u32, ArrayLayout> arrayLayouts;  // By element type token
 
         u8 *stackPointer = nullptr;
         u8 *framePointer = nullptr;
         u8 *stack;
+        size_t stackSize = 0;
 
         Type *typeStackPointer = nullptr;
         Type *typeFramePointer = nullptr;
         Type *typeStack;
 
+        OutputBuffer output;
+
         std::unordered_map<std::string, std::function<void()>> nativeFunctions;
+        std::vector<std::function<void()>*> nativeBindings;
 
+        // Prepared instantiations of generic methods, by MethodDef and canonical type arguments. Every instantiation
+        // over reference types shares the one over object, ones over value types get their own
+        std::unordered_map<std::string, PreparedMethod*> instantiations;
+        std::vector<PreparedMethod*> instantiationBindings;     // By the same index as nativeBindings
+        // Layouts of the fields ldfld and friends access, by Field index and then by MemberRef index
+        std::vector<const FieldLayout*> fieldBindings;
+        std::unordered_map<u32, ValueLayout> valueLayouts;      // Of the types ldobj and friends access, by token
 
 
         Type getTypeOnStack(u16 pos = 0) {
@@ -56,30 +118,27 @@ namespace ili {
         T pop() {
             T ret = {};
 
-            if (stackPointer <= stack) {
-                Logger::error("Popped %d bytes from the stack but the stack is empty!", sizeof(T));
-                exit(1);
-            }
+            if (stackPointer <= stack)
+                this->fatalError(LogCategory::Stack, "Popped %d bytes from the stack but the stack is empty!", sizeof(T));
 
             size_t sizeToPop = getTypeSize(getTypeOnStack());
 
-            if (sizeToPop > sizeof(T)) {
-                Logger::error("Popped %d bytes into %d byte return value!", sizeToPop, sizeof(T));
-                exit(1);
-            }
+            if (sizeToPop > sizeof(T))
+                this->fatalError(LogCategory::Stack, "Popped %d bytes into %d byte return value!", sizeToPop, sizeof(T));
 
             typeStackPointer--;
             stackPointer -= sizeof(T);
 
-            if (stackPointer < stack) {
-                Logger::error("Popped %d which was more than the stack held!", sizeof(T));
-                exit(1);
-            }
+            if (stackPointer < stack)
+                this->fatalError(LogCategory::Stack, "Popped %d which was more than the stack held!", sizeof(T));
 
             std::memset(&ret, 0x00, sizeof(T));
             std::memcpy(&ret, stackPointer, sizeToPop);
 
-            Logger::debug("Popped %d bytes from stack: %016llx", sizeof(T), ret);
+            if constexpr (std::is_arithmetic_v<T>)
+                Logger::debug(LogCategory::Stack, "Popped %d bytes from stack: %016llx", sizeof(T), ret);
+            else
+                Logger::debug(LogCategory::Stack, "Popped %d bytes from stack", sizeof(T));
 
             return ret;
         }
@@ -93,12 +152,130 @@ namespace ili {
             typeStackPointer++;
             stackPointer += sizeof(T);
 
-            Logger::debug("Pushed %d bytes onto stack: %016llx", sizeof(T), val);
+            if constexpr (std::is_arithmetic_v<T>)
+                Logger::debug(LogCategory::Stack, "Pushed %d bytes onto stack: %016llx", sizeof(T), val);
+            else
+                Logger::debug(LogCategory::Stack, "Pushed %d bytes onto stack", sizeof(T));
+        }
+
+        // Structs are pushed as their bytes followed by their size, so they can be popped and moved around without
+        // knowing their type. Returns where the bytes go
+        u8* pushValueType(u32 size) {
+            u8 *value = stackPointer;
+
+            std::memcpy(stackPointer + size, &size, sizeof(size));
+            *typeStackPointer = Type::ValueType;
+
+            typeStackPointer++;
+            stackPointer += size + sizeof(u32);
+
+            Logger::debug(LogCategory::Stack, "Pushed %d byte struct onto stack", size);
+
+            return value;
+        }
+
+        // The bytes stay where they are until the next push
+        u8* popValueType(u32 &size) {
+            if (typeStackPointer <= typeStack || getTypeOnStack() != Type::ValueType)
+                this->fatalError(LogCategory::Stack, "Popped a struct but there's none on top of the stack!");
+
+            std::memcpy(&size, stackPointer - sizeof(u32), sizeof(size));
+
+            typeStackPointer--;
+            stackPointer -= size + sizeof(u32);
+
+            Logger::debug(LogCategory::Stack, "Popped %d byte struct from stack", size);
+
+            return stackPointer;
+        }
+
+        // Bytes the value on top of the stack takes up
+        u32 getSizeOnStack() {
+            Type type = getTypeOnStack();
+            if (type != Type::ValueType)
+                return getTypeSize(type);
+
+            u32 size;
+            std::memcpy(&size, stackPointer - sizeof(u32), sizeof(size));
+
+            return size + sizeof(u32);
         }
 
         u32 getUsedStackSize() {
             return this->stackPointer - this->stack;
         }
+
+        // Ends the program after an error it can't recover from. Whatever it printed so far comes out before the error
+        template<typename... Args>
+        [[noreturn]] void fatalError(LogCategory category, const char *format, Args... args) {
+            this->output.flush();
+            Logger::error(category, format, args...);
+            Logger::flush();
+            exit(1);
+        }
+
+        u8* allocate(size_t size, AllocationKind kind = AllocationKind::Internal, u32 typeToken = 0, const TypeLayout *layout = nullptr) {
+            u8 *newMemory = this->heap;
+            if (!this->heapReferences.empty()) {
+                auto &lastElement = this->heapReferences.back();
+                newMemory = lastElement.heapPointer + ((lastElement.size + alignof(u64) - 1) & ~(alignof(u64) - 1));
+            }
+
+            if (newMemory + size > this->heap + this->heapSize)
+                this->fatalError(LogCategory::Stack, "Out of heap memory while allocating %d bytes!", size);
+
+            std::memset(newMemory, 0x00, size);
+            this->heapReferences.push_back({ newMemory, size, kind, typeToken, layout });
+
+            if (this->allocationTracker != nullptr) [[unlikely]]
+                this->allocationTracker->recordAllocation(kind, typeToken, size);
+
+            if (this->metrics != nullptr) [[unlikely]] {
+                this->metrics->add(Metrics::Allocations);
+                this->metrics->add(Metrics::AllocatedBytes, size);
+            }
+
+            return newMemory;
+        }
+
+        // Grows the most recent allocation without moving it. Fails for every other allocation or if the heap is full
+        bool extend(u8 *memory, size_t size) {
+            if (this->heapReferences.empty() || this->heapReferences.back().heapPointer != memory)
+                return false;
+
+            auto &lastElement = this->heapReferences.back();
+            if (size <= lastElement.size || memory + size > this->heap + this->heapSize)
+                return false;
+
+            std::memset(memory + lastElement.size, 0x00, size - lastElement.size);
+
+            if (this->metrics != nullptr) [[unlikely]]
+                this->metrics->add(Metrics::AllocatedBytes, size - lastElement.size);
+
+            lastElement.size = size;
+
+            return true;
+        }
+
+        // The allocation that starts at an address, found by a binary search. Null for anything else
+        HeapReference* findAllocation(u64 address) {
+            auto reference = std::lower_bound(this->heapReferences.begin(), this->heapReferences.end(), address, [](const HeapReference &reference, u64 address) {
+                return reinterpret_cast<u64>(reference.heapPointer) < address;
+            });
+
+            if (reference == this->heapReferences.end() || reinterpret_cast<u64>(reference->heapPointer) != address)
+                return nullptr;
+
+            return &*reference;
+        }
+
+        u32 getUsedHeapSize() {
+            if (this->heapReferences.empty())
+                return 0;
+
+            auto &lastElement = this->heapReferences.back();
+            return (lastElement.heapPointer + lastElement.size) - this->heap;
+        }
     };
 
 }
\ No newline at end of file
@@ -3,12 +3,20 @@
 #include "types.hpp"
 #include "file_headers.hpp"
 #include "tables.hpp"
+#include "cache.hpp"
+#include "signature.hpp"
+#include "exceptions.hpp"
+#include "value_types.hpp"
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <stdio.h>
 #include <cstring>
 #include <span>
 #include <vector>
+#include <mutex>
+#include <unordered_map>
 
 namespace ili {
 
@@ -18,23 +26,30 @@ namespace ili {
 
     class DLL {
     public:
-        DLL(std::string filePath);
+        static constexpr u32 UnknownObjectSize = 0xFFFF'FFFF;
+
+        // Derived metadata is only cached across runs if a cache directory is given
+        DLL(std::string filePath, std::string cacheDirectory = "");
         ~DLL();
 
         void validate();
 
         table_method_def_t* getMethodDefByMetadataToken(u32 methodToken);
         table_member_ref_t* getMemberRefByMetadataToken(u32 memberToken);
+        table_method_spec_t* getMethodSpecByMetadataToken(u32 methodSpecToken);
         table_method_def_t* getMethodDefByIndex(u32 index);
         table_type_def_t* getTypeDefByIndex(u32 index);
         table_type_ref_t* getTypeRefByIndex(u32 index);
         table_assembly_ref_t* getAssemblyRefByIndex(u32 index);
         table_field_t* getFieldByIndex(u32 index);
+        table_type_spec_t* getTypeSpecByIndex(u32 index);
+        table_stand_alone_sig_t* getStandAloneSigByIndex(u32 index);
 
         u32 getEntryMethodToken();
 
         const char* getString(u32 index);
         std::span<u8> getUserString(u32 index);
+        u32 getUserStringHeapSize();
         u8 *getBlob(u32 index);
 
         u8* getData();
@@ -44,19 +59,71 @@ namespace ili {
         section_table_entry_t* getVirtualSection(u64 rva);
 
         std::string getFullMethodName(u32 methodToken);
-        std::string decodeUserString(u32 token);
 
-        u16 findTypeDefWithMethod(u32 methodToken);
+        const method_body_t* getMethodBody(u32 methodToken);
+        u32 getObjectSize(u32 typeIndex);
+        const char* getMemberRefName(u32 memberToken);
+        std::string getMemberRefSignature(u32 memberToken);
+        u32 getMethodSpecMethod(u32 methodSpecToken);
+        std::string getMethodSpecName(u32 methodSpecToken);
+        bool decodeMethodSignature(u32 methodToken, MethodSignature &signature, const GenericContext *instantiation = nullptr);
+        bool decodeLocalTypes(u32 localVarSigToken, std::vector<Type> &types, const GenericContext *genericContext = nullptr, std::vector<const TypeLayout*> *valueTypes = nullptr);
+        bool resolveInstantiation(u32 methodToken, const GenericContext *callerContext, u32 &methodDefToken, GenericContext &genericContext);
+        std::span<const u8> getTypeArgument(u32 typeToken, const GenericContext &genericContext);
+        std::string instantiateName(std::string_view name, const GenericContext &genericContext);
+        bool decodeExceptionClauses(u32 methodToken, std::vector<ExceptionClause> &clauses);
+
+        std::string getTypeName(u32 typeToken);
+        bool isAssignableTo(u32 typeToken, u32 classToken);
+        bool implementsInterface(u32 typeIndex, u32 interfaceToken);
+        u32 findTypeRef(std::string_view typeName);
+        u32 getRuntimeExceptionType(std::string_view typeName);
+        bool isVectorType(u32 typeToken);
+        bool isValueType(u32 typeIndex);
+
+        const TypeLayout* getTypeLayout(u32 typeToken, const GenericContext *genericContext = nullptr);
+        const TypeLayout* getInstantiationLayout(u32 typeIndex, const GenericContext &instantiation);
+        bool getValueLayout(u32 typeToken, ValueLayout &layout, const GenericContext *genericContext = nullptr);
+        bool decodeValueLayout(const u8 *&signature, const u8 *signatureEnd, ValueLayout &layout, const GenericContext *genericContext);
+        const FieldLayout* getFieldLayout(u32 fieldToken, const GenericContext *genericContext = nullptr);
+
+        u32 findTypeDefWithMethod(u32 methodToken);
+        u32 findTypeDefWithField(u32 fieldIndex);
         table_class_layout_t* getClassLayoutOfType(table_type_def_t *typeDef);
 
+        static u8 decodeCompressedUnsigned(const u8 *data, u32 &value);
         u32 getBlobSize(u32 index);
         u8 getBlobHeaderSize(u32 index);
 
         u32 getNumTableRows(u8 index);
+        cache_table_descriptor_t getTableDescriptor(u8 index);
+
+        const u8* getGuid(u32 index);
+        const u8* getMvid();
+        u64 getFileHash();
+        size_t getFileSize();
 
     private:
+        void parseTables(tilde_stream_t *tildeStream);
+        bool loadTablesFromCache();
+        void buildIndexes();
+        void useCachedIndexes();
+
+        method_body_t decodeMethodBody(table_method_def_t *methodDef);
+
+        std::string getTypeRefPath(u32 typeRefIndex);
+        std::string getTypeSpecPath(u32 typeSpecIndex);
+        std::string readTypeName(const u8 *&signature, const u8 *signatureEnd);
+        bool decodeStackType(const u8 *&signature, const u8 *signatureEnd, Type &type, const GenericContext *genericContext, const TypeLayout **valueType = nullptr);
+        bool getGenericContext(u32 methodToken, u32 &memberRefToken, GenericContext &genericContext);
+        u32 findMethodDefOfMemberRef(u32 memberRefToken);
+        u32 getBaseType(u32 typeIndex);
+        const TypeLayout* layOutType(u32 typeIndex, const std::vector<std::span<const u8>> &typeArguments);
+        const TypeLayout* layOutInstantiation(const u8 *&signature, const u8 *signatureEnd, const GenericContext *genericContext);
+
         u8 *m_dllData;
         size_t m_fileSize;
+        u64 m_fileHash;
 
         dos_header_t *m_dosHeader;
         dos_stub_t *m_dosStub;
@@ -68,10 +135,31 @@ namespace ili {
         std::vector<stream_header_t*> m_streamHeaders;
         u32 m_numRows[64] = { 0 };
 
-        std::vector<std::vector<unspecified_table_t>> m_tildeTableData;
+        unspecified_table_t m_tables[64] = { 0 };
         u8 *m_stringsHeap;
         u8 *m_userStringsHeap;
+        u32 m_userStringsHeapSize = 0;
         u8 *m_blobHeap;
+        u8 *m_guidHeap;
+
+        // Derived structures, either built from the metadata or pointing into the memory-mapped cache
+        Cache m_cache;
+        bool m_cacheDirty = false;
+        std::mutex m_lazyDecodeMutex;   // Method bodies and object sizes get decoded from the preparation workers too
+        std::vector<method_body_t> m_methodBodyData;
+        std::vector<u32> m_methodOwnerData;
+        std::vector<u32> m_objectSizeData;
+        std::vector<u32> m_memberRefNameData;
+        std::string m_namePoolData;
+
+        // Layouts by TypeDef index and canonical type arguments. Laying out a type can lay out the ones of its fields
+        // and its base type, so the lock is taken again from the same thread
+        std::recursive_mutex m_layoutMutex;
+        std::unordered_map<std::string, std::unique_ptr<TypeLayout>> m_typeLayouts;
+
+        const u32 *m_methodOwners = nullptr;
+        const u32 *m_memberRefNames = nullptr;
+        const char *m_namePool = nullptr;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <string>
+
+namespace ili {
+
+    enum class ExceptionClauseKind : u8 {
+        Catch,
+        Filter,
+        Finally,
+        Fault
+    };
+
+    // An entry of a method's exception handling table with its offsets turned into ranges
+    struct ExceptionClause {
+        ExceptionClauseKind kind;
+        u32 tryStart, tryEnd;               // End is exclusive
+        u32 handlerStart, handlerEnd;
+        u32 classToken;                     // Catch only, type of the exceptions it catches
+        u32 filterStart;                    // Filter only, the filter block runs up to the handler
+
+        bool isInTry(u32 offset) const { return offset >= this->tryStart && offset < this->tryEnd; }
+        bool isInHandler(u32 offset) const { return offset >= this->handlerStart && offset < this->handlerEnd; }
+    };
+
+    // Instructions and natives that fail the way the runtime reports with one of its exceptions throw this. The
+    // interpreter turns it into a managed exception of that type, so the program can catch it like any other
+    struct RuntimeException {
+        const char *typeName;
+        std::string message;
+    };
+
+    [[noreturn]] void throwRuntimeException(const char *typeName, const char *format, ...);
+
+}
@@ -146,16 +146,45 @@ namespace ili {
         size_t size;
     } unspecified_table_t;
 
+    typedef struct PACKED {
+        u16 flagsAndSize;           // Lower 12 bits flags, upper 4 bits header size in dwords
+        u16 maxStack;
+        u32 codeSize;
+        u32 localVarSigToken;
+    } method_fat_header_t;
+    static_assert(sizeof(method_fat_header_t) == 0x0C, "method_fat_header_t size invalid!");
+
+    typedef struct PACKED {
+        u16 flags;
+        u16 tryOffset;
+        u8 tryLength;
+        u16 handlerOffset;
+        u8 handlerLength;
+        u32 classTokenOrFilterOffset;
+    } exception_clause_small_t;
+    static_assert(sizeof(exception_clause_small_t) == 0x0C, "exception_clause_small_t size invalid!");
+
+    typedef struct PACKED {
+        u32 flags;
+        u32 tryOffset;
+        u32 tryLength;
+        u32 handlerOffset;
+        u32 handlerLength;
+        u32 classTokenOrFilterOffset;
+    } exception_clause_fat_t;
+    static_assert(sizeof(exception_clause_fat_t) == 0x18, "exception_clause_fat_t size invalid!");
+
 
     static constexpr u8 getMetadataTableSize(u8 index) {
         // TODO: Some of these values depend on if a table/heap has more than 2^16 entries
         // TODO: For now, assume we don't reach that limit
         constexpr u8 table[64] = {
-                10, 6, 14, 0, 6, 0, 14, 0,
-                6, 0, 6, 0, 6, 0, 0, 0,
-                0, 2, 0, 0, 0, 0, 0, 0,
-                0, 0, 0, 0, 0, 0, 0, 0,
-                22, 0, 0, 20
+                10, 6, 14, 2, 6, 2, 14, 2,
+                6, 4, 6, 6, 6, 4, 6, 8,
+                6, 2, 4, 2, 6, 4, 2, 6,
+                6, 6, 2, 2, 8, 6, 8, 4,
+                22, 4, 12, 20, 6, 14, 8, 14,
+                12, 4, 8, 4, 4
         };
 
         if (index >= sizeof(table))
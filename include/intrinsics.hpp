@@ -0,0 +1,56 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace ili {
+
+    class DLL;
+
+    // Library methods the Preparer replaces with call.intrinsic so they run straight from the dispatch loop
+    // instead of going through the native bindings
+    enum class Intrinsic : u32 {
+        None,
+
+        SqrtDouble,
+        SqrtFloat,
+        AbsInt8,
+        AbsInt16,
+        AbsInt32,
+        AbsInt64,
+        AbsDouble,
+        AbsFloat,
+        MinInt32,
+        MinUInt32,
+        MinInt64,
+        MinUInt64,
+        MinDouble,
+        MinFloat,
+        MaxInt32,
+        MaxUInt32,
+        MaxInt64,
+        MaxUInt64,
+        MaxDouble,
+        MaxFloat,
+        FloorDouble,
+        FloorFloat,
+        CeilingDouble,
+        CeilingFloat,
+
+        ArrayCopy,              // Array.Copy(Array, Array, int)
+        ArrayCopyRange,         // Array.Copy(Array, int, Array, int, int)
+        ArrayClear,             // Array.Clear(Array)
+        ArrayClearRange,        // Array.Clear(Array, int, int)
+        ArrayFill,              // Array.Fill<T>(T[], T)
+        ArrayFillRange,         // Array.Fill<T>(T[], T, int, int)
+        BufferBlockCopy,        // Buffer.BlockCopy(Array, int, Array, int, int)
+        CopyBlock,              // Unsafe.CopyBlock and CopyBlockUnaligned, the same as cpblk
+        InitBlock               // Unsafe.InitBlock and InitBlockUnaligned, the same as initblk
+    };
+
+    class Intrinsics {
+    public:
+        // Intrinsic a MemberRef or MethodSpec stands for, None if it's an ordinary call
+        static Intrinsic find(DLL *dll, u32 methodToken);
+    };
+
+}
@@ -1,14 +1,149 @@
 #pragma once
 
+#include "types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
 namespace ili {
 
+    enum class LogLevel : u8 {
+        Debug   = 0,
+        Info    = 1,
+        Error   = 2
+    };
+
+    enum class LogCategory : u8 {
+        General,
+        Metadata,
+        Interpreter,
+        Stack,
+        Preparer,
+        Native,
+        Snapshot,
+
+        Count
+    };
+
+    enum class LogArgumentType : u8 {
+        Integer,
+        Float,
+        String
+    };
+
+    // A log message before formatting. The format string has to be a literal, only its address is stored.
+    // Arguments follow the header, each one being a type byte followed by 8 bytes of value or a length
+    // byte and the characters of a string
+    typedef struct PACKED {
+        u64 timestamp;
+        const char *format;
+        LogLevel level;
+        LogCategory category;
+        u16 size;
+    } log_record_t;
+
     class Logger {
     public:
-        static constexpr bool DebugLogging = true;
+        static constexpr size_t MaxRecordSize = 0x100;
+
+        template<typename... Args>
+        static void error(const char *format, Args... args) { log(LogLevel::Error, LogCategory::General, format, args...); }
+        template<typename... Args>
+        static void error(LogCategory category, const char *format, Args... args) { log(LogLevel::Error, category, format, args...); }
+
+        template<typename... Args>
+        static void info(const char *format, Args... args) { log(LogLevel::Info, LogCategory::General, format, args...); }
+        template<typename... Args>
+        static void info(LogCategory category, const char *format, Args... args) { log(LogLevel::Info, category, format, args...); }
+
+        template<typename... Args>
+        static void debug(const char *format, Args... args) { log(LogLevel::Debug, LogCategory::General, format, args...); }
+        template<typename... Args>
+        static void debug(LogCategory category, const char *format, Args... args) { log(LogLevel::Debug, category, format, args...); }
+
+        // Arguments are evaluated before log() gets to check this, so callers whose arguments look anything up
+        // have to check it themselves
+        static bool isEnabled(LogLevel level, LogCategory category) {
+            return (s_enabledCategories[static_cast<u8>(level)].load(std::memory_order_relaxed) & (1U << static_cast<u8>(category))) != 0;
+        }
+
+        // Enables the given level and everything more severe for a category, disables everything less severe
+        static void setLevel(LogLevel level, LogCategory category);
+        static void setLevel(LogLevel level);
+
+        // Parses "level" or "level:category,category,...", e.g. "debug:interpreter,stack". Multiple of those
+        // can be separated by semicolons
+        static bool configure(std::string_view specification);
+
+        // Formats and writes everything that was logged so far
+        static void flush();
+
+    private:
+        struct RecordWriter {
+            u8 data[MaxRecordSize];
+            u16 size;
+
+            void add(LogArgumentType type, const void *value, size_t valueSize) {
+                if (this->size + 1 + valueSize > MaxRecordSize)
+                    return;
+
+                this->data[this->size++] = static_cast<u8>(type);
+                std::memcpy(&this->data[this->size], value, valueSize);
+                this->size += valueSize;
+            }
+
+            template<typename T>
+            void add(T value) {
+                if constexpr (std::is_floating_point_v<T>) {
+                    double number = value;
+                    this->add(LogArgumentType::Float, &number, sizeof(number));
+                } else if constexpr (std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>) {
+                    // Strings are copied right away as they might not outlive the record
+                    if (size_t(this->size) + 2 > MaxRecordSize)
+                        return;
+
+                    size_t length = value == nullptr ? 0 : std::strlen(value);
+                    u8 storedLength = std::min<size_t>({ length, MaxRecordSize - this->size - 2, 0xFF });
+
+                    this->data[this->size++] = static_cast<u8>(LogArgumentType::String);
+                    this->data[this->size++] = storedLength;
+                    std::memcpy(&this->data[this->size], value, storedLength);
+                    this->size += storedLength;
+                } else if constexpr (std::is_pointer_v<T>) {
+                    u64 address = reinterpret_cast<u64>(value);
+                    this->add(LogArgumentType::Integer, &address, sizeof(address));
+                } else if constexpr (std::is_enum_v<T>) {
+                    u64 number = static_cast<u64>(static_cast<std::underlying_type_t<T>>(value));
+                    this->add(LogArgumentType::Integer, &number, sizeof(number));
+                } else {
+                    static_assert(std::is_integral_v<T>, "Unsupported log argument type");
+
+                    // Sign extended so the formatter can print it with any integer conversion
+                    u64 number = static_cast<u64>(static_cast<std::conditional_t<std::is_signed_v<T>, s64, u64>>(value));
+                    this->add(LogArgumentType::Integer, &number, sizeof(number));
+                }
+            }
+        };
+
+        template<typename... Args>
+        static void log(LogLevel level, LogCategory category, const char *format, Args... args) {
+            // This is all a disabled message costs
+            if (!isEnabled(level, category)) [[likely]]
+                return;
+
+            RecordWriter writer;
+            writer.size = sizeof(log_record_t);
+            (writer.add(args), ...);
+
+            submit(level, category, format, writer);
+        }
+
+        static void submit(LogLevel level, LogCategory category, const char *format, RecordWriter &writer);
 
-        static void error(const char *format, ...);
-        static void info(const char *format, ...);
-        static void debug(const char *format, ...);
+        static std::atomic<u32> s_enabledCategories[3];
     };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <string>
+
+namespace ili {
+
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        bool open(const std::string &path);
+        bool allocate(size_t size);
+        void close();
+
+        bool isOpen();
+        u8* getData();
+        size_t getSize();
+
+    private:
+        u8 *m_data = nullptr;
+        size_t m_size = 0;
+
+#if defined(_WIN32)
+        void *m_fileHandle = nullptr;
+        void *m_mappingHandle = nullptr;
+#endif
+    };
+
+}
@@ -3,24 +3,92 @@
 #include "types.hpp"
 #include "context.hpp"
 #include "tables.hpp"
+#include "signature.hpp"
+#include "exceptions.hpp"
+#include "arrays.hpp"
+#include "intrinsics.hpp"
+#include "preparer.hpp"
+
+#include <unordered_map>
+#include <vector>
 
 namespace ili  {
 
 
+    // Runs a method together with everything it calls in a single dispatch loop. Managed calls push a frame onto
+    // the stack instead of recursing, so the depth of managed recursion is only limited by the size of the stack
     class Method {
     public:
         Method(Context &ctx, u32 methodToken);
-        ~Method();
         void run();
 
     private:
         Context &m_ctx;
-        table_method_def_t *m_methodDef;
+        u32 m_methodToken;
+
+        InterpreterFrame *m_frame = nullptr;
+        const u8 *m_programCounter = nullptr;
+        u32 m_depth = 0;                // Frames this loop entered that haven't returned yet
+        bool m_tailCall = false;        // Set by the tail. prefix for the call that follows it
+
+        // A catch, finally or fault block that's currently running
+        struct ActiveHandler {
+            InterpreterFrame *frame;
+            u16 clause;
+            u16 nextClause;                 // Finally and fault, where the search for the next one continues
+            u32 offset;                     // Finally and fault, the instruction that's being left or that threw
+            u32 leaveTarget;                // Finally run by leave, where execution continues afterwards
+            bool unwinding;                 // Run while an exception unwinds the stack rather than by leave
+            u64 exception;                  // Catch, the exception that was caught. Otherwise the one that's being unwound
+            InterpreterFrame *catchFrame;   // While unwinding, the frame and clause that will catch the exception
+            u16 catchClause;
+        };
+
+        // In the order of the conditional branches in OpcodePrefix. Unsigned for integers, unordered for floats
+        enum class Condition : u8 {
+            Equal,
+            GreaterOrEqual,
+            Greater,
+            LessOrEqual,
+            Less,
+            NotEqualUnsigned,
+            GreaterOrEqualUnsigned,
+            GreaterUnsigned,
+            LessOrEqualUnsigned,
+            LessUnsigned
+        };
+
+        enum class Operation : u8 {
+            Add,
+            Subtract,
+            Multiply,
+            Divide,
+            DivideUnsigned,
+            Remainder,
+            RemainderUnsigned,
+            And,
+            Or,
+            Xor,
+            ShiftLeft,
+            ShiftRight,
+            ShiftRightUnsigned,
+            Negate,
+            Not
+        };
+
+        std::unordered_map<u32, MethodSignature> m_nativeSignatures;
 
-        u8 *m_programCounter;
+        std::vector<ActiveHandler> m_activeHandlers;
+        InterpreterFrame *m_filterFrame = nullptr;  // Set while a filter block runs
+        bool m_filterAbandoned = false;             // An exception escaped the filter that's running
 
-        VariableBase *m_localVariable[0xFF] = { nullptr };
 
+        template<ProfilingMode Mode>
+        void execute();
+        template<ProfilingMode Mode>
+        void dispatch();
+        template<ProfilingMode Mode>
+        void interpret();
 
         // General Operations
 
@@ -28,16 +96,124 @@ namespace ili  {
         T getNext();
 
         DLL* getDLL();
+        PreparedMethod* getVerifiedMethod(u32 methodToken);
+        PreparedMethod* instantiate(u32 methodToken, const GenericContext *callerContext);
+        CalleeBinding resolveCallee(u32 methodToken);
+        const MethodSignature* getNativeSignature(u32 methodToken);
+        Variable<u64>& getLocal(u16 id);
+        u8* getEvaluationStack(InterpreterFrame *frame);
+        void resetEvaluationStack(InterpreterFrame *frame);
+        Variable<u64>& getStaticField(u32 fieldToken);
+        const FieldLayout* bindField(u32 fieldToken);
+        const FieldLayout& resolveField(u32 fieldToken);
+        const ValueLayout& resolveValueLayout(u32 typeToken);
+        u64 popValue(Type &type);
+        void loadValueType(const u8 *source, u32 size);
+        void storeValueType(u8 *destination, u32 size);
+
+        template<ProfilingMode Mode>
+        void enter(u32 methodToken, PreparedMethod *preparedMethod, InterpreterFrame *caller, const u8 *returnAddress);
+        template<ProfilingMode Mode>
+        void tailCall(u32 methodToken, PreparedMethod *preparedMethod);
+        template<ProfilingMode Mode>
+        void leaveFrame(InterpreterFrame *caller);
+
+        // Exception Handling
+
+        u32 getObjectType(u64 object);
+        u64 createException(const RuntimeException &error);
+        void discardHandlers(InterpreterFrame *frame, u32 offset);
+
+        template<ProfilingMode Mode>
+        bool throwException(u64 exception, u32 offset, const RuntimeException *cause = nullptr);
+        template<ProfilingMode Mode>
+        bool runFilter(InterpreterFrame *frame, const ExceptionClause &clause, u64 exception);
+        template<ProfilingMode Mode>
+        void unwind(u64 exception, u32 offset, u16 firstClause, InterpreterFrame *catchFrame, u16 catchClause);
+        template<ProfilingMode Mode>
+        void leave(u32 offset, u32 target, u16 firstClause);
+        template<ProfilingMode Mode>
+        void endFinally(u32 offset);
+        template<ProfilingMode Mode>
+        bool rethrow(u32 offset);
 
         // Instruction Implementations
 
-        void stloc(u8 id);
-        void ldloc(u8 id);
-        void ldloca(u8 id);
+        void stloc(u16 id);
+        void ldloc(u16 id);
+        void ldloca(u16 id);
+        void ldarg(u16 index);
+        void ldarga(u16 index);
+        void starg(u16 index);
+        void ldsfld(u32 fieldToken);
+        void ldsflda(u32 fieldToken);
+        void stsfld(u32 fieldToken);
+        void ldfld(u32 fieldToken);
+        void ldflda(u32 fieldToken);
+        void stfld(u32 fieldToken);
+        void ldobj(u32 typeToken);
+        void stobj(u32 typeToken);
+        void cpobj(u32 typeToken);
+        void initobj(u32 typeToken);
+        bool isInstanceOf(u64 object, u32 classToken);
+        void isinst(u32 classToken);
+        void castclass(u32 classToken);
         template<typename T>
         void ldc(Type type, T num);
 
+        template<ProfilingMode Mode>
         void call(u32 methodToken);
+        template<ProfilingMode Mode>
+        void newobj(u32 methodToken);
+        template<ProfilingMode Mode>
+        void newValue(u32 methodToken, const MethodSignature &signature, const TypeLayout *valueType);
+        template<ProfilingMode Mode>
+        bool ret();
+
+        template<Operation O>
+        void arithmetic();
+        template<Operation O>
+        void shift();
+        template<Operation O>
+        void unary();
+        template<Condition C>
+        bool evaluate();
+        template<Condition C>
+        void branch(s32 offset);
+        bool popCondition();
+        template<ProfilingMode Mode, Condition C>
+        void compare();
+        void switchTable();
+
+        template<typename T>
+        void pushAs(Type type, T value);
+        template<typename T>
+        T fromValue(u64 value);
+
+        void dup();
+        template<typename T>
+        void ldind(Type type);
+        template<typename T>
+        void stind();
+        template<typename T>
+        void conv(Type type);
+
+        template<bool Checked>
+        array_object_t* popArrayElement(u32 &index, u16 elementSize);
+        void newarr(u32 elementTypeToken);
+        void ldlen();
+        void ldelema();
+        template<typename T, bool Checked>
+        void ldelem(Type type);
+        template<typename T, bool Checked>
+        void stelem();
+        template<bool Checked>
+        void ldelemAny();
+        template<bool Checked>
+        void stelemAny();
+
+        void callIntrinsic(Intrinsic intrinsic);
+        void cpblk();
+        void initblk();
     };
 }
-
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ili {
+
+    struct Context;
+
+    // Runtime counters and histograms that can be dumped in the Prometheus text format while a program runs.
+    // Every thread updates its own shard, so recording never needs a lock or an atomic read-modify-write. The
+    // shards only get added up when the values are read
+    class Metrics {
+    public:
+        static constexpr size_t MaxCounters = 64;
+        static constexpr size_t MaxHistograms = 16;
+        static constexpr size_t NumBuckets = 40;    // Bucket i holds values below 2^i, the last one everything else
+
+        struct Counter { u16 index; };
+        struct Histogram { u16 index; };
+
+        enum class CounterKind : u8 {
+            Counter,        // Only ever goes up, shards are summed
+            Maximum         // Largest value seen by any thread
+        };
+
+        struct HistogramValues {
+            std::array<u64, NumBuckets> buckets = { };
+            u64 count = 0;
+            u64 sum = 0;
+        };
+
+        // Registered by the constructor, in this order
+        static constexpr Counter InstructionsExecuted   = { 0 };
+        static constexpr Counter ManagedCalls           = { 1 };
+        static constexpr Counter NativeCalls            = { 2 };
+        static constexpr Counter VirtualCalls           = { 3 };
+        static constexpr Counter Allocations            = { 4 };
+        static constexpr Counter AllocatedBytes         = { 5 };
+        static constexpr Counter StackHighWater         = { 6 };
+        static constexpr Counter InlinePreparations     = { 7 };    // On the thread that first calls the method
+        static constexpr Counter WorkerPreparations     = { 8 };    // Ahead of the first call
+        static constexpr Counter ExceptionsThrown       = { 9 };
+        static constexpr Counter EliminatedBoundsChecks = { 10 };
+        static constexpr Counter ReplacedIntrinsics     = { 11 };
+        static constexpr Counter GenericInstantiations  = { 12 };
+
+        static constexpr Histogram NativeCallDuration   = { 0 };    // Nanoseconds
+
+        explicit Metrics(Context &ctx);
+        ~Metrics();
+
+        Metrics(const Metrics&) = delete;
+        Metrics& operator=(const Metrics&) = delete;
+
+        // Lets the host add its own metrics. Names may carry Prometheus labels, metrics of the same family
+        // should be registered one after another
+        Counter addCounter(const std::string &name, const std::string &help, CounterKind kind = CounterKind::Counter);
+        // Values are recorded as integers and multiplied by the unit when written out, e.g. 1e-9 for nanoseconds
+        Histogram addHistogram(const std::string &name, const std::string &help, double unit = 1.0);
+
+        void add(Counter counter, u64 value = 1) {
+            auto &slot = this->getShard().counters[counter.index];
+            slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        void raise(Counter counter, u64 value) {
+            auto &slot = this->getShard().counters[counter.index];
+            if (value > slot.load(std::memory_order_relaxed))
+                slot.store(value, std::memory_order_relaxed);
+        }
+
+        void observe(Histogram histogram, u64 value);
+
+        u64 getValue(Counter counter);
+        HistogramValues getValues(Histogram histogram);
+
+        // Also picks up the state of the interpreter, so this has to be called from the interpreter thread
+        bool writePrometheus(const std::string &path);
+
+        // Asks for the metrics to be written to the dump path by the interpreter thread. Safe to call from a
+        // signal handler
+        void requestDump() { this->m_dumpRequested.store(true, std::memory_order_relaxed); }
+        bool isDumpRequested() const { return this->m_dumpRequested.load(std::memory_order_relaxed); }
+        void writeRequestedDump();
+
+        void setDumpPath(const std::string &path);
+        void startPeriodicDumps(u32 intervalMilliseconds);
+        void stopPeriodicDumps();
+
+    private:
+        struct Shard {
+            std::array<std::atomic<u64>, MaxCounters> counters = { };
+            std::array<std::array<std::atomic<u64>, NumBuckets>, MaxHistograms> buckets = { };
+            std::array<std::atomic<u64>, MaxHistograms> sums = { };
+        };
+
+        struct Descriptor {
+            std::string name;
+            std::string help;
+            CounterKind kind = CounterKind::Counter;
+            double unit = 1.0;
+        };
+
+        Shard& getShard() {
+            thread_local u64 owner = 0;
+            thread_local Shard *shard = nullptr;
+
+            if (owner != this->m_id) [[unlikely]] {
+                shard = this->addShard();
+                owner = this->m_id;
+            }
+
+            return *shard;
+        }
+
+        Shard* addShard();
+        void publishInterpreterState();
+
+        Context &m_ctx;
+        u64 m_id;                       // Tells the thread local shard caches of different instances apart
+        u64 m_publishedInstructions = 0;
+
+        // Guards the descriptors and the list of shards
+        std::mutex m_mutex;
+        std::vector<Descriptor> m_counters;
+        std::vector<Descriptor> m_histograms;
+        std::vector<std::unique_ptr<Shard>> m_shards;
+
+        std::string m_dumpPath = "metrics.prom";
+        std::atomic<bool> m_dumpRequested = false;
+
+        std::thread m_dumpThread;
+        std::mutex m_dumpMutex;
+        std::condition_variable m_dumpSignal;
+        bool m_stopDumps = false;
+    };
+
+}
@@ -1,19 +1,29 @@
 #pragma once
 
+#include "types.hpp"
+
 #include <string>
 #include <functional>
 
 namespace ili {
 
-    class Context;
+    struct Context;
+    struct GenericContext;
 
     class NativeMethods {
     public:
         static void loadMSCORLIBLibrary(Context &ctx);
         static void loadNXLibrary(Context &ctx);
+        static void loadVectorLibrary(Context &ctx);
+        static void loadStringLibrary(Context &ctx);
+        static void loadCollectionsLibrary(Context &ctx);
 
         static void registerMethod(Context &ctx, std::string methodName, std::function<void()> method);
         static void callMethod(Context &ctx, std::string methodName);
+        static std::function<void()>* resolveMethod(Context &ctx, u32 methodToken, const GenericContext *genericContext = nullptr);
+
+        static u32 getBindingIndex(Context &ctx, u32 methodToken);
+        static u32 getBindingToken(Context &ctx, u32 index);
     };
 
 }
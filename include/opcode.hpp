@@ -197,6 +197,31 @@ namespace ili {
         Stind_i,
         Conv_u,
 
+        // Never part of a DLL. The Preparer rewrites element accesses it proved to be in bounds into these, which
+        // are in the same order as the ldelem and stelem instructions they replace, and calls to intrinsics
+        Ldelem_i1_unchecked = 0xE1,
+        Ldelem_u1_unchecked,
+        Ldelem_i2_unchecked,
+        Ldelem_u2_unchecked,
+        Ldelem_i4_unchecked,
+        Ldelem_u4_unchecked,
+        Ldelem_i8_unchecked,
+        Ldelem_i_unchecked,
+        Ldelem_r4_unchecked,
+        Ldelem_r8_unchecked,
+        Ldelem_ref_unchecked,
+        Stelem_i_unchecked,
+        Stelem_i1_unchecked,
+        Stelem_i2_unchecked,
+        Stelem_i4_unchecked,
+        Stelem_i8_unchecked,
+        Stelem_r4_unchecked,
+        Stelem_r8_unchecked,
+        Stelem_ref_unchecked,
+        Ldelem_unchecked,
+        Stelem_unchecked,
+        Call_intrinsic,         // Replaces calls to the library methods in Intrinsic, the operand is which one
+
         Arglist = 0xFE00,
         Ceq,
         Cgt,
@@ -205,7 +230,7 @@ namespace ili {
         Clt_un,
         Ldftn,
         Ldvirtftn = 0xFE07,
-        Ldarg = 0xFE0A,
+        Ldarg = 0xFE09,
         Ldarga,
         Starg,
         Ldloc,
@@ -226,4 +251,358 @@ namespace ili {
         Refanytype,
         Readonly
     };
+
+    // Size of the inline operand following an opcode. Switch is followed by a variable
+    // sized jump table which the caller has to account for separately
+    static constexpr u8 getOpcodeOperandSize(OpcodePrefix opcode) {
+        switch (opcode) {
+            case OpcodePrefix::Ldarg_s:
+            case OpcodePrefix::Ldarga_s:
+            case OpcodePrefix::Starg_s:
+            case OpcodePrefix::Ldloc_s:
+            case OpcodePrefix::Ldloca_s:
+            case OpcodePrefix::Stloc_s:
+            case OpcodePrefix::Ldc_i4_s:
+            case OpcodePrefix::Br_s:
+            case OpcodePrefix::Brfalse_s:
+            case OpcodePrefix::Brtrue_s:
+            case OpcodePrefix::Beq_s:
+            case OpcodePrefix::Bge_s:
+            case OpcodePrefix::Bgt_s:
+            case OpcodePrefix::Ble_s:
+            case OpcodePrefix::Blt_s:
+            case OpcodePrefix::Bne_un_s:
+            case OpcodePrefix::Bge_un_s:
+            case OpcodePrefix::Bgt_un_s:
+            case OpcodePrefix::Ble_un_s:
+            case OpcodePrefix::Blt_un_s:
+            case OpcodePrefix::Leave_s:
+            case OpcodePrefix::Unaligned:
+            case OpcodePrefix::No:
+                return 1;
+            case OpcodePrefix::Ldarg:
+            case OpcodePrefix::Ldarga:
+            case OpcodePrefix::Starg:
+            case OpcodePrefix::Ldloc:
+            case OpcodePrefix::Ldloca:
+            case OpcodePrefix::Stloc:
+                return 2;
+            case OpcodePrefix::Ldc_i4:
+            case OpcodePrefix::Ldc_r4:
+            case OpcodePrefix::Jmp:
+            case OpcodePrefix::Call:
+            case OpcodePrefix::Calli:
+            case OpcodePrefix::Br:
+            case OpcodePrefix::Brfalse:
+            case OpcodePrefix::Brtrue:
+            case OpcodePrefix::Beq:
+            case OpcodePrefix::Bge:
+            case OpcodePrefix::Bgt:
+            case OpcodePrefix::Ble:
+            case OpcodePrefix::Blt:
+            case OpcodePrefix::Bne_un:
+            case OpcodePrefix::Bge_un:
+            case OpcodePrefix::Bgt_un:
+            case OpcodePrefix::Ble_un:
+            case OpcodePrefix::Blt_un:
+            case OpcodePrefix::Swtch:
+            case OpcodePrefix::Callvirt:
+            case OpcodePrefix::Cpobj:
+            case OpcodePrefix::Ldobj:
+            case OpcodePrefix::Ldstr:
+            case OpcodePrefix::Newobj:
+            case OpcodePrefix::Castclass:
+            case OpcodePrefix::Isinst:
+            case OpcodePrefix::Unbox:
+            case OpcodePrefix::Ldfld:
+            case OpcodePrefix::Ldflda:
+            case OpcodePrefix::Stfld:
+            case OpcodePrefix::Ldsfld:
+            case OpcodePrefix::Ldsflda:
+            case OpcodePrefix::Stsfld:
+            case OpcodePrefix::Stobj:
+            case OpcodePrefix::Box:
+            case OpcodePrefix::Newarr:
+            case OpcodePrefix::Ldelema:
+            case OpcodePrefix::Ldelem:
+            case OpcodePrefix::Stelem:
+            case OpcodePrefix::Ldelem_unchecked:
+            case OpcodePrefix::Stelem_unchecked:
+            case OpcodePrefix::Call_intrinsic:
+            case OpcodePrefix::Unbox_any:
+            case OpcodePrefix::Refanyval:
+            case OpcodePrefix::Mkrefany:
+            case OpcodePrefix::Ldtoken:
+            case OpcodePrefix::Leave:
+            case OpcodePrefix::Ldftn:
+            case OpcodePrefix::Ldvirtftn:
+            case OpcodePrefix::Initobj:
+            case OpcodePrefix::Constrained:
+            case OpcodePrefix::Size_of:
+                return 4;
+            case OpcodePrefix::Ldc_i8:
+            case OpcodePrefix::Ldc_r8:
+                return 8;
+            default:
+                return 0;
+        }
+    }
+
+    static constexpr bool isInternalOpcode(OpcodePrefix opcode) {
+        return opcode >= OpcodePrefix::Ldelem_i1_unchecked && opcode <= OpcodePrefix::Call_intrinsic;
+    }
+
+    // Maps ldelem.i1 up to stelem to the variant that skips the null and bounds checks
+    static constexpr OpcodePrefix getUncheckedElementAccess(OpcodePrefix opcode) {
+        return static_cast<OpcodePrefix>(u16(opcode) - u16(OpcodePrefix::Ldelem_i1) + u16(OpcodePrefix::Ldelem_i1_unchecked));
+    }
+
+    static constexpr const char* getOpcodeName(OpcodePrefix opcode) {
+        switch (opcode) {
+            case OpcodePrefix::Nop:            return "nop";
+            case OpcodePrefix::Brk:            return "break";
+            case OpcodePrefix::Ldarg_0:        return "ldarg.0";
+            case OpcodePrefix::Ldarg_1:        return "ldarg.1";
+            case OpcodePrefix::Ldarg_2:        return "ldarg.2";
+            case OpcodePrefix::Ldarg_3:        return "ldarg.3";
+            case OpcodePrefix::Ldloc_0:        return "ldloc.0";
+            case OpcodePrefix::Ldloc_1:        return "ldloc.1";
+            case OpcodePrefix::Ldloc_2:        return "ldloc.2";
+            case OpcodePrefix::Ldloc_3:        return "ldloc.3";
+            case OpcodePrefix::Stloc_0:        return "stloc.0";
+            case OpcodePrefix::Stloc_1:        return "stloc.1";
+            case OpcodePrefix::Stloc_2:        return "stloc.2";
+            case OpcodePrefix::Stloc_3:        return "stloc.3";
+            case OpcodePrefix::Ldarg_s:        return "ldarg.s";
+            case OpcodePrefix::Ldarga_s:       return "ldarga.s";
+            case OpcodePrefix::Starg_s:        return "starg.s";
+            case OpcodePrefix::Ldloc_s:        return "ldloc.s";
+            case OpcodePrefix::Ldloca_s:       return "ldloca.s";
+            case OpcodePrefix::Stloc_s:        return "stloc.s";
+            case OpcodePrefix::Ldnull:         return "ldnull";
+            case OpcodePrefix::Ldc_i4_m1:      return "ldc.i4.m1";
+            case OpcodePrefix::Ldc_i4_0:       return "ldc.i4.0";
+            case OpcodePrefix::Ldc_i4_1:       return "ldc.i4.1";
+            case OpcodePrefix::Ldc_i4_2:       return "ldc.i4.2";
+            case OpcodePrefix::Ldc_i4_3:       return "ldc.i4.3";
+            case OpcodePrefix::Ldc_i4_4:       return "ldc.i4.4";
+            case OpcodePrefix::Ldc_i4_5:       return "ldc.i4.5";
+            case OpcodePrefix::Ldc_i4_6:       return "ldc.i4.6";
+            case OpcodePrefix::Ldc_i4_7:       return "ldc.i4.7";
+            case OpcodePrefix::Ldc_i4_8:       return "ldc.i4.8";
+            case OpcodePrefix::Ldc_i4_s:       return "ldc.i4.s";
+            case OpcodePrefix::Ldc_i4:         return "ldc.i4";
+            case OpcodePrefix::Ldc_i8:         return "ldc.i8";
+            case OpcodePrefix::Ldc_r4:         return "ldc.r4";
+            case OpcodePrefix::Ldc_r8:         return "ldc.r8";
+            case OpcodePrefix::Dup:            return "dup";
+            case OpcodePrefix::Pop:            return "pop";
+            case OpcodePrefix::Jmp:            return "jmp";
+            case OpcodePrefix::Call:           return "call";
+            case OpcodePrefix::Calli:          return "calli";
+            case OpcodePrefix::Ret:            return "ret";
+            case OpcodePrefix::Br_s:           return "br.s";
+            case OpcodePrefix::Brfalse_s:      return "brfalse.s";
+            case OpcodePrefix::Brtrue_s:       return "brtrue.s";
+            case OpcodePrefix::Beq_s:          return "beq.s";
+            case OpcodePrefix::Bge_s:          return "bge.s";
+            case OpcodePrefix::Bgt_s:          return "bgt.s";
+            case OpcodePrefix::Ble_s:          return "ble.s";
+            case OpcodePrefix::Blt_s:          return "blt.s";
+            case OpcodePrefix::Bne_un_s:       return "bne.un.s";
+            case OpcodePrefix::Bge_un_s:       return "bge.un.s";
+            case OpcodePrefix::Bgt_un_s:       return "bgt.un.s";
+            case OpcodePrefix::Ble_un_s:       return "ble.un.s";
+            case OpcodePrefix::Blt_un_s:       return "blt.un.s";
+            case OpcodePrefix::Br:             return "br";
+            case OpcodePrefix::Brfalse:        return "brfalse";
+            case OpcodePrefix::Brtrue:         return "brtrue";
+            case OpcodePrefix::Beq:            return "beq";
+            case OpcodePrefix::Bge:            return "bge";
+            case OpcodePrefix::Bgt:            return "bgt";
+            case OpcodePrefix::Ble:            return "ble";
+            case OpcodePrefix::Blt:            return "blt";
+            case OpcodePrefix::Bne_un:         return "bne.un";
+            case OpcodePrefix::Bge_un:         return "bge.un";
+            case OpcodePrefix::Bgt_un:         return "bgt.un";
+            case OpcodePrefix::Ble_un:         return "ble.un";
+            case OpcodePrefix::Blt_un:         return "blt.un";
+            case OpcodePrefix::Swtch:          return "switch";
+            case OpcodePrefix::Ldind_i1:       return "ldind.i1";
+            case OpcodePrefix::Ldind_u1:       return "ldind.u1";
+            case OpcodePrefix::Ldind_i2:       return "ldind.i2";
+            case OpcodePrefix::Ldind_u2:       return "ldind.u2";
+            case OpcodePrefix::Ldind_i4:       return "ldind.i4";
+            case OpcodePrefix::Ldind_u4:       return "ldind.u4";
+            case OpcodePrefix::Ldind_i8:       return "ldind.i8";
+            case OpcodePrefix::Ldind_i:        return "ldind.i";
+            case OpcodePrefix::Ldind_r4:       return "ldind.r4";
+            case OpcodePrefix::Ldind_r8:       return "ldind.r8";
+            case OpcodePrefix::Ldind_ref:      return "ldind.ref";
+            case OpcodePrefix::Stind_ref:      return "stind.ref";
+            case OpcodePrefix::Stind_i1:       return "stind.i1";
+            case OpcodePrefix::Stind_i2:       return "stind.i2";
+            case OpcodePrefix::Stind_i4:       return "stind.i4";
+            case OpcodePrefix::Stind_i8:       return "stind.i8";
+            case OpcodePrefix::Stind_r4:       return "stind.r4";
+            case OpcodePrefix::Stind_r8:       return "stind.r8";
+            case OpcodePrefix::Add:            return "add";
+            case OpcodePrefix::Sub:            return "sub";
+            case OpcodePrefix::Mul:            return "mul";
+            case OpcodePrefix::Div:            return "div";
+            case OpcodePrefix::Div_un:         return "div.un";
+            case OpcodePrefix::Rem:            return "rem";
+            case OpcodePrefix::Rem_un:         return "rem.un";
+            case OpcodePrefix::Logical_and:    return "and";
+            case OpcodePrefix::Logical_or:     return "or";
+            case OpcodePrefix::Logical_xor:    return "xor";
+            case OpcodePrefix::Shl:            return "shl";
+            case OpcodePrefix::Shr:            return "shr";
+            case OpcodePrefix::Shr_un:         return "shr.un";
+            case OpcodePrefix::Neg:            return "neg";
+            case OpcodePrefix::Logical_not:    return "not";
+            case OpcodePrefix::Conv_i1:        return "conv.i1";
+            case OpcodePrefix::Conv_i2:        return "conv.i2";
+            case OpcodePrefix::Conv_i4:        return "conv.i4";
+            case OpcodePrefix::Conv_i8:        return "conv.i8";
+            case OpcodePrefix::Conv_r4:        return "conv.r4";
+            case OpcodePrefix::Conv_r8:        return "conv.r8";
+            case OpcodePrefix::Conv_u4:        return "conv.u4";
+            case OpcodePrefix::Conv_u8:        return "conv.u8";
+            case OpcodePrefix::Callvirt:       return "callvirt";
+            case OpcodePrefix::Cpobj:          return "cpobj";
+            case OpcodePrefix::Ldobj:          return "ldobj";
+            case OpcodePrefix::Ldstr:          return "ldstr";
+            case OpcodePrefix::Newobj:         return "newobj";
+            case OpcodePrefix::Castclass:      return "castclass";
+            case OpcodePrefix::Isinst:         return "isinst";
+            case OpcodePrefix::Conv_r_un:      return "conv.r.un";
+            case OpcodePrefix::Unbox:          return "unbox";
+            case OpcodePrefix::Thrw:           return "throw";
+            case OpcodePrefix::Ldfld:          return "ldfld";
+            case OpcodePrefix::Ldflda:         return "ldflda";
+            case OpcodePrefix::Stfld:          return "stfld";
+            case OpcodePrefix::Ldsfld:         return "ldsfld";
+            case OpcodePrefix::Ldsflda:        return "ldsflda";
+            case OpcodePrefix::Stsfld:         return "stsfld";
+            case OpcodePrefix::Stobj:          return "stobj";
+            case OpcodePrefix::Conv_ovf_i1_un: return "conv.ovf.i1.un";
+            case OpcodePrefix::Conv_ovf_i2_un: return "conv.ovf.i2.un";
+            case OpcodePrefix::Conv_ovf_i4_un: return "conv.ovf.i4.un";
+            case OpcodePrefix::Conv_ovf_i8_un: return "conv.ovf.i8.un";
+            case OpcodePrefix::Conv_ovf_u1_un: return "conv.ovf.u1.un";
+            case OpcodePrefix::Conv_ovf_u2_un: return "conv.ovf.u2.un";
+            case OpcodePrefix::Conv_ovf_u4_un: return "conv.ovf.u4.un";
+            case OpcodePrefix::Conv_ovf_u8_un: return "conv.ovf.u8.un";
+            case OpcodePrefix::Conv_ovf_i_un:  return "conv.ovf.i.un";
+            case OpcodePrefix::Conv_ovf_u_un:  return "conv.ovf.u.un";
+            case OpcodePrefix::Box:            return "box";
+            case OpcodePrefix::Newarr:         return "newarr";
+            case OpcodePrefix::Ldlen:          return "ldlen";
+            case OpcodePrefix::Ldelema:        return "ldelema";
+            case OpcodePrefix::Ldelem_i1:      return "ldelem.i1";
+            case OpcodePrefix::Ldelem_u1:      return "ldelem.u1";
+            case OpcodePrefix::Ldelem_i2:      return "ldelem.i2";
+            case OpcodePrefix::Ldelem_u2:      return "ldelem.u2";
+            case OpcodePrefix::Ldelem_i4:      return "ldelem.i4";
+            case OpcodePrefix::Ldelem_u4:      return "ldelem.u4";
+            case OpcodePrefix::Ldelem_i8:      return "ldelem.i8";
+            case OpcodePrefix::Ldelem_i:       return "ldelem.i";
+            case OpcodePrefix::Ldelem_r4:      return "ldelem.r4";
+            case OpcodePrefix::Ldelem_r8:      return "ldelem.r8";
+            case OpcodePrefix::Ldelem_ref:     return "ldelem.ref";
+            case OpcodePrefix::Stelem_i:       return "stelem.i";
+            case OpcodePrefix::Stelem_i1:      return "stelem.i1";
+            case OpcodePrefix::Stelem_i2:      return "stelem.i2";
+            case OpcodePrefix::Stelem_i4:      return "stelem.i4";
+            case OpcodePrefix::Stelem_i8:      return "stelem.i8";
+            case OpcodePrefix::Stelem_r4:      return "stelem.r4";
+            case OpcodePrefix::Stelem_r8:      return "stelem.r8";
+            case OpcodePrefix::Stelem_ref:     return "stelem.ref";
+            case OpcodePrefix::Ldelem:         return "ldelem";
+            case OpcodePrefix::Stelem:         return "stelem";
+            case OpcodePrefix::Unbox_any:      return "unbox.any";
+            case OpcodePrefix::Conv_ovf_i1:    return "conv.ovf.i1";
+            case OpcodePrefix::Conv_ovf_u1:    return "conv.ovf.u1";
+            case OpcodePrefix::Conv_ovf_i2:    return "conv.ovf.i2";
+            case OpcodePrefix::Conv_ovf_u2:    return "conv.ovf.u2";
+            case OpcodePrefix::Conv_ovf_i4:    return "conv.ovf.i4";
+            case OpcodePrefix::Conv_ovf_u4:    return "conv.ovf.u4";
+            case OpcodePrefix::Conv_ovf_i8:    return "conv.ovf.i8";
+            case OpcodePrefix::Conv_ovf_u8:    return "conv.ovf.u8";
+            case OpcodePrefix::Refanyval:      return "refanyval";
+            case OpcodePrefix::Ckfinite:       return "ckfinite";
+            case OpcodePrefix::Mkrefany:       return "mkrefany";
+            case OpcodePrefix::Ldtoken:        return "ldtoken";
+            case OpcodePrefix::Conv_u2:        return "conv.u2";
+            case OpcodePrefix::Conv_u1:        return "conv.u1";
+            case OpcodePrefix::Conv_i:         return "conv.i";
+            case OpcodePrefix::Conv_ovf_i:     return "conv.ovf.i";
+            case OpcodePrefix::Conv_ovf_u:     return "conv.ovf.u";
+            case OpcodePrefix::Add_ovf:        return "add.ovf";
+            case OpcodePrefix::Add_ovf_un:     return "add.ovf.un";
+            case OpcodePrefix::Mul_ovf:        return "mul.ovf";
+            case OpcodePrefix::Mul_ovf_un:     return "mul.ovf.un";
+            case OpcodePrefix::Sub_ovf:        return "sub.ovf";
+            case OpcodePrefix::Sub_ovf_un:     return "sub.ovf.un";
+            case OpcodePrefix::Endfinally:     return "endfinally";
+            case OpcodePrefix::Leave:          return "leave";
+            case OpcodePrefix::Leave_s:        return "leave.s";
+            case OpcodePrefix::Stind_i:        return "stind.i";
+            case OpcodePrefix::Conv_u:         return "conv.u";
+            case OpcodePrefix::Ldelem_i1_unchecked:     return "ldelem.i1.unchecked";
+            case OpcodePrefix::Ldelem_u1_unchecked:     return "ldelem.u1.unchecked";
+            case OpcodePrefix::Ldelem_i2_unchecked:     return "ldelem.i2.unchecked";
+            case OpcodePrefix::Ldelem_u2_unchecked:     return "ldelem.u2.unchecked";
+            case OpcodePrefix::Ldelem_i4_unchecked:     return "ldelem.i4.unchecked";
+            case OpcodePrefix::Ldelem_u4_unchecked:     return "ldelem.u4.unchecked";
+            case OpcodePrefix::Ldelem_i8_unchecked:     return "ldelem.i8.unchecked";
+            case OpcodePrefix::Ldelem_i_unchecked:      return "ldelem.i.unchecked";
+            case OpcodePrefix::Ldelem_r4_unchecked:     return "ldelem.r4.unchecked";
+            case OpcodePrefix::Ldelem_r8_unchecked:     return "ldelem.r8.unchecked";
+            case OpcodePrefix::Ldelem_ref_unchecked:    return "ldelem.ref.unchecked";
+            case OpcodePrefix::Stelem_i_unchecked:      return "stelem.i.unchecked";
+            case OpcodePrefix::Stelem_i1_unchecked:     return "stelem.i1.unchecked";
+            case OpcodePrefix::Stelem_i2_unchecked:     return "stelem.i2.unchecked";
+            case OpcodePrefix::Stelem_i4_unchecked:     return "stelem.i4.unchecked";
+            case OpcodePrefix::Stelem_i8_unchecked:     return "stelem.i8.unchecked";
+            case OpcodePrefix::Stelem_r4_unchecked:     return "stelem.r4.unchecked";
+            case OpcodePrefix::Stelem_r8_unchecked:     return "stelem.r8.unchecked";
+            case OpcodePrefix::Stelem_ref_unchecked:    return "stelem.ref.unchecked";
+            case OpcodePrefix::Ldelem_unchecked:        return "ldelem.unchecked";
+            case OpcodePrefix::Stelem_unchecked:        return "stelem.unchecked";
+            case OpcodePrefix::Call_intrinsic:          return "call.intrinsic";
+            case OpcodePrefix::Arglist:        return "arglist";
+            case OpcodePrefix::Ceq:            return "ceq";
+            case OpcodePrefix::Cgt:            return "cgt";
+            case OpcodePrefix::Cgt_un:         return "cgt.un";
+            case OpcodePrefix::Clt:            return "clt";
+            case OpcodePrefix::Clt_un:         return "clt.un";
+            case OpcodePrefix::Ldftn:          return "ldftn";
+            case OpcodePrefix::Ldvirtftn:      return "ldvirtftn";
+            case OpcodePrefix::Ldarg:          return "ldarg";
+            case OpcodePrefix::Ldarga:         return "ldarga";
+            case OpcodePrefix::Starg:          return "starg";
+            case OpcodePrefix::Ldloc:          return "ldloc";
+            case OpcodePrefix::Ldloca:         return "ldloca";
+            case OpcodePrefix::Stloc:          return "stloc";
+            case OpcodePrefix::Localloc:       return "localloc";
+            case OpcodePrefix::Endfilter:      return "endfilter";
+            case OpcodePrefix::Unaligned:      return "unaligned.";
+            case OpcodePrefix::Volatle:        return "volatile.";
+            case OpcodePrefix::Tail:           return "tail.";
+            case OpcodePrefix::Initobj:        return "initobj";
+            case OpcodePrefix::Constrained:    return "constrained.";
+            case OpcodePrefix::Cpblk:          return "cpblk";
+            case OpcodePrefix::Initblk:        return "initblk";
+            case OpcodePrefix::No:             return "no.";
+            case OpcodePrefix::Rethrow:        return "rethrow";
+            case OpcodePrefix::Size_of:        return "sizeof";
+            case OpcodePrefix::Refanytype:     return "refanytype";
+            case OpcodePrefix::Readonly:       return "readonly.";
+            default:
+                return "unknown";
+        }
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace ili {
+
+    struct OutputChunk {
+        const char *data;
+        size_t size;
+    };
+
+    // Destination for everything the interpreted program prints. Chunks passed to a single write call should end
+    // up in the destination in one go where possible
+    class OutputSink {
+    public:
+        virtual ~OutputSink() = default;
+
+        virtual bool write(const OutputChunk *chunks, size_t numChunks) = 0;
+        virtual bool isInteractive() { return false; }
+    };
+
+    class FileDescriptorSink : public OutputSink {
+    public:
+        explicit FileDescriptorSink(int fd, bool closeOnDestruction = false);
+        ~FileDescriptorSink() override;
+
+        bool write(const OutputChunk *chunks, size_t numChunks) override;
+        bool isInteractive() override;
+
+    private:
+        int m_fd;
+        bool m_closeOnDestruction;
+    };
+
+    class MemorySink : public OutputSink {
+    public:
+        bool write(const OutputChunk *chunks, size_t numChunks) override;
+
+        const std::string& getContents();
+        void clear();
+
+    private:
+        std::string m_contents;
+    };
+
+    enum class FlushPolicy : u8 {
+        Full,       // Only flush once the buffer is full, on explicit flushes and on exit
+        Line        // Additionally flush after every completed line
+    };
+
+    class OutputBuffer {
+    public:
+        static constexpr size_t DefaultCapacity = 64 * 1024;
+
+        // Without a sink, output goes to stdout and is line buffered if that's a terminal
+        explicit OutputBuffer(std::unique_ptr<OutputSink> sink = nullptr, size_t capacity = DefaultCapacity);
+        ~OutputBuffer();
+
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        void setSink(std::unique_ptr<OutputSink> sink);
+        OutputSink* getSink();
+        void setFlushPolicy(FlushPolicy policy);
+
+        void write(std::string_view string);
+        void write(std::u16string_view string);
+        void write(char character);
+        void writeLine();
+
+        // Hands out space for up to size bytes of output, which gets added to the buffer by commit
+        char* reserve(size_t size);
+        void commit(size_t size);
+
+        void flush();
+
+    private:
+        void writeThrough(std::string_view string);
+        void lineCompleted();
+
+        std::unique_ptr<OutputSink> m_sink;
+        std::unique_ptr<char[]> m_buffer;
+        size_t m_capacity;
+        size_t m_size = 0;
+        FlushPolicy m_flushPolicy;
+    };
+
+}
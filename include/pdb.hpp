@@ -0,0 +1,63 @@
+#pragma once
+
+#include "types.hpp"
+#include "mapped_file.hpp"
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ili {
+
+#define PDB_TABLE_ID_DOCUMENT                   0x30
+#define PDB_TABLE_ID_METHOD_DEBUG_INFORMATION   0x31
+
+    struct SourceLocation {
+        std::string document;
+        u32 line;
+    };
+
+    // Reader for the line information in portable PDBs, the debug symbol format the .NET SDK produces by default
+    class PortablePDB {
+    public:
+        bool open(const std::string &path);
+        bool isOpen();
+
+        // Location of the sequence point an IL offset belongs to, if it has one that isn't hidden
+        std::optional<SourceLocation> getSourceLocation(u32 methodToken, u32 ilOffset);
+
+    private:
+        struct SequencePoint {
+            u32 ilOffset;
+            u32 document;
+            u32 line;
+        };
+
+        static constexpr u32 HiddenLine = 0x00FE'EFEE;
+
+        const std::vector<SequencePoint>& getSequencePoints(u32 methodToken);
+        const std::string& getDocumentName(u32 document);
+
+        u32 readIndex(const u8 *data, bool wide);
+        const u8* getBlob(u32 index, u32 &size);
+
+        MappedFile m_file;
+
+        const u8 *m_blobHeap = nullptr;
+        bool m_wideGuidIndices = false;
+        bool m_wideBlobIndices = false;
+
+        const u8 *m_documents = nullptr;
+        u32 m_numDocuments = 0;
+        u32 m_documentRowSize = 0;
+
+        const u8 *m_methodDebugInformation = nullptr;
+        u32 m_numMethodDebugInformation = 0;
+        u32 m_methodDebugInformationRowSize = 0;
+
+        std::unordered_map<u32, std::vector<SequencePoint>> m_sequencePoints;
+        std::unordered_map<u32, std::string> m_documentNames;
+    };
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+#include <string>
+
+namespace ili {
+
+    enum class PerfEvent : u8 {
+        Instructions,
+        Cycles,
+        BranchMisses,
+        L1DMisses,
+        LLCMisses,
+        DTLBMisses,
+
+        Count
+    };
+
+    using PerfCounterValues = std::array<u64, static_cast<size_t>(PerfEvent::Count)>;
+
+    // Hardware performance counters of the calling thread, read through perf_event_open on Linux. Events the CPU
+    // or the kernel don't support are left out. Only user space is counted so this works without privileges
+    class PerfCounters {
+    public:
+        PerfCounters() = default;
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        bool open();
+        void close();
+
+        bool isOpen() const { return this->m_groupFd >= 0; }
+        bool isAvailable(PerfEvent event) const { return this->m_fds[static_cast<size_t>(event)] >= 0; }
+
+        void start();
+        void stop();
+
+        // Current counts since start, scaled up if the kernel had to multiplex the counters
+        bool read(PerfCounterValues &values);
+
+        static const char* getEventName(PerfEvent event);
+
+        // Writes counts and derived metrics as a flat JSON object. Metrics relating to IL instructions are left
+        // out if none were counted
+        bool writeReport(const std::string &path, const PerfCounterValues &values, u64 ilInstructions);
+
+    private:
+        int m_groupFd = -1;
+        std::array<int, static_cast<size_t>(PerfEvent::Count)> m_fds = { -1, -1, -1, -1, -1, -1 };
+        std::array<u8, static_cast<size_t>(PerfEvent::Count)> m_readIndices = { };     // Position in the group read
+        u8 m_numOpened = 0;
+    };
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "types.hpp"
+#include "signature.hpp"
+#include "exceptions.hpp"
+#include "opcode.hpp"
+#include "value_types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+namespace ili {
+
+    class DLL;
+    class Metrics;
+
+    struct PreparedMethod;
+
+    // What a call through a MemberRef or MethodSpec ends up at, either an instantiation of a generic method of the
+    // program or a native
+    struct CalleeBinding {
+        PreparedMethod *instantiation = nullptr;
+        std::function<void()> *native = nullptr;
+    };
+
+    struct PreparedMethod {
+        u32 token = 0;
+
+        u8 *code = nullptr;
+        u32 codeSize = 0;
+        u16 maxStack = 0;
+        u32 localVarSigToken = 0;
+        u16 numLocals = 0;          // One more than the highest local index the code uses
+        u32 localsSize = 0;         // Bytes between the frame header and the evaluation stack
+        u32 stackSlotSize = sizeof(u64);    // Room the evaluation stack needs per value, vectors and structs are wider
+
+        // Vectors don't fit into the slot a local has, so these point at storage behind the other locals
+        std::vector<u16> vectorLocals;
+        // Same for structs, by where their storage starts relative to the first local
+        std::vector<std::pair<u16, u32>> valueTypeLocals;
+        std::vector<const TypeLayout*> localLayouts;    // By local, nullptr for everything but structs
+        // Declared stack type of every local, for the ones written through their address before being stored to
+        std::vector<Type> localTypes;
+
+        MethodSignature signature;
+        bool verified = false;
+
+        // In the order of the method body, which puts nested clauses before the ones enclosing them. That's the
+        // order the handler search needs, so nothing gets sorted
+        std::vector<ExceptionClause> exceptionClauses;
+
+        // MethodDefs referenced through call, callvirt, newobj, jmp, ldftn and ldvirtftn
+        std::vector<u32> callees;
+
+        // Type arguments of an instantiation of a generic method, with every reference type replaced by object.
+        // Empty for everything else
+        GenericContext genericContext;
+        // Tokens in the code of an instantiation can refer to its type arguments, so it binds its callees on its own.
+        // Filled in by the interpreter on the first call through each token
+        std::unordered_map<u32, CalleeBinding> calleeBindings;
+        // Fields of generic types are laid out differently in every instantiation, so it binds its fields on its own as well
+        std::unordered_map<u32, const FieldLayout*> fieldBindings;
+        std::unordered_map<u32, ValueLayout> valueLayouts;
+
+        // Methods with rewritten instructions run from their own copy of the IL so it can be changed without
+        // touching the DLL
+        std::unique_ptr<u8[]> ownedCode;
+    };
+
+    class Preparer {
+    public:
+        explicit Preparer(DLL *dll);
+        ~Preparer();
+
+        PreparedMethod* getPreparedMethod(u32 methodToken);
+        PreparedMethod* prepareInstantiation(u32 methodToken, const GenericContext &genericContext);
+
+        void addRoot(u32 methodToken);
+        bool isReachable(u32 methodToken);
+
+        void setMetrics(Metrics *metrics);
+
+        void startBackgroundPreparation(u32 numWorkers = 0);
+        void stopBackgroundPreparation();
+
+    private:
+        PreparedMethod* prepare(u32 methodToken, const GenericContext *genericContext = nullptr);
+        bool verify(PreparedMethod *method);
+        u32 getValueWidth(PreparedMethod *method, OpcodePrefix opcode, u32 token);
+        bool layOutLocals(PreparedMethod *method);
+        u32 eliminateBoundsChecks(PreparedMethod *method);
+        u32 replaceIntrinsics(PreparedMethod *method);
+        void install(u32 methodToken, PreparedMethod *preparedMethod);
+        void markReachable(std::span<const u32> methodTokens);
+        void backgroundWorker();
+
+        DLL *m_dll;
+        Metrics *m_metrics = nullptr;
+
+        std::vector<std::atomic<PreparedMethod*>> m_preparedMethods;
+
+        // Everything below is guarded by m_mutex
+        std::mutex m_mutex;
+        std::vector<bool> m_reachable;
+        std::deque<u32> m_reachableWorklist;
+        std::vector<PreparedMethod*> m_instantiatedMethods;
+        std::condition_variable m_worklistSignal;
+        std::vector<std::thread> m_workers;
+        bool m_stopWorkers = false;
+    };
+
+}
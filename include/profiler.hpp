@@ -0,0 +1,124 @@
+#pragma once
+
+#include "types.hpp"
+#include "perf_counters.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+namespace ili {
+
+    class DLL;
+
+    // Instrumenting profiler for the interpreter loop. Every executed instruction and every call is timestamped, so
+    // this is only ever active when asked for. Times are in timestamp counter ticks
+    class Profiler {
+    public:
+        static constexpr u16 NumOpcodes = 0x200;   // One byte opcodes followed by the ones prefixed with 0xFE
+
+        struct OpcodeStats {
+            u64 count = 0;
+            u64 cycles = 0;
+        };
+
+        struct MethodStats {
+            u64 calls = 0;
+            u64 inclusiveCycles = 0;
+            u64 exclusiveCycles = 0;
+            u32 activeCalls = 0;                            // Recursive calls only count towards inclusive time once
+            u64 instructions = 0;                           // IL instructions executed in this method itself
+            PerfCounterValues counters = { };               // Exclusive, only collected with hardware counters set
+            std::unordered_map<u64, u64> callSites;         // (caller token << 32 | IL offset) -> number of calls
+        };
+
+        explicit Profiler(DLL *dll);
+
+        // Additionally attributes hardware counter values to methods. Reading them on every call and return is
+        // expensive, the counts include that overhead
+        void setPerfCounters(PerfCounters *counters);
+
+        static u64 readTimestamp() {
+        #if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+        #else
+            return std::chrono::steady_clock::now().time_since_epoch().count();
+        #endif
+        }
+
+        // Called right before an instruction executes. Whatever ran since the previous call is charged to the previous instruction
+        void beginInstruction(u16 opcode, u32 offset) {
+            u64 now = readTimestamp();
+            auto &frame = this->m_frames.back();
+
+            this->closeInstruction(frame, now);
+
+            frame.instructions++;
+            frame.opcode = opcode;
+            frame.instructionStart = now;
+            frame.instructionChildCycles = 0;
+            frame.instructionOffset = offset;
+        }
+
+        // Tokens are either MethodDefs or MemberRefs of native methods
+        void enterMethod(u32 token);
+        void exitMethod();
+
+        const OpcodeStats& getOpcodeStats(u16 opcode) const { return this->m_opcodes[opcode]; }
+        const std::unordered_map<u32, MethodStats>& getMethodStats() const { return this->m_methods; }
+
+        // Type qualified name of a MethodDef, or the full name of a native method
+        static std::string getMethodName(DLL *dll, u32 token);
+
+        bool writeReport(const std::string &path);
+        bool writeCollapsedStacks(const std::string &path);
+
+    private:
+        static constexpr u16 NoOpcode = 0xFFFF;
+
+        struct Frame {
+            u32 token;
+            u64 start;
+            u64 childCycles;
+            u64 instructions;
+
+            PerfCounterValues startCounters;
+            PerfCounterValues childCounters;
+
+            u16 opcode;
+            u64 instructionStart;
+            u64 instructionChildCycles;
+            u32 instructionOffset;
+        };
+
+        void writePerfCounterReport(FILE *file, std::vector<std::pair<u32, const MethodStats*>> &methods);
+
+        void closeInstruction(Frame &frame, u64 now) {
+            if (frame.opcode == NoOpcode)
+                return;
+
+            auto &stats = this->m_opcodes[frame.opcode];
+            stats.count++;
+            stats.cycles += now - frame.instructionStart - frame.instructionChildCycles;
+        }
+
+        DLL *m_dll;
+        PerfCounters *m_perfCounters = nullptr;
+
+        OpcodeStats m_opcodes[NumOpcodes];
+        std::unordered_map<u32, MethodStats> m_methods;
+        std::vector<Frame> m_frames;
+        std::map<std::vector<u32>, u64> m_stacks;     // Call stack -> exclusive time spent with it on top
+        std::vector<u32> m_currentStack;
+    };
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "types.hpp"
+#include "pdb.hpp"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ili {
+
+    struct Context;
+
+    // Statistical profiler. A timer periodically interrupts the interpreter thread and the signal handler copies the
+    // chain of interpreter frames into a ring buffer, which gets aggregated on a separate thread
+    class Sampler {
+    public:
+        static constexpr u32 DefaultFrequency = 997;   // Prime so samples don't line up with periodic behaviour
+        static constexpr u32 MaxDepth = 64;
+
+        // Line information is taken from the portable PDB next to the assembly if there is one
+        Sampler(Context &ctx, const std::string &assemblyPath);
+        ~Sampler();
+
+        Sampler(const Sampler&) = delete;
+        Sampler& operator=(const Sampler&) = delete;
+
+        // Must be called from the thread that runs the interpreter
+        bool start(u32 frequency = DefaultFrequency);
+        void stop();
+
+        u64 getNumSamples();
+        u64 getNumDroppedSamples();
+
+        bool writeCollapsedStacks(const std::string &path);
+        bool writeProfile(const std::string &path);     // pprof protobuf format
+
+    private:
+        struct Sample {
+            u32 depth;
+            u64 frames[MaxDepth];       // Method token << 32 | IL offset, innermost frame first
+        };
+
+        struct SampleRing {
+            static constexpr u32 NumSlots = 0x400;
+
+            std::atomic<u64> head = 0;
+            std::atomic<u64> tail = 0;
+            Sample slots[NumSlots];
+        };
+
+        static void handleSignal(int signal);
+        void takeSample();
+        void drainSamples();
+        void aggregationWorker();
+
+        std::string getFrameName(u64 frame);
+
+        Context &m_ctx;
+        PortablePDB m_pdb;
+        u32 m_frequency = DefaultFrequency;
+
+        std::unique_ptr<SampleRing> m_ring;
+        std::atomic<u64> m_droppedSamples = 0;
+        u64 m_numSamples = 0;
+        std::map<std::vector<u64>, u64> m_stacks;      // Frames, innermost first -> number of samples
+
+        std::thread m_aggregationThread;
+        std::atomic<bool> m_running = false;
+        void *m_timer = nullptr;
+        u64 m_interpreterThread = 0;
+
+        static std::atomic<Sampler*> s_activeSampler;
+    };
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <span>
+#include <vector>
+
+namespace ili {
+
+    struct TypeLayout;
+
+    typedef struct {
+        Type type;                  // How the argument is represented on the evaluation stack
+        u32 offset;                 // Byte offset from the first argument
+        const TypeLayout *valueType = nullptr;  // Structs passed by value, they take up their size plus the size word
+    } parameter_t;
+
+    // The type arguments of a generic instantiation as blobs, so Var and MVar in a signature can be resolved
+    struct GenericContext {
+        std::vector<std::span<const u8>> typeArguments;     // !0, !1, ... from the TypeSpec of the parent type
+        std::vector<std::span<const u8>> methodArguments;   // !!0, !!1, ... from the MethodSpec
+
+        bool empty() const { return this->typeArguments.empty() && this->methodArguments.empty(); }
+    };
+
+    // A MethodDefSig decoded into what calling the method needs. The implicit this is the first parameter
+    struct MethodSignature {
+        bool hasThis = false;
+        Type returnType = Type::Invalid;    // Invalid for void
+        const TypeLayout *returnValueType = nullptr;
+        std::vector<parameter_t> parameters;
+        u32 argumentsSize = 0;              // Bytes the arguments take up on the evaluation stack
+
+        u16 getNumParameters() const { return this->parameters.size(); }
+        bool returnsValue() const { return this->returnType != Type::Invalid; }
+    };
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "types.hpp"
+#include "allocation_tracker.hpp"
+
+#include <string>
+
+namespace ili {
+
+    typedef struct PACKED {
+        char magic[4];              // ILIS
+        u32 version;
+        u8 mvid[16];
+        u64 fileHash;
+
+        u64 heapBase;               // Address of the heap when the snapshot was taken
+        u64 heapSize;
+        u64 heapUsed;
+
+        u32 numHeapReferences;
+        u32 numStatics;
+        u32 numFixups;
+        u32 numBindings;
+        u32 numInternedStrings;
+
+        u64 heapReferencesOffset;   // snapshot_heap_reference_t[numHeapReferences]
+        u64 staticsOffset;          // snapshot_static_t[numStatics]
+        u64 fixupsOffset;           // snapshot_fixup_t[numFixups]
+        u64 bindingsOffset;         // u32[numBindings], MemberRef and MethodSpec tokens
+        u64 internedStringsOffset;  // snapshot_interned_string_t[numInternedStrings]
+        u64 heapImageOffset;        // Aligned to Snapshot::ImageAlignment so it can be mapped directly
+    } snapshot_header_t;
+
+    typedef struct PACKED {
+        u64 offset;
+        u64 size;
+        u32 typeToken;
+        AllocationKind kind;
+    } snapshot_heap_reference_t;
+
+    typedef struct PACKED {
+        Type type;
+        u64 value;
+    } snapshot_static_t;
+
+    typedef struct PACKED {
+        u32 userStringIndex;        // Offset into the #US heap
+        u64 offset;                 // Offset of the string object from the start of the heap
+    } snapshot_interned_string_t;
+
+    enum class SnapshotRegion : u8 {
+        Heap    = 0,
+        Statics = 1
+    };
+
+    typedef struct PACKED {
+        SnapshotRegion region;
+        u64 offset;                 // Byte offset into the heap or index into the statics
+    } snapshot_fixup_t;
+
+    struct Context;
+
+    class Snapshot {
+    public:
+        static constexpr u32 Version = 5;
+        static constexpr u64 ImageAlignment = 0x10000;
+
+        static bool capture(Context &ctx, const std::string &path);
+        static bool restore(Context &ctx, const std::string &path);
+    };
+
+}
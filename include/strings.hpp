@@ -0,0 +1,53 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace ili {
+
+    // Layout of a System.String on the managed heap. The UTF-16 payload follows the header directly and is
+    // always null terminated so it can be handed to native code without copying
+    typedef struct PACKED {
+        u32 length;                 // In UTF-16 code units, excluding the terminator
+        u32 hash;                   // 0 until Strings::getHash was called the first time
+    } string_object_t;
+    static_assert(sizeof(string_object_t) == 0x08, "string_object_t size invalid!");
+
+    // Characters behind a System.Text.StringBuilder, which itself only holds a pointer to this. Also lives on the
+    // managed heap and grows in place for as long as nothing else got allocated after it
+    typedef struct PACKED {
+        u32 length;                 // In UTF-16 code units
+        u32 capacity;
+    } string_buffer_t;
+    static_assert(sizeof(string_buffer_t) == 0x08, "string_buffer_t size invalid!");
+
+    struct Context;
+
+    class Strings {
+    public:
+        static string_object_t* create(Context &ctx, std::u16string_view value);
+        static string_object_t* createFromUTF8(Context &ctx, std::string_view value);
+
+        // Returns the one string object every ldstr of the given #US token shares
+        static string_object_t* intern(Context &ctx, u32 userStringToken);
+
+        static char16_t* getData(string_object_t *string);
+        static std::u16string_view getView(string_object_t *string);
+        static u32 getHash(string_object_t *string);
+        static std::string toUTF8(string_object_t *string);
+
+        static bool equals(string_object_t *left, string_object_t *right);
+        // Ordinal searches, -1 if there's no match at or after start
+        static s32 indexOf(std::u16string_view string, char16_t character, u32 start = 0);
+        static s32 indexOf(std::u16string_view string, std::u16string_view value, u32 start = 0);
+
+        static string_buffer_t* createBuffer(Context &ctx, u32 capacity);
+        static char16_t* getData(string_buffer_t *buffer);
+        static std::u16string_view getView(string_buffer_t *buffer);
+        // Moves the buffer if it has to grow and can't do so in place, so the pointer to it gets updated
+        static void append(Context &ctx, string_buffer_t *&buffer, std::u16string_view value);
+    };
+
+}
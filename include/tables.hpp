@@ -10,9 +10,13 @@ namespace ili {
 #define TABLE_ID_TYPEREF        0x01
 #define TABLE_ID_TYPEDEF        0x02
 #define TABLE_ID_MEMBERREF      0x0A
+#define TABLE_ID_INTERFACEIMPL  0x09
 #define TABLE_ID_CLASS_LAYOUT   0x0F
 #define TABLE_ID_MODULE         0x00
 #define TABLE_ID_FIELD          0x04
+#define TABLE_ID_TYPESPEC       0x1B
+#define TABLE_ID_STANDALONESIG  0x11
+#define TABLE_ID_METHODSPEC     0x2B
 
     typedef struct PACKED { // 0x06
         u32 rva;
@@ -64,6 +68,11 @@ namespace ili {
         u16 encBaseId;
     } table_module_t;
 
+    typedef struct PACKED { // 0x09
+        u16 classIndex;
+        u16 interfaceIndex;
+    } table_interface_impl_t;
+
     typedef struct PACKED { // 0x0F
         u16 packingSize;
         u32 classSize;
@@ -76,6 +85,19 @@ namespace ili {
         u16 signatureIndex;
     } table_field_t;
 
+    typedef struct PACKED { // 0x11
+        u16 signatureIndex;
+    } table_stand_alone_sig_t;
+
+    typedef struct PACKED { // 0x1B
+        u16 signatureIndex;
+    } table_type_spec_t;
+
+    typedef struct PACKED { // 0x2B
+        u16 methodIndex;
+        u16 instantiationIndex;
+    } table_method_spec_t;
+
 #define TYPE_DEF_OR_REF 2
 #define HAS_CONSTANT 2
 #define HAS_CUSTOM_ATTRIBUTE 5
@@ -90,7 +112,7 @@ namespace ili {
 #define RESOLUTION_SCOPE 2
 #define TYPE_OR_METHOD_DEF 1
 
-#define INDEX_TAG(index, tag_type) index & (0xFFFFFFFF << tag_type)
+#define INDEX_TAG(index, tag_type) ((index) & ~(0xFFFFFFFF << tag_type))
 #define INDEX_INDEX(index, tag_type) (index >> tag_type)
 
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace ili {
+
+    enum class TranscodeKernel : u8 {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // UTF-16 <-> UTF-8 conversion for every place a managed string crosses into native code. Unpaired surrogates
+    // and malformed UTF-8 sequences are replaced with U+FFFD instead of failing
+    class Transcoder {
+    public:
+        // Worst case output sizes, the destination buffers have to be at least this large
+        static constexpr size_t getMaxUTF8Size(size_t utf16Length) { return utf16Length * 3; }
+        static constexpr size_t getMaxUTF16Size(size_t utf8Length) { return utf8Length; }
+
+        // Both return the number of code units written to the destination
+        static size_t utf16ToUTF8(const char16_t *source, size_t length, char *destination);
+        static size_t utf8ToUTF16(const char *source, size_t length, char16_t *destination);
+
+        static std::string toUTF8(std::u16string_view string);
+        static std::u16string toUTF16(std::string_view string);
+
+        // The fastest kernel the CPU supports gets picked on first use. Forcing one is meant for benchmarking
+        static TranscodeKernel getKernel();
+        static bool forceKernel(TranscodeKernel kernel);
+        static const char* getKernelName(TranscodeKernel kernel);
+    };
+
+}
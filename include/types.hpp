@@ -16,7 +16,8 @@ using s64 = int64_t;
 
 using namespace std::string_literals;
 
-enum class Type : u8 {
+// Each type has a bit of its own
+enum class Type : u16 {
     Invalid                 = 0,
     Int32                   = 1,
     Int64                   = 2,
@@ -24,45 +25,47 @@ enum class Type : u8 {
     Native_unsigned_int     = 8,
     F                       = 16,
     O                       = 32,
-    Pointer                 = 64
+    Pointer                 = 64,
+    Vector                  = 128,      // Vector<T>, Vector128<T> and Vector256<T>, see VectorValue
+    ValueType               = 256       // Structs of the program, see Context::pushValueType
 };
 
 enum class SignatureElementType : u8 {
-    End,
-    Void,
-    Boolean,
-    Char,
-    I1,
-    U1,
-    I2,
-    U2,
-    I4,
-    U4,
-    I8,
-    U8,
-    R4,
-    R8,
-    String,
-    Ptr,
-    ByRef,
-    ValueType,
-    Class,
-    Var,
-    Array,
-    GenericInst,
-    TypedByRef,
-    I,
-    U,
-    FuncPtr,
-    Object,
-    SzArray,
-    MVar,
-    CmodReqd,
-    CmodOpt,
-    Internal,
-    Modifier,
-    Sentinel,
-    Pinned
+    End             = 0x00,
+    Void            = 0x01,
+    Boolean         = 0x02,
+    Char            = 0x03,
+    I1              = 0x04,
+    U1              = 0x05,
+    I2              = 0x06,
+    U2              = 0x07,
+    I4              = 0x08,
+    U4              = 0x09,
+    I8              = 0x0A,
+    U8              = 0x0B,
+    R4              = 0x0C,
+    R8              = 0x0D,
+    String          = 0x0E,
+    Ptr             = 0x0F,
+    ByRef           = 0x10,
+    ValueType       = 0x11,
+    Class           = 0x12,
+    Var             = 0x13,
+    Array           = 0x14,
+    GenericInst     = 0x15,
+    TypedByRef      = 0x16,
+    I               = 0x18,
+    U               = 0x19,
+    FuncPtr         = 0x1B,
+    Object          = 0x1C,
+    SzArray         = 0x1D,
+    MVar            = 0x1E,
+    CmodReqd        = 0x1F,
+    CmodOpt         = 0x20,
+    Internal        = 0x21,
+    Modifier        = 0x40,
+    Sentinel        = 0x41,
+    Pinned          = 0x45
 };
 
 static u8 getSignatureElementTypeSize(SignatureElementType type) {
@@ -94,6 +97,7 @@ static u8 getTypeSize(Type type) {
         case Type::F: return 8;
         case Type::O: return 8;
         case Type::Pointer: return 8;
+        case Type::Vector: return 32;
         default: return 0;
     }
 }
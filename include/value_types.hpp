@@ -0,0 +1,59 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <vector>
+
+namespace ili {
+
+    struct TypeLayout;
+
+    // Copies a value of a known size. Every size up to ValueTypes::MaxSpecializedSize has a handler of its own the
+    // compiler turns into a few moves, size is only looked at by the one for everything bigger
+    using CopyHandler = void(*)(void *destination, const void *source, u32 size);
+
+    // How a value of some type is stored in a field, an array element or behind an address
+    struct ValueLayout {
+        Type type = Type::Invalid;          // How the value is represented on the evaluation stack, Invalid if it can't be
+        SignatureElementType elementType = SignatureElementType::End;   // Tells primitives apart, ValueType for structs and Class for references
+        u32 size = 0;
+        u32 alignment = 1;
+        const TypeLayout *valueType = nullptr;  // Structs only
+    };
+
+    struct FieldLayout {
+        u32 offset = 0;                     // From the start of the object or struct, unused for static fields
+        bool isStatic = false;
+        ValueLayout value;
+    };
+
+    // Fields of a TypeDef, or of one instantiation of a generic TypeDef. Laid out in declaration order, each one
+    // aligned to its size but at most to the packing size. Objects have no header, they start with the fields of
+    // their base type
+    struct TypeLayout {
+        u32 typeToken = 0;
+        u32 size = 0;
+        u32 alignment = 1;
+        bool isValueType = false;
+        bool isEnum = false;
+        CopyHandler copy = nullptr;
+        u32 fieldListStart = 0;             // Index of the first field in the Field table
+        std::vector<FieldLayout> fields;    // Every field the type declares itself, in the order of the Field table
+        std::vector<u32> referenceOffsets;  // Of every reference and pointer in an instance, including the base type's and nested structs'
+    };
+
+    struct Context;
+
+    class ValueTypes {
+    public:
+        static constexpr u32 MaxSpecializedSize = 64;
+
+        static CopyHandler getCopyHandler(u32 size);
+
+        // Pushes the value stored at address. Primitives are widened the way ldind does, structs are copied as a whole
+        static void load(Context &ctx, const ValueLayout &layout, const u8 *address);
+        // Pops a value and stores it at address, narrowing primitives the way stind does
+        static void store(Context &ctx, const ValueLayout &layout, u8 *address);
+    };
+
+}
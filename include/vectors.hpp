@@ -0,0 +1,20 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace ili {
+
+    // A Vector<T>, Vector128<T> or Vector256<T> on the evaluation stack or in a local. Always as wide as the widest
+    // vector, the narrower ones only use the start of it and leave the rest zeroed
+    struct VectorValue {
+        u8 bytes[32];
+    };
+    static_assert(sizeof(VectorValue) == 32, "VectorValue size invalid!");
+
+    class Vectors {
+    public:
+        static bool hasAVX2();
+        static u32 getVectorSize();     // Bytes in a Vector<T>, picked from what the CPU supports
+    };
+
+}
@@ -0,0 +1,152 @@
+#include "allocation_tracker.hpp"
+
+#include "context.hpp"
+#include "dll.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace ili {
+
+    AllocationTracker::AllocationTracker(Context &ctx, u64 sampleInterval) : m_ctx(ctx), m_sampleInterval(sampleInterval), m_random(std::random_device()()) {
+        if (this->m_sampleInterval != 0)
+            this->m_bytesUntilSample = this->getNextSampleInterval();
+    }
+
+    void AllocationTracker::requestCensus() {
+        this->m_censusRequested.store(true, std::memory_order_relaxed);
+    }
+
+    void AllocationTracker::setCensusPrefix(const std::string &prefix) {
+        this->m_censusPrefix = prefix;
+    }
+
+    void AllocationTracker::record(AllocationKind kind, u32 typeToken, size_t size, double weight) {
+        u64 typeKey = getTypeKey(kind, typeToken);
+
+        // Allocations made outside of interpreted code are attributed to site 0
+        u64 site = 0;
+        if (auto frame = this->m_ctx.currentFrame; frame != nullptr)
+            site = (u64(frame->methodToken) << 32) | u32(frame->programCounter - frame->code);
+
+        auto &type = this->m_types[typeKey];
+        type.count += weight;
+        type.bytes += weight * size;
+
+        auto &allocationSite = this->m_sites[{ site, typeKey }];
+        allocationSite.count += weight;
+        allocationSite.bytes += weight * size;
+    }
+
+    // Exponentially distributed so that the sampling can't line up with a repeating allocation pattern
+    u64 AllocationTracker::getNextSampleInterval() {
+        std::exponential_distribution<double> distribution(1.0 / double(this->m_sampleInterval));
+        return std::max<u64>(1, distribution(this->m_random));
+    }
+
+    void AllocationTracker::writeRequestedCensus() {
+        this->m_censusRequested.store(false, std::memory_order_relaxed);
+
+        auto path = this->m_censusPrefix + ".census." + std::to_string(this->m_numCensuses++) + ".txt";
+        if (this->writeHeapCensus(path))
+            Logger::info("Wrote heap census to %s", path.c_str());
+        else
+            Logger::error("Cannot write heap census to %s!", path.c_str());
+    }
+
+    std::string AllocationTracker::getTypeName(AllocationKind kind, u32 typeToken) {
+        switch (kind) {
+            case AllocationKind::String:
+                return "System.String";
+            case AllocationKind::Object: {
+                auto dll = this->m_ctx.dll;
+                if (TABLE_ID(typeToken) != TABLE_ID_TYPEDEF || TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > dll->getNumTableRows(TABLE_ID_TYPEDEF))
+                    return "<unknown>";
+
+                auto typeDef = dll->getTypeDefByIndex(TABLE_INDEX(typeToken));
+                std::string nameSpace = dll->getString(typeDef->typeNamespaceIndex);
+                std::string name = dll->getString(typeDef->typeNameIndex);
+
+                return nameSpace.empty() ? name : nameSpace + "." + name;
+            }
+            case AllocationKind::Array:
+                return this->m_ctx.dll->getTypeName(typeToken) + "[]";
+            default:
+                return "<runtime>";
+        }
+    }
+
+    bool AllocationTracker::writeReport(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        if (this->m_sampleInterval != 0)
+            std::fprintf(file, "Sampled about every %llu bytes, numbers are estimates\n\n", static_cast<unsigned long long>(this->m_sampleInterval));
+
+        std::vector<std::pair<u64, AllocationStats>> types(this->m_types.begin(), this->m_types.end());
+        std::sort(types.begin(), types.end(), [](auto &a, auto &b) { return a.second.bytes > b.second.bytes; });
+
+        std::fprintf(file, "Allocations by type\n\n");
+        std::fprintf(file, "%14s %16s  %s\n", "count", "bytes", "type");
+        for (auto &[typeKey, stats] : types) {
+            std::fprintf(file, "%14.0f %16.0f  %s\n", stats.count, stats.bytes,
+                         this->getTypeName(static_cast<AllocationKind>(typeKey >> 32), typeKey & 0xFFFF'FFFF).c_str());
+        }
+
+        std::vector<std::pair<std::pair<u64, u64>, AllocationStats>> sites(this->m_sites.begin(), this->m_sites.end());
+        std::sort(sites.begin(), sites.end(), [](auto &a, auto &b) { return a.second.bytes > b.second.bytes; });
+
+        std::fprintf(file, "\nAllocations by site\n\n");
+        std::fprintf(file, "%14s %16s  %-40s %s\n", "count", "bytes", "site", "type");
+        for (auto &[key, stats] : sites) {
+            auto [site, typeKey] = key;
+
+            std::string siteName = "<runtime>";
+            if (site != 0) {
+                char offset[16];
+                std::snprintf(offset, sizeof(offset), "+IL_%04x", static_cast<u32>(site & 0xFFFF'FFFF));
+                siteName = Profiler::getMethodName(this->m_ctx.dll, site >> 32) + offset;
+            }
+
+            std::fprintf(file, "%14.0f %16.0f  %-40s %s\n", stats.count, stats.bytes, siteName.c_str(),
+                         this->getTypeName(static_cast<AllocationKind>(typeKey >> 32), typeKey & 0xFFFF'FFFF).c_str());
+        }
+
+        std::fclose(file);
+
+        return true;
+    }
+
+    // Every object on the heap is live as nothing is ever freed yet, so the census is a walk over all heap references
+    bool AllocationTracker::writeHeapCensus(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        std::unordered_map<u64, std::pair<u64, u64>> types;     // Type key -> (objects, bytes)
+        for (auto &heapReference : this->m_ctx.heapReferences) {
+            auto &[count, bytes] = types[getTypeKey(heapReference.kind, heapReference.typeToken)];
+            count++;
+            bytes += heapReference.size;
+        }
+
+        std::vector<std::pair<u64, std::pair<u64, u64>>> sortedTypes(types.begin(), types.end());
+        std::sort(sortedTypes.begin(), sortedTypes.end(), [](auto &a, auto &b) { return a.second.second > b.second.second; });
+
+        std::fprintf(file, "Live objects: %zu, heap used: %u of %zu bytes\n\n", this->m_ctx.heapReferences.size(), this->m_ctx.getUsedHeapSize(), this->m_ctx.heapSize);
+        std::fprintf(file, "%14s %16s  %s\n", "objects", "bytes", "type");
+        for (auto &[typeKey, stats] : sortedTypes) {
+            std::fprintf(file, "%14llu %16llu  %s\n", static_cast<unsigned long long>(stats.first), static_cast<unsigned long long>(stats.second),
+                         this->getTypeName(static_cast<AllocationKind>(typeKey >> 32), typeKey & 0xFFFF'FFFF).c_str());
+        }
+
+        std::fclose(file);
+
+        return true;
+    }
+
+}
@@ -0,0 +1,102 @@
+#include "arrays.hpp"
+
+#include "context.hpp"
+#include "dll.hpp"
+#include "tables.hpp"
+#include "logger.hpp"
+
+#include <limits>
+
+namespace ili {
+
+    // Elements are stored the way fields of their type are, structs and enums included
+    static array_object_t getElementLayout(u32 elementTypeToken, const ValueLayout &value) {
+        array_object_t layout = { };
+        layout.elementTypeToken = elementTypeToken;
+        layout.elementSize = sizeof(u64);
+        layout.elementType = Type::O;
+
+        if (value.type == Type::Invalid)
+            return layout;
+
+        if (value.size > std::numeric_limits<u16>::max()) {
+            Logger::error(LogCategory::Interpreter, "Cannot create an array of %u byte elements!", value.size);
+            exit(1);
+        }
+
+        layout.elementSize = value.size;
+        layout.elementType = value.type;
+
+        switch (value.elementType) {
+            case SignatureElementType::Boolean:
+            case SignatureElementType::Char:
+            case SignatureElementType::U1:
+            case SignatureElementType::U2:
+                layout.elementUnsigned = true;
+                break;
+            default:
+                break;
+        }
+
+        return layout;
+    }
+
+    static ArrayLayout getArrayLayout(DLL *dll, u32 elementTypeToken) {
+        ValueLayout value;
+        if (!dll->getValueLayout(elementTypeToken, value))
+            value = { };
+
+        return { getElementLayout(elementTypeToken, value), value.valueType };
+    }
+
+    array_object_t* Arrays::create(Context &ctx, u32 elementTypeToken, u32 length, const GenericContext *genericContext) {
+        ArrayLayout instantiatedLayout;
+        const ArrayLayout *layoutPointer = nullptr;
+
+        // Arrays of a generic parameter take the layout of the type argument. Those can't be cached by token, the
+        // same one stands for a different type in every instantiation
+        if (genericContext != nullptr) {
+            auto argument = ctx.dll->getTypeArgument(elementTypeToken, *genericContext);
+            if (!argument.empty()) {
+                ValueLayout value;
+                const u8 *signature = argument.data();
+                if (!ctx.dll->decodeValueLayout(signature, signature + argument.size(), value, nullptr))
+                    value = { };
+
+                instantiatedLayout = { getElementLayout(elementTypeToken, value), value.valueType };
+                layoutPointer = &instantiatedLayout;
+            }
+        }
+
+        if (layoutPointer == nullptr) {
+            auto cachedLayout = ctx.arrayLayouts.find(elementTypeToken);
+            if (cachedLayout == ctx.arrayLayouts.end())
+                cachedLayout = ctx.arrayLayouts.emplace(elementTypeToken, getArrayLayout(ctx.dll, elementTypeToken)).first;
+
+            layoutPointer = &cachedLayout->second;
+        }
+
+        auto &layout = layoutPointer->header;
+        auto array = reinterpret_cast<array_object_t*>(ctx.allocate(sizeof(array_object_t) + size_t(length) * layout.elementSize, AllocationKind::Array, elementTypeToken, layoutPointer->elementLayout));
+
+        *array = layout;
+        array->length = length;
+
+        return array;
+    }
+
+    u8* Arrays::getData(array_object_t *array) {
+        return reinterpret_cast<u8*>(array) + sizeof(array_object_t);
+    }
+
+    u8* Arrays::getElement(array_object_t *array, u32 index) {
+        return getData(array) + size_t(index) * array->elementSize;
+    }
+
+    bool Arrays::hasElementLayout(const array_object_t *array, const ValueLayout &value) {
+        auto layout = getElementLayout(0, value);
+
+        return layout.elementType == array->elementType && layout.elementSize == array->elementSize && layout.elementUnsigned == array->elementUnsigned;
+    }
+
+}
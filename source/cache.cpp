@@ -0,0 +1,184 @@
+#include "cache.hpp"
+
+#include "dll.hpp"
+#include "tables.hpp"
+#include "logger.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace ili {
+
+    Cache::Cache(std::string path) : m_path(std::move(path)) {
+
+    }
+
+    template<typename T>
+    const T* Cache::getSection(u32 offset) {
+        return reinterpret_cast<const T*>(this->m_file.getData() + offset);
+    }
+
+    bool Cache::isSectionValid(u32 offset, u64 size) {
+        // Everything is done in 64 bit so neither the offset nor the size can wrap around the check
+        return offset <= this->m_file.getSize() && size <= this->m_file.getSize() - offset;
+    }
+
+    bool Cache::load(u64 fileHash, u64 fileSize) {
+        if (this->m_path.empty() || !this->m_file.open(this->m_path))
+            return false;
+
+        if (this->m_file.getSize() < sizeof(cache_header_t)) {
+            this->m_file.close();
+            return false;
+        }
+
+        auto header = reinterpret_cast<const cache_header_t*>(this->m_file.getData());
+
+        // Everything below is only a few compares, the actual sections are used directly from the mapping
+        if (std::memcmp(header->magic, "ILIC", 4) != 0 || header->version != Cache::Version
+            || header->fileHash != fileHash || header->fileSize != fileSize
+            || !this->isSectionValid(header->tablesOffset, 64 * sizeof(cache_table_descriptor_t))) {
+            Logger::debug(LogCategory::Metadata, "Discarding stale metadata cache %s", this->m_path.c_str());
+            this->m_file.close();
+            return false;
+        }
+
+        // The size of all other sections depends on the row counts stored in the cache itself
+        auto tables = this->getSection<cache_table_descriptor_t>(header->tablesOffset);
+        u64 numMethods = tables[TABLE_ID_METHODDEF].numRows;
+        u64 numTypes = tables[TABLE_ID_TYPEDEF].numRows;
+        u64 numMemberRefs = tables[TABLE_ID_MEMBERREF].numRows;
+
+        bool valid = this->isSectionValid(header->methodBodiesOffset, numMethods * sizeof(method_body_t))
+            && this->isSectionValid(header->methodOwnersOffset, numMethods * sizeof(u32))
+            && this->isSectionValid(header->objectSizesOffset, numTypes * sizeof(u32))
+            && this->isSectionValid(header->memberRefNamesOffset, numMemberRefs * sizeof(u32))
+            && this->isSectionValid(header->namePoolOffset, header->namePoolSize)
+            && (header->namePoolSize == 0 || this->getSection<char>(header->namePoolOffset)[header->namePoolSize - 1] == '\0');
+
+        // Names are read as C strings, so each one has to start inside of the terminated pool
+        auto memberRefNames = valid ? this->getSection<u32>(header->memberRefNamesOffset) : nullptr;
+        for (u64 i = 0; valid && i < numMemberRefs; i++)
+            valid = memberRefNames[i] < header->namePoolSize;
+
+        if (!valid) {
+            Logger::debug(LogCategory::Metadata, "Discarding corrupted metadata cache %s", this->m_path.c_str());
+            this->m_file.close();
+            return false;
+        }
+
+        this->m_header = header;
+
+        return true;
+    }
+
+    void Cache::store(DLL &dll, std::span<const method_body_t> methodBodies, std::span<const u32> objectSizes) {
+        if (this->m_path.empty())
+            return;
+
+        u32 numMethods = dll.getNumTableRows(TABLE_ID_METHODDEF);
+        u32 numMemberRefs = dll.getNumTableRows(TABLE_ID_MEMBERREF);
+
+        std::vector<cache_table_descriptor_t> tables;
+        std::vector<u32> methodOwners;
+        std::vector<u32> memberRefNames;
+        std::string namePool;
+
+        for (u8 i = 0; i < 64; i++)
+            tables.push_back(dll.getTableDescriptor(i));
+
+        for (u32 i = 1; i <= numMethods; i++)
+            methodOwners.push_back(dll.findTypeDefWithMethod((TABLE_ID_METHODDEF << 24) | i));
+
+        for (u32 i = 1; i <= numMemberRefs; i++) {
+            memberRefNames.push_back(namePool.size());
+            namePool += dll.getMemberRefName((TABLE_ID_MEMBERREF << 24) | i);
+            namePool += '\0';
+        }
+
+        cache_header_t header = { 0 };
+        std::memcpy(header.magic, "ILIC", 4);
+        header.version = Cache::Version;
+        std::memcpy(header.mvid, dll.getMvid(), sizeof(header.mvid));
+        header.fileHash = dll.getFileHash();
+        header.fileSize = dll.getFileSize();
+
+        u32 offset = sizeof(cache_header_t);
+        auto placeSection = [&offset](size_t size) -> u32 {
+            u32 sectionOffset = ALIGN(offset, 8);
+            offset = sectionOffset + size;
+            return sectionOffset;
+        };
+
+        header.tablesOffset = placeSection(tables.size() * sizeof(cache_table_descriptor_t));
+        header.methodBodiesOffset = placeSection(methodBodies.size() * sizeof(method_body_t));
+        header.methodOwnersOffset = placeSection(methodOwners.size() * sizeof(u32));
+        header.objectSizesOffset = placeSection(objectSizes.size() * sizeof(u32));
+        header.memberRefNamesOffset = placeSection(memberRefNames.size() * sizeof(u32));
+        header.namePoolOffset = placeSection(namePool.size());
+        header.namePoolSize = namePool.size();
+
+        std::vector<u8> data(offset, 0x00);
+        std::memcpy(&data[0], &header, sizeof(header));
+        std::memcpy(&data[header.tablesOffset], tables.data(), tables.size() * sizeof(cache_table_descriptor_t));
+        std::memcpy(&data[header.methodBodiesOffset], methodBodies.data(), methodBodies.size() * sizeof(method_body_t));
+        std::memcpy(&data[header.methodOwnersOffset], methodOwners.data(), methodOwners.size() * sizeof(u32));
+        std::memcpy(&data[header.objectSizesOffset], objectSizes.data(), objectSizes.size() * sizeof(u32));
+        std::memcpy(&data[header.memberRefNamesOffset], memberRefNames.data(), memberRefNames.size() * sizeof(u32));
+        std::memcpy(&data[header.namePoolOffset], namePool.data(), namePool.size());
+
+        // The name pool might live in the current mapping, so it's only released once everything has been copied
+        this->m_file.close();
+        this->m_header = nullptr;
+
+        // Write to a temporary file first so concurrently starting processes never map a half written cache
+        std::string tempPath = this->m_path + ".tmp";
+        FILE *cacheFile = fopen(tempPath.c_str(), "wb");
+        if (cacheFile == nullptr) {
+            Logger::debug(LogCategory::Metadata, "Cannot create metadata cache %s", this->m_path.c_str());
+            return;
+        }
+
+        bool written = fwrite(data.data(), 1, data.size(), cacheFile) == data.size();
+        fclose(cacheFile);
+
+        if (!written || std::rename(tempPath.c_str(), this->m_path.c_str()) != 0) {
+            Logger::debug(LogCategory::Metadata, "Cannot write metadata cache %s", this->m_path.c_str());
+            std::remove(tempPath.c_str());
+        }
+    }
+
+    bool Cache::isLoaded() {
+        return this->m_header != nullptr;
+    }
+
+    const cache_header_t* Cache::getHeader() {
+        return this->m_header;
+    }
+
+    const cache_table_descriptor_t* Cache::getTableDescriptors() {
+        return this->getSection<cache_table_descriptor_t>(this->m_header->tablesOffset);
+    }
+
+    const method_body_t* Cache::getMethodBodies() {
+        return this->getSection<method_body_t>(this->m_header->methodBodiesOffset);
+    }
+
+    const u32* Cache::getMethodOwners() {
+        return this->getSection<u32>(this->m_header->methodOwnersOffset);
+    }
+
+    const u32* Cache::getObjectSizes() {
+        return this->getSection<u32>(this->m_header->objectSizesOffset);
+    }
+
+    const u32* Cache::getMemberRefNameOffsets() {
+        return this->getSection<u32>(this->m_header->memberRefNamesOffset);
+    }
+
+    const char* Cache::getNamePool() {
+        return this->getSection<char>(this->m_header->namePoolOffset);
+    }
+
+}
@@ -0,0 +1,80 @@
+#include "collections.hpp"
+
+#include "context.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace ili {
+
+    // Lists start out with room for this many elements once the first one gets added
+    static constexpr u32 MinimumListCapacity = 4;
+    // Keeps every array of a hash table a multiple of 8 bytes long
+    static constexpr u32 MinimumHashTableCapacity = 8;
+
+    list_storage_t* Collections::createList(Context &ctx, u32 elementSize, u32 capacity, bool references) {
+        auto list = reinterpret_cast<list_storage_t*>(ctx.allocate(sizeof(list_storage_t) + size_t(capacity) * elementSize, AllocationKind::List));
+        list->capacity = capacity;
+        list->references = references;
+
+        return list;
+    }
+
+    u8* Collections::getElements(list_storage_t *list) {
+        return reinterpret_cast<u8*>(list) + sizeof(list_storage_t);
+    }
+
+    void Collections::reserve(Context &ctx, list_storage_t *&list, u32 elementSize, u32 capacity) {
+        if (capacity <= list->capacity)
+            return;
+
+        // Doubling keeps adding elements one at a time linear
+        capacity = std::max({ capacity, list->capacity * 2, MinimumListCapacity });
+
+        bool wrapped = list->head + list->count > list->capacity;
+        if (!wrapped && ctx.extend(reinterpret_cast<u8*>(list), sizeof(list_storage_t) + size_t(capacity) * elementSize)) {
+            list->capacity = capacity;
+            return;
+        }
+
+        auto grown = createList(ctx, elementSize, capacity, list->references);
+        u32 numBeforeEnd = std::min(list->count, list->capacity - list->head);
+        std::memcpy(getElements(grown), getElements(list) + size_t(list->head) * elementSize, size_t(numBeforeEnd) * elementSize);
+        std::memcpy(getElements(grown) + size_t(numBeforeEnd) * elementSize, getElements(list), size_t(list->count - numBeforeEnd) * elementSize);
+        grown->count = list->count;
+
+        list = grown;
+    }
+
+    hash_table_t* Collections::createHashTable(Context &ctx, u8 keySize, u8 valueSize, u32 capacity, bool referenceKeys, bool referenceValues) {
+        capacity = std::bit_ceil(std::max(capacity, MinimumHashTableCapacity));
+
+        auto table = reinterpret_cast<hash_table_t*>(ctx.allocate(sizeof(hash_table_t) + size_t(capacity) * (sizeof(SlotState) + keySize + valueSize), AllocationKind::HashTable));
+        table->capacity = capacity;
+        table->keySize = keySize;
+        table->valueSize = valueSize;
+        table->referenceKeys = referenceKeys;
+        table->referenceValues = referenceValues;
+
+        return table;
+    }
+
+    SlotState* Collections::getStates(hash_table_t *table) {
+        return reinterpret_cast<SlotState*>(reinterpret_cast<u8*>(table) + sizeof(hash_table_t));
+    }
+
+    u8* Collections::getKeys(hash_table_t *table) {
+        return reinterpret_cast<u8*>(getStates(table) + table->capacity);
+    }
+
+    u8* Collections::getValues(hash_table_t *table) {
+        return getKeys(table) + size_t(table->capacity) * table->keySize;
+    }
+
+    bool Collections::hasRoom(hash_table_t *table) {
+        // At most three quarters of the slots are used, so probe sequences stay short
+        return (u64(table->used) + 1) * 4 <= u64(table->capacity) * 3;
+    }
+
+}
@@ -9,19 +9,48 @@
 #include <cstdio>
 #include <cstring>
 #include <vector>
-#include <codecvt>
-#include <locale>
+#include <algorithm>
 #include <span>
+#include <atomic>
+#include <charconv>
+#include <filesystem>
 
 using namespace std::literals::string_view_literals;
 
 namespace ili {
 
-    DLL::DLL(std::string filePath) {
+    static u64 hashData(const u8 *data, size_t size) {
+        constexpr u64 Prime = 0x0000'0100'0000'01B3;
+        u64 hash = 0xCBF2'9CE4'8422'2325;
+
+        size_t i = 0;
+        for (; i + sizeof(u64) <= size; i += sizeof(u64)) {
+            u64 word;
+            std::memcpy(&word, data + i, sizeof(u64));
+            hash = (hash ^ word) * Prime;
+        }
+
+        for (; i < size; i++)
+            hash = (hash ^ data[i]) * Prime;
+
+        return hash;
+    }
+
+    static std::string getCachePath(const std::string &filePath, const std::string &cacheDirectory) {
+        if (cacheDirectory.empty())
+            return "";
+
+        std::error_code error;
+        std::filesystem::create_directories(cacheDirectory, error);
+
+        return (std::filesystem::path(cacheDirectory) / std::filesystem::path(filePath).filename()).string() + ".ilicache";
+    }
+
+    DLL::DLL(std::string filePath, std::string cacheDirectory) : m_cache(getCachePath(filePath, cacheDirectory)) {
         FILE *dllFile = fopen(filePath.c_str(), "rb");
 
         if (dllFile == nullptr) {
-            Logger::error("Cannot open file %s!", filePath.c_str());
+            Logger::error(LogCategory::Metadata, "Cannot open file %s!", filePath.c_str());
             exit(1);
         }
 
@@ -33,6 +62,8 @@ namespace ili {
         fread(this->m_dllData, 1, this->m_fileSize, dllFile);
         fclose(dllFile);
 
+        this->m_fileHash = hashData(this->m_dllData, this->m_fileSize);
+
         this->m_dosHeader = reinterpret_cast<dos_header_t*>(this->m_dllData);
         this->m_dosStub = reinterpret_cast<dos_stub_t*>(OFFSET(this->m_dosHeader, sizeof(dos_header_t)));
         this->m_ntHeader = reinterpret_cast<nt_header_t*>(OFFSET(this->m_dosStub, sizeof(dos_stub_t)));
@@ -72,117 +103,239 @@ namespace ili {
 
         }
 
-        // Parse #~ Stream rows and tables
+        // Locate heaps and the #~ Stream
+        tilde_stream_t *tildeStream = nullptr;
         {
             for (u8 stream = 0; stream < this->m_metadata.streams; stream++) {
                 if (std::string(this->m_streamHeaders[stream]->name) == "#~") {
-                    tilde_stream_t *tildeStream = reinterpret_cast<tilde_stream_t*>(OFFSET(metadataBase, this->m_streamHeaders[stream]->offset));
-
-                    currentDataPtr += 24; // Skip to rows array
-
-                    for (u8 i = 0; i < 64; i++) {
-                        if ((tildeStream->valid & (1ULL << i)) == (1ULL << i)) {
-                            this->m_numRows[i] = *reinterpret_cast<u32*>(currentDataPtr);
-                            currentDataPtr += sizeof(u32);
-                        }
-                    }
-
-                    for (u8 i = 0; i < 64; i++) {
-                        u32 count = this->m_numRows[i];
-
-                        this->m_tildeTableData.push_back({});
-                        if (count != 0) {
-                            u8 tableSize = getMetadataTableSize(i);
-                            for (u16 j = 0; j < count; j++) {
-                                this->m_tildeTableData[i].push_back({ currentDataPtr, tableSize });
-                                currentDataPtr += tableSize;
-                            }
-                        }
-                    }
+                    tildeStream = reinterpret_cast<tilde_stream_t*>(OFFSET(metadataBase, this->m_streamHeaders[stream]->offset));
                 } else if (std::string(this->m_streamHeaders[stream]->name) == "#Strings") {
                     this->m_stringsHeap = OFFSET(metadataBase, this->m_streamHeaders[stream]->offset);
                 } else if (std::string(this->m_streamHeaders[stream]->name) == "#US") {
                     this->m_userStringsHeap = OFFSET(metadataBase, this->m_streamHeaders[stream]->offset);
+                    this->m_userStringsHeapSize = this->m_streamHeaders[stream]->size;
+                } else if (std::string(this->m_streamHeaders[stream]->name) == "#GUID") {
+                    this->m_guidHeap = OFFSET(metadataBase, this->m_streamHeaders[stream]->offset);
                 } else if (std::string(this->m_streamHeaders[stream]->name) == "#Blob") {
                     this->m_blobHeap = OFFSET(metadataBase, this->m_streamHeaders[stream]->offset);
                 }
             }
         }
+
+        // Use the derived structures of a previous run if there's a matching cache, otherwise build them now
+        if (this->loadTablesFromCache()) {
+            this->useCachedIndexes();
+            Logger::info(LogCategory::Metadata, "Loaded metadata cache");
+        } else {
+            this->parseTables(tildeStream);
+            this->buildIndexes();
+            this->m_cacheDirty = true;
+        }
+    }
+
+    void DLL::parseTables(tilde_stream_t *tildeStream) {
+        u8 *currentDataPtr = OFFSET(tildeStream, sizeof(tilde_stream_t)); // Skip to rows array
+
+        for (u8 i = 0; i < 64; i++) {
+            if ((tildeStream->valid & (1ULL << i)) == (1ULL << i)) {
+                this->m_numRows[i] = *reinterpret_cast<u32*>(currentDataPtr);
+                currentDataPtr += sizeof(u32);
+            }
+        }
+
+        for (u8 i = 0; i < 64; i++) {
+            u8 tableSize = getMetadataTableSize(i);
+
+            this->m_tables[i] = { currentDataPtr, tableSize };
+            currentDataPtr += tableSize * this->m_numRows[i];
+        }
+    }
+
+    bool DLL::loadTablesFromCache() {
+        if (!this->m_cache.load(this->m_fileHash, this->m_fileSize))
+            return false;
+
+        auto descriptors = this->m_cache.getTableDescriptors();
+        for (u8 i = 0; i < 64; i++) {
+            if (descriptors[i].offset > this->m_fileSize || u64(descriptors[i].rowSize) * descriptors[i].numRows > this->m_fileSize - descriptors[i].offset)
+                return false;
+
+            this->m_numRows[i] = descriptors[i].numRows;
+            this->m_tables[i] = { OFFSET(this->m_dllData, descriptors[i].offset), descriptors[i].rowSize };
+        }
+
+        // The file hash already matched, the MVID makes sure it's not a collision between two different modules
+        if (this->m_numRows[TABLE_ID_MODULE] == 0 || std::memcmp(this->getMvid(), this->m_cache.getHeader()->mvid, 16) != 0) {
+            std::memset(this->m_numRows, 0x00, sizeof(this->m_numRows));
+            return false;
+        }
+
+        return true;
+    }
+
+    void DLL::buildIndexes() {
+        u32 numMethods = this->m_numRows[TABLE_ID_METHODDEF];
+        u32 numTypes = this->m_numRows[TABLE_ID_TYPEDEF];
+        u32 numMemberRefs = this->m_numRows[TABLE_ID_MEMBERREF];
+
+        // Method bodies and type layouts are only decoded once something actually needs them
+        this->m_methodBodyData.assign(numMethods, { 0 });
+        this->m_objectSizeData.assign(numTypes, DLL::UnknownObjectSize);
+
+        this->m_methodOwnerData.assign(numMethods, 0);
+        for (u32 i = 1; i <= numTypes; i++) {
+            table_type_def_t *type = this->getTypeDefByIndex(i);
+
+            u32 methodListEnd = i < numTypes ? this->getTypeDefByIndex(i + 1)->methodListIndex : numMethods + 1;
+            for (u32 method = type->methodListIndex; method < methodListEnd && method <= numMethods; method++)
+                this->m_methodOwnerData[method - 1] = i;
+        }
+
+        this->m_memberRefNameData.resize(numMemberRefs);
+        for (u32 i = 1; i <= numMemberRefs; i++) {
+            this->m_memberRefNameData[i - 1] = this->m_namePoolData.size();
+            this->m_namePoolData += this->getFullMethodName((TABLE_ID_MEMBERREF << 24) | i);
+            this->m_namePoolData += '\0';
+        }
+
+        this->m_methodOwners = this->m_methodOwnerData.data();
+        this->m_memberRefNames = this->m_memberRefNameData.data();
+        this->m_namePool = this->m_namePoolData.c_str();
+    }
+
+    void DLL::useCachedIndexes() {
+        // Bodies and layouts keep getting filled in lazily, so they're copied out of the read-only mapping
+        auto methodBodies = this->m_cache.getMethodBodies();
+        auto objectSizes = this->m_cache.getObjectSizes();
+        this->m_methodBodyData.assign(methodBodies, methodBodies + this->m_numRows[TABLE_ID_METHODDEF]);
+        this->m_objectSizeData.assign(objectSizes, objectSizes + this->m_numRows[TABLE_ID_TYPEDEF]);
+
+        this->m_methodOwners = this->m_cache.getMethodOwners();
+        this->m_memberRefNames = this->m_cache.getMemberRefNameOffsets();
+        this->m_namePool = this->m_cache.getNamePool();
+    }
+
+    method_body_t DLL::decodeMethodBody(table_method_def_t *methodDef) {
+        method_body_t body = { 0 };
+
+        // Abstract, runtime and internal call methods don't have a body
+        if (methodDef->rva == 0)
+            return body;
+
+        section_table_entry_t *ilHeaderSection = this->getVirtualSection(methodDef->rva);
+        if (ilHeaderSection == nullptr)
+            return body;
+
+        u8 *methodHeader = OFFSET(this->m_dllData, VRA_TO_OFFSET(ilHeaderSection, methodDef->rva));
+
+        if ((*methodHeader & 0x03) == 0x02) { // Tiny Header
+            body.codeOffset = (methodHeader + 1) - this->m_dllData;
+            body.codeSize = *methodHeader >> 2;
+            body.maxStack = 8;
+        } else if ((*methodHeader & 0x03) == 0x03) { // Fat Header
+            auto fatHeader = reinterpret_cast<method_fat_header_t*>(methodHeader);
+
+            body.codeOffset = (methodHeader + (fatHeader->flagsAndSize >> 12) * sizeof(u32)) - this->m_dllData;
+            body.codeSize = fatHeader->codeSize;
+            body.maxStack = fatHeader->maxStack;
+            body.flags = fatHeader->flagsAndSize & 0x0FFF;
+            body.localVarSigToken = fatHeader->localVarSigToken;
+        }
+
+        return body;
     }
 
     DLL::~DLL() {
+        // Write back everything that got decoded in this run so the next one can skip it
+        if (this->m_cacheDirty)
+            this->m_cache.store(*this, this->m_methodBodyData, this->m_objectSizeData);
+
         delete[] this->m_dllData;
     }
 
     void DLL::validate() {
         if (std::memcmp(this->m_dosHeader->magic, "MZ", 2) != 0) {
-            Logger::error("Invalid DOS Header!");
+            Logger::error(LogCategory::Metadata, "Invalid DOS Header!");
             exit(1);
-        } else Logger::info("Valid DOS Header!");
+        } else Logger::info(LogCategory::Metadata, "Valid DOS Header!");
 
         if (std::memcmp(this->m_ntHeader->magic, "PE\x00\x00", 4) != 0) {
-            Logger::error("Invalid NT Header!");
+            Logger::error(LogCategory::Metadata, "Invalid NT Header!");
             exit(1);
-        } else Logger::info("Valid NT Header!");
+        } else Logger::info(LogCategory::Metadata, "Valid NT Header!");
 
-        Logger::info("Stack size: %lx", this->getStackSize());
+        Logger::info(LogCategory::Metadata, "Stack size: %lx", this->getStackSize());
 
         if (this->m_crlRuntimeHeader->headerSize != sizeof(crl_runtime_header_t)) {
-            Logger::error("Invalid CLR Header!");
+            Logger::error(LogCategory::Metadata, "Invalid CLR Header!");
             exit(1);
-        } else Logger::info("Valid CLR Header!");
+        } else Logger::info(LogCategory::Metadata, "Valid CLR Header!");
 
-        Logger::info("Runtime version: %d.%d", this->m_crlRuntimeHeader->runtimeVersionMajor, this->m_crlRuntimeHeader->runtimeVersionMinor);
-        Logger::info("Entrypoint Token: %x", this->m_crlRuntimeHeader->entryPointToken);
+        Logger::info(LogCategory::Metadata, "Runtime version: %d.%d", this->m_crlRuntimeHeader->runtimeVersionMajor, this->m_crlRuntimeHeader->runtimeVersionMinor);
+        Logger::info(LogCategory::Metadata, "Entrypoint Token: %x", this->m_crlRuntimeHeader->entryPointToken);
 
         if (std::memcmp(this->m_metadata.magic, "BSJB", 4) != 0) {
-            Logger::error("Invalid Metadata Header!");
+            Logger::error(LogCategory::Metadata, "Invalid Metadata Header!");
             exit(1);
-        } else Logger::info("Valid Metadata Header!");
+        } else Logger::info(LogCategory::Metadata, "Valid Metadata Header!");
 
-        Logger::info(".NET Framework version: %s", this->m_metadata.version);
+        Logger::info(LogCategory::Metadata, ".NET Framework version: %s", this->m_metadata.version);
 
         for (u8 stream = 0; stream < this->m_metadata.streams; stream++) {
-            Logger::info("Found Stream: %s", this->m_streamHeaders[stream]->name);
+            Logger::info(LogCategory::Metadata, "Found Stream: %s", this->m_streamHeaders[stream]->name);
 
             if (std::string(this->m_streamHeaders[stream]->name) == "#~") {
                 for (u8 i = 0; i < 64; i++)
                     if (this->m_numRows[i] != 0)
-                        Logger::info("  Table 0x%X: %u entries", i, this->m_numRows[i]);
+                        Logger::info(LogCategory::Metadata, "  Table 0x%X: %u entries", i, this->m_numRows[i]);
             }
         }
     }
 
     table_method_def_t* DLL::getMethodDefByMetadataToken(u32 token) {
         if (TABLE_ID(token) == TABLE_ID_METHODDEF)
-            return reinterpret_cast<table_method_def_t*>(this->m_tildeTableData[TABLE_ID(token)][TABLE_INDEX(token) - 1].base);
+            return reinterpret_cast<table_method_def_t*>(OFFSET(this->m_tables[TABLE_ID_METHODDEF].base, (TABLE_INDEX(token) - 1) * this->m_tables[TABLE_ID_METHODDEF].size));
         else return nullptr;
     }
 
     table_member_ref_t* DLL::getMemberRefByMetadataToken(u32 token) {
         if (TABLE_ID(token) == TABLE_ID_MEMBERREF)
-            return reinterpret_cast<table_member_ref_t*>(this->m_tildeTableData[TABLE_ID(token)][TABLE_INDEX(token) - 1].base);
+            return reinterpret_cast<table_member_ref_t*>(OFFSET(this->m_tables[TABLE_ID_MEMBERREF].base, (TABLE_INDEX(token) - 1) * this->m_tables[TABLE_ID_MEMBERREF].size));
+        else return nullptr;
+    }
+
+    table_method_spec_t* DLL::getMethodSpecByMetadataToken(u32 token) {
+        if (TABLE_ID(token) == TABLE_ID_METHODSPEC)
+            return reinterpret_cast<table_method_spec_t*>(OFFSET(this->m_tables[TABLE_ID_METHODSPEC].base, (TABLE_INDEX(token) - 1) * this->m_tables[TABLE_ID_METHODSPEC].size));
         else return nullptr;
     }
 
     table_method_def_t * DLL::getMethodDefByIndex(u32 index) {
-        return reinterpret_cast<table_method_def_t*>(this->m_tildeTableData[TABLE_ID_METHODDEF][index - 1].base);
+        return reinterpret_cast<table_method_def_t*>(OFFSET(this->m_tables[TABLE_ID_METHODDEF].base, (index - 1) * this->m_tables[TABLE_ID_METHODDEF].size));
     }
 
     table_type_ref_t* DLL::getTypeRefByIndex(u32 index) {
-        return reinterpret_cast<table_type_ref_t*>(this->m_tildeTableData[TABLE_ID_TYPEREF][index - 1].base);
+        return reinterpret_cast<table_type_ref_t*>(OFFSET(this->m_tables[TABLE_ID_TYPEREF].base, (index - 1) * this->m_tables[TABLE_ID_TYPEREF].size));
     }
 
     table_type_def_t* DLL::getTypeDefByIndex(u32 index) {
-        return reinterpret_cast<table_type_def_t*>(this->m_tildeTableData[TABLE_ID_TYPEDEF][index - 1].base);
+        return reinterpret_cast<table_type_def_t*>(OFFSET(this->m_tables[TABLE_ID_TYPEDEF].base, (index - 1) * this->m_tables[TABLE_ID_TYPEDEF].size));
     }
 
     table_assembly_ref_t* DLL::getAssemblyRefByIndex(u32 index) {
-        return reinterpret_cast<table_assembly_ref_t*>(this->m_tildeTableData[TABLE_ID_ASSEMBLYREF][index - 1].base);
+        return reinterpret_cast<table_assembly_ref_t*>(OFFSET(this->m_tables[TABLE_ID_ASSEMBLYREF].base, (index - 1) * this->m_tables[TABLE_ID_ASSEMBLYREF].size));
     }
 
     table_field_t* DLL::getFieldByIndex(u32 index) {
-        return reinterpret_cast<table_field_t*>(this->m_tildeTableData[TABLE_ID_FIELD][index - 1].base);
+        return reinterpret_cast<table_field_t*>(OFFSET(this->m_tables[TABLE_ID_FIELD].base, (index - 1) * this->m_tables[TABLE_ID_FIELD].size));
+    }
+
+    table_type_spec_t* DLL::getTypeSpecByIndex(u32 index) {
+        return reinterpret_cast<table_type_spec_t*>(OFFSET(this->m_tables[TABLE_ID_TYPESPEC].base, (index - 1) * this->m_tables[TABLE_ID_TYPESPEC].size));
+    }
+
+    table_stand_alone_sig_t* DLL::getStandAloneSigByIndex(u32 index) {
+        return reinterpret_cast<table_stand_alone_sig_t*>(OFFSET(this->m_tables[TABLE_ID_STANDALONESIG].base, (index - 1) * this->m_tables[TABLE_ID_STANDALONESIG].size));
     }
 
     u32 DLL::getEntryMethodToken() {
@@ -193,39 +346,52 @@ namespace ili {
         return reinterpret_cast<char*>(&this->m_stringsHeap[index]);
     }
 
-    u32 DLL::getBlobSize(u32 index) {
-        switch (getBlobHeaderSize(index)) {
-            case 1: return this->m_blobHeap[index];
-            case 2: return ((this->m_blobHeap[index] & 0x3F) << 8) + this->m_blobHeap[index + 1];
-            case 4: return ((this->m_blobHeap[index] & 0x1F) << 24)
-                            + (this->m_blobHeap[index + 1] << 16)
-                            + (this->m_blobHeap[index + 2] << 8)
-                            +  this->m_blobHeap[index + 3];
-            default: return 0;
-        }
-    }
-
-    u8 DLL::getBlobHeaderSize(u32 index) {
-        if ((this->m_userStringsHeap[index] & 0x80) == 0x00)
+    // Compressed unsigned integers as used for blob lengths and inside signatures. Returns how many bytes were used
+    u8 DLL::decodeCompressedUnsigned(const u8 *data, u32 &value) {
+        if ((data[0] & 0x80) == 0x00) {
+            value = data[0];
             return 1;
-        if ((this->m_userStringsHeap[index] & 0xC0) == 0x80)
+        }
+        if ((data[0] & 0xC0) == 0x80) {
+            value = ((data[0] & 0x3F) << 8) + data[1];
             return 2;
-        if ((this->m_userStringsHeap[index] & 0xE0) == 0xC0)
+        }
+        if ((data[0] & 0xE0) == 0xC0) {
+            value = ((data[0] & 0x1F) << 24) + (data[1] << 16) + (data[2] << 8) + data[3];
             return 4;
+        }
 
+        value = 0;
         return 0;
     }
 
+    u32 DLL::getBlobSize(u32 index) {
+        u32 size;
+        decodeCompressedUnsigned(&this->m_blobHeap[index], size);
+
+        return size;
+    }
+
+    u8 DLL::getBlobHeaderSize(u32 index) {
+        u32 size;
+        return decodeCompressedUnsigned(&this->m_blobHeap[index], size);
+    }
+
     std::span<u8> DLL::getUserString(u32 index) {
         if ((index >> 24) == 0x70) {
             index = index & 0x00FFFFFF;
 
-            auto blobHeaderSize = getBlobHeaderSize(index);
-            auto string = &this->m_userStringsHeap[index] + blobHeaderSize;
-            u32 size = 0;
-            std::memcpy(&size, &this->m_userStringsHeap[index], blobHeaderSize);
+            if (index >= this->m_userStringsHeapSize)
+                return {};
+
+            u8 *header = &this->m_userStringsHeap[index];
+            u32 size;
+            u8 headerSize = decodeCompressedUnsigned(header, size);
+
+            if (headerSize == 0 || index + headerSize + size > this->m_userStringsHeapSize)
+                return {};
 
-            return { string, size };
+            return { header + headerSize, size };
         }
 
         return {};
@@ -235,6 +401,10 @@ namespace ili {
         return &this->m_blobHeap[index + getBlobHeaderSize(index)];
     }
 
+    u32 DLL::getUserStringHeapSize() {
+        return this->m_userStringsHeapSize;
+    }
+
     u8* DLL::getData() {
         return this->m_dllData;
     }
@@ -245,21 +415,76 @@ namespace ili {
 
     std::string DLL::getFullMethodName(u32 methodToken) {
         auto memberRef = this->getMemberRefByMetadataToken(methodToken);
-        auto typeRef = this->getTypeRefByIndex(INDEX_INDEX(memberRef->classIndex, MEMBER_REF_PARENT));
+
+        // Only members of types referenced from other assemblies can be bound to native methods
+        std::string type;
+        switch (INDEX_TAG(memberRef->classIndex, MEMBER_REF_PARENT)) {
+            case 1: // TypeRef
+                type = this->getTypeRefPath(INDEX_INDEX(memberRef->classIndex, MEMBER_REF_PARENT));
+                break;
+            case 4: // TypeSpec
+                type = this->getTypeSpecPath(INDEX_INDEX(memberRef->classIndex, MEMBER_REF_PARENT));
+                break;
+        }
+
+        if (type.empty())
+            return "";
+
+        return type + "::"s + this->getString(memberRef->nameIndex);
+    }
+
+    // "[Assembly]Namespace.Type", or nothing if the type isn't from another assembly
+    std::string DLL::getTypeRefPath(u32 typeRefIndex) {
+        if (typeRefIndex == 0 || typeRefIndex > this->m_numRows[TABLE_ID_TYPEREF])
+            return "";
+
+        auto typeRef = this->getTypeRefByIndex(typeRefIndex);
+        if (INDEX_TAG(typeRef->resolutionScopeIndex, RESOLUTION_SCOPE) != 2) // AssemblyRef
+            return "";
+
         auto assemblyRef = this->getAssemblyRefByIndex(INDEX_INDEX(typeRef->resolutionScopeIndex, RESOLUTION_SCOPE));
 
         auto assembly = this->getString(assemblyRef->nameIndex);
         auto nameSpace = this->getString(typeRef->typeNamespaceIndex);
         auto type = this->getString(typeRef->typeNameIndex);
-        auto method = this->getString(memberRef->nameIndex);
 
-        return "["s + assembly + "]"s + nameSpace + "."s + type + "::"s + method;
+        return "["s + assembly + "]"s + nameSpace + "."s + type;
     }
 
-    std::string DLL::decodeUserString(u32 token) {
-        auto utf16String = this->getUserString(token);
-        std::wstring_convert<std::codecvt_utf8_utf16<char16_t>,char16_t> conversion;
-        return conversion.to_bytes(reinterpret_cast<char16_t*>(utf16String.data()), reinterpret_cast<char16_t*>(utf16String.data() + utf16String.size_bytes() - 1));
+    // Generic instantiations of types from other assemblies get their type arguments appended, e.g.
+    // "[System.Runtime]System.Numerics.Vector`1<int32>"
+    std::string DLL::getTypeSpecPath(u32 typeSpecIndex) {
+        if (typeSpecIndex == 0 || typeSpecIndex > this->m_numRows[TABLE_ID_TYPESPEC])
+            return "";
+
+        auto typeSpec = this->getTypeSpecByIndex(typeSpecIndex);
+        const u8 *signature = this->getBlob(typeSpec->signatureIndex);
+        const u8 *signatureEnd = signature + this->getBlobSize(typeSpec->signatureIndex);
+
+        if (signatureEnd - signature < 2 || static_cast<SignatureElementType>(signature[0]) != SignatureElementType::GenericInst)
+            return "";
+        signature += 2; // Class or ValueType
+
+        u32 typeDefOrRef, numArguments;
+        signature += decodeCompressedUnsigned(signature, typeDefOrRef);
+        if ((typeDefOrRef & 0b11) != 1) // TypeRef
+            return "";
+
+        std::string path = this->getTypeRefPath(typeDefOrRef >> 2);
+        if (path.empty())
+            return "";
+
+        signature += decodeCompressedUnsigned(signature, numArguments);
+
+        path += "<";
+        for (u32 i = 0; i < numArguments; i++) {
+            if (i > 0)
+                path += ",";
+            path += this->readTypeName(signature, signatureEnd);
+        }
+        path += ">";
+
+        return path;
     }
 
     section_table_entry_t* DLL::getVirtualSection(u64 rva) {
@@ -272,34 +497,37 @@ namespace ili {
         return nullptr;
     }
 
-    u16 DLL::findTypeDefWithMethod(u32 methodToken) {
-        table_method_def_t *methodToFind = this->getMethodDefByMetadataToken(methodToken);
-
-        if (methodToFind == nullptr)
+    u32 DLL::findTypeDefWithMethod(u32 methodToken) {
+        if (TABLE_ID(methodToken) != TABLE_ID_METHODDEF || TABLE_INDEX(methodToken) == 0 || TABLE_INDEX(methodToken) > this->m_numRows[TABLE_ID_METHODDEF])
             return 0;
 
-        // Check all rows in the typedef table except the last one for if it contains the method
-        for (u32 i = 0; i < this->m_numRows[TABLE_ID_METHODDEF] - 1; i++) {
-            table_type_def_t* currTypeDef = reinterpret_cast<table_type_def_t*>(this->m_tildeTableData[TABLE_ID_TYPEDEF][i].base);
-            table_type_def_t* nextTypeDef = reinterpret_cast<table_type_def_t*>(this->m_tildeTableData[TABLE_ID_TYPEDEF][i + 1].base);
+        return this->m_methodOwners[TABLE_INDEX(methodToken) - 1];
+    }
 
-            table_method_def_t* currMethodDef = this->getMethodDefByIndex(currTypeDef->methodListIndex);
-            table_method_def_t* nextMethodDef = this->getMethodDefByIndex(nextTypeDef->methodListIndex);
+    // TypeDefs own the fields from their field list up to the one of the next TypeDef. Ones without fields share
+    // their list index with the next type, so the last TypeDef starting at or before the field is the owner
+    u32 DLL::findTypeDefWithField(u32 fieldIndex) {
+        u32 numTypes = this->m_numRows[TABLE_ID_TYPEDEF];
+        if (fieldIndex == 0 || fieldIndex > this->m_numRows[TABLE_ID_FIELD] || numTypes == 0)
+            return 0;
 
-            if (methodToFind >= currMethodDef && methodToFind < nextMethodDef)
-                return i + 1;
+        u32 low = 1, high = numTypes;
+        while (low < high) {
+            u32 middle = (low + high + 1) / 2;
+            if (this->getTypeDefByIndex(middle)->fieldListIndex <= fieldIndex)
+                low = middle;
+            else
+                high = middle - 1;
         }
 
-        // When the method hasn't been found in the previous rows, it has to be in the last one
-        // since if it wouldn't exist at all, methodToFind would have been nullptr
-        return this->m_numRows[TABLE_ID_METHODDEF];
+        return this->getTypeDefByIndex(low)->fieldListIndex <= fieldIndex ? low : 0;
     }
 
     table_class_layout_t* DLL::getClassLayoutOfType(table_type_def_t *typeDef) {
         for (u32 i = 0; i < this->m_numRows[TABLE_ID_CLASS_LAYOUT]; i++) {
-            table_class_layout_t *currClassLayout = reinterpret_cast<table_class_layout_t*>(this->m_tildeTableData[TABLE_ID_CLASS_LAYOUT][i].base);
+            table_class_layout_t *currClassLayout = reinterpret_cast<table_class_layout_t*>(OFFSET(this->m_tables[TABLE_ID_CLASS_LAYOUT].base, i * this->m_tables[TABLE_ID_CLASS_LAYOUT].size));
 
-            if (reinterpret_cast<table_type_def_t*>(this->m_tildeTableData[TABLE_ID_TYPEDEF][currClassLayout->parentIndex].base) == typeDef)
+            if (this->getTypeDefByIndex(currClassLayout->parentIndex) == typeDef)
                 return currClassLayout;
         }
 
@@ -307,10 +535,1520 @@ namespace ili {
     }
 
     u32 DLL::getNumTableRows(u8 index) {
-        if (index >= sizeof(this->m_numRows))
+        if (index >= std::size(this->m_numRows))
             return 0;
 
         return this->m_numRows[index];
     }
 
+    cache_table_descriptor_t DLL::getTableDescriptor(u8 index) {
+        if (index >= std::size(this->m_numRows))
+            return { 0 };
+
+        return { static_cast<u32>(this->m_tables[index].base - this->m_dllData), static_cast<u32>(this->m_tables[index].size), this->m_numRows[index] };
+    }
+
+    const method_body_t* DLL::getMethodBody(u32 methodToken) {
+        if (TABLE_ID(methodToken) != TABLE_ID_METHODDEF || TABLE_INDEX(methodToken) == 0 || TABLE_INDEX(methodToken) > this->m_numRows[TABLE_ID_METHODDEF])
+            return nullptr;
+
+        std::scoped_lock lock(this->m_lazyDecodeMutex);
+
+        method_body_t &body = this->m_methodBodyData[TABLE_INDEX(methodToken) - 1];
+        if (body.codeOffset == 0) {
+            body = this->decodeMethodBody(this->getMethodDefByMetadataToken(methodToken));
+            this->m_cacheDirty |= body.codeOffset != 0;
+        }
+
+        return &body;
+    }
+
+    u32 DLL::getObjectSize(u32 typeIndex) {
+        u32 numTypes = this->m_numRows[TABLE_ID_TYPEDEF];
+
+        if (typeIndex == 0 || typeIndex > numTypes)
+            return 0;
+
+        // newobj asks for this every time, so only the first lookup of each type takes the lock
+        std::atomic_ref<u32> objectSize(this->m_objectSizeData[typeIndex - 1]);
+        u32 size = objectSize.load(std::memory_order_acquire);
+        if (size != DLL::UnknownObjectSize)
+            return size;
+
+        // Laid out before taking the lock, that takes the layout lock and looks at everything the fields refer to
+        u32 layoutSize = this->layOutType(typeIndex, { })->size;
+
+        std::scoped_lock lock(this->m_lazyDecodeMutex);
+
+        size = objectSize.load(std::memory_order_relaxed);
+        if (size == DLL::UnknownObjectSize) {
+            size = layoutSize;
+            objectSize.store(size, std::memory_order_release);
+            this->m_cacheDirty = true;
+        }
+
+        return size;
+    }
+
+    const char* DLL::getMemberRefName(u32 memberToken) {
+        if (TABLE_ID(memberToken) != TABLE_ID_MEMBERREF || TABLE_INDEX(memberToken) == 0 || TABLE_INDEX(memberToken) > this->m_numRows[TABLE_ID_MEMBERREF])
+            return "";
+
+        return &this->m_namePool[this->m_memberRefNames[TABLE_INDEX(memberToken) - 1]];
+    }
+
+    // Moves past a type in a signature without looking at what it is. Returns false for types whose length can't be told
+    static bool skipType(const u8 *&signature, const u8 *signatureEnd) {
+        while (signature < signatureEnd) {
+            auto elementType = static_cast<SignatureElementType>(*signature++);
+
+            u32 value;
+            switch (elementType) {
+                case SignatureElementType::Void:
+                case SignatureElementType::Boolean:
+                case SignatureElementType::Char:
+                case SignatureElementType::I1:
+                case SignatureElementType::U1:
+                case SignatureElementType::I2:
+                case SignatureElementType::U2:
+                case SignatureElementType::I4:
+                case SignatureElementType::U4:
+                case SignatureElementType::I8:
+                case SignatureElementType::U8:
+                case SignatureElementType::R4:
+                case SignatureElementType::R8:
+                case SignatureElementType::String:
+                case SignatureElementType::TypedByRef:
+                case SignatureElementType::I:
+                case SignatureElementType::U:
+                case SignatureElementType::Object:
+                    return true;
+                case SignatureElementType::Ptr:
+                case SignatureElementType::ByRef:
+                case SignatureElementType::SzArray:
+                case SignatureElementType::Pinned:
+                    break;
+                case SignatureElementType::CmodReqd:
+                case SignatureElementType::CmodOpt:
+                    signature += DLL::decodeCompressedUnsigned(signature, value);
+                    break;
+                case SignatureElementType::Class:
+                case SignatureElementType::ValueType:
+                case SignatureElementType::Var:
+                case SignatureElementType::MVar:
+                    signature += DLL::decodeCompressedUnsigned(signature, value);
+                    return true;
+                case SignatureElementType::GenericInst: {
+                    signature++; // Class or ValueType
+                    signature += DLL::decodeCompressedUnsigned(signature, value);
+
+                    u32 numArguments;
+                    signature += DLL::decodeCompressedUnsigned(signature, numArguments);
+                    for (u32 i = 0; i < numArguments; i++) {
+                        if (!skipType(signature, signatureEnd))
+                            return false;
+                    }
+
+                    return signature <= signatureEnd;
+                }
+                case SignatureElementType::Array: {
+                    if (!skipType(signature, signatureEnd))
+                        return false;
+
+                    // Rank, then the sizes and lower bounds, each with their count in front
+                    u32 numSizes, numLowerBounds;
+                    signature += DLL::decodeCompressedUnsigned(signature, value);
+                    signature += DLL::decodeCompressedUnsigned(signature, numSizes);
+                    for (u32 i = 0; i < numSizes; i++)
+                        signature += DLL::decodeCompressedUnsigned(signature, value);
+                    signature += DLL::decodeCompressedUnsigned(signature, numLowerBounds);
+                    for (u32 i = 0; i < numLowerBounds; i++)
+                        signature += DLL::decodeCompressedUnsigned(signature, value);
+
+                    return signature <= signatureEnd;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        return false;
+    }
+
+    // Collects where each type argument of a generic instantiation starts and ends
+    static bool readTypeArguments(const u8 *&signature, const u8 *signatureEnd, std::vector<std::span<const u8>> &arguments) {
+        u32 numArguments;
+        signature += DLL::decodeCompressedUnsigned(signature, numArguments);
+
+        for (u32 i = 0; i < numArguments; i++) {
+            const u8 *argument = signature;
+            if (!skipType(signature, signatureEnd))
+                return false;
+
+            arguments.emplace_back(argument, signature);
+        }
+
+        return true;
+    }
+
+    // Turns a TypeDefOrRefOrSpecEncoded from a signature into a metadata token
+    static u32 decodeTypeDefOrRef(u32 typeDefOrRef) {
+        constexpr u8 typeDefOrRefTables[] = { TABLE_ID_TYPEDEF, TABLE_ID_TYPEREF, TABLE_ID_TYPESPEC, 0 };
+
+        return (typeDefOrRefTables[typeDefOrRef & 0b11] << 24) | (typeDefOrRef >> 2);
+    }
+
+    // Names a type in a signature the way ILAsm would. Only the types needed to tell overloads of native methods
+    // apart are named, everything else shows up as "?"
+    std::string DLL::readTypeName(const u8 *&signature, const u8 *signatureEnd) {
+        if (signature >= signatureEnd)
+            return "?";
+
+        auto readUnsigned = [&signature]() {
+            u32 value;
+            signature += decodeCompressedUnsigned(signature, value);
+            return value;
+        };
+
+        auto elementType = static_cast<SignatureElementType>(*signature++);
+        switch (elementType) {
+            case SignatureElementType::Void:        return "void";
+            case SignatureElementType::Boolean:     return "bool";
+            case SignatureElementType::Char:        return "char";
+            case SignatureElementType::I1:          return "int8";
+            case SignatureElementType::U1:          return "uint8";
+            case SignatureElementType::I2:          return "int16";
+            case SignatureElementType::U2:          return "uint16";
+            case SignatureElementType::I4:          return "int32";
+            case SignatureElementType::U4:          return "uint32";
+            case SignatureElementType::I8:          return "int64";
+            case SignatureElementType::U8:          return "uint64";
+            case SignatureElementType::R4:          return "float32";
+            case SignatureElementType::R8:          return "float64";
+            case SignatureElementType::String:      return "string";
+            case SignatureElementType::Object:      return "object";
+            case SignatureElementType::I:           return "native int";
+            case SignatureElementType::U:           return "native uint";
+            case SignatureElementType::SzArray:     return this->readTypeName(signature, signatureEnd) + "[]";
+            case SignatureElementType::Ptr:         return this->readTypeName(signature, signatureEnd) + "*";
+            case SignatureElementType::ByRef:       return this->readTypeName(signature, signatureEnd) + "&";
+            case SignatureElementType::Class:
+            case SignatureElementType::ValueType:
+                readUnsigned();
+                return "?";
+            case SignatureElementType::Var:
+                return "!" + std::to_string(readUnsigned());
+            case SignatureElementType::MVar:
+                return "!!" + std::to_string(readUnsigned());
+            case SignatureElementType::GenericInst: {
+                signature++; // Class or ValueType
+                std::string name = this->getTypeName(decodeTypeDefOrRef(readUnsigned()));
+
+                u32 numArguments = readUnsigned();
+                name += "<";
+                for (u32 i = 0; i < numArguments; i++) {
+                    if (i > 0)
+                        name += ",";
+                    name += this->readTypeName(signature, signatureEnd);
+                }
+                name += ">";
+
+                return name;
+            }
+            default:
+                // Can't know how long the rest of the signature is
+                signature = signatureEnd;
+                return "?";
+        }
+    }
+
+    // Renders the parameter types of a MemberRef signature, e.g. "(string,int32)"
+    std::string DLL::getMemberRefSignature(u32 memberToken) {
+        if (TABLE_ID(memberToken) != TABLE_ID_MEMBERREF || TABLE_INDEX(memberToken) == 0 || TABLE_INDEX(memberToken) > this->m_numRows[TABLE_ID_MEMBERREF])
+            return "";
+
+        auto memberRef = this->getMemberRefByMetadataToken(memberToken);
+        const u8 *signature = this->getBlob(memberRef->signatureIndex);
+        const u8 *signatureEnd = signature + this->getBlobSize(memberRef->signatureIndex);
+
+        u32 value;
+        u8 callingConvention = *signature++;
+        if (callingConvention & 0x10) // Generic
+            signature += decodeCompressedUnsigned(signature, value);
+
+        u32 numParams;
+        signature += decodeCompressedUnsigned(signature, numParams);
+        this->readTypeName(signature, signatureEnd); // Return type
+
+        std::string result = "(";
+        for (u32 i = 0; i < numParams; i++) {
+            if (i > 0)
+                result += ",";
+            result += this->readTypeName(signature, signatureEnd);
+        }
+        result += ")";
+
+        return result;
+    }
+
+    u32 DLL::getMethodSpecMethod(u32 methodSpecToken) {
+        auto methodSpec = this->getMethodSpecByMetadataToken(methodSpecToken);
+        u8 table = INDEX_TAG(methodSpec->methodIndex, METHOD_DEF_OR_REF) == 0 ? TABLE_ID_METHODDEF : TABLE_ID_MEMBERREF;
+
+        return (table << 24) | INDEX_INDEX(methodSpec->methodIndex, METHOD_DEF_OR_REF);
+    }
+
+    // Instantiations of generic methods are named after the method with the type arguments appended, e.g.
+    // "[System.Runtime]System.Numerics.Vector::Dot<int32>"
+    std::string DLL::getMethodSpecName(u32 methodSpecToken) {
+        if (TABLE_ID(methodSpecToken) != TABLE_ID_METHODSPEC || TABLE_INDEX(methodSpecToken) == 0 || TABLE_INDEX(methodSpecToken) > this->m_numRows[TABLE_ID_METHODSPEC])
+            return "";
+
+        u32 method = this->getMethodSpecMethod(methodSpecToken);
+        std::string name;
+        if (TABLE_ID(method) == TABLE_ID_MEMBERREF)
+            name = this->getMemberRefName(method);
+        else if (TABLE_INDEX(method) != 0 && TABLE_INDEX(method) <= this->m_numRows[TABLE_ID_METHODDEF])
+            name = this->getString(this->getMethodDefByMetadataToken(method)->nameIndex);
+
+        auto methodSpec = this->getMethodSpecByMetadataToken(methodSpecToken);
+        const u8 *signature = this->getBlob(methodSpec->instantiationIndex);
+        const u8 *signatureEnd = signature + this->getBlobSize(methodSpec->instantiationIndex);
+
+        if (signature >= signatureEnd || *signature++ != 0x0A) // GenericInst
+            return name;
+
+        u32 numArguments;
+        signature += decodeCompressedUnsigned(signature, numArguments);
+
+        name += "<";
+        for (u32 i = 0; i < numArguments; i++) {
+            if (i > 0)
+                name += ",";
+            name += this->readTypeName(signature, signatureEnd);
+        }
+        name += ">";
+
+        return name;
+    }
+
+    // Maps a parameter or return type onto the type its values have on the evaluation stack. Returns false for
+    // anything that can't be passed around yet. Structs passed by value also get their layout
+    bool DLL::decodeStackType(const u8 *&signature, const u8 *signatureEnd, Type &type, const GenericContext *genericContext, const TypeLayout **valueType) {
+        while (signature < signatureEnd) {
+            auto elementType = static_cast<SignatureElementType>(*signature++);
+            switch (elementType) {
+                case SignatureElementType::Void:
+                    type = Type::Invalid;
+                    return true;
+                case SignatureElementType::Boolean:
+                case SignatureElementType::Char:
+                case SignatureElementType::I1:
+                case SignatureElementType::U1:
+                case SignatureElementType::I2:
+                case SignatureElementType::U2:
+                case SignatureElementType::I4:
+                case SignatureElementType::U4:
+                    type = Type::Int32;
+                    return true;
+                case SignatureElementType::I8:
+                case SignatureElementType::U8:
+                    type = Type::Int64;
+                    return true;
+                case SignatureElementType::R4:
+                case SignatureElementType::R8:
+                    type = Type::F;
+                    return true;
+                case SignatureElementType::I:
+                case SignatureElementType::U:
+                    type = Type::Native_int;
+                    return true;
+                case SignatureElementType::String:
+                case SignatureElementType::Object:
+                    type = Type::O;
+                    return true;
+                case SignatureElementType::Class: {
+                    u32 typeDefOrRef;
+                    signature += DLL::decodeCompressedUnsigned(signature, typeDefOrRef);
+                    type = Type::O;
+                    return true;
+                }
+                case SignatureElementType::SzArray: {
+                    // Only the reference to the array is passed, the element type doesn't matter
+                    Type elementStackType;
+                    if (!this->decodeStackType(signature, signatureEnd, elementStackType, genericContext))
+                        return false;
+
+                    type = Type::O;
+                    return true;
+                }
+                case SignatureElementType::Ptr:
+                case SignatureElementType::ByRef: {
+                    Type pointeeType;
+                    if (!this->decodeStackType(signature, signatureEnd, pointeeType, genericContext))
+                        return false;
+
+                    type = Type::Pointer;
+                    return true;
+                }
+                case SignatureElementType::ValueType:
+                case SignatureElementType::GenericInst: {
+                    if (elementType == SignatureElementType::GenericInst && static_cast<SignatureElementType>(*signature) == SignatureElementType::Class) {
+                        // The arguments don't change how an instantiation is passed, only the generic type does
+                        signature--;
+                        if (!skipType(signature, signatureEnd))
+                            return false;
+
+                        type = Type::O;
+                        return true;
+                    }
+
+                    // Enums are passed as their underlying type, everything else by value
+                    signature--;
+                    ValueLayout layout;
+                    if (!this->decodeValueLayout(signature, signatureEnd, layout, genericContext) || layout.type == Type::Invalid)
+                        return false;
+
+                    type = layout.type;
+                    if (valueType != nullptr)
+                        *valueType = layout.valueType;
+
+                    return true;
+                }
+                case SignatureElementType::Var:
+                case SignatureElementType::MVar: {
+                    u32 number;
+                    signature += DLL::decodeCompressedUnsigned(signature, number);
+
+                    if (genericContext == nullptr)
+                        return false;
+
+                    auto &arguments = elementType == SignatureElementType::Var ? genericContext->typeArguments : genericContext->methodArguments;
+                    if (number >= arguments.size())
+                        return false;
+
+                    // Type arguments are closed types, they never refer back to the context
+                    const u8 *argument = arguments[number].data();
+                    return this->decodeStackType(argument, argument + arguments[number].size(), type, nullptr, valueType);
+                }
+                case SignatureElementType::Pinned:
+                    break;
+                case SignatureElementType::CmodReqd:
+                case SignatureElementType::CmodOpt: {
+                    // Custom modifiers don't change how the value is passed
+                    u32 typeDefOrRef;
+                    signature += DLL::decodeCompressedUnsigned(signature, typeDefOrRef);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        return false;
+    }
+
+    // Resolves a MethodSpec to the method it instantiates and collects the type arguments of that instantiation and
+    // of the generic type a MemberRef belongs to
+    bool DLL::getGenericContext(u32 methodToken, u32 &memberRefToken, GenericContext &genericContext) {
+        memberRefToken = methodToken;
+
+        if (TABLE_ID(methodToken) == TABLE_ID_METHODSPEC) {
+            if (TABLE_INDEX(methodToken) == 0 || TABLE_INDEX(methodToken) > this->m_numRows[TABLE_ID_METHODSPEC])
+                return false;
+
+            auto methodSpec = this->getMethodSpecByMetadataToken(methodToken);
+            const u8 *instantiation = this->getBlob(methodSpec->instantiationIndex);
+            const u8 *instantiationEnd = instantiation + this->getBlobSize(methodSpec->instantiationIndex);
+
+            if (instantiation >= instantiationEnd || *instantiation++ != 0x0A) // GenericInst
+                return false;
+            if (!readTypeArguments(instantiation, instantiationEnd, genericContext.methodArguments))
+                return false;
+
+            memberRefToken = this->getMethodSpecMethod(methodToken);
+        }
+
+        if (TABLE_ID(memberRefToken) != TABLE_ID_MEMBERREF)
+            return true;
+
+        auto memberRef = this->getMemberRefByMetadataToken(memberRefToken);
+        u32 typeSpecIndex = INDEX_INDEX(memberRef->classIndex, MEMBER_REF_PARENT);
+        if (INDEX_TAG(memberRef->classIndex, MEMBER_REF_PARENT) != 4 || typeSpecIndex == 0 || typeSpecIndex > this->m_numRows[TABLE_ID_TYPESPEC]) // TypeSpec
+            return true;
+
+        auto typeSpec = this->getTypeSpecByIndex(typeSpecIndex);
+        const u8 *typeSignature = this->getBlob(typeSpec->signatureIndex);
+        const u8 *typeSignatureEnd = typeSignature + this->getBlobSize(typeSpec->signatureIndex);
+
+        // Members of arrays and the like have no type arguments
+        if (typeSignatureEnd - typeSignature < 2 || static_cast<SignatureElementType>(typeSignature[0]) != SignatureElementType::GenericInst)
+            return true;
+        typeSignature += 2; // Class or ValueType
+
+        u32 typeDefOrRef;
+        typeSignature += decodeCompressedUnsigned(typeSignature, typeDefOrRef);
+
+        return readTypeArguments(typeSignature, typeSignatureEnd, genericContext.typeArguments);
+    }
+
+    // Finds the MethodDef a MemberRef to a member of a generic type of this assembly, like Box<int>::Get, refers to.
+    // 0 for members of types from other assemblies
+    u32 DLL::findMethodDefOfMemberRef(u32 memberRefToken) {
+        auto memberRef = this->getMemberRefByMetadataToken(memberRefToken);
+        u32 typeSpecIndex = INDEX_INDEX(memberRef->classIndex, MEMBER_REF_PARENT);
+        if (INDEX_TAG(memberRef->classIndex, MEMBER_REF_PARENT) != 4 || typeSpecIndex == 0 || typeSpecIndex > this->m_numRows[TABLE_ID_TYPESPEC]) // TypeSpec
+            return 0;
+
+        auto typeSpec = this->getTypeSpecByIndex(typeSpecIndex);
+        const u8 *typeSignature = this->getBlob(typeSpec->signatureIndex);
+        const u8 *typeSignatureEnd = typeSignature + this->getBlobSize(typeSpec->signatureIndex);
+
+        if (typeSignatureEnd - typeSignature < 3 || static_cast<SignatureElementType>(typeSignature[0]) != SignatureElementType::GenericInst)
+            return 0;
+
+        u32 typeDefOrRef;
+        decodeCompressedUnsigned(typeSignature + 2, typeDefOrRef);
+
+        u32 typeIndex = typeDefOrRef >> 2;
+        u32 numTypes = this->m_numRows[TABLE_ID_TYPEDEF];
+        if ((typeDefOrRef & 0b11) != 0 || typeIndex == 0 || typeIndex > numTypes) // TypeDef
+            return 0;
+
+        // The MemberRef carries the signature of the generic definition, so it matches the MethodDef byte for byte
+        const char *name = this->getString(memberRef->nameIndex);
+        std::span<const u8> signature(this->getBlob(memberRef->signatureIndex), this->getBlobSize(memberRef->signatureIndex));
+
+        u32 numMethods = this->m_numRows[TABLE_ID_METHODDEF];
+        u32 methodListEnd = typeIndex < numTypes ? this->getTypeDefByIndex(typeIndex + 1)->methodListIndex : numMethods + 1;
+        for (u32 method = this->getTypeDefByIndex(typeIndex)->methodListIndex; method < methodListEnd && method <= numMethods; method++) {
+            auto methodDef = this->getMethodDefByIndex(method);
+            if (std::strcmp(this->getString(methodDef->nameIndex), name) != 0)
+                continue;
+
+            std::span<const u8> methodSignature(this->getBlob(methodDef->signatureIndex), this->getBlobSize(methodDef->signatureIndex));
+            if (std::equal(signature.begin(), signature.end(), methodSignature.begin(), methodSignature.end()))
+                return (TABLE_ID_METHODDEF << 24) | method;
+        }
+
+        return 0;
+    }
+
+    // Whether a type in a signature refers to a generic parameter anywhere. Types that can't be read count as open
+    static bool isOpenType(const u8 *&signature, const u8 *signatureEnd) {
+        if (signature >= signatureEnd)
+            return true;
+
+        u32 value;
+        auto elementType = static_cast<SignatureElementType>(*signature++);
+        switch (elementType) {
+            case SignatureElementType::Var:
+            case SignatureElementType::MVar:
+                return true;
+            case SignatureElementType::SzArray:
+            case SignatureElementType::Ptr:
+            case SignatureElementType::ByRef:
+                return isOpenType(signature, signatureEnd);
+            case SignatureElementType::GenericInst: {
+                signature++; // Class or ValueType
+                signature += DLL::decodeCompressedUnsigned(signature, value);
+
+                u32 numArguments;
+                signature += DLL::decodeCompressedUnsigned(signature, numArguments);
+
+                bool open = false;
+                for (u32 i = 0; i < numArguments; i++)
+                    open |= isOpenType(signature, signatureEnd);
+
+                return open;
+            }
+            default:
+                signature--;
+                return !skipType(signature, signatureEnd);
+        }
+    }
+
+    // Every reference type argument is replaced with this, so all instantiations over reference types share their code
+    static constexpr u8 CanonicalReferenceType[] = { u8(SignatureElementType::Object) };
+
+    // Brings type arguments into the form instantiations are looked up by. Generic parameters in them refer to the
+    // instantiation the call comes from and get replaced with its arguments, which are canonical already
+    static bool canonicalizeTypeArguments(std::vector<std::span<const u8>> &arguments, const GenericContext *callerContext) {
+        for (auto &argument : arguments) {
+            const u8 *signature = argument.data();
+            auto elementType = static_cast<SignatureElementType>(*signature++);
+
+            switch (elementType) {
+                case SignatureElementType::Var:
+                case SignatureElementType::MVar: {
+                    u32 number;
+                    DLL::decodeCompressedUnsigned(signature, number);
+
+                    if (callerContext == nullptr)
+                        return false;
+
+                    auto &callerArguments = elementType == SignatureElementType::Var ? callerContext->typeArguments : callerContext->methodArguments;
+                    if (number >= callerArguments.size())
+                        return false;
+
+                    argument = callerArguments[number];
+                    break;
+                }
+                case SignatureElementType::String:
+                case SignatureElementType::Object:
+                case SignatureElementType::Class:
+                case SignatureElementType::SzArray:
+                case SignatureElementType::Array:
+                    argument = CanonicalReferenceType;
+                    break;
+                case SignatureElementType::GenericInst: {
+                    if (static_cast<SignatureElementType>(*signature) == SignatureElementType::Class) {
+                        argument = CanonicalReferenceType;
+                        break;
+                    }
+
+                    // A value type over a generic parameter would need a signature of its own for every instantiation
+                    const u8 *type = argument.data();
+                    if (isOpenType(type, argument.data() + argument.size()))
+                        return false;
+                    break;
+                }
+                default:
+                    // Primitives and value types get code of their own
+                    break;
+            }
+        }
+
+        return true;
+    }
+
+    // Finds the method of this assembly a MethodSpec or a MemberRef to a member of a generic type instantiates, along
+    // with the canonical type arguments it's instantiated with. methodDefToken is 0 for methods of other assemblies,
+    // false is returned for instantiations that can't be represented
+    bool DLL::resolveInstantiation(u32 methodToken, const GenericContext *callerContext, u32 &methodDefToken, GenericContext &genericContext) {
+        methodDefToken = 0;
+        genericContext = { };
+
+        u32 memberToken;
+        if (!this->getGenericContext(methodToken, memberToken, genericContext))
+            return false;
+
+        if (TABLE_ID(memberToken) == TABLE_ID_MEMBERREF)
+            memberToken = this->findMethodDefOfMemberRef(memberToken);
+
+        if (TABLE_ID(memberToken) != TABLE_ID_METHODDEF || TABLE_INDEX(memberToken) == 0 || TABLE_INDEX(memberToken) > this->m_numRows[TABLE_ID_METHODDEF])
+            return true;
+
+        methodDefToken = memberToken;
+
+        return canonicalizeTypeArguments(genericContext.typeArguments, callerContext) && canonicalizeTypeArguments(genericContext.methodArguments, callerContext);
+    }
+
+    // The type argument a TypeSpec consisting of nothing but a generic parameter stands for, e.g. the element type
+    // of new T[]. Empty for every other type
+    std::span<const u8> DLL::getTypeArgument(u32 typeToken, const GenericContext &genericContext) {
+        if (TABLE_ID(typeToken) != TABLE_ID_TYPESPEC || TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > this->m_numRows[TABLE_ID_TYPESPEC])
+            return { };
+
+        auto typeSpec = this->getTypeSpecByIndex(TABLE_INDEX(typeToken));
+        const u8 *signature = this->getBlob(typeSpec->signatureIndex);
+        if (this->getBlobSize(typeSpec->signatureIndex) < 2)
+            return { };
+
+        auto elementType = static_cast<SignatureElementType>(*signature++);
+        if (elementType != SignatureElementType::Var && elementType != SignatureElementType::MVar)
+            return { };
+
+        u32 number;
+        decodeCompressedUnsigned(signature, number);
+
+        auto &arguments = elementType == SignatureElementType::Var ? genericContext.typeArguments : genericContext.methodArguments;
+        if (number >= arguments.size())
+            return { };
+
+        return arguments[number];
+    }
+
+    // Replaces the generic parameters in the name of a native with the type arguments of the calling instantiation,
+    // e.g. "List`1<!0>::Add" called from code instantiated over int32 becomes "List`1<int32>::Add"
+    std::string DLL::instantiateName(std::string_view name, const GenericContext &genericContext) {
+        std::string result;
+
+        size_t position = 0;
+        while (position < name.size()) {
+            size_t parameter = name.find('!', position);
+            if (parameter == std::string_view::npos)
+                break;
+
+            bool methodParameter = parameter + 1 < name.size() && name[parameter + 1] == '!';
+            const char *numberStart = name.data() + parameter + (methodParameter ? 2 : 1);
+
+            u32 number;
+            auto [numberEnd, error] = std::from_chars(numberStart, name.data() + name.size(), number);
+            auto &arguments = methodParameter ? genericContext.methodArguments : genericContext.typeArguments;
+
+            result += name.substr(position, parameter - position);
+            position = numberEnd - name.data();
+
+            if (error != std::errc() || number >= arguments.size()) {
+                result += name.substr(parameter, position - parameter);
+                continue;
+            }
+
+            const u8 *argument = arguments[number].data();
+            result += this->readTypeName(argument, argument + arguments[number].size());
+        }
+
+        result += name.substr(position);
+
+        return result;
+    }
+
+    // MemberRefs to methods use the same signature format as MethodDefs. The ones of generic types and generic methods
+    // get their Var and MVar resolved from the type arguments of the instantiation
+    bool DLL::decodeMethodSignature(u32 methodToken, MethodSignature &signature, const GenericContext *instantiation) {
+        signature = { };
+
+        GenericContext genericContext;
+        if (!this->getGenericContext(methodToken, methodToken, genericContext))
+            return false;
+
+        // Generic MethodDefs have no type arguments of their own, they come from whoever instantiated them
+        if (instantiation != nullptr)
+            genericContext = *instantiation;
+
+        u32 signatureIndex;
+        if (TABLE_ID(methodToken) == TABLE_ID_MEMBERREF)
+            signatureIndex = this->getMemberRefByMetadataToken(methodToken)->signatureIndex;
+        else
+            signatureIndex = this->getMethodDefByMetadataToken(methodToken)->signatureIndex;
+
+        const u8 *blob = this->getBlob(signatureIndex);
+        const u8 *blobEnd = blob + this->getBlobSize(signatureIndex);
+
+        if (blob >= blobEnd)
+            return false;
+
+        u8 callingConvention = *blob++;
+        if (callingConvention & 0x10) { // Generic
+            u32 numGenericParams;
+            blob += decodeCompressedUnsigned(blob, numGenericParams);
+        }
+
+        u32 numParams;
+        blob += decodeCompressedUnsigned(blob, numParams);
+
+        if (!this->decodeStackType(blob, blobEnd, signature.returnType, &genericContext, &signature.returnValueType))
+            return false;
+
+        signature.hasThis = callingConvention & 0x20;
+        if (signature.hasThis) {
+            // Reference types get their this as an object reference, vectors and structs as a managed pointer to the value
+            Type thisType = Type::O;
+            if (TABLE_ID(methodToken) == TABLE_ID_MEMBERREF) {
+                u16 parent = this->getMemberRefByMetadataToken(methodToken)->classIndex;
+                if (INDEX_TAG(parent, MEMBER_REF_PARENT) == 4 && this->isVectorType((TABLE_ID_TYPESPEC << 24) | INDEX_INDEX(parent, MEMBER_REF_PARENT))) // TypeSpec
+                    thisType = Type::Pointer;
+            } else if (this->isValueType(this->findTypeDefWithMethod(methodToken))) {
+                thisType = Type::Pointer;
+            }
+
+            signature.parameters.push_back({ thisType, 0 });
+            signature.argumentsSize = getTypeSize(thisType);
+        }
+
+        for (u32 i = 0; i < numParams; i++) {
+            Type type;
+            const TypeLayout *valueType = nullptr;
+            if (!this->decodeStackType(blob, blobEnd, type, &genericContext, &valueType) || type == Type::Invalid)
+                return false;
+
+            signature.parameters.push_back({ type, signature.argumentsSize, valueType });
+            signature.argumentsSize += type == Type::ValueType ? valueType->size + sizeof(u32) : getTypeSize(type);
+        }
+
+        return true;
+    }
+
+    // Types of all locals in a LocalVarSig. Invalid for the ones that can't be held on the evaluation stack. Struct
+    // locals also get their layout, every other one nullptr
+    bool DLL::decodeLocalTypes(u32 localVarSigToken, std::vector<Type> &types, const GenericContext *genericContext, std::vector<const TypeLayout*> *valueTypes) {
+        types.clear();
+        if (valueTypes != nullptr)
+            valueTypes->clear();
+
+        if (localVarSigToken == 0)
+            return true;
+        if (TABLE_ID(localVarSigToken) != TABLE_ID_STANDALONESIG || TABLE_INDEX(localVarSigToken) == 0 || TABLE_INDEX(localVarSigToken) > this->m_numRows[TABLE_ID_STANDALONESIG])
+            return false;
+
+        u32 signatureIndex = this->getStandAloneSigByIndex(TABLE_INDEX(localVarSigToken))->signatureIndex;
+        const u8 *signature = this->getBlob(signatureIndex);
+        const u8 *signatureEnd = signature + this->getBlobSize(signatureIndex);
+
+        if (signature >= signatureEnd || *signature++ != 0x07) // LocalSig
+            return false;
+
+        u32 numLocals;
+        signature += decodeCompressedUnsigned(signature, numLocals);
+
+        for (u32 i = 0; i < numLocals; i++) {
+            const u8 *nextLocal = signature;
+            if (!skipType(nextLocal, signatureEnd))
+                return false;
+
+            Type type;
+            const TypeLayout *valueType = nullptr;
+            if (!this->decodeStackType(signature, signatureEnd, type, genericContext, &valueType))
+                type = Type::Invalid;
+
+            types.push_back(type);
+            if (valueTypes != nullptr)
+                valueTypes->push_back(type == Type::ValueType ? valueType : nullptr);
+
+            signature = nextLocal;
+        }
+
+        return true;
+    }
+
+    // Exception handling tables live in the extra data sections that follow the code of methods with a fat header
+    bool DLL::decodeExceptionClauses(u32 methodToken, std::vector<ExceptionClause> &clauses) {
+        clauses.clear();
+
+        const method_body_t *body = this->getMethodBody(methodToken);
+        if (body == nullptr || body->codeOffset == 0 || (body->flags & 0x08) == 0) // MoreSects
+            return true;
+
+        u32 sectionOffset = (body->codeOffset + body->codeSize + 3) & ~3U;
+        while (true) {
+            if (sectionOffset + sizeof(u32) > this->m_fileSize)
+                return false;
+
+            const u8 *section = OFFSET(this->m_dllData, sectionOffset);
+            u8 kind = section[0];
+            bool fat = kind & 0x40;
+            u32 sectionSize = fat ? section[1] | (section[2] << 8) | (section[3] << 16) : section[1];
+
+            if (sectionSize < sizeof(u32) || sectionOffset + sectionSize > this->m_fileSize)
+                return false;
+
+            if (kind & 0x01) { // EHTable
+                u32 clauseSize = fat ? sizeof(exception_clause_fat_t) : sizeof(exception_clause_small_t);
+
+                for (u32 offset = sizeof(u32); offset + clauseSize <= sectionSize; offset += clauseSize) {
+                    exception_clause_fat_t clause;
+
+                    if (fat) {
+                        std::memcpy(&clause, section + offset, sizeof(clause));
+                    } else {
+                        exception_clause_small_t smallClause;
+                        std::memcpy(&smallClause, section + offset, sizeof(smallClause));
+
+                        clause = { smallClause.flags, smallClause.tryOffset, smallClause.tryLength, smallClause.handlerOffset, smallClause.handlerLength, smallClause.classTokenOrFilterOffset };
+                    }
+
+                    ExceptionClause decoded = { };
+                    switch (clause.flags) {
+                        case 0x00:
+                            decoded.kind = ExceptionClauseKind::Catch;
+                            decoded.classToken = clause.classTokenOrFilterOffset;
+                            break;
+                        case 0x01:
+                            decoded.kind = ExceptionClauseKind::Filter;
+                            decoded.filterStart = clause.classTokenOrFilterOffset;
+                            break;
+                        case 0x02:
+                            decoded.kind = ExceptionClauseKind::Finally;
+                            break;
+                        case 0x04:
+                            decoded.kind = ExceptionClauseKind::Fault;
+                            break;
+                        default:
+                            return false;
+                    }
+
+                    decoded.tryStart = clause.tryOffset;
+                    decoded.tryEnd = clause.tryOffset + clause.tryLength;
+                    decoded.handlerStart = clause.handlerOffset;
+                    decoded.handlerEnd = clause.handlerOffset + clause.handlerLength;
+
+                    clauses.push_back(decoded);
+                }
+            }
+
+            if ((kind & 0x80) == 0) // MoreSects
+                break;
+
+            sectionOffset = (sectionOffset + sectionSize + 3) & ~3U;
+        }
+
+        return true;
+    }
+
+    std::string DLL::getTypeName(u32 typeToken) {
+        const char *nameSpace, *name;
+
+        if (TABLE_ID(typeToken) == TABLE_ID_TYPEDEF && TABLE_INDEX(typeToken) != 0 && TABLE_INDEX(typeToken) <= this->m_numRows[TABLE_ID_TYPEDEF]) {
+            auto typeDef = this->getTypeDefByIndex(TABLE_INDEX(typeToken));
+            nameSpace = this->getString(typeDef->typeNamespaceIndex);
+            name = this->getString(typeDef->typeNameIndex);
+        } else if (TABLE_ID(typeToken) == TABLE_ID_TYPEREF && TABLE_INDEX(typeToken) != 0 && TABLE_INDEX(typeToken) <= this->m_numRows[TABLE_ID_TYPEREF]) {
+            auto typeRef = this->getTypeRefByIndex(TABLE_INDEX(typeToken));
+            nameSpace = this->getString(typeRef->typeNamespaceIndex);
+            name = this->getString(typeRef->typeNameIndex);
+        } else if (TABLE_ID(typeToken) == TABLE_ID_TYPESPEC) {
+            // Instantiations of generic types from other assemblies, e.g. "System.Collections.Generic.List`1<int32>"
+            std::string path = this->getTypeSpecPath(TABLE_INDEX(typeToken));
+            return path.empty() ? "<unknown>" : path.substr(path.find(']') + 1);
+        } else {
+            return "<unknown>";
+        }
+
+        return *nameSpace == '\0' ? std::string(name) : nameSpace + "."s + name;
+    }
+
+    // Types from other assemblies can't be looked into. Only the bases of the framework's exceptions are known, so
+    // catching one of those also catches the exceptions derived from it
+    static std::string_view getFrameworkBaseType(std::string_view typeName) {
+        constexpr static std::pair<std::string_view, std::string_view> BaseTypes[] = {
+            { "System.Exception",                                   "System.Object" },
+            { "System.SystemException",                             "System.Exception" },
+            { "System.ArithmeticException",                         "System.SystemException" },
+            { "System.DivideByZeroException",                       "System.ArithmeticException" },
+            { "System.OverflowException",                           "System.ArithmeticException" },
+            { "System.ArgumentException",                           "System.SystemException" },
+            { "System.ArgumentNullException",                       "System.ArgumentException" },
+            { "System.ArgumentOutOfRangeException",                 "System.ArgumentException" },
+            { "System.FormatException",                             "System.SystemException" },
+            { "System.IndexOutOfRangeException",                    "System.SystemException" },
+            { "System.InvalidCastException",                        "System.SystemException" },
+            { "System.InvalidOperationException",                   "System.SystemException" },
+            { "System.NullReferenceException",                      "System.SystemException" },
+            { "System.Collections.Generic.KeyNotFoundException",    "System.SystemException" },
+        };
+
+        for (auto [type, base] : BaseTypes) {
+            if (type == typeName)
+                return base;
+        }
+
+        return { };
+    }
+
+    u32 DLL::findTypeRef(std::string_view typeName) {
+        for (u32 i = 1; i <= this->m_numRows[TABLE_ID_TYPEREF]; i++) {
+            if (this->getTypeName((TABLE_ID_TYPEREF << 24) | i) == typeName)
+                return (TABLE_ID_TYPEREF << 24) | i;
+        }
+
+        return 0;
+    }
+
+    // The program can only name the exception types it has a TypeRef for, so the closest of them that the exception
+    // derives from catches it exactly like the exception itself would. 0 if not even System.Object is referenced
+    u32 DLL::getRuntimeExceptionType(std::string_view typeName) {
+        for (; !typeName.empty(); typeName = getFrameworkBaseType(typeName)) {
+            if (u32 typeToken = this->findTypeRef(typeName); typeToken != 0)
+                return typeToken;
+        }
+
+        return 0;
+    }
+
+    // Classes list every interface they implement, including the ones inherited by their interfaces
+    bool DLL::implementsInterface(u32 typeIndex, u32 interfaceToken) {
+        constexpr u8 typeDefOrRefTables[] = { TABLE_ID_TYPEDEF, TABLE_ID_TYPEREF, TABLE_ID_TYPESPEC };
+
+        for (u32 i = 0; i < this->m_numRows[TABLE_ID_INTERFACEIMPL]; i++) {
+            auto interfaceImpl = reinterpret_cast<table_interface_impl_t*>(OFFSET(this->m_tables[TABLE_ID_INTERFACEIMPL].base, i * this->m_tables[TABLE_ID_INTERFACEIMPL].size));
+            if (interfaceImpl->classIndex != typeIndex || INDEX_TAG(interfaceImpl->interfaceIndex, TYPE_DEF_OR_REF) >= std::size(typeDefOrRefTables))
+                continue;
+
+            u32 implementedToken = (typeDefOrRefTables[INDEX_TAG(interfaceImpl->interfaceIndex, TYPE_DEF_OR_REF)] << 24) | INDEX_INDEX(interfaceImpl->interfaceIndex, TYPE_DEF_OR_REF);
+            if (implementedToken == interfaceToken)
+                return true;
+            if (TABLE_ID(implementedToken) == TABLE_ID_TYPEREF && TABLE_ID(interfaceToken) == TABLE_ID_TYPEREF && this->getTypeName(implementedToken) == this->getTypeName(interfaceToken))
+                return true;
+        }
+
+        return false;
+    }
+
+    // Follows the base types of a TypeDef. Once the chain reaches a type from another assembly, it only matches a
+    // type with the same name or one of the known framework bases of it
+    bool DLL::isAssignableTo(u32 typeToken, u32 classToken) {
+        if (TABLE_ID(classToken) == TABLE_ID_TYPEREF && this->getTypeName(classToken) == "System.Object")
+            return true;
+
+        constexpr u8 typeDefOrRefTables[] = { TABLE_ID_TYPEDEF, TABLE_ID_TYPEREF, TABLE_ID_TYPESPEC };
+
+        while (TABLE_ID(typeToken) == TABLE_ID_TYPEDEF && TABLE_INDEX(typeToken) != 0 && TABLE_INDEX(typeToken) <= this->m_numRows[TABLE_ID_TYPEDEF]) {
+            if (typeToken == classToken || this->implementsInterface(TABLE_INDEX(typeToken), classToken))
+                return true;
+
+            u16 extends = this->getTypeDefByIndex(TABLE_INDEX(typeToken))->extendsIndex;
+            if (INDEX_TAG(extends, TYPE_DEF_OR_REF) >= std::size(typeDefOrRefTables))
+                return false;
+
+            typeToken = (typeDefOrRefTables[INDEX_TAG(extends, TYPE_DEF_OR_REF)] << 24) | INDEX_INDEX(extends, TYPE_DEF_OR_REF);
+        }
+
+        if (TABLE_ID(typeToken) != TABLE_ID_TYPEREF || TABLE_INDEX(typeToken) == 0)
+            return false;
+
+        if (typeToken == classToken)
+            return true;
+        if (TABLE_ID(classToken) != TABLE_ID_TYPEREF)
+            return false;
+
+        std::string typeName = this->getTypeName(typeToken);
+        std::string className = this->getTypeName(classToken);
+        for (std::string_view name = typeName; !name.empty(); name = getFrameworkBaseType(name)) {
+            if (name == className)
+                return true;
+        }
+
+        return false;
+    }
+
+    // Vector<T>, Vector128<T> and Vector256<T> are the only value types that can be held on the evaluation stack yet.
+    // Takes the TypeRef of the generic type or a TypeSpec instantiating it
+    bool DLL::isVectorType(u32 typeToken) {
+        if (TABLE_ID(typeToken) == TABLE_ID_TYPESPEC) {
+            if (TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > this->m_numRows[TABLE_ID_TYPESPEC])
+                return false;
+
+            auto typeSpec = this->getTypeSpecByIndex(TABLE_INDEX(typeToken));
+            const u8 *signature = this->getBlob(typeSpec->signatureIndex);
+            const u8 *signatureEnd = signature + this->getBlobSize(typeSpec->signatureIndex);
+
+            if (signatureEnd - signature < 3 || static_cast<SignatureElementType>(signature[0]) != SignatureElementType::GenericInst)
+                return false;
+
+            u32 typeDefOrRef;
+            decodeCompressedUnsigned(signature + 2, typeDefOrRef);
+            typeToken = decodeTypeDefOrRef(typeDefOrRef);
+        }
+
+        if (TABLE_ID(typeToken) != TABLE_ID_TYPEREF)
+            return false;
+
+        auto name = this->getTypeName(typeToken);
+        return name == "System.Numerics.Vector`1" || name == "System.Runtime.Intrinsics.Vector128`1" || name == "System.Runtime.Intrinsics.Vector256`1";
+    }
+
+    // The base type of a TypeDef as a token, 0 for interfaces and System.Object
+    u32 DLL::getBaseType(u32 typeIndex) {
+        constexpr u8 typeDefOrRefTables[] = { TABLE_ID_TYPEDEF, TABLE_ID_TYPEREF, TABLE_ID_TYPESPEC };
+
+        if (typeIndex == 0 || typeIndex > this->m_numRows[TABLE_ID_TYPEDEF])
+            return 0;
+
+        u16 extends = this->getTypeDefByIndex(typeIndex)->extendsIndex;
+        if (INDEX_TAG(extends, TYPE_DEF_OR_REF) >= std::size(typeDefOrRefTables) || INDEX_INDEX(extends, TYPE_DEF_OR_REF) == 0)
+            return 0;
+
+        return (typeDefOrRefTables[INDEX_TAG(extends, TYPE_DEF_OR_REF)] << 24) | INDEX_INDEX(extends, TYPE_DEF_OR_REF);
+    }
+
+    // Structs and enums, which derive from System.ValueType and System.Enum in the core library
+    bool DLL::isValueType(u32 typeIndex) {
+        u32 baseType = this->getBaseType(typeIndex);
+        if (TABLE_ID(baseType) != TABLE_ID_TYPEREF)
+            return false;
+
+        auto name = this->getTypeName(baseType);
+        return name == "System.ValueType" || name == "System.Enum";
+    }
+
+    // Primitives get referred to through TypeRefs into the core library in tokens and in the signatures of enums
+    static SignatureElementType getPrimitiveElementType(const std::string &name) {
+        static const std::unordered_map<std::string, SignatureElementType> primitives = {
+            { "System.Boolean", SignatureElementType::Boolean },
+            { "System.Char",    SignatureElementType::Char },
+            { "System.SByte",   SignatureElementType::I1 },
+            { "System.Byte",    SignatureElementType::U1 },
+            { "System.Int16",   SignatureElementType::I2 },
+            { "System.UInt16",  SignatureElementType::U2 },
+            { "System.Int32",   SignatureElementType::I4 },
+            { "System.UInt32",  SignatureElementType::U4 },
+            { "System.Int64",   SignatureElementType::I8 },
+            { "System.UInt64",  SignatureElementType::U8 },
+            { "System.Single",  SignatureElementType::R4 },
+            { "System.Double",  SignatureElementType::R8 },
+            { "System.IntPtr",  SignatureElementType::I },
+            { "System.UIntPtr", SignatureElementType::U },
+        };
+
+        auto primitive = primitives.find(name);
+        return primitive == primitives.end() ? SignatureElementType::End : primitive->second;
+    }
+
+    static void setPrimitiveLayout(ValueLayout &layout, SignatureElementType elementType) {
+        u8 size = getSignatureElementTypeSize(elementType);
+        if (elementType == SignatureElementType::I || elementType == SignatureElementType::U)
+            size = sizeof(u64);
+
+        layout = { };
+        layout.elementType = elementType;
+        layout.size = size;
+        layout.alignment = size;
+
+        switch (elementType) {
+            case SignatureElementType::I8:
+            case SignatureElementType::U8:
+                layout.type = Type::Int64;
+                break;
+            case SignatureElementType::R4:
+            case SignatureElementType::R8:
+                layout.type = Type::F;
+                break;
+            case SignatureElementType::I:
+            case SignatureElementType::U:
+                layout.type = Type::Native_int;
+                break;
+            default:
+                layout.type = Type::Int32;
+                break;
+        }
+    }
+
+    static void setReferenceLayout(ValueLayout &layout, Type type = Type::O) {
+        layout = { };
+        layout.type = type;
+        layout.elementType = type == Type::O ? SignatureElementType::Class : SignatureElementType::Ptr;
+        layout.size = sizeof(u64);
+        layout.alignment = sizeof(u64);
+    }
+
+    static void setValueTypeLayout(ValueLayout &layout, const TypeLayout *valueType) {
+        // Enums are nothing but their value__ field
+        if (valueType->isEnum) {
+            for (auto &field : valueType->fields) {
+                if (!field.isStatic) {
+                    layout = field.value;
+                    return;
+                }
+            }
+        }
+
+        layout = { };
+        layout.type = Type::ValueType;
+        layout.elementType = SignatureElementType::ValueType;
+        layout.size = valueType->size;
+        layout.alignment = valueType->alignment;
+        layout.valueType = valueType;
+    }
+
+    // Lays out a TypeDef with the canonical type arguments of an instantiation, or with none for everything that's
+    // not generic. Fields whose type can't be stored get a reference sized slot that can't be accessed
+    const TypeLayout* DLL::layOutType(u32 typeIndex, const std::vector<std::span<const u8>> &typeArguments) {
+        std::scoped_lock lock(this->m_layoutMutex);
+
+        std::string key(reinterpret_cast<const char*>(&typeIndex), sizeof(typeIndex));
+        for (auto &argument : typeArguments)
+            key.append(reinterpret_cast<const char*>(argument.data()), argument.size());
+
+        // Fields never hold a struct they're part of, so this never gets looked up again before it's filled in
+        auto &cached = this->m_typeLayouts[key];
+        if (cached != nullptr)
+            return cached.get();
+
+        auto layout = std::make_unique<TypeLayout>();
+        auto typeDef = this->getTypeDefByIndex(typeIndex);
+        u32 numTypes = this->m_numRows[TABLE_ID_TYPEDEF];
+        u32 numFields = this->m_numRows[TABLE_ID_FIELD];
+
+        GenericContext genericContext;
+        genericContext.typeArguments = typeArguments;
+
+        layout->typeToken = (TABLE_ID_TYPEDEF << 24) | typeIndex;
+        layout->fieldListStart = typeDef->fieldListIndex;
+        layout->isValueType = this->isValueType(typeIndex);
+        layout->isEnum = layout->isValueType && this->getTypeName(this->getBaseType(typeIndex)) == "System.Enum";
+
+        // Objects start with the fields of their base type
+        u32 offset = 0;
+        if (!layout->isValueType) {
+            u32 baseType = this->getBaseType(typeIndex);
+            const TypeLayout *baseLayout = nullptr;
+
+            if (TABLE_ID(baseType) == TABLE_ID_TYPEDEF) {
+                baseLayout = this->layOutType(TABLE_INDEX(baseType), { });
+            } else if (TABLE_ID(baseType) == TABLE_ID_TYPESPEC && TABLE_INDEX(baseType) <= this->m_numRows[TABLE_ID_TYPESPEC]) {
+                auto typeSpec = this->getTypeSpecByIndex(TABLE_INDEX(baseType));
+                const u8 *signature = this->getBlob(typeSpec->signatureIndex);
+                const u8 *signatureEnd = signature + this->getBlobSize(typeSpec->signatureIndex);
+
+                if (signature < signatureEnd && static_cast<SignatureElementType>(*signature++) == SignatureElementType::GenericInst)
+                    baseLayout = this->layOutInstantiation(signature, signatureEnd, &genericContext);
+            }
+
+            if (baseLayout != nullptr) {
+                offset = baseLayout->size;
+                layout->alignment = baseLayout->alignment;
+                layout->referenceOffsets = baseLayout->referenceOffsets;
+            }
+        }
+
+        auto classLayout = this->getClassLayoutOfType(typeDef);
+        u32 packingSize = classLayout != nullptr ? classLayout->packingSize : 0;
+
+        u32 fieldListEnd = typeIndex < numTypes ? this->getTypeDefByIndex(typeIndex + 1)->fieldListIndex : numFields + 1;
+        for (u32 i = typeDef->fieldListIndex; i < fieldListEnd && i <= numFields; i++) {
+            auto field = this->getFieldByIndex(i);
+
+            FieldLayout fieldLayout;
+            fieldLayout.isStatic = field->flags & 0x10; // Static, which literals are as well
+
+            // Static fields can be of the type they belong to, they're decoded once it's laid out
+            if (fieldLayout.isStatic) {
+                layout->fields.push_back(fieldLayout);
+                continue;
+            }
+
+            const u8 *signature = this->getBlob(field->signatureIndex);
+            const u8 *signatureEnd = signature + this->getBlobSize(field->signatureIndex);
+
+            bool valid = signature < signatureEnd && *signature++ == 0x06; // Field
+            valid = valid && this->decodeValueLayout(signature, signatureEnd, fieldLayout.value, &genericContext);
+            if (!valid || fieldLayout.value.type == Type::Invalid) {
+                fieldLayout.value = { };
+                fieldLayout.value.size = sizeof(u64);
+                fieldLayout.value.alignment = sizeof(u64);
+            }
+
+            u32 alignment = packingSize != 0 ? std::min<u32>(fieldLayout.value.alignment, packingSize) : fieldLayout.value.alignment;
+            offset = (offset + alignment - 1) / alignment * alignment;
+
+            fieldLayout.offset = offset;
+            if (fieldLayout.value.type == Type::O || fieldLayout.value.type == Type::Pointer) {
+                layout->referenceOffsets.push_back(offset);
+            } else if (fieldLayout.value.valueType != nullptr) {
+                for (u32 nestedOffset : fieldLayout.value.valueType->referenceOffsets)
+                    layout->referenceOffsets.push_back(offset + nestedOffset);
+            }
+
+            offset += fieldLayout.value.size;
+            layout->alignment = std::max(layout->alignment, alignment);
+
+            layout->fields.push_back(fieldLayout);
+        }
+
+        layout->size = (offset + layout->alignment - 1) / layout->alignment * layout->alignment;
+
+        // Structs without fields still take up a byte, and an explicit size can only make a type bigger
+        if (layout->isValueType)
+            layout->size = std::max<u32>(layout->size, 1);
+        if (classLayout != nullptr)
+            layout->size = std::max(layout->size, classLayout->classSize);
+
+        layout->copy = ValueTypes::getCopyHandler(layout->size);
+
+        cached = std::move(layout);
+        auto result = cached.get();
+
+        for (u32 i = 0; i < result->fields.size(); i++) {
+            auto &fieldLayout = result->fields[i];
+            if (!fieldLayout.isStatic)
+                continue;
+
+            auto field = this->getFieldByIndex(result->fieldListStart + i);
+            const u8 *signature = this->getBlob(field->signatureIndex);
+            const u8 *signatureEnd = signature + this->getBlobSize(field->signatureIndex);
+
+            if (signature >= signatureEnd || *signature++ != 0x06 || !this->decodeValueLayout(signature, signatureEnd, fieldLayout.value, &genericContext))
+                fieldLayout.value = { };
+        }
+
+        return result;
+    }
+
+    // Lays out the generic type of the program a GenericInst signature instantiates, starting right after the
+    // GenericInst. Nullptr for generic types of other assemblies
+    const TypeLayout* DLL::layOutInstantiation(const u8 *&signature, const u8 *signatureEnd, const GenericContext *genericContext) {
+        if (signature >= signatureEnd)
+            return nullptr;
+        signature++; // Class or ValueType
+
+        u32 typeDefOrRef;
+        signature += decodeCompressedUnsigned(signature, typeDefOrRef);
+
+        std::vector<std::span<const u8>> arguments;
+        if (!readTypeArguments(signature, signatureEnd, arguments))
+            return nullptr;
+
+        u32 typeToken = decodeTypeDefOrRef(typeDefOrRef);
+        if (TABLE_ID(typeToken) != TABLE_ID_TYPEDEF || TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > this->m_numRows[TABLE_ID_TYPEDEF])
+            return nullptr;
+
+        // Instantiations over different reference types store the same thing, a reference
+        if (!canonicalizeTypeArguments(arguments, genericContext))
+            return nullptr;
+
+        return this->layOutType(TABLE_INDEX(typeToken), arguments);
+    }
+
+    // Layout of a TypeDef, or of the instantiation of a generic TypeDef a TypeSpec refers to. Generic parameters in
+    // the TypeSpec are resolved from genericContext
+    const TypeLayout* DLL::getTypeLayout(u32 typeToken, const GenericContext *genericContext) {
+        if (TABLE_ID(typeToken) == TABLE_ID_TYPEDEF) {
+            if (TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > this->m_numRows[TABLE_ID_TYPEDEF])
+                return nullptr;
+
+            return this->layOutType(TABLE_INDEX(typeToken), { });
+        }
+
+        if (TABLE_ID(typeToken) != TABLE_ID_TYPESPEC || TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > this->m_numRows[TABLE_ID_TYPESPEC])
+            return nullptr;
+
+        auto typeSpec = this->getTypeSpecByIndex(TABLE_INDEX(typeToken));
+        const u8 *signature = this->getBlob(typeSpec->signatureIndex);
+        const u8 *signatureEnd = signature + this->getBlobSize(typeSpec->signatureIndex);
+
+        if (signature >= signatureEnd || static_cast<SignatureElementType>(*signature++) != SignatureElementType::GenericInst)
+            return nullptr;
+
+        return this->layOutInstantiation(signature, signatureEnd, genericContext);
+    }
+
+    // Layout of a generic TypeDef in the instantiation a method of it runs in, whose type arguments are canonical already
+    const TypeLayout* DLL::getInstantiationLayout(u32 typeIndex, const GenericContext &instantiation) {
+        if (typeIndex == 0 || typeIndex > this->m_numRows[TABLE_ID_TYPEDEF])
+            return nullptr;
+
+        return this->layOutType(typeIndex, instantiation.typeArguments);
+    }
+
+    // How values of the type a TypeDef, TypeRef or TypeSpec token refers to are stored, e.g. for ldobj or sizeof.
+    // TypeRefs are either primitives or assumed to be reference types
+    bool DLL::getValueLayout(u32 typeToken, ValueLayout &layout, const GenericContext *genericContext) {
+        switch (TABLE_ID(typeToken)) {
+            case TABLE_ID_TYPEDEF: {
+                auto typeLayout = this->getTypeLayout(typeToken);
+                if (typeLayout == nullptr)
+                    return false;
+
+                if (typeLayout->isValueType)
+                    setValueTypeLayout(layout, typeLayout);
+                else
+                    setReferenceLayout(layout);
+
+                return true;
+            }
+            case TABLE_ID_TYPEREF: {
+                if (TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > this->m_numRows[TABLE_ID_TYPEREF])
+                    return false;
+
+                auto elementType = getPrimitiveElementType(this->getTypeName(typeToken));
+                if (elementType != SignatureElementType::End)
+                    setPrimitiveLayout(layout, elementType);
+                else
+                    setReferenceLayout(layout);
+
+                return true;
+            }
+            case TABLE_ID_TYPESPEC: {
+                if (TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > this->m_numRows[TABLE_ID_TYPESPEC])
+                    return false;
+
+                auto typeSpec = this->getTypeSpecByIndex(TABLE_INDEX(typeToken));
+                const u8 *signature = this->getBlob(typeSpec->signatureIndex);
+                const u8 *signatureEnd = signature + this->getBlobSize(typeSpec->signatureIndex);
+
+                return this->decodeValueLayout(signature, signatureEnd, layout, genericContext);
+            }
+            default:
+                return false;
+        }
+    }
+
+    // How values of a type in a signature are stored. Value types of other assemblies other than primitives and
+    // vectors can't be laid out
+    bool DLL::decodeValueLayout(const u8 *&signature, const u8 *signatureEnd, ValueLayout &layout, const GenericContext *genericContext) {
+        while (signature < signatureEnd) {
+            auto elementType = static_cast<SignatureElementType>(*signature++);
+
+            u32 value;
+            switch (elementType) {
+                case SignatureElementType::Boolean:
+                case SignatureElementType::Char:
+                case SignatureElementType::I1:
+                case SignatureElementType::U1:
+                case SignatureElementType::I2:
+                case SignatureElementType::U2:
+                case SignatureElementType::I4:
+                case SignatureElementType::U4:
+                case SignatureElementType::I8:
+                case SignatureElementType::U8:
+                case SignatureElementType::R4:
+                case SignatureElementType::R8:
+                case SignatureElementType::I:
+                case SignatureElementType::U:
+                    setPrimitiveLayout(layout, elementType);
+                    return true;
+                case SignatureElementType::String:
+                case SignatureElementType::Object:
+                    setReferenceLayout(layout);
+                    return true;
+                case SignatureElementType::Class:
+                    signature += decodeCompressedUnsigned(signature, value);
+                    setReferenceLayout(layout);
+                    return true;
+                case SignatureElementType::SzArray:
+                case SignatureElementType::Array:
+                case SignatureElementType::Ptr:
+                case SignatureElementType::ByRef:
+                    signature--;
+                    if (!skipType(signature, signatureEnd))
+                        return false;
+
+                    setReferenceLayout(layout, elementType == SignatureElementType::Ptr || elementType == SignatureElementType::ByRef ? Type::Pointer : Type::O);
+                    return true;
+                case SignatureElementType::ValueType: {
+                    signature += decodeCompressedUnsigned(signature, value);
+                    u32 typeToken = decodeTypeDefOrRef(value);
+
+                    if (TABLE_ID(typeToken) == TABLE_ID_TYPEDEF)
+                        return this->getValueLayout(typeToken, layout);
+
+                    // Only the primitives of other assemblies are known, signatures usually have their own element types for them
+                    if (TABLE_ID(typeToken) != TABLE_ID_TYPEREF || TABLE_INDEX(typeToken) == 0 || TABLE_INDEX(typeToken) > this->m_numRows[TABLE_ID_TYPEREF])
+                        return false;
+
+                    auto primitive = getPrimitiveElementType(this->getTypeName(typeToken));
+                    if (primitive == SignatureElementType::End)
+                        return false;
+
+                    setPrimitiveLayout(layout, primitive);
+                    return true;
+                }
+                case SignatureElementType::GenericInst: {
+                    const u8 *instantiation = signature;
+                    if (signature >= signatureEnd)
+                        return false;
+
+                    if (static_cast<SignatureElementType>(*signature) == SignatureElementType::Class) {
+                        signature--;
+                        if (!skipType(signature, signatureEnd))
+                            return false;
+
+                        setReferenceLayout(layout);
+                        return true;
+                    }
+
+                    // Vectors are always held as wide as the widest one
+                    decodeCompressedUnsigned(signature + 1, value);
+                    if (this->isVectorType(decodeTypeDefOrRef(value))) {
+                        signature--;
+                        if (!skipType(signature, signatureEnd))
+                            return false;
+
+                        layout = { };
+                        layout.type = Type::Vector;
+                        layout.elementType = SignatureElementType::ValueType;
+                        layout.size = getTypeSize(Type::Vector);
+                        layout.alignment = 16;
+                        return true;
+                    }
+
+                    auto typeLayout = this->layOutInstantiation(instantiation, signatureEnd, genericContext);
+                    signature = instantiation;
+                    if (typeLayout == nullptr || !typeLayout->isValueType)
+                        return false;
+
+                    setValueTypeLayout(layout, typeLayout);
+                    return true;
+                }
+                case SignatureElementType::Var:
+                case SignatureElementType::MVar: {
+                    signature += decodeCompressedUnsigned(signature, value);
+
+                    if (genericContext == nullptr)
+                        return false;
+
+                    auto &arguments = elementType == SignatureElementType::Var ? genericContext->typeArguments : genericContext->methodArguments;
+                    if (value >= arguments.size())
+                        return false;
+
+                    // Type arguments are closed types, they never refer back to the context
+                    const u8 *argument = arguments[value].data();
+                    return this->decodeValueLayout(argument, argument + arguments[value].size(), layout, nullptr);
+                }
+                case SignatureElementType::Pinned:
+                    break;
+                case SignatureElementType::CmodReqd:
+                case SignatureElementType::CmodOpt:
+                    signature += decodeCompressedUnsigned(signature, value);
+                    break;
+                default:
+                    return false;
+            }
+        }
+
+        return false;
+    }
+
+    // Layout of the field a Field token or a MemberRef to a field of a type of the program refers to. Fields of
+    // generic types are referenced through their instantiation, generic parameters in it are resolved from genericContext
+    const FieldLayout* DLL::getFieldLayout(u32 fieldToken, const GenericContext *genericContext) {
+        if (TABLE_ID(fieldToken) == TABLE_ID_FIELD) {
+            u32 typeIndex = this->findTypeDefWithField(TABLE_INDEX(fieldToken));
+            if (typeIndex == 0)
+                return nullptr;
+
+            auto typeLayout = this->layOutType(typeIndex, { });
+            return &typeLayout->fields[TABLE_INDEX(fieldToken) - typeLayout->fieldListStart];
+        }
+
+        if (TABLE_ID(fieldToken) != TABLE_ID_MEMBERREF || TABLE_INDEX(fieldToken) == 0 || TABLE_INDEX(fieldToken) > this->m_numRows[TABLE_ID_MEMBERREF])
+            return nullptr;
+
+        auto memberRef = this->getMemberRefByMetadataToken(fieldToken);
+        u32 parentIndex = INDEX_INDEX(memberRef->classIndex, MEMBER_REF_PARENT);
+
+        const TypeLayout *typeLayout = nullptr;
+        switch (INDEX_TAG(memberRef->classIndex, MEMBER_REF_PARENT)) {
+            case 0: // TypeDef
+                typeLayout = this->getTypeLayout((TABLE_ID_TYPEDEF << 24) | parentIndex);
+                break;
+            case 4: // TypeSpec
+                typeLayout = this->getTypeLayout((TABLE_ID_TYPESPEC << 24) | parentIndex, genericContext);
+                break;
+            default:
+                return nullptr;
+        }
+
+        if (typeLayout == nullptr)
+            return nullptr;
+
+        // Field names are unique within a type, the signature doesn't need to be compared
+        const char *name = this->getString(memberRef->nameIndex);
+        for (u32 i = 0; i < typeLayout->fields.size(); i++) {
+            if (std::strcmp(this->getString(this->getFieldByIndex(typeLayout->fieldListStart + i)->nameIndex), name) == 0)
+                return &typeLayout->fields[i];
+        }
+
+        return nullptr;
+    }
+
+    const u8* DLL::getGuid(u32 index) {
+        // GUID heap indices are 1-based
+        return &this->m_guidHeap[(index - 1) * 16];
+    }
+
+    const u8* DLL::getMvid() {
+        auto module = reinterpret_cast<table_module_t*>(this->m_tables[TABLE_ID_MODULE].base);
+        return this->getGuid(module->mvId);
+    }
+
+    u64 DLL::getFileHash() {
+        return this->m_fileHash;
+    }
+
+    size_t DLL::getFileSize() {
+        return this->m_fileSize;
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "exceptions.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace ili {
+
+    void throwRuntimeException(const char *typeName, const char *format, ...) {
+        va_list arguments;
+
+        va_start(arguments, format);
+        int length = std::vsnprintf(nullptr, 0, format, arguments);
+        va_end(arguments);
+
+        std::string message(length > 0 ? length : 0, '\0');
+
+        va_start(arguments, format);
+        std::vsnprintf(message.data(), message.size() + 1, format, arguments);
+        va_end(arguments);
+
+        throw RuntimeException { typeName, std::move(message) };
+    }
+
+}
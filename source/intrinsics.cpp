@@ -0,0 +1,99 @@
+#include "intrinsics.hpp"
+
+#include "dll.hpp"
+#include "tables.hpp"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ili {
+
+    struct IntrinsicEntry {
+        const char *name;       // Without the assembly, with the parameters the same way natives are registered
+        Intrinsic intrinsic;
+    };
+
+    static constexpr IntrinsicEntry IntrinsicEntries[] = {
+        { "System.Math::Sqrt(float64)",                 Intrinsic::SqrtDouble },
+        { "System.MathF::Sqrt(float32)",                Intrinsic::SqrtFloat },
+        { "System.Math::Abs(int8)",                     Intrinsic::AbsInt8 },
+        { "System.Math::Abs(int16)",                    Intrinsic::AbsInt16 },
+        { "System.Math::Abs(int32)",                    Intrinsic::AbsInt32 },
+        { "System.Math::Abs(int64)",                    Intrinsic::AbsInt64 },
+        { "System.Math::Abs(float64)",                  Intrinsic::AbsDouble },
+        { "System.Math::Abs(float32)",                  Intrinsic::AbsFloat },
+        { "System.MathF::Abs(float32)",                 Intrinsic::AbsFloat },
+        { "System.Math::Min(int32,int32)",              Intrinsic::MinInt32 },
+        { "System.Math::Min(uint32,uint32)",            Intrinsic::MinUInt32 },
+        { "System.Math::Min(int64,int64)",              Intrinsic::MinInt64 },
+        { "System.Math::Min(uint64,uint64)",            Intrinsic::MinUInt64 },
+        { "System.Math::Min(float64,float64)",          Intrinsic::MinDouble },
+        { "System.Math::Min(float32,float32)",          Intrinsic::MinFloat },
+        { "System.MathF::Min(float32,float32)",         Intrinsic::MinFloat },
+        { "System.Math::Max(int32,int32)",              Intrinsic::MaxInt32 },
+        { "System.Math::Max(uint32,uint32)",            Intrinsic::MaxUInt32 },
+        { "System.Math::Max(int64,int64)",              Intrinsic::MaxInt64 },
+        { "System.Math::Max(uint64,uint64)",            Intrinsic::MaxUInt64 },
+        { "System.Math::Max(float64,float64)",          Intrinsic::MaxDouble },
+        { "System.Math::Max(float32,float32)",          Intrinsic::MaxFloat },
+        { "System.MathF::Max(float32,float32)",         Intrinsic::MaxFloat },
+        { "System.Math::Floor(float64)",                Intrinsic::FloorDouble },
+        { "System.MathF::Floor(float32)",               Intrinsic::FloorFloat },
+        { "System.Math::Ceiling(float64)",              Intrinsic::CeilingDouble },
+        { "System.MathF::Ceiling(float32)",             Intrinsic::CeilingFloat },
+
+        { "System.Array::Copy(?,?,int32)",              Intrinsic::ArrayCopy },
+        { "System.Array::Copy(?,int32,?,int32,int32)",  Intrinsic::ArrayCopyRange },
+        { "System.Array::Clear(?)",                     Intrinsic::ArrayClear },
+        { "System.Array::Clear(?,int32,int32)",         Intrinsic::ArrayClearRange },
+        { "System.Array::Fill(!!0[],!!0)",              Intrinsic::ArrayFill },
+        { "System.Array::Fill(!!0[],!!0,int32,int32)",  Intrinsic::ArrayFillRange },
+        { "System.Buffer::BlockCopy(?,int32,?,int32,int32)", Intrinsic::BufferBlockCopy },
+        { "System.Runtime.CompilerServices.Unsafe::CopyBlock(void*,void*,uint32)",              Intrinsic::CopyBlock },
+        { "System.Runtime.CompilerServices.Unsafe::CopyBlock(uint8&,uint8&,uint32)",            Intrinsic::CopyBlock },
+        { "System.Runtime.CompilerServices.Unsafe::CopyBlockUnaligned(void*,void*,uint32)",     Intrinsic::CopyBlock },
+        { "System.Runtime.CompilerServices.Unsafe::CopyBlockUnaligned(uint8&,uint8&,uint32)",   Intrinsic::CopyBlock },
+        { "System.Runtime.CompilerServices.Unsafe::InitBlock(void*,uint8,uint32)",              Intrinsic::InitBlock },
+        { "System.Runtime.CompilerServices.Unsafe::InitBlock(uint8&,uint8,uint32)",             Intrinsic::InitBlock },
+        { "System.Runtime.CompilerServices.Unsafe::InitBlockUnaligned(void*,uint8,uint32)",     Intrinsic::InitBlock },
+        { "System.Runtime.CompilerServices.Unsafe::InitBlockUnaligned(uint8&,uint8,uint32)",    Intrinsic::InitBlock },
+    };
+
+    // The same types are forwarded through different assemblies depending on what the program was built against
+    static constexpr std::string_view CoreAssemblies[] = { "[mscorlib]", "[System.Runtime]", "[System.Private.CoreLib]" };
+
+    Intrinsic Intrinsics::find(DLL *dll, u32 methodToken) {
+        static const auto intrinsics = [] {
+            std::unordered_map<std::string_view, Intrinsic> intrinsics;
+            for (auto &entry : IntrinsicEntries)
+                intrinsics.insert({ entry.name, entry.intrinsic });
+
+            return intrinsics;
+        }();
+
+        // Generic intrinsics are matched by their definition, they work out the type from the arguments
+        u32 memberRefToken = methodToken;
+        if (TABLE_ID(methodToken) == TABLE_ID_METHODSPEC) {
+            if (TABLE_INDEX(methodToken) == 0 || TABLE_INDEX(methodToken) > dll->getNumTableRows(TABLE_ID_METHODSPEC))
+                return Intrinsic::None;
+
+            memberRefToken = dll->getMethodSpecMethod(methodToken);
+        }
+
+        if (TABLE_ID(memberRefToken) != TABLE_ID_MEMBERREF || TABLE_INDEX(memberRefToken) == 0 || TABLE_INDEX(memberRefToken) > dll->getNumTableRows(TABLE_ID_MEMBERREF))
+            return Intrinsic::None;
+
+        std::string_view name = dll->getMemberRefName(memberRefToken);
+        for (auto assembly : CoreAssemblies) {
+            if (!name.starts_with(assembly))
+                continue;
+
+            auto intrinsic = intrinsics.find(std::string(name.substr(assembly.size())) + dll->getMemberRefSignature(memberRefToken));
+            return intrinsic == intrinsics.end() ? Intrinsic::None : intrinsic->second;
+        }
+
+        return Intrinsic::None;
+    }
+
+}
@@ -1,37 +1,340 @@
-#include <cstdio>
-#include <cstdarg>
 #include "logger.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace ili {
 
-    void Logger::error(const char *format, ...) {
-        va_list ap;
-        va_start(ap, format);
-        printf("\033%s[%s]\033[0m ", "[0;31m", "ERROR");
-        vprintf(format, ap);
-        printf("\n");
-        va_end(ap);
-    }
+    // Info and errors are on for everything by default, debug messages have to be enabled explicitly
+    std::atomic<u32> Logger::s_enabledCategories[3] = { 0x0000'0000, 0xFFFF'FFFF, 0xFFFF'FFFF };
+
+    namespace {
+
+        // Single producer, single consumer queue of fixed size records. Every thread that logs gets its own one,
+        // so producing a record never takes a lock
+        struct LogRing {
+            static constexpr u32 NumSlots = 0x400;
+
+            std::atomic<u64> head = 0;      // Next slot the logging thread writes
+            std::atomic<u64> tail = 0;      // Next slot the formatter reads
+            u8 slots[NumSlots][Logger::MaxRecordSize];
+        };
+
+        struct LogBackend {
+            std::mutex registryMutex;
+            std::vector<LogRing*> rings;
+
+            std::mutex consumerMutex;
+            std::condition_variable wakeSignal;
+            std::mutex wakeMutex;
+            std::thread formatterThread;
+            std::atomic<bool> running = false;
+            std::atomic<bool> shutDown = false;
+        };
+
+        // Never destroyed so that logging keeps working while other static objects are torn down
+        LogBackend& getBackend() {
+            static auto backend = new LogBackend();
+            return *backend;
+        }
+
+        const char* getPrefix(LogLevel level) {
+            switch (level) {
+                case LogLevel::Error:   return "\033[0;31m[ERROR]\033[0m ";
+                case LogLevel::Info:    return "\033[0;34m[INFO]\033[0m  ";
+                default:                return "\033[0;32m[DEBUG]\033[0m ";
+            }
+        }
+
+        template<typename T>
+        void appendFormatted(std::string &output, const std::string &specification, T value) {
+            int length = std::snprintf(nullptr, 0, specification.c_str(), value);
+            if (length <= 0)
+                return;
+
+            size_t offset = output.size();
+            output.resize(offset + length + 1);
+            std::snprintf(&output[offset], length + 1, specification.c_str(), value);
+            output.resize(offset + length);
+        }
+
+        // Replays a printf format string against the arguments stored in a record. Each conversion is handed to
+        // snprintf on its own with the length modifier replaced to match how the argument was stored
+        void formatRecord(const log_record_t *record, std::string &output) {
+            const u8 *argument = reinterpret_cast<const u8*>(record) + sizeof(log_record_t);
+            const u8 *argumentsEnd = reinterpret_cast<const u8*>(record) + record->size;
+
+            output += getPrefix(record->level);
+
+            for (const char *format = record->format; *format != '\0'; format++) {
+                if (*format != '%') {
+                    output += *format;
+                    continue;
+                }
+
+                if (format[1] == '%') {
+                    output += '%';
+                    format++;
+                    continue;
+                }
+
+                std::string specification = "%";
+                format++;
+                while (*format != '\0' && std::strchr("-+ #0123456789.", *format) != nullptr)
+                    specification += *format++;
+                while (*format != '\0' && std::strchr("hljztL", *format) != nullptr)
+                    format++;
+
+                char conversion = *format;
+                if (conversion == '\0')
+                    break;
+
+                if (argument >= argumentsEnd) {
+                    output += "<missing>";
+                    continue;
+                }
+
+                auto type = static_cast<LogArgumentType>(*argument++);
+
+                if (type == LogArgumentType::String) {
+                    u8 stringLength = *argument++;
+                    std::string string(reinterpret_cast<const char*>(argument), stringLength);
+                    argument += stringLength;
+
+                    if (conversion == 's')
+                        appendFormatted(output, specification + 's', string.c_str());
+                    else
+                        output += string;
+
+                    continue;
+                }
+
+                u64 value;
+                std::memcpy(&value, argument, sizeof(value));
+                argument += sizeof(value);
+
+                if (std::strchr("fFeEgGaA", conversion) != nullptr) {
+                    double number = type == LogArgumentType::Float ? std::bit_cast<double>(value) : static_cast<double>(static_cast<s64>(value));
+                    appendFormatted(output, specification + conversion, number);
+                } else if (conversion == 'c') {
+                    appendFormatted(output, specification + 'c', static_cast<int>(value));
+                } else if (conversion == 'p') {
+                    appendFormatted(output, specification + 'p', reinterpret_cast<void*>(value));
+                } else if (conversion == 's') {
+                    appendFormatted(output, "<0x%llx>", static_cast<unsigned long long>(value));
+                } else {
+                    // Floats printed with an integer conversion show their bit pattern
+                    appendFormatted(output, specification + "ll" + conversion, static_cast<unsigned long long>(value));
+                }
+            }
+
+            output += '\n';
+        }
+
+        // Must be called with the consumer mutex held. Records of all threads are merged in timestamp order
+        bool drainRings(LogBackend &backend) {
+            std::vector<LogRing*> rings;
+            {
+                std::scoped_lock lock(backend.registryMutex);
+                rings = backend.rings;
+            }
+
+            std::string output;
+            bool drainedAnything = false;
+
+            while (true) {
+                LogRing *oldestRing = nullptr;
+                const log_record_t *oldestRecord = nullptr;
+
+                for (auto ring : rings) {
+                    u64 tail = ring->tail.load(std::memory_order_relaxed);
+                    if (tail == ring->head.load(std::memory_order_acquire))
+                        continue;
+
+                    auto record = reinterpret_cast<const log_record_t*>(ring->slots[tail % LogRing::NumSlots]);
+                    if (oldestRecord == nullptr || record->timestamp < oldestRecord->timestamp) {
+                        oldestRing = ring;
+                        oldestRecord = record;
+                    }
+                }
+
+                if (oldestRing == nullptr)
+                    break;
+
+                formatRecord(oldestRecord, output);
+                oldestRing->tail.fetch_add(1, std::memory_order_release);
+                drainedAnything = true;
+
+                if (output.size() > 0x10000) {
+                    std::fwrite(output.data(), 1, output.size(), stdout);
+                    output.clear();
+                }
+            }
+
+            if (!output.empty())
+                std::fwrite(output.data(), 1, output.size(), stdout);
+            if (drainedAnything)
+                std::fflush(stdout);
+
+            return drainedAnything;
+        }
+
+        void formatterThread() {
+            auto &backend = getBackend();
+
+            while (backend.running.load(std::memory_order_acquire)) {
+                bool drainedAnything;
+                {
+                    std::scoped_lock lock(backend.consumerMutex);
+                    drainedAnything = drainRings(backend);
+                }
+
+                if (!drainedAnything) {
+                    std::unique_lock lock(backend.wakeMutex);
+                    backend.wakeSignal.wait_for(lock, std::chrono::milliseconds(2));
+                }
+            }
+        }
+
+        void shutDown() {
+            auto &backend = getBackend();
+
+            backend.shutDown.store(true, std::memory_order_release);
+            if (backend.running.exchange(false)) {
+                backend.wakeSignal.notify_all();
+                backend.formatterThread.join();
+            }
+
+            Logger::flush();
+        }
+
+        LogRing* getThreadRing() {
+            thread_local LogRing *ring = nullptr;
+
+            if (ring == nullptr) [[unlikely]] {
+                auto &backend = getBackend();
+                ring = new LogRing();
+
+                std::scoped_lock lock(backend.registryMutex);
+                backend.rings.push_back(ring);
+
+                if (backend.rings.size() == 1) {
+                    backend.running = true;
+                    backend.formatterThread = std::thread(formatterThread);
+                    std::atexit(shutDown);
+                }
+            }
+
+            return ring;
+        }
+
+        u64 getTimestamp() {
+            return std::chrono::steady_clock::now().time_since_epoch().count();
+        }
 
-    void Logger::info(const char *format, ...) {
-        va_list ap;
-        va_start(ap, format);
-        printf("\033%s[%s]\033[0m  ", "[0;34m", "INFO");
-        vprintf(format, ap);
-        printf("\n");
-        va_end(ap);
     }
 
-    void Logger::debug(const char *format, ...) {
-        if (!Logger::DebugLogging)
+    void Logger::submit(LogLevel level, LogCategory category, const char *format, RecordWriter &writer) {
+        auto record = reinterpret_cast<log_record_t*>(writer.data);
+        record->timestamp = getTimestamp();
+        record->format = format;
+        record->level = level;
+        record->category = category;
+        record->size = writer.size;
+
+        auto &backend = getBackend();
+
+        // Once the formatter is gone, e.g. while the process exits, messages are written out directly
+        if (backend.shutDown.load(std::memory_order_acquire)) {
+            std::string output;
+            formatRecord(record, output);
+            std::fwrite(output.data(), 1, output.size(), stdout);
             return;
+        }
+
+        LogRing *ring = getThreadRing();
+        u64 head = ring->head.load(std::memory_order_relaxed);
+
+        // Never drop messages. If the formatter can't keep up, wait for it
+        while (head - ring->tail.load(std::memory_order_acquire) >= LogRing::NumSlots) {
+            backend.wakeSignal.notify_one();
+            std::this_thread::yield();
+        }
+
+        std::memcpy(ring->slots[head % LogRing::NumSlots], writer.data, writer.size);
+        ring->head.store(head + 1, std::memory_order_release);
+
+        // Errors usually end the program right away, get them out as soon as possible
+        if (level == LogLevel::Error)
+            backend.wakeSignal.notify_one();
+    }
+
+    void Logger::setLevel(LogLevel level, LogCategory category) {
+        for (u8 i = 0; i < std::size(s_enabledCategories); i++) {
+            if (i >= static_cast<u8>(level))
+                s_enabledCategories[i].fetch_or(1U << static_cast<u8>(category));
+            else
+                s_enabledCategories[i].fetch_and(~(1U << static_cast<u8>(category)));
+        }
+    }
+
+    void Logger::setLevel(LogLevel level) {
+        for (u8 category = 0; category < static_cast<u8>(LogCategory::Count); category++)
+            setLevel(level, static_cast<LogCategory>(category));
+    }
+
+    bool Logger::configure(std::string_view specification) {
+        constexpr static const char* LevelNames[] = { "debug", "info", "error" };
+        constexpr static const char* CategoryNames[] = { "general", "metadata", "interpreter", "stack", "preparer", "native", "snapshot" };
+        static_assert(std::size(CategoryNames) == static_cast<size_t>(LogCategory::Count));
+
+        while (!specification.empty()) {
+            auto entry = specification.substr(0, specification.find(';'));
+            specification.remove_prefix(std::min(entry.size() + 1, specification.size()));
+
+            auto levelName = entry.substr(0, entry.find(':'));
+            auto level = std::find(std::begin(LevelNames), std::end(LevelNames), levelName);
+            if (level == std::end(LevelNames))
+                return false;
+
+            auto logLevel = static_cast<LogLevel>(level - std::begin(LevelNames));
+
+            if (levelName.size() == entry.size()) {
+                setLevel(logLevel);
+                continue;
+            }
+
+            auto categories = entry.substr(levelName.size() + 1);
+            while (!categories.empty()) {
+                auto categoryName = categories.substr(0, categories.find(','));
+                categories.remove_prefix(std::min(categoryName.size() + 1, categories.size()));
+
+                auto category = std::find(std::begin(CategoryNames), std::end(CategoryNames), categoryName);
+                if (category == std::end(CategoryNames))
+                    return false;
+
+                setLevel(logLevel, static_cast<LogCategory>(category - std::begin(CategoryNames)));
+            }
+        }
+
+        return true;
+    }
+
+    void Logger::flush() {
+        auto &backend = getBackend();
 
-        va_list ap;
-        va_start(ap, format);
-        printf("\033%s[%s]\033[0m ", "[0;32m", "DEBUG");
-        vprintf(format, ap);
-        printf("\n");
-        va_end(ap);
+        std::scoped_lock lock(backend.consumerMutex);
+        drainRings(backend);
     }
 
-}
\ No newline at end of file
+}
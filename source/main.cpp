@@ -2,33 +2,204 @@
 #include "dll.hpp"
 #include "native.hpp"
 #include "method.hpp"
+#include "snapshot.hpp"
+#include "mapped_file.hpp"
+#include "preparer.hpp"
+#include "profiler.hpp"
+#include "sampler.hpp"
+#include "perf_counters.hpp"
+#include "metrics.hpp"
 
-#include <windows.h>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
 
-static void loadExecutable(std::string path) {
+#include <fcntl.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <io.h>
+#endif
+
+// Passing 0 workers to the Preparer picks a count based on the number of cores
+static constexpr u32 NoPreparationWorkers = 0xFFFF'FFFF;
+
+// Everything the command line configures. Empty paths turn the feature they're for off
+struct RunOptions {
+    std::string path = "test/example/bin/Debug/net8.0/win-x64/example.dll";
+    std::string snapshotPath;
+    std::string outputPath;
+    std::string profilePath;
+    std::string samplePath;
+    u32 sampleFrequency = ili::Sampler::DefaultFrequency;
+    std::string allocationsPath;
+    u64 allocationSampleInterval = 0;
+    std::string perfCountersPath;
+    std::string metricsPath;
+    u32 metricsInterval = 0;
+    u32 numPreparationWorkers = NoPreparationWorkers;
+    std::string cacheDirectory;
+};
+
+static void runTypeInitializers(ili::Context &context) {
+    for (u32 i = 1; i <= context.dll->getNumTableRows(TABLE_ID_METHODDEF); i++) {
+        auto methodDef = context.dll->getMethodDefByIndex(i);
+
+        if (std::strcmp(context.dll->getString(methodDef->nameIndex), ".cctor") != 0)
+            continue;
+
+        context.preparer->addRoot((TABLE_ID_METHODDEF << 24) | i);
+
+        auto typeInitializer = std::make_unique<ili::Method>(context, (TABLE_ID_METHODDEF << 24) | i);
+        typeInitializer->run();
+    }
+}
+
+static void loadExecutable(const RunOptions &options) {
     static ili::Context context;
+    ili::MappedFile heapMemory;
+    ili::PerfCounters perfCounters;
+
+    if (!options.outputPath.empty()) {
+        int fd = ::open(options.outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            ili::Logger::error("Cannot open output file %s!", options.outputPath.c_str());
+            exit(1);
+        }
 
-    context.dll = new ili::DLL(path);
+        context.output.setSink(std::make_unique<ili::FileDescriptorSink>(fd, true));
+    }
+
+    context.dll = new ili::DLL(options.path, options.cacheDirectory);
     context.dll->validate();
 
-    context.heap = new u8[0x0010'0000];
+    if (!options.metricsPath.empty()) {
+        context.metrics = new ili::Metrics(context);
+        context.metrics->setDumpPath(options.metricsPath);
+
+        if (options.metricsInterval != 0)
+            context.metrics->startPeriodicDumps(options.metricsInterval);
+
+    #if !defined(_WIN32)
+        signal(SIGUSR1, [](int) { context.metrics->requestDump(); });
+    #endif
+    }
+
+    // Methods get prepared when they're first called, or ahead of time once they're known to be reachable
+    context.preparer = new ili::Preparer(context.dll);
+    context.preparer->setMetrics(context.metrics);
+    context.preparer->addRoot(context.dll->getEntryMethodToken());
+    if (options.numPreparationWorkers != NoPreparationWorkers)
+        context.preparer->startBackgroundPreparation(options.numPreparationWorkers);
+
+    if (!options.profilePath.empty())
+        context.profiler = new ili::Profiler(context.dll);
+
+    if (!options.allocationsPath.empty()) {
+        context.allocationTracker = new ili::AllocationTracker(context, options.allocationSampleInterval);
+        context.allocationTracker->setCensusPrefix(options.allocationsPath);
+
+    #if !defined(_WIN32)
+        // Lets a census be taken while a long running program is still going
+        signal(SIGUSR2, [](int) { context.allocationTracker->requestCensus(); });
+    #endif
+    }
+
+    if (!options.samplePath.empty()) {
+        context.sampler = new ili::Sampler(context, options.path);
+        if (!context.sampler->start(options.sampleFrequency)) {
+            delete context.sampler;
+            context.sampler = nullptr;
+        }
+    }
+
+    if (!options.perfCountersPath.empty() && perfCounters.open() && context.profiler != nullptr)
+        context.profiler->setPerfCounters(&perfCounters);
+
+    // The Profiler times everything itself, the Sampler and the AllocationTracker only need to be able to see the frames
+    if (context.profiler != nullptr)
+        context.profilingMode = ili::ProfilingMode::Instrumenting;
+    else if (context.sampler != nullptr || context.allocationTracker != nullptr)
+        context.profilingMode = ili::ProfilingMode::StackWalking;
+    else if (perfCounters.isOpen() || context.metrics != nullptr)
+        context.profilingMode = ili::ProfilingMode::Counting;
+
+    context.heapSize = 0x0010'0000;
+    if (!heapMemory.allocate(context.heapSize)) {
+        ili::Logger::error("Cannot allocate %d bytes of heap!", context.heapSize);
+        exit(1);
+    }
+    context.heap = heapMemory.getData();
 
-    context.stack = new u8[context.dll->getStackSize()];
-    context.typeStack = new Type[context.dll->getStackSize()];
+    context.stackSize = context.dll->getStackSize();
+    context.stack = new u8[context.stackSize];
+    context.typeStack = new Type[context.stackSize];
 
     context.stackPointer = context.stack;
     context.framePointer = nullptr;
     context.typeStackPointer = context.typeStack;
     context.typeFramePointer = nullptr;
 
+    context.statics.resize(context.dll->getNumTableRows(TABLE_ID_FIELD), { { Type::Invalid }, 0 });
+
     ili::NativeMethods::loadMSCORLIBLibrary(context);
     ili::NativeMethods::loadNXLibrary(context);
+    ili::NativeMethods::loadVectorLibrary(context);
+    ili::NativeMethods::loadStringLibrary(context);
+    ili::NativeMethods::loadCollectionsLibrary(context);
+
+    perfCounters.start();
+
+    // Initialize all types, or pick up the state a previous run left behind after doing so
+    if (options.snapshotPath.empty() || !ili::Snapshot::restore(context, options.snapshotPath)) {
+        runTypeInitializers(context);
+
+        if (!options.snapshotPath.empty())
+            ili::Snapshot::capture(context, options.snapshotPath);
+    }
 
     // Execute Main
     {
+        // Command line arguments aren't passed on, Main(string[] args) gets null
+        ili::MethodSignature entrySignature;
+        if (context.dll->decodeMethodSignature(context.dll->getEntryMethodToken(), entrySignature) && entrySignature.getNumParameters() > 0)
+            context.push<u64>(Type::O, 0);
+
         auto entryPoint = std::make_unique<ili::Method>(context, context.dll->getEntryMethodToken());
         entryPoint->run();
 
+        perfCounters.stop();
+        context.output.flush();
+
+        if (perfCounters.isOpen()) {
+            ili::PerfCounterValues values;
+            if (!perfCounters.read(values) || !perfCounters.writeReport(options.perfCountersPath, values, context.executedInstructions))
+                ili::Logger::error("Cannot write hardware counters to %s!", options.perfCountersPath.c_str());
+        }
+
+        if (context.profiler != nullptr) {
+            if (!context.profiler->writeReport(options.profilePath + ".txt") || !context.profiler->writeCollapsedStacks(options.profilePath + ".collapsed"))
+                ili::Logger::error("Cannot write profile to %s!", options.profilePath.c_str());
+        }
+
+        if (context.metrics != nullptr) {
+            context.metrics->stopPeriodicDumps();
+            context.metrics->writeRequestedDump();
+        }
+
+        if (context.allocationTracker != nullptr) {
+            if (!context.allocationTracker->writeReport(options.allocationsPath + ".txt") || !context.allocationTracker->writeHeapCensus(options.allocationsPath + ".census.txt"))
+                ili::Logger::error("Cannot write allocation report to %s!", options.allocationsPath.c_str());
+        }
+
+        if (context.sampler != nullptr) {
+            context.sampler->stop();
+            ili::Logger::info("Collected %llu samples", context.sampler->getNumSamples());
+
+            if (!context.sampler->writeCollapsedStacks(options.samplePath + ".collapsed") || !context.sampler->writeProfile(options.samplePath + ".pb"))
+                ili::Logger::error("Cannot write samples to %s!", options.samplePath.c_str());
+        }
+
         if (context.getUsedStackSize() == 0)
             ili::Logger::info("Program finished");
         else
@@ -38,14 +209,62 @@ static void loadExecutable(std::string path) {
 
     delete[] context.typeStack;
     delete[] context.stack;
-    delete[] context.heap;
+    delete   context.sampler;
+    delete   context.allocationTracker;
+    delete   context.profiler;
+    delete   context.preparer;
+    delete   context.metrics;
     delete   context.dll;
 }
 
-int main() {
+int main(int argc, char **argv) {
+#if defined(_WIN32)
     auto hConsole = ::GetStdHandle(STD_OUTPUT_HANDLE);
     ::SetConsoleMode(hConsole, ENABLE_VIRTUAL_TERMINAL_PROCESSING | ENABLE_PROCESSED_OUTPUT);
-    loadExecutable("test/example/bin/Debug/net8.0/win-x64/example.dll");
+#endif
+
+    RunOptions options;
+
+    if (const char *logSpecification = std::getenv("ILI_LOG"); logSpecification != nullptr && !ili::Logger::configure(logSpecification))
+        ili::Logger::error("Invalid log configuration '%s'!", logSpecification);
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            if (!ili::Logger::configure(argv[++i])) {
+                ili::Logger::error("Invalid log configuration '%s'!", argv[i]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+            options.snapshotPath = argv[++i];
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            options.outputPath = argv[++i];
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            options.profilePath = argv[++i];
+        else if (std::strcmp(argv[i], "--sample") == 0 && i + 1 < argc)
+            options.samplePath = argv[++i];
+        else if (std::strcmp(argv[i], "--sample-frequency") == 0 && i + 1 < argc)
+            options.sampleFrequency = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--track-allocations") == 0 && i + 1 < argc)
+            options.allocationsPath = argv[++i];
+        else if (std::strcmp(argv[i], "--allocation-sample-interval") == 0 && i + 1 < argc)
+            options.allocationSampleInterval = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--perf-counters") == 0 && i + 1 < argc)
+            options.perfCountersPath = argv[++i];
+        else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+            options.metricsPath = argv[++i];
+        else if (std::strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc)
+            options.metricsInterval = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--prepare-background") == 0)
+            options.numPreparationWorkers = 0;
+        else if (std::strcmp(argv[i], "--prepare-threads") == 0 && i + 1 < argc)
+            options.numPreparationWorkers = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            options.cacheDirectory = argv[++i];
+        else
+            options.path = argv[i];
+    }
+
+    loadExecutable(options);
 
     return 0;
 }
@@ -0,0 +1,145 @@
+#include "mapped_file.hpp"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace ili {
+
+    MappedFile::~MappedFile() {
+        this->close();
+    }
+
+#if defined(_WIN32)
+
+    bool MappedFile::open(const std::string &path) {
+        this->close();
+
+        HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!::GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            ::CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            ::CloseHandle(file);
+            return false;
+        }
+
+        void *data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == nullptr) {
+            ::CloseHandle(mapping);
+            ::CloseHandle(file);
+            return false;
+        }
+
+        this->m_fileHandle = file;
+        this->m_mappingHandle = mapping;
+        this->m_data = static_cast<u8*>(data);
+        this->m_size = fileSize.QuadPart;
+
+        return true;
+    }
+
+    bool MappedFile::allocate(size_t size) {
+        this->close();
+
+        void *data = ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (data == nullptr)
+            return false;
+
+        this->m_data = static_cast<u8*>(data);
+        this->m_size = size;
+
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (this->m_data != nullptr && this->m_mappingHandle == nullptr)
+            ::VirtualFree(this->m_data, 0, MEM_RELEASE);
+        else if (this->m_data != nullptr)
+            ::UnmapViewOfFile(this->m_data);
+        if (this->m_mappingHandle != nullptr)
+            ::CloseHandle(this->m_mappingHandle);
+        if (this->m_fileHandle != nullptr)
+            ::CloseHandle(this->m_fileHandle);
+
+        this->m_data = nullptr;
+        this->m_size = 0;
+        this->m_mappingHandle = nullptr;
+        this->m_fileHandle = nullptr;
+    }
+
+#else
+
+    bool MappedFile::open(const std::string &path) {
+        this->close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat fileInfo = { };
+        if (::fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+
+        void *data = ::mmap(nullptr, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+            return false;
+
+        this->m_data = static_cast<u8*>(data);
+        this->m_size = fileInfo.st_size;
+
+        return true;
+    }
+
+    bool MappedFile::allocate(size_t size) {
+        this->close();
+
+        void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+            return false;
+
+        this->m_data = static_cast<u8*>(data);
+        this->m_size = size;
+
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (this->m_data != nullptr)
+            ::munmap(this->m_data, this->m_size);
+
+        this->m_data = nullptr;
+        this->m_size = 0;
+    }
+
+#endif
+
+    bool MappedFile::isOpen() {
+        return this->m_data != nullptr;
+    }
+
+    u8* MappedFile::getData() {
+        return this->m_data;
+    }
+
+    size_t MappedFile::getSize() {
+        return this->m_size;
+    }
+
+}
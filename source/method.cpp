@@ -1,6 +1,14 @@
 #include "method.hpp"
 
 #include <string>
+#include <csignal>
+#include <bit>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
 
 #include "types.hpp"
 #include "tables.hpp"
@@ -8,279 +16,854 @@
 #include "opcode.hpp"
 #include "context.hpp"
 #include "logger.hpp"
+#include "native.hpp"
+#include "preparer.hpp"
+#include "profiler.hpp"
+#include "strings.hpp"
+#include "arrays.hpp"
+#include "vectors.hpp"
+#include "intrinsics.hpp"
 
 namespace ili  {
 
-    Method::Method(Context &ctx, u32 methodToken) : m_ctx(ctx) {
-        this->m_methodDef = getDLL()->getMethodDefByMetadataToken(methodToken);
-        Logger::debug("Executing method '%s'", getDLL()->getString(this->m_methodDef->nameIndex));
-    }
-
-    Method::~Method() {
-        for (u16 i = 0; i < 0xFF; i++) {
-            if (this->m_localVariable[i] == nullptr)
-                continue;
+    Method::Method(Context &ctx, u32 methodToken) : m_ctx(ctx), m_methodToken(methodToken) {
 
-            delete this->m_localVariable[i];
-            this->m_localVariable[i] = nullptr;
-        }
     }
 
     void Method::run() {
-        section_table_entry_t *ilHeaderSection = getDLL()->getVirtualSection(this->m_methodDef->rva);
-        u8 *methodHeader = OFFSET(getDLL()->getData(), VRA_TO_OFFSET(ilHeaderSection, this->m_methodDef->rva));
+        // The profiling hooks are compiled into separate copies of the loop so they cost nothing when turned off
+        switch (this->m_ctx.profilingMode) {
+            [[likely]] case ProfilingMode::None:
+                this->execute<ProfilingMode::None>();
+                break;
+            case ProfilingMode::Counting:
+                this->execute<ProfilingMode::Counting>();
+                break;
+            case ProfilingMode::Instrumenting:
+                this->execute<ProfilingMode::Instrumenting>();
+                break;
+            case ProfilingMode::StackWalking:
+                this->execute<ProfilingMode::StackWalking>();
+                break;
+        }
+    }
 
-        if ((*methodHeader & 0x03) == 0x02) // Tiny Header
-            this->m_programCounter = methodHeader + 1;
-        else if ((*methodHeader & 0x03) == 0x03) // Fat Header
-            this->m_programCounter = methodHeader + 12;
+    template<ProfilingMode Mode>
+    void Method::execute() {
+        this->enter<Mode>(this->m_methodToken, this->getVerifiedMethod(this->m_methodToken), this->m_ctx.currentFrame, nullptr);
+        this->dispatch<Mode>();
+    }
 
-        for (u16 i = 0; i < 0xFF; i++)
-            this->m_localVariable[i] = nullptr;
+    // Runs until the frame the loop was started with returns, or until the filter block that's being run ends.
+    // Instructions and natives that fail leave the loop with a RuntimeException, which is then thrown as a managed
+    // exception. The loop picks back up in its handler
+    template<ProfilingMode Mode>
+    void Method::dispatch() {
+        while (true) {
+            try {
+                this->interpret<Mode>();
+                return;
+            } catch (const RuntimeException &error) {
+                // The program counter is somewhere inside of the instruction that failed
+                u32 offset = this->m_programCounter - this->m_frame->code - 1;
 
-        u8 *methodStart = this->m_programCounter;
+                if (!this->throwException<Mode>(this->createException(error), offset, &error))
+                    return;
+            }
+        }
+    }
 
+    template<ProfilingMode Mode>
+    void Method::interpret() {
         while (true) {
             u8 currOpcode = *this->m_programCounter;
 
+            if constexpr (Mode != ProfilingMode::None) {
+                this->m_ctx.executedInstructions++;
+
+                if (this->m_ctx.metrics != nullptr && this->m_ctx.metrics->isDumpRequested()) [[unlikely]]
+                    this->m_ctx.metrics->writeRequestedDump();
+            }
+
+            if constexpr (Mode == ProfilingMode::Instrumenting) {
+                u16 opcode = currOpcode == 0xFE ? 0x100 | this->m_programCounter[1] : currOpcode;
+                this->m_ctx.profiler->beginInstruction(opcode, this->m_programCounter - this->m_frame->code);
+            } else if constexpr (Mode == ProfilingMode::StackWalking) {
+                this->m_frame->programCounter = this->m_programCounter;
+                std::atomic_signal_fence(std::memory_order_release);
+            }
+
             this->m_programCounter++;
 
             if (currOpcode != 0xFE) { // Handle normal opcodes
                 switch (static_cast<OpcodePrefix>(currOpcode)) {
                     case OpcodePrefix::Nop:
-                        Logger::debug("Instruction NOP");
+                        Logger::debug(LogCategory::Interpreter, "Instruction NOP");
                         break;
                     case OpcodePrefix::Brk:
-                        Logger::debug("Instruction BREAK");
+                        Logger::debug(LogCategory::Interpreter, "Instruction BREAK");
                         raise(SIGILL);
                         break;
                     case OpcodePrefix::Call: {
-                        Logger::debug("Instruction CALL");
+                        Logger::debug(LogCategory::Interpreter, "Instruction CALL");
+                        u32 token = this->getNext<u32>();
+                        call<Mode>(token);
+
+                        break;
+                    }
+                    case OpcodePrefix::Callvirt: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction CALLVIRT");
                         u32 token = this->getNext<u32>();
-                        call(token); // TODO: Handle return value
+
+                        // Objects don't know their type at runtime yet, so this always calls the method named by the token
+                        if (this->m_ctx.metrics != nullptr) [[unlikely]]
+                            this->m_ctx.metrics->add(Metrics::VirtualCalls);
+
+                        call<Mode>(token);
 
                         break;
                     }
                     case OpcodePrefix::Stloc_0:
-                        Logger::debug("Instruction STLOC.0");
+                        Logger::debug(LogCategory::Interpreter, "Instruction STLOC.0");
                         stloc(0);
 
                         break;
                     case OpcodePrefix::Stloc_1:
-                        Logger::debug("Instruction STLOC.1");
+                        Logger::debug(LogCategory::Interpreter, "Instruction STLOC.1");
                         stloc(1);
 
                         break;
                     case OpcodePrefix::Stloc_2:
-                        Logger::debug("Instruction STLOC.2");
+                        Logger::debug(LogCategory::Interpreter, "Instruction STLOC.2");
                         stloc(2);
                         break;
                     case OpcodePrefix::Stloc_3:
-                        Logger::debug("Instruction STLOC.3");
+                        Logger::debug(LogCategory::Interpreter, "Instruction STLOC.3");
                         stloc(3);
                         break;
                     case OpcodePrefix::Stloc_s:
-                        Logger::debug("Instruction STLOC.s");
+                        Logger::debug(LogCategory::Interpreter, "Instruction STLOC.s");
                         stloc(getNext<u8>());
                         break;
                     case OpcodePrefix::Ldc_i4_0:
-                        Logger::debug("Instruction LDC.I4.0");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.0");
                         ldc<s32>(Type::Int32, 0);
                         break;
                     case OpcodePrefix::Ldc_i4_1:
-                        Logger::debug("Instruction LDC.I4.1");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.1");
                         ldc<s32>(Type::Int32, 1);
                         break;
                     case OpcodePrefix::Ldc_i4_2:
-                        Logger::debug("Instruction LDC.I4.2");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.2");
                         ldc<s32>(Type::Int32, 2);
                         break;
                     case OpcodePrefix::Ldc_i4_3:
-                        Logger::debug("Instruction LDC.I4.3");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.3");
                         ldc<s32>(Type::Int32, 3);
                         break;
                     case OpcodePrefix::Ldc_i4_4:
-                        Logger::debug("Instruction LDC.I4.4");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.4");
                         ldc<s32>(Type::Int32, 4);
                         break;
                     case OpcodePrefix::Ldc_i4_5:
-                        Logger::debug("Instruction LDC.I4.5");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.5");
                         ldc<s32>(Type::Int32, 5);
                         break;
                     case OpcodePrefix::Ldc_i4_6:
-                        Logger::debug("Instruction LDC.I4.6");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.6");
                         ldc<s32>(Type::Int32, 6);
                         break;
                     case OpcodePrefix::Ldc_i4_7:
-                        Logger::debug("Instruction LDC.I4.7");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.7");
                         ldc<s32>(Type::Int32, 7);
                         break;
                     case OpcodePrefix::Ldc_i4_8:
-                        Logger::debug("Instruction LDC.I4.8");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.8");
                         ldc<s32>(Type::Int32, 8);
                         break;
                     case OpcodePrefix::Ldc_i4_m1:
-                        Logger::debug("Instruction LDC.I4.M1");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.M1");
                         ldc<s32>(Type::Int32, -1);
                         break;
                     case OpcodePrefix::Ldc_i4:
-                        Logger::debug("Instruction LDC.I4");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4");
                         ldc<s32>(Type::Int32, getNext<s32>());
                         break;
                     case OpcodePrefix::Ldc_i8:
-                        Logger::debug("Instruction LDC.I8");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I8");
                         ldc<s64>(Type::Int64, getNext<s64>());
                         break;
+                    case OpcodePrefix::Ldnull:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDNULL");
+                        ldc<u64>(Type::O, 0);
+                        break;
                     case OpcodePrefix::Ldc_r4:
-                        Logger::debug("Instruction LDC.R4");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.R4");
                         ldc<double>(Type::F, getNext<float>());
                         break;
                     case OpcodePrefix::Ldc_r8:
-                        Logger::debug("Instruction LDC.R8");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.R8");
                         ldc<double>(Type::F, getNext<double>());
                         break;
                     case OpcodePrefix::Ldc_i4_s:
-                        Logger::debug("Instruction LDC.I4.s");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDC.I4.s");
                         ldc<s32>(Type::Int32, getNext<s8>());
                         break;
                     case OpcodePrefix::Ldloc_0:
-                        Logger::debug("Instruction LDLOC.0");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLOC.0");
                         ldloc(0);
                         break;
                     case OpcodePrefix::Ldloc_1:
-                        Logger::debug("Instruction LDLOC.1");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLOC.1");
                         ldloc(1);
                         break;
                     case OpcodePrefix::Ldloc_2:
-                        Logger::debug("Instruction LDLOC.2");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLOC.2");
                         ldloc(2);
                         break;
                     case OpcodePrefix::Ldloc_3:
-                        Logger::debug("Instruction LDLOC.3");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLOC.3");
                         ldloc(3);
                         break;
                     case OpcodePrefix::Ldloc_s:
-                        Logger::debug("Instruction LDLOC.s");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLOC.s");
                         ldloc(getNext<u8>());
                         break;
                     case OpcodePrefix::Ldloca_s:
-                        Logger::debug("Instruction LDLOCA.s");
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLOCA.s");
                         ldloca(getNext<u8>());
                         break;
+                    case OpcodePrefix::Pop: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction POP");
+                        if (this->m_ctx.getTypeOnStack() == Type::Vector) {
+                            this->m_ctx.pop<VectorValue>();
+                        } else if (this->m_ctx.getTypeOnStack() == Type::ValueType) {
+                            u32 size;
+                            this->m_ctx.popValueType(size);
+                        } else {
+                            Type type;
+                            popValue(type);
+                        }
+                        break;
+                    }
                     case OpcodePrefix::Ldstr:
-                        Logger::debug("Instruction LDSTR");
-                        this->m_ctx.push<u64>(Type::O, getNext<u32>());
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDSTR");
+                        this->m_ctx.push<u64>(Type::O, reinterpret_cast<u64>(Strings::intern(this->m_ctx, getNext<u32>())));
+                        break;
+                    case OpcodePrefix::Ldarg_0:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDARG.0");
+                        ldarg(0);
+                        break;
+                    case OpcodePrefix::Ldarg_1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDARG.1");
+                        ldarg(1);
                         break;
-                    case OpcodePrefix ::Ldarg_0:
-                        Logger::debug("Instruction LDARG.0");
+                    case OpcodePrefix::Ldarg_2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDARG.2");
+                        ldarg(2);
+                        break;
+                    case OpcodePrefix::Ldarg_3:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDARG.3");
+                        ldarg(3);
+                        break;
+                    case OpcodePrefix::Ldarg_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDARG.s");
+                        ldarg(getNext<u8>());
+                        break;
+                    case OpcodePrefix::Ldarga_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDARGA.s");
+                        ldarga(getNext<u8>());
+                        break;
+                    case OpcodePrefix::Starg_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STARG.s");
+                        starg(getNext<u8>());
                         break;
                     case OpcodePrefix::Br:
-                        Logger::debug("Instruction BR");
-                        this->m_programCounter = methodStart + getNext<s32>();
+                        Logger::debug(LogCategory::Interpreter, "Instruction BR");
+                        this->m_programCounter += getNext<s32>();
                         break;
                     case OpcodePrefix::Br_s:
-                        Logger::debug("Instruction BR.S");
+                        Logger::debug(LogCategory::Interpreter, "Instruction BR.S");
                         this->m_programCounter += getNext<s8>();
                         break;
-                    case OpcodePrefix::Add: {
-                        Logger::debug("Instruction ADD");
-                        Type opAType = this->m_ctx.getTypeOnStack(2);
-                        Type opBType = this->m_ctx.getTypeOnStack(1);
-                        Type resType = Type::Invalid;
-
-                        // Type validating
-                        if (opAType == opBType)
-                            resType = opAType;
-
-                        if ((opAType == Type::Int32 && opBType == Type::Native_int) ||
-                            (opAType == Type::Native_int && opBType == Type::Int32))
-                            resType = Type::Native_int;
-
-                        if ((opAType == Type::Pointer && (opBType == Type::Int32 || opBType == Type::Native_int)) ||
-                            (opAType == Type::Pointer && (opBType == Type::Int32 || opBType == Type::Native_int)))
-                            resType = Type::Pointer;
-
-                        if (opAType == Type::O || opBType == Type::O || (opAType == Type::Pointer && opBType == Type::Pointer))
-                            resType = Type::Invalid;
-
-                        if (resType == Type::Invalid) {
-                            Logger::error("Add operation performed on invalid types!");
-                            exit(1);
-                        }
-
-                        //Addition
-                        if ((opAType == Type::Int32 && opBType == Type::Int32) || (opAType == Type::Int32 && opBType == Type::Native_int) || (opAType == Type::Native_int && opBType == Type::Int32))
-                            this->m_ctx.push<s32>(resType, this->m_ctx.pop<s32>() + this->m_ctx.pop<s32>());
-                        else if (opAType == Type::Int64 && opBType == Type::Int64)
-                            this->m_ctx.push<s64>(resType, this->m_ctx.pop<s64>() + this->m_ctx.pop<s32>());
-                        else if (opAType == Type::Native_int && opBType == Type::Native_int)
-                            this->m_ctx.push<s32>(resType, this->m_ctx.pop<s32>() + this->m_ctx.pop<s32>());
-                        else if (opAType == Type::F && opBType == Type::F)
-                            this->m_ctx.push<double>(resType, this->m_ctx.pop<double>() + this->m_ctx.pop<double>());
-                        else if (opAType == Type::Pointer && opBType == Type::Pointer)
-                            this->m_ctx.push<u64>(resType, this->m_ctx.pop<u64>() + this->m_ctx.pop<u64>());
-                        else if (opAType == Type::Pointer && opBType == Type::Int32)
-                            this->m_ctx.push<u64>(resType, this->m_ctx.pop<s32>() + this->m_ctx.pop<u64>());
-                        else if (opAType == Type::Pointer && opBType == Type::Native_int)
-                            this->m_ctx.push<u64>(resType, this->m_ctx.pop<s32>() + this->m_ctx.pop<u64>());
-                        else if (opAType == Type::Int32 && opBType == Type::Pointer)
-                            this->m_ctx.push<u64>(resType, this->m_ctx.pop<u64>() + this->m_ctx.pop<s32>());
-                        else if (opAType == Type::Native_int && opBType == Type::Pointer)
-                            this->m_ctx.push<u64>(resType, this->m_ctx.pop<u64>() + this->m_ctx.pop<s32>());
-
+                    case OpcodePrefix::Brfalse_s: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction BRFALSE.S");
+                        s8 target = getNext<s8>();
+                        if (!popCondition())
+                            this->m_programCounter += target;
                         break;
                     }
-                    case OpcodePrefix::Newobj: {
-                        Logger::debug("Instruction NEWOBJ");
-                        u32 token = this->getNext<u32>();
-                        if (TABLE_ID(token) == TABLE_ID_METHODDEF) {
-                            u16 typeIndex = getDLL()->findTypeDefWithMethod(token);
-
-                            table_type_def_t *type = getDLL()->getTypeDefByIndex(typeIndex);
-                            table_type_def_t *typeNext = getDLL()->getTypeDefByIndex(typeIndex + 1);
-
-                            Logger::debug("Creating instance of Type %s::%s", getDLL()->getString(type->typeNamespaceIndex), getDLL()->getString(type->typeNameIndex));
-
-                            size_t objSize = 0;
-                            for (u16 i = type->fieldListIndex; i < typeNext->fieldListIndex && i <= getDLL()->getNumTableRows(TABLE_ID_FIELD); i++) {
-                                auto field = getDLL()->getFieldByIndex(i);
-                                auto sig = getDLL()->getBlob(field->signatureIndex);
-                                auto sigSize = getDLL()->getBlobSize(field->signatureIndex);
-
-                                size_t fieldSize = getSignatureElementTypeSize(static_cast<SignatureElementType>(*(sig + sigSize - 1)));
-
-                                objSize += fieldSize;
-
-                                Logger::debug("  Field %s [0x%02x]", getDLL()->getString(field->nameIndex), fieldSize);
-                            }
-
-                            Logger::debug("Allocating %d bytes on the heap", objSize);
+                    case OpcodePrefix::Brtrue_s: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction BRTRUE.S");
+                        s8 target = getNext<s8>();
+                        if (popCondition())
+                            this->m_programCounter += target;
+                        break;
+                    }
+                    case OpcodePrefix::Beq_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BEQ.S");
+                        branch<Condition::Equal>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Bge_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BGE.S");
+                        branch<Condition::GreaterOrEqual>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Bgt_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BGT.S");
+                        branch<Condition::Greater>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Ble_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BLE.S");
+                        branch<Condition::LessOrEqual>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Blt_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BLT.S");
+                        branch<Condition::Less>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Bne_un_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BNE.UN.S");
+                        branch<Condition::NotEqualUnsigned>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Bge_un_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BGE.UN.S");
+                        branch<Condition::GreaterOrEqualUnsigned>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Bgt_un_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BGT.UN.S");
+                        branch<Condition::GreaterUnsigned>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Ble_un_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BLE.UN.S");
+                        branch<Condition::LessOrEqualUnsigned>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Blt_un_s:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BLT.UN.S");
+                        branch<Condition::LessUnsigned>(getNext<s8>());
+                        break;
+                    case OpcodePrefix::Brfalse: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction BRFALSE");
+                        s32 target = getNext<s32>();
+                        if (!popCondition())
+                            this->m_programCounter += target;
+                        break;
+                    }
+                    case OpcodePrefix::Brtrue: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction BRTRUE");
+                        s32 target = getNext<s32>();
+                        if (popCondition())
+                            this->m_programCounter += target;
+                        break;
+                    }
+                    case OpcodePrefix::Beq:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BEQ");
+                        branch<Condition::Equal>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Bge:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BGE");
+                        branch<Condition::GreaterOrEqual>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Bgt:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BGT");
+                        branch<Condition::Greater>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Ble:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BLE");
+                        branch<Condition::LessOrEqual>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Blt:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BLT");
+                        branch<Condition::Less>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Bne_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BNE.UN");
+                        branch<Condition::NotEqualUnsigned>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Bge_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BGE.UN");
+                        branch<Condition::GreaterOrEqualUnsigned>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Bgt_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BGT.UN");
+                        branch<Condition::GreaterUnsigned>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Ble_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BLE.UN");
+                        branch<Condition::LessOrEqualUnsigned>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Blt_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction BLT.UN");
+                        branch<Condition::LessUnsigned>(getNext<s32>());
+                        break;
+                    case OpcodePrefix::Swtch:
+                        Logger::debug(LogCategory::Interpreter, "Instruction SWITCH");
+                        switchTable();
+                        break;
+                    case OpcodePrefix::Add:
+                        Logger::debug(LogCategory::Interpreter, "Instruction ADD");
+                        arithmetic<Operation::Add>();
+                        break;
+                    case OpcodePrefix::Sub:
+                        Logger::debug(LogCategory::Interpreter, "Instruction SUB");
+                        arithmetic<Operation::Subtract>();
+                        break;
+                    case OpcodePrefix::Mul:
+                        Logger::debug(LogCategory::Interpreter, "Instruction MUL");
+                        arithmetic<Operation::Multiply>();
+                        break;
+                    case OpcodePrefix::Div:
+                        Logger::debug(LogCategory::Interpreter, "Instruction DIV");
+                        arithmetic<Operation::Divide>();
+                        break;
+                    case OpcodePrefix::Div_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction DIV.UN");
+                        arithmetic<Operation::DivideUnsigned>();
+                        break;
+                    case OpcodePrefix::Rem:
+                        Logger::debug(LogCategory::Interpreter, "Instruction REM");
+                        arithmetic<Operation::Remainder>();
+                        break;
+                    case OpcodePrefix::Rem_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction REM.UN");
+                        arithmetic<Operation::RemainderUnsigned>();
+                        break;
+                    case OpcodePrefix::Logical_and:
+                        Logger::debug(LogCategory::Interpreter, "Instruction AND");
+                        arithmetic<Operation::And>();
+                        break;
+                    case OpcodePrefix::Logical_or:
+                        Logger::debug(LogCategory::Interpreter, "Instruction OR");
+                        arithmetic<Operation::Or>();
+                        break;
+                    case OpcodePrefix::Logical_xor:
+                        Logger::debug(LogCategory::Interpreter, "Instruction XOR");
+                        arithmetic<Operation::Xor>();
+                        break;
+                    case OpcodePrefix::Shl:
+                        Logger::debug(LogCategory::Interpreter, "Instruction SHL");
+                        shift<Operation::ShiftLeft>();
+                        break;
+                    case OpcodePrefix::Shr:
+                        Logger::debug(LogCategory::Interpreter, "Instruction SHR");
+                        shift<Operation::ShiftRight>();
+                        break;
+                    case OpcodePrefix::Shr_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction SHR.UN");
+                        shift<Operation::ShiftRightUnsigned>();
+                        break;
+                    case OpcodePrefix::Neg:
+                        Logger::debug(LogCategory::Interpreter, "Instruction NEG");
+                        unary<Operation::Negate>();
+                        break;
+                    case OpcodePrefix::Logical_not:
+                        Logger::debug(LogCategory::Interpreter, "Instruction NOT");
+                        unary<Operation::Not>();
+                        break;
+                    case OpcodePrefix::Newobj:
+                        Logger::debug(LogCategory::Interpreter, "Instruction NEWOBJ");
+                        newobj<Mode>(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Isinst:
+                        Logger::debug(LogCategory::Interpreter, "Instruction ISINST");
+                        isinst(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Castclass:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CASTCLASS");
+                        castclass(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Ldsfld:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDSFLD");
+                        ldsfld(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Ldsflda:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDSFLDA");
+                        ldsflda(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Stsfld:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STSFLD");
+                        stsfld(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Ret: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction RET");
+                        if (ret<Mode>())
+                            return;
 
-                            u8 *newMemory = nullptr;
-                            if (this->m_ctx.heapReferences.empty()) {
-                                newMemory = this->m_ctx.heap;
-                            } else {
-                                auto lastElement = this->m_ctx.heapReferences.back();
-                                newMemory = lastElement.heapPointer + lastElement.size;
-                            }
+                        break;
+                    }
+                    case OpcodePrefix::Thrw: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction THROW");
+                        u32 offset = this->m_programCounter - this->m_frame->code - 1;
 
-                            std::memset(newMemory, 0x00, objSize);
-                            this->m_ctx.heapReferences.push_back({ newMemory, objSize });
+                        if (!throwException<Mode>(this->m_ctx.pop<u64>(), offset))
+                            return;
 
-                            this->m_ctx.push<u64>(Type::O, reinterpret_cast<u64>(newMemory));
+                        break;
+                    }
+                    case OpcodePrefix::Leave: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction LEAVE");
+                        s32 target = getNext<s32>();
+                        u32 next = this->m_programCounter - this->m_frame->code;
 
-                            call(token);
-                        }
+                        leave<Mode>(next - 5, next + target, 0);
                         break;
                     }
-                    case OpcodePrefix::Ret: {
-                        Logger::debug("Instruction RET");
+                    case OpcodePrefix::Leave_s: {
+                        Logger::debug(LogCategory::Interpreter, "Instruction LEAVE.S");
+                        s8 target = getNext<s8>();
+                        u32 next = this->m_programCounter - this->m_frame->code;
 
-                        return;
+                        leave<Mode>(next - 2, next + target, 0);
+                        break;
                     }
+                    case OpcodePrefix::Dup:
+                        Logger::debug(LogCategory::Interpreter, "Instruction DUP");
+                        dup();
+                        break;
+                    case OpcodePrefix::Ldind_i1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.I1");
+                        ldind<s8>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldind_u1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.U1");
+                        ldind<u8>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldind_i2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.I2");
+                        ldind<s16>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldind_u2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.U2");
+                        ldind<u16>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldind_i4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.I4");
+                        ldind<s32>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldind_u4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.U4");
+                        ldind<u32>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldind_i8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.I8");
+                        ldind<s64>(Type::Int64);
+                        break;
+                    case OpcodePrefix::Ldind_i:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.I");
+                        ldind<s64>(Type::Native_int);
+                        break;
+                    case OpcodePrefix::Ldind_r4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.R4");
+                        ldind<float>(Type::F);
+                        break;
+                    case OpcodePrefix::Ldind_r8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.R8");
+                        ldind<double>(Type::F);
+                        break;
+                    case OpcodePrefix::Ldind_ref:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDIND.REF");
+                        ldind<u64>(Type::O);
+                        break;
+                    case OpcodePrefix::Stind_ref:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STIND.REF");
+                        stind<u64>();
+                        break;
+                    case OpcodePrefix::Stind_i1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STIND.I1");
+                        stind<s8>();
+                        break;
+                    case OpcodePrefix::Stind_i2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STIND.I2");
+                        stind<s16>();
+                        break;
+                    case OpcodePrefix::Stind_i4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STIND.I4");
+                        stind<s32>();
+                        break;
+                    case OpcodePrefix::Stind_i8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STIND.I8");
+                        stind<s64>();
+                        break;
+                    case OpcodePrefix::Stind_r4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STIND.R4");
+                        stind<float>();
+                        break;
+                    case OpcodePrefix::Stind_r8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STIND.R8");
+                        stind<double>();
+                        break;
+                    case OpcodePrefix::Stind_i:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STIND.I");
+                        stind<s64>();
+                        break;
+                    case OpcodePrefix::Conv_i1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.I1");
+                        conv<s8>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Conv_i2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.I2");
+                        conv<s16>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Conv_i4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.I4");
+                        conv<s32>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Conv_i8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.I8");
+                        conv<s64>(Type::Int64);
+                        break;
+                    case OpcodePrefix::Conv_r4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.R4");
+                        conv<float>(Type::F);
+                        break;
+                    case OpcodePrefix::Conv_r8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.R8");
+                        conv<double>(Type::F);
+                        break;
+                    case OpcodePrefix::Conv_u4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.U4");
+                        conv<u32>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Conv_u8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.U8");
+                        conv<u64>(Type::Int64);
+                        break;
+                    case OpcodePrefix::Conv_u2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.U2");
+                        conv<u16>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Conv_u1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.U1");
+                        conv<u8>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Conv_i:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.I");
+                        conv<s64>(Type::Native_int);
+                        break;
+                    case OpcodePrefix::Conv_u:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CONV.U");
+                        conv<u64>(Type::Native_int);
+                        break;
+                    case OpcodePrefix::Newarr:
+                        Logger::debug(LogCategory::Interpreter, "Instruction NEWARR");
+                        newarr(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Ldlen:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLEN");
+                        ldlen();
+                        break;
+                    case OpcodePrefix::Ldelema:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEMA");
+                        getNext<u32>();
+                        ldelema();
+                        break;
+                    case OpcodePrefix::Ldelem_i1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I1");
+                        ldelem<s8, true>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_u1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.U1");
+                        ldelem<u8, true>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_i2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I2");
+                        ldelem<s16, true>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_u2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.U2");
+                        ldelem<u16, true>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_i4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I4");
+                        ldelem<s32, true>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_u4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.U4");
+                        ldelem<u32, true>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_i8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I8");
+                        ldelem<s64, true>(Type::Int64);
+                        break;
+                    case OpcodePrefix::Ldelem_i:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I");
+                        ldelem<s64, true>(Type::Native_int);
+                        break;
+                    case OpcodePrefix::Ldelem_r4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.R4");
+                        ldelem<float, true>(Type::F);
+                        break;
+                    case OpcodePrefix::Ldelem_r8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.R8");
+                        ldelem<double, true>(Type::F);
+                        break;
+                    case OpcodePrefix::Ldelem_ref:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.REF");
+                        ldelem<u64, true>(Type::O);
+                        break;
+                    case OpcodePrefix::Stelem_i:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I");
+                        stelem<s64, true>();
+                        break;
+                    case OpcodePrefix::Stelem_i1:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I1");
+                        stelem<s8, true>();
+                        break;
+                    case OpcodePrefix::Stelem_i2:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I2");
+                        stelem<s16, true>();
+                        break;
+                    case OpcodePrefix::Stelem_i4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I4");
+                        stelem<s32, true>();
+                        break;
+                    case OpcodePrefix::Stelem_i8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I8");
+                        stelem<s64, true>();
+                        break;
+                    case OpcodePrefix::Stelem_r4:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.R4");
+                        stelem<float, true>();
+                        break;
+                    case OpcodePrefix::Stelem_r8:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.R8");
+                        stelem<double, true>();
+                        break;
+                    case OpcodePrefix::Stelem_ref:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.REF");
+                        stelem<u64, true>();
+                        break;
+                    case OpcodePrefix::Ldelem:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM");
+                        getNext<u32>();     // Arrays know their element type, the token isn't needed
+                        ldelemAny<true>();
+                        break;
+                    case OpcodePrefix::Stelem:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM");
+                        getNext<u32>();
+                        stelemAny<true>();
+                        break;
+                    case OpcodePrefix::Ldelem_i1_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I1.UNCHECKED");
+                        ldelem<s8, false>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_u1_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.U1.UNCHECKED");
+                        ldelem<u8, false>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_i2_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I2.UNCHECKED");
+                        ldelem<s16, false>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_u2_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.U2.UNCHECKED");
+                        ldelem<u16, false>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_i4_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I4.UNCHECKED");
+                        ldelem<s32, false>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_u4_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.U4.UNCHECKED");
+                        ldelem<u32, false>(Type::Int32);
+                        break;
+                    case OpcodePrefix::Ldelem_i8_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I8.UNCHECKED");
+                        ldelem<s64, false>(Type::Int64);
+                        break;
+                    case OpcodePrefix::Ldelem_i_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.I.UNCHECKED");
+                        ldelem<s64, false>(Type::Native_int);
+                        break;
+                    case OpcodePrefix::Ldelem_r4_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.R4.UNCHECKED");
+                        ldelem<float, false>(Type::F);
+                        break;
+                    case OpcodePrefix::Ldelem_r8_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.R8.UNCHECKED");
+                        ldelem<double, false>(Type::F);
+                        break;
+                    case OpcodePrefix::Ldelem_ref_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.REF.UNCHECKED");
+                        ldelem<u64, false>(Type::O);
+                        break;
+                    case OpcodePrefix::Stelem_i_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I.UNCHECKED");
+                        stelem<s64, false>();
+                        break;
+                    case OpcodePrefix::Stelem_i1_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I1.UNCHECKED");
+                        stelem<s8, false>();
+                        break;
+                    case OpcodePrefix::Stelem_i2_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I2.UNCHECKED");
+                        stelem<s16, false>();
+                        break;
+                    case OpcodePrefix::Stelem_i4_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I4.UNCHECKED");
+                        stelem<s32, false>();
+                        break;
+                    case OpcodePrefix::Stelem_i8_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.I8.UNCHECKED");
+                        stelem<s64, false>();
+                        break;
+                    case OpcodePrefix::Stelem_r4_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.R4.UNCHECKED");
+                        stelem<float, false>();
+                        break;
+                    case OpcodePrefix::Stelem_r8_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.R8.UNCHECKED");
+                        stelem<double, false>();
+                        break;
+                    case OpcodePrefix::Stelem_ref_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.REF.UNCHECKED");
+                        stelem<u64, false>();
+                        break;
+                    case OpcodePrefix::Ldelem_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDELEM.UNCHECKED");
+                        getNext<u32>();
+                        ldelemAny<false>();
+                        break;
+                    case OpcodePrefix::Stelem_unchecked:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STELEM.UNCHECKED");
+                        getNext<u32>();
+                        stelemAny<false>();
+                        break;
+                    case OpcodePrefix::Call_intrinsic:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CALL.INTRINSIC");
+
+                        // Returns before the next instruction just like a native, a tail. prefix changes nothing
+                        this->m_tailCall = false;
+                        callIntrinsic(static_cast<Intrinsic>(getNext<u32>()));
+                        break;
+                    case OpcodePrefix::Ldfld:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDFLD");
+                        ldfld(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Ldflda:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDFLDA");
+                        ldflda(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Stfld:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STFLD");
+                        stfld(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Ldobj:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDOBJ");
+                        ldobj(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Stobj:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STOBJ");
+                        stobj(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Cpobj:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CPOBJ");
+                        cpobj(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Endfinally:
+                        Logger::debug(LogCategory::Interpreter, "Instruction ENDFINALLY");
+                        endFinally<Mode>(this->m_programCounter - this->m_frame->code - 1);
+                        break;
                     default:
-                        Logger::error("Unknown opcode (0x%02x)!", currOpcode);
-                        exit(1);
+                        this->m_ctx.fatalError(LogCategory::Interpreter, "Unknown opcode (0x%02x)!", currOpcode);
                         break;
                 }
             }
@@ -288,8 +871,95 @@ namespace ili  {
                 currOpcode = *this->m_programCounter;
                 this->m_programCounter++;
 
-                switch (currOpcode) {
+                switch (static_cast<OpcodePrefix>(0xFE00 | currOpcode)) {
+                    case OpcodePrefix::Ceq:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CEQ");
+                        compare<Mode, Condition::Equal>();
+                        break;
+                    case OpcodePrefix::Cgt:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CGT");
+                        compare<Mode, Condition::Greater>();
+                        break;
+                    case OpcodePrefix::Cgt_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CGT.UN");
+                        compare<Mode, Condition::GreaterUnsigned>();
+                        break;
+                    case OpcodePrefix::Clt:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CLT");
+                        compare<Mode, Condition::Less>();
+                        break;
+                    case OpcodePrefix::Clt_un:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CLT.UN");
+                        compare<Mode, Condition::LessUnsigned>();
+                        break;
+                    case OpcodePrefix::Ldarg:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDARG");
+                        ldarg(getNext<u16>());
+                        break;
+                    case OpcodePrefix::Ldarga:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDARGA");
+                        ldarga(getNext<u16>());
+                        break;
+                    case OpcodePrefix::Starg:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STARG");
+                        starg(getNext<u16>());
+                        break;
+                    case OpcodePrefix::Ldloc:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLOC");
+                        ldloc(getNext<u16>());
+                        break;
+                    case OpcodePrefix::Ldloca:
+                        Logger::debug(LogCategory::Interpreter, "Instruction LDLOCA");
+                        ldloca(getNext<u16>());
+                        break;
+                    case OpcodePrefix::Stloc:
+                        Logger::debug(LogCategory::Interpreter, "Instruction STLOC");
+                        stloc(getNext<u16>());
+                        break;
+                    case OpcodePrefix::Tail:
+                        Logger::debug(LogCategory::Interpreter, "Instruction TAIL");
+                        this->m_tailCall = true;
+                        break;
+                    case OpcodePrefix::Unaligned:
+                        Logger::debug(LogCategory::Interpreter, "Instruction UNALIGNED");
+                        getNext<u8>();
+                        break;
+                    case OpcodePrefix::Volatle:
+                        Logger::debug(LogCategory::Interpreter, "Instruction VOLATILE");
+                        break;
+                    case OpcodePrefix::Cpblk:
+                        Logger::debug(LogCategory::Interpreter, "Instruction CPBLK");
+                        cpblk();
+                        break;
+                    case OpcodePrefix::Initblk:
+                        Logger::debug(LogCategory::Interpreter, "Instruction INITBLK");
+                        initblk();
+                        break;
+                    case OpcodePrefix::Initobj:
+                        Logger::debug(LogCategory::Interpreter, "Instruction INITOBJ");
+                        initobj(getNext<u32>());
+                        break;
+                    case OpcodePrefix::Size_of:
+                        Logger::debug(LogCategory::Interpreter, "Instruction SIZEOF");
+                        this->m_ctx.push<s32>(Type::Int32, s32(this->resolveValueLayout(getNext<u32>()).size));
+                        break;
+                    case OpcodePrefix::Endfilter:
+                        Logger::debug(LogCategory::Interpreter, "Instruction ENDFILTER");
+
+                        // The filter's result is left on the stack for runFilter
+                        if (this->m_filterFrame != this->m_frame)
+                            this->m_ctx.fatalError(LogCategory::Interpreter, "endfilter outside of a filter block!");
+
+                        return;
+                    case OpcodePrefix::Rethrow:
+                        Logger::debug(LogCategory::Interpreter, "Instruction RETHROW");
+                        if (!rethrow<Mode>(this->m_programCounter - this->m_frame->code - 2))
+                            return;
 
+                        break;
+                    default:
+                        this->m_ctx.fatalError(LogCategory::Interpreter, "Unknown opcode (0xFE 0x%02x)!", currOpcode);
+                        break;
                 }
             }
         }
@@ -299,7 +969,7 @@ namespace ili  {
 
     template<typename T>
     T Method::getNext() {
-        T value = *reinterpret_cast<T*>(this->m_programCounter);
+        T value = *reinterpret_cast<const T*>(this->m_programCounter);
         this->m_programCounter += sizeof(T);
 
         return value;
@@ -309,99 +979,1738 @@ namespace ili  {
         return this->m_ctx.dll;
     }
 
-    // Instruction Implementations
+    PreparedMethod* Method::getVerifiedMethod(u32 methodToken) {
+        PreparedMethod *preparedMethod = this->m_ctx.preparer->getPreparedMethod(methodToken);
+        if (!preparedMethod->verified)
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Method '%s' failed verification!", getDLL()->getString(getDLL()->getMethodDefByMetadataToken(methodToken)->nameIndex));
 
-    void Method::stloc(u8 id) {
-        if (this->m_localVariable[id] != nullptr)
-            delete this->m_localVariable[id];
-        this->m_localVariable[id] = nullptr;
+        return preparedMethod;
+    }
 
-        Type type = this->m_ctx.getTypeOnStack();
+    // Prepares the method of the program a MemberRef or MethodSpec instantiates, or finds the instantiation that shares
+    // its code. Nullptr if the token refers to a native instead
+    PreparedMethod* Method::instantiate(u32 methodToken, const GenericContext *callerContext) {
+        u32 methodDefToken;
+        GenericContext genericContext;
+        bool valid = getDLL()->resolveInstantiation(methodToken, callerContext, methodDefToken, genericContext);
 
-        switch (type) {
-            case Type::Int32:
-                this->m_localVariable[id] = new Variable<s32>{type, this->m_ctx.pop<s32>()};
-                break;
-            case Type::Int64:
-                this->m_localVariable[id] = new Variable<s64>{type, this->m_ctx.pop<s64>()};
-                break;
-            case Type::Native_int:
-                this->m_localVariable[id] = new Variable<s32>{type, this->m_ctx.pop<s32>()};
-                break;
-            case Type::F:
-                this->m_localVariable[id] = new Variable<double>{type, this->m_ctx.pop<double>()};
-                break;
-            case Type::O:
-                this->m_localVariable[id] = new Variable<u64>{type, this->m_ctx.pop<u64>()};
-                break;
-            case Type::Pointer:
-                this->m_localVariable[id] = new Variable<u64>{type, this->m_ctx.pop<u64>()};
-                break;
-        }
-    }
+        if (methodDefToken == 0)
+            return nullptr;
 
-    void Method::ldloc(u8 id) {
-        auto varType = this->m_localVariable[id]->type;
+        if (!valid)
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Cannot instantiate method '%s'!", getDLL()->getString(getDLL()->getMethodDefByMetadataToken(methodDefToken)->nameIndex));
 
-        switch (varType) {
-            case Type::Int32:
-                this->m_ctx.push<s32>(varType, static_cast<Variable<s32>*>(this->m_localVariable[id])->value);
-                break;
-            case Type::Int64:
-                this->m_ctx.push<s64>(varType, static_cast<Variable<s64>*>(this->m_localVariable[id])->value);
-                break;
-            case Type::Native_int:
-                this->m_ctx.push<s32>(varType, static_cast<Variable<s32>*>(this->m_localVariable[id])->value);
-                break;
-            case Type::F:
-                this->m_ctx.push<double>(varType, static_cast<Variable<double>*>(this->m_localVariable[id])->value);
-                break;
-            case Type::O:
-                this->m_ctx.push<u64>(varType, static_cast<Variable<u64>*>(this->m_localVariable[id])->value);
-                break;
-            case Type::Pointer:
-                this->m_ctx.push<u64>(varType, static_cast<Variable<u64>*>(this->m_localVariable[id])->value);
-                break;
+        // The type arguments are signatures that end where they say, so they can simply be strung together
+        std::string key(reinterpret_cast<const char*>(&methodDefToken), sizeof(methodDefToken));
+        for (auto arguments : { &genericContext.typeArguments, &genericContext.methodArguments }) {
+            key += char(arguments->size());
+            for (auto &argument : *arguments)
+                key.append(reinterpret_cast<const char*>(argument.data()), argument.size());
         }
-        if (this->m_localVariable[id] != nullptr)
-            delete this->m_localVariable[id];
 
-        this->m_localVariable[id] = nullptr;
-    }
+        auto [instantiation, inserted] = this->m_ctx.instantiations.try_emplace(std::move(key), nullptr);
+        if (inserted)
+            instantiation->second = this->m_ctx.preparer->prepareInstantiation(methodDefToken, genericContext);
 
-    void Method::ldloca(u8 id) {
-        this->m_ctx.push<u64>(Type::Pointer, reinterpret_cast<u64>(this->m_localVariable[id]));
-    }
+        if (!instantiation->second->verified)
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Method '%s' failed verification!", getDLL()->getString(getDLL()->getMethodDefByMetadataToken(methodDefToken)->nameIndex));
 
-    template<typename T>
-    void Method::ldc(Type type, T num) {
-        this->m_ctx.push(type, num);
+        return instantiation->second;
     }
 
-    void Method::call(u32 methodToken) {
-        switch (TABLE_ID(methodToken)) {
-            case TABLE_ID_METHODDEF:
-            {
-                auto method = getDLL()->getMethodDefByMetadataToken(methodToken);
-                auto sig = getDLL()->getBlob(method->signatureIndex);
+    // Generic methods of the program are called through MemberRefs and MethodSpecs just like natives. Both are bound on
+    // the first call through a token, by the calling instantiation if the token could refer to its type arguments
+    CalleeBinding Method::resolveCallee(u32 methodToken) {
+        PreparedMethod *caller = this->m_frame->method;
 
-                auto calledMethod = new Method(this->m_ctx, methodToken);
-                calledMethod->run();
+        if (caller->genericContext.empty()) {
+            u32 index = NativeMethods::getBindingIndex(this->m_ctx, methodToken);
 
-                delete calledMethod;
-                break;
+            if (index < this->m_ctx.nativeBindings.size() && this->m_ctx.nativeBindings[index] != nullptr)
+                return { nullptr, this->m_ctx.nativeBindings[index] };
+            if (index < this->m_ctx.instantiationBindings.size() && this->m_ctx.instantiationBindings[index] != nullptr)
+                return { this->m_ctx.instantiationBindings[index], nullptr };
+
+            PreparedMethod *instantiation = this->instantiate(methodToken, nullptr);
+            if (instantiation == nullptr)
+                return { nullptr, NativeMethods::resolveMethod(this->m_ctx, methodToken) };
+
+            if (index >= this->m_ctx.instantiationBindings.size())
+                this->m_ctx.instantiationBindings.resize(getDLL()->getNumTableRows(TABLE_ID_MEMBERREF) + getDLL()->getNumTableRows(TABLE_ID_METHODSPEC), nullptr);
+
+            this->m_ctx.instantiationBindings[index] = instantiation;
+            return { instantiation, nullptr };
+        }
+
+        auto &binding = caller->calleeBindings[methodToken];
+        if (binding.instantiation == nullptr && binding.native == nullptr) {
+            binding.instantiation = this->instantiate(methodToken, &caller->genericContext);
+            if (binding.instantiation == nullptr)
+                binding.native = NativeMethods::resolveMethod(this->m_ctx, methodToken, &caller->genericContext);
+        }
+
+        return binding;
+    }
+
+    // Signatures of natives are decoded the first time they're constructed through. Nullptr if they can't be called
+    const MethodSignature* Method::getNativeSignature(u32 methodToken) {
+        auto cached = this->m_nativeSignatures.find(methodToken);
+        if (cached == this->m_nativeSignatures.end()) {
+            MethodSignature signature;
+            if (!getDLL()->decodeMethodSignature(methodToken, signature))
+                return nullptr;
+
+            cached = this->m_nativeSignatures.emplace(methodToken, std::move(signature)).first;
+        }
+
+        return &cached->second;
+    }
+
+    // Locals directly follow the frame header
+    Variable<u64>& Method::getLocal(u16 id) {
+        return reinterpret_cast<Variable<u64>*>(this->m_frame + 1)[id];
+    }
+
+    u8* Method::getEvaluationStack(InterpreterFrame *frame) {
+        return reinterpret_cast<u8*>(frame + 1) + frame->method->localsSize;
+    }
+
+    void Method::resetEvaluationStack(InterpreterFrame *frame) {
+        this->m_ctx.stackPointer = this->getEvaluationStack(frame);
+        this->m_ctx.typeStackPointer = frame->argumentTypes + frame->method->signature.getNumParameters();
+    }
+
+    // Pushes a frame for a method whose arguments are on top of the stack. Frames are laid out as
+    // [arguments][InterpreterFrame][locals][vector locals][struct locals][evaluation stack] and the arguments stay where the caller pushed them
+    template<ProfilingMode Mode>
+    void Method::enter(u32 methodToken, PreparedMethod *preparedMethod, InterpreterFrame *caller, const u8 *returnAddress) {
+        auto &signature = preparedMethod->signature;
+
+        if (Logger::isEnabled(LogLevel::Debug, LogCategory::Interpreter)) [[unlikely]]
+            Logger::debug(LogCategory::Interpreter, "Executing method '%s'", getDLL()->getString(getDLL()->getMethodDefByMetadataToken(methodToken)->nameIndex));
+
+        if (this->m_ctx.getUsedStackSize() < signature.argumentsSize || u32(this->m_ctx.typeStackPointer - this->m_ctx.typeStack) < signature.getNumParameters())
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Method '%s' called with fewer arguments than it takes!", getDLL()->getString(getDLL()->getMethodDefByMetadataToken(methodToken)->nameIndex));
+
+        u8 *arguments = this->m_ctx.stackPointer - signature.argumentsSize;
+        Type *argumentTypes = this->m_ctx.typeStackPointer - signature.getNumParameters();
+
+        auto frameAddress = (reinterpret_cast<uintptr_t>(this->m_ctx.stackPointer) + alignof(InterpreterFrame) - 1) & ~(alignof(InterpreterFrame) - 1);
+        auto frame = reinterpret_cast<InterpreterFrame*>(frameAddress);
+        auto locals = reinterpret_cast<Variable<u64>*>(frame + 1);
+        auto vectorLocals = reinterpret_cast<VectorValue*>(locals + preparedMethod->numLocals);
+        auto evaluationStack = reinterpret_cast<u8*>(frame + 1) + preparedMethod->localsSize;
+
+        if (evaluationStack + preparedMethod->maxStack * preparedMethod->stackSlotSize > this->m_ctx.stack + this->m_ctx.stackSize)
+            this->m_ctx.fatalError(LogCategory::Stack, "Stack overflow while calling method '%s'!", getDLL()->getString(getDLL()->getMethodDefByMetadataToken(methodToken)->nameIndex));
+
+        *frame = { caller, methodToken, preparedMethod->code, preparedMethod->code, preparedMethod, returnAddress, arguments, argumentTypes };
+
+        // Zeroed locals have the type Invalid, which ldloc treats as a zero
+        std::memset(locals, 0x00, preparedMethod->localsSize);
+        for (u32 i = 0; i < preparedMethod->vectorLocals.size(); i++)
+            locals[preparedMethod->vectorLocals[i]] = { { Type::Vector }, reinterpret_cast<u64>(&vectorLocals[i]) };
+        for (auto [local, offset] : preparedMethod->valueTypeLocals)
+            locals[local] = { { Type::ValueType }, reinterpret_cast<u64>(reinterpret_cast<u8*>(locals) + offset) };
+
+        this->m_ctx.stackPointer = evaluationStack;
+
+        // The frame has to be complete before a signal handler can see it
+        std::atomic_signal_fence(std::memory_order_release);
+        this->m_ctx.currentFrame = frame;
+        std::atomic_signal_fence(std::memory_order_release);
+
+        this->m_frame = frame;
+        this->m_programCounter = preparedMethod->code;
+        this->m_depth++;
+
+        if constexpr (Mode == ProfilingMode::Instrumenting)
+            this->m_ctx.profiler->enterMethod(methodToken);
+    }
+
+    // Replaces the current frame with the callee's. Its arguments are moved over the current ones and it returns
+    // straight to the current method's caller, so tail recursion runs in constant stack space
+    template<ProfilingMode Mode>
+    void Method::tailCall(u32 methodToken, PreparedMethod *preparedMethod) {
+        auto &signature = preparedMethod->signature;
+        InterpreterFrame frame = *this->m_frame;
+
+        if (this->m_ctx.getUsedStackSize() < signature.argumentsSize || u32(this->m_ctx.typeStackPointer - this->m_ctx.typeStack) < signature.getNumParameters())
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Method '%s' called with fewer arguments than it takes!", getDLL()->getString(getDLL()->getMethodDefByMetadataToken(methodToken)->nameIndex));
+
+        if constexpr (Mode == ProfilingMode::Instrumenting)
+            this->m_ctx.profiler->exitMethod();
+
+        // Unlinked first, the frame gets overwritten below
+        std::atomic_signal_fence(std::memory_order_release);
+        this->m_ctx.currentFrame = frame.caller;
+        std::atomic_signal_fence(std::memory_order_release);
+
+        std::memmove(frame.arguments, this->m_ctx.stackPointer - signature.argumentsSize, signature.argumentsSize);
+        std::memmove(frame.argumentTypes, this->m_ctx.typeStackPointer - signature.getNumParameters(), signature.getNumParameters() * sizeof(Type));
+
+        this->m_ctx.stackPointer = frame.arguments + signature.argumentsSize;
+        this->m_ctx.typeStackPointer = frame.argumentTypes + signature.getNumParameters();
+
+        this->m_depth--;
+        this->enter<Mode>(methodToken, preparedMethod, frame.caller, frame.returnAddress);
+    }
+
+    // Pops whatever is on top of the stack, with 32 bit values sign extended so they can be stored into wider slots
+    u64 Method::popValue(Type &type) {
+        type = this->m_ctx.getTypeOnStack();
+
+        if (getTypeSize(type) == sizeof(u32))
+            return static_cast<u64>(static_cast<s64>(this->m_ctx.pop<s32>()));
+        else
+            return this->m_ctx.pop<u64>();
+    }
+
+    // Copies a struct onto the stack from wherever it's stored
+    void Method::loadValueType(const u8 *source, u32 size) {
+        ValueTypes::getCopyHandler(size)(this->m_ctx.pushValueType(size), source, size);
+    }
+
+    // Pops a struct into storage for one of the given size
+    void Method::storeValueType(u8 *destination, u32 size) {
+        u32 valueSize;
+        const u8 *value = this->m_ctx.popValueType(valueSize);
+
+        if (valueSize != size) [[unlikely]]
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Stored a %u byte struct into %u bytes!", valueSize, size);
+
+        ValueTypes::getCopyHandler(size)(destination, value, size);
+    }
+
+    template<ProfilingMode Mode>
+    void Method::leaveFrame(InterpreterFrame *caller) {
+        if constexpr (Mode == ProfilingMode::Instrumenting)
+            this->m_ctx.profiler->exitMethod();
+
+        std::atomic_signal_fence(std::memory_order_release);
+        this->m_ctx.currentFrame = caller;
+        std::atomic_signal_fence(std::memory_order_release);
+
+        this->m_frame = caller;
+        this->m_depth--;
+    }
+
+    // Exception Handling
+
+    // Objects don't carry their type, the heap reference they were allocated with does
+    u32 Method::getObjectType(u64 object) {
+        auto reference = this->m_ctx.findAllocation(object);
+
+        return reference != nullptr && reference->kind == AllocationKind::Object ? reference->typeToken : 0;
+    }
+
+    // Drops the handlers that were exited to get to offset in frame, together with everything running in frames above it
+    void Method::discardHandlers(InterpreterFrame *frame, u32 offset) {
+        while (!this->m_activeHandlers.empty()) {
+            auto &handler = this->m_activeHandlers.back();
+
+            if (handler.frame < frame || (handler.frame == frame && handler.frame->method->exceptionClauses[handler.clause].isInHandler(offset)))
+                break;
+
+            this->m_activeHandlers.pop_back();
+        }
+    }
+
+    // Objects of the framework's exceptions only need an identity and a type, like the ones natives construct
+    u64 Method::createException(const RuntimeException &error) {
+        u32 typeToken = getDLL()->getRuntimeExceptionType(error.typeName);
+
+        return reinterpret_cast<u64>(this->m_ctx.allocate(sizeof(u64), AllocationKind::Object, typeToken));
+    }
+
+    // Two passes, like the CLR: the handler is searched first without changing anything so filters still see the
+    // stack as it was when the exception was thrown. Only then is the stack unwound to it. Returns false if the
+    // dispatch loop has to stop because the exception escaped the filter that's running
+    template<ProfilingMode Mode>
+    bool Method::throwException(u64 exception, u32 offset, const RuntimeException *cause) {
+        RuntimeException nullThrown;
+        if (exception == 0) {
+            nullThrown = { "System.NullReferenceException", "Threw a null reference!" };
+            exception = this->createException(nullThrown);
+            cause = &nullThrown;
+        }
+
+        if (this->m_ctx.metrics != nullptr) [[unlikely]]
+            this->m_ctx.metrics->add(Metrics::ExceptionsThrown);
+
+        u32 typeToken = this->getObjectType(exception);
+
+        // Frames below the one a filter runs in are still in the middle of the search that started the filter
+        u32 numFrames = this->m_filterFrame == nullptr ? this->m_depth : this->m_depth - 1;
+
+        InterpreterFrame *frame = this->m_frame;
+        u32 frameOffset = offset;
+        for (u32 i = 0; i < numFrames; i++) {
+            auto &clauses = frame->method->exceptionClauses;
+
+            for (u16 clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
+                auto &clause = clauses[clauseIndex];
+                if (!clause.isInTry(frameOffset))
+                    continue;
+
+                bool catches = false;
+                if (clause.kind == ExceptionClauseKind::Catch)
+                    catches = getDLL()->isAssignableTo(typeToken, clause.classToken);
+                else if (clause.kind == ExceptionClauseKind::Filter)
+                    catches = this->runFilter<Mode>(frame, clause, exception);
+
+                if (catches) {
+                    this->unwind<Mode>(exception, offset, 0, frame, clauseIndex);
+                    return true;
+                }
+            }
+
+            if (i + 1 < numFrames) {
+                // Callers are somewhere inside their call instruction
+                frameOffset = frame->returnAddress - frame->caller->code - 1;
+                frame = frame->caller;
+            }
+        }
+
+        // Exceptions that escape a filter count as the filter not matching
+        if (this->m_filterFrame != nullptr) {
+            while (this->m_depth > 1)
+                this->leaveFrame<Mode>(this->m_frame->caller);
+
+            this->m_filterAbandoned = true;
+            return false;
+        }
+
+        if (cause != nullptr)
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Unhandled exception of type '%s': %s", cause->typeName, cause->message.c_str());
+        this->m_ctx.fatalError(LogCategory::Interpreter, "Unhandled exception of type '%s'!", getDLL()->getTypeName(typeToken).c_str());
+    }
+
+    // Filters run on top of everything that's on the stack while the handler is searched for, with the frame of the
+    // method they belong to. They may call other methods but never return from their own frame
+    template<ProfilingMode Mode>
+    bool Method::runFilter(InterpreterFrame *frame, const ExceptionClause &clause, u64 exception) {
+        InterpreterFrame *previousFrame = this->m_frame;
+        InterpreterFrame *previousCurrentFrame = this->m_ctx.currentFrame;
+        InterpreterFrame *previousFilterFrame = this->m_filterFrame;
+        const u8 *previousProgramCounter = this->m_programCounter;
+        u32 previousDepth = this->m_depth;
+        u8 *previousStackPointer = this->m_ctx.stackPointer;
+        Type *previousTypeStackPointer = this->m_ctx.typeStackPointer;
+        size_t previousNumHandlers = this->m_activeHandlers.size();
+
+        this->m_frame = frame;
+        this->m_filterFrame = frame;
+        this->m_filterAbandoned = false;
+        this->m_programCounter = frame->code + clause.filterStart;
+        this->m_depth = 1;
+
+        std::atomic_signal_fence(std::memory_order_release);
+        this->m_ctx.currentFrame = frame;
+        std::atomic_signal_fence(std::memory_order_release);
+
+        this->m_ctx.push<u64>(Type::O, exception);
+        this->dispatch<Mode>();
+
+        bool result = !this->m_filterAbandoned && this->m_ctx.pop<s32>() != 0;
+
+        std::atomic_signal_fence(std::memory_order_release);
+        this->m_ctx.currentFrame = previousCurrentFrame;
+        std::atomic_signal_fence(std::memory_order_release);
+
+        this->m_frame = previousFrame;
+        this->m_filterFrame = previousFilterFrame;
+        this->m_filterAbandoned = false;
+        this->m_programCounter = previousProgramCounter;
+        this->m_depth = previousDepth;
+        this->m_ctx.stackPointer = previousStackPointer;
+        this->m_ctx.typeStackPointer = previousTypeStackPointer;
+        this->m_activeHandlers.resize(previousNumHandlers);
+
+        return result;
+    }
+
+    // Runs the next finally or fault block between where the exception was thrown and the clause that catches it, or
+    // enters the catch handler once there's none left. endfinally picks the unwinding back up where it stopped
+    template<ProfilingMode Mode>
+    void Method::unwind(u64 exception, u32 offset, u16 firstClause, InterpreterFrame *catchFrame, u16 catchClause) {
+        while (true) {
+            auto &clauses = this->m_frame->method->exceptionClauses;
+            u16 lastClause = this->m_frame == catchFrame ? catchClause : clauses.size();
+
+            for (u16 clauseIndex = firstClause; clauseIndex < lastClause; clauseIndex++) {
+                auto &clause = clauses[clauseIndex];
+                if (clause.kind == ExceptionClauseKind::Catch || clause.kind == ExceptionClauseKind::Filter || !clause.isInTry(offset))
+                    continue;
+
+                this->resetEvaluationStack(this->m_frame);
+                this->m_activeHandlers.push_back({ this->m_frame, clauseIndex, u16(clauseIndex + 1), offset, 0, true, exception, catchFrame, catchClause });
+                this->m_programCounter = this->m_frame->code + clause.handlerStart;
+
+                return;
+            }
+
+            if (this->m_frame == catchFrame)
+                break;
+
+            offset = this->m_frame->returnAddress - this->m_frame->caller->code - 1;
+            firstClause = 0;
+            this->leaveFrame<Mode>(this->m_frame->caller);
+        }
+
+        auto &clause = this->m_frame->method->exceptionClauses[catchClause];
+
+        // Kept around while the handler runs so it can rethrow
+        this->discardHandlers(this->m_frame, clause.handlerStart);
+        this->m_activeHandlers.push_back({ this->m_frame, catchClause, 0, 0, 0, false, exception, nullptr, 0 });
+
+        this->resetEvaluationStack(this->m_frame);
+        this->m_ctx.push<u64>(Type::O, exception);
+        this->m_programCounter = this->m_frame->code + clause.handlerStart;
+    }
+
+    // Runs the finally blocks of the try regions leave exits, innermost first, then continues at its target.
+    // Entering a try region costs nothing, this is the only place that looks at the clauses without an exception
+    template<ProfilingMode Mode>
+    void Method::leave(u32 offset, u32 target, u16 firstClause) {
+        auto &clauses = this->m_frame->method->exceptionClauses;
+
+        this->resetEvaluationStack(this->m_frame);
+
+        for (u16 clauseIndex = firstClause; clauseIndex < clauses.size(); clauseIndex++) {
+            auto &clause = clauses[clauseIndex];
+            if (clause.kind != ExceptionClauseKind::Finally || !clause.isInTry(offset) || clause.isInTry(target))
+                continue;
+
+            this->m_activeHandlers.push_back({ this->m_frame, clauseIndex, u16(clauseIndex + 1), offset, target, false, 0, nullptr, 0 });
+            this->m_programCounter = this->m_frame->code + clause.handlerStart;
+
+            return;
+        }
+
+        this->discardHandlers(this->m_frame, target);
+        this->m_programCounter = this->m_frame->code + target;
+    }
+
+    template<ProfilingMode Mode>
+    void Method::endFinally(u32 offset) {
+        this->discardHandlers(this->m_frame, offset);
+
+        if (this->m_activeHandlers.empty() || this->m_activeHandlers.back().frame != this->m_frame)
+            this->m_ctx.fatalError(LogCategory::Interpreter, "endfinally outside of a finally or fault block!");
+
+        ActiveHandler handler = this->m_activeHandlers.back();
+        this->m_activeHandlers.pop_back();
+
+        if (handler.unwinding)
+            this->unwind<Mode>(handler.exception, handler.offset, handler.nextClause, handler.catchFrame, handler.catchClause);
+        else
+            this->leave<Mode>(handler.offset, handler.leaveTarget, handler.nextClause);
+    }
+
+    template<ProfilingMode Mode>
+    bool Method::rethrow(u32 offset) {
+        for (auto handler = this->m_activeHandlers.rbegin(); handler != this->m_activeHandlers.rend(); ++handler) {
+            if (handler->frame != this->m_frame)
+                break;
+
+            auto &clause = this->m_frame->method->exceptionClauses[handler->clause];
+            if ((clause.kind == ExceptionClauseKind::Catch || clause.kind == ExceptionClauseKind::Filter) && clause.isInHandler(offset))
+                return this->throwException<Mode>(handler->exception, offset);
+        }
+
+        this->m_ctx.fatalError(LogCategory::Interpreter, "rethrow outside of a catch block!");
+    }
+
+    // Instruction Implementations
+
+    void Method::stloc(u16 id) {
+        auto &local = this->getLocal(id);
+
+        // Vector locals keep pointing at their storage
+        if (local.type == Type::Vector) {
+            if (this->m_ctx.getTypeOnStack() != Type::Vector)
+                this->m_ctx.fatalError(LogCategory::Interpreter, "Stored a value that isn't a vector into a vector local!");
+
+            auto value = this->m_ctx.pop<VectorValue>();
+            std::memcpy(reinterpret_cast<void*>(local.value), &value, sizeof(value));
+            return;
+        }
+
+        // So do struct locals
+        if (local.type == Type::ValueType) {
+            this->storeValueType(reinterpret_cast<u8*>(local.value), this->m_frame->method->localLayouts[id]->size);
+            return;
+        }
+
+        Type type;
+        local.value = this->popValue(type);
+        local.type = type;
+    }
+
+    void Method::ldloc(u16 id) {
+        auto &local = this->getLocal(id);
+
+        switch (local.type) {
+            case Type::Invalid: // Never written to
+                this->m_ctx.push<s32>(Type::Int32, 0);
+                break;
+            case Type::Int32:
+                this->m_ctx.push<s32>(local.type, static_cast<s32>(local.value));
+                break;
+            case Type::Vector:
+                this->m_ctx.push<VectorValue>(local.type, *reinterpret_cast<VectorValue*>(local.value));
+                break;
+            case Type::ValueType:
+                this->loadValueType(reinterpret_cast<const u8*>(local.value), this->m_frame->method->localLayouts[id]->size);
+                break;
+            default:
+                this->m_ctx.push<u64>(local.type, local.value);
+                break;
+        }
+    }
+
+    void Method::ldloca(u16 id) {
+        auto &local = this->getLocal(id);
+
+        // Values stored through the address don't change the type of the local, e.g. for out parameters. Without
+        // one it would read back as a zero
+        if (local.type == Type::Invalid)
+            local.type = this->m_frame->method->localTypes[id];
+
+        if (local.type == Type::Vector || local.type == Type::ValueType)
+            this->m_ctx.push<u64>(Type::Pointer, local.value);
+        else
+            this->m_ctx.push<u64>(Type::Pointer, reinterpret_cast<u64>(&local.value));
+    }
+
+    // Argument indices are checked by the Preparer
+    void Method::ldarg(u16 index) {
+        auto &parameter = this->m_frame->method->signature.parameters[index];
+        const u8 *argument = this->m_frame->arguments + parameter.offset;
+
+        if (getTypeSize(parameter.type) == sizeof(u32)) {
+            u32 value;
+            std::memcpy(&value, argument, sizeof(value));
+            this->m_ctx.push<u32>(parameter.type, value);
+        } else if (parameter.type == Type::Vector) {
+            VectorValue value;
+            std::memcpy(&value, argument, sizeof(value));
+            this->m_ctx.push<VectorValue>(parameter.type, value);
+        } else if (parameter.type == Type::ValueType) {
+            this->loadValueType(argument, parameter.valueType->size);
+        } else {
+            u64 value;
+            std::memcpy(&value, argument, sizeof(value));
+            this->m_ctx.push<u64>(parameter.type, value);
+        }
+    }
+
+    void Method::ldarga(u16 index) {
+        this->m_ctx.push<u64>(Type::Pointer, reinterpret_cast<u64>(this->m_frame->arguments + this->m_frame->method->signature.parameters[index].offset));
+    }
+
+    void Method::starg(u16 index) {
+        auto &parameter = this->m_frame->method->signature.parameters[index];
+
+        if (parameter.type == Type::Vector && this->m_ctx.getTypeOnStack() == Type::Vector) {
+            auto value = this->m_ctx.pop<VectorValue>();
+            std::memcpy(this->m_frame->arguments + parameter.offset, &value, sizeof(value));
+            return;
+        }
+
+        if (parameter.type == Type::ValueType) {
+            this->storeValueType(this->m_frame->arguments + parameter.offset, parameter.valueType->size);
+            return;
+        }
+
+        Type type;
+        u64 value = this->popValue(type);
+        std::memcpy(this->m_frame->arguments + parameter.offset, &value, getTypeSize(parameter.type));
+    }
+
+    // Moves the return value down to where the arguments started, which drops them together with the frame and
+    // whatever else is left. Returns true once the method this loop started with has returned
+    template<ProfilingMode Mode>
+    bool Method::ret() {
+        // Copied out first, the return value may end up on top of the frame header
+        InterpreterFrame frame = *this->m_frame;
+        auto &signature = frame.method->signature;
+
+        if (signature.returnsValue()) {
+            if (this->m_ctx.stackPointer <= this->getEvaluationStack(this->m_frame))
+                this->m_ctx.fatalError(LogCategory::Interpreter, "Method '%s' returned without a value!", getDLL()->getString(getDLL()->getMethodDefByMetadataToken(frame.methodToken)->nameIndex));
+
+            Type type = this->m_ctx.getTypeOnStack();
+            u32 size = this->m_ctx.getSizeOnStack();
+
+            std::memmove(frame.arguments, this->m_ctx.stackPointer - size, size);
+            *frame.argumentTypes = type;
+
+            this->m_ctx.stackPointer = frame.arguments + size;
+            this->m_ctx.typeStackPointer = frame.argumentTypes + 1;
+        } else {
+            this->m_ctx.stackPointer = frame.arguments;
+            this->m_ctx.typeStackPointer = frame.argumentTypes;
+        }
+
+        this->leaveFrame<Mode>(frame.caller);
+        this->m_programCounter = frame.returnAddress;
+
+        return this->m_depth == 0;
+    }
+
+    Variable<u64>& Method::getStaticField(u32 fieldToken) {
+        if (TABLE_ID(fieldToken) != TABLE_ID_FIELD || TABLE_INDEX(fieldToken) == 0 || TABLE_INDEX(fieldToken) > this->m_ctx.statics.size())
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Invalid static field token (0x%08x)!", fieldToken);
+
+        auto &field = this->m_ctx.statics[TABLE_INDEX(fieldToken) - 1];
+
+        // Statics that were never written to take the type of their field so they read back as zero of that type,
+        // e.g. through their address. Static structs live on the heap, the field points at them from then on
+        if (field.type == Type::Invalid) [[unlikely]] {
+            auto layout = this->bindField(fieldToken);
+            if (layout != nullptr && layout->value.type == Type::ValueType)
+                field = { { Type::ValueType }, reinterpret_cast<u64>(this->m_ctx.allocate(layout->value.size, AllocationKind::Internal, layout->value.valueType->typeToken, layout->value.valueType)) };
+            else if (layout != nullptr && layout->value.type != Type::Vector)
+                field.type = layout->value.type;
+        }
+
+        return field;
+    }
+
+    // Fields are bound on the first access through each token, by the instantiation that's running if the token
+    // could refer to its type arguments. Nullptr for fields that can't be laid out
+    const FieldLayout* Method::bindField(u32 fieldToken) {
+        PreparedMethod *method = this->m_frame->method;
+        const FieldLayout *field = nullptr;
+
+        if (method->genericContext.empty()) {
+            u32 numFields = getDLL()->getNumTableRows(TABLE_ID_FIELD);
+            u32 index = TABLE_ID(fieldToken) == TABLE_ID_FIELD ? TABLE_INDEX(fieldToken) - 1 : numFields + TABLE_INDEX(fieldToken) - 1;
+
+            if (this->m_ctx.fieldBindings.empty())
+                this->m_ctx.fieldBindings.resize(numFields + getDLL()->getNumTableRows(TABLE_ID_MEMBERREF), nullptr);
+
+            if (index < this->m_ctx.fieldBindings.size()) {
+                field = this->m_ctx.fieldBindings[index];
+                if (field == nullptr)
+                    field = this->m_ctx.fieldBindings[index] = getDLL()->getFieldLayout(fieldToken);
+            }
+        } else {
+            auto &binding = method->fieldBindings[fieldToken];
+            if (binding == nullptr)
+                binding = getDLL()->getFieldLayout(fieldToken, &method->genericContext);
+
+            field = binding;
+        }
+
+        return field;
+    }
+
+    const FieldLayout& Method::resolveField(u32 fieldToken) {
+        auto field = this->bindField(fieldToken);
+
+        if (field == nullptr || field->value.type == Type::Invalid) [[unlikely]]
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Cannot access field 0x%08x!", fieldToken);
+
+        return *field;
+    }
+
+    // Same for the types of ldobj, stobj, initobj and friends
+    const ValueLayout& Method::resolveValueLayout(u32 typeToken) {
+        PreparedMethod *method = this->m_frame->method;
+        bool generic = !method->genericContext.empty();
+
+        auto &layouts = generic ? method->valueLayouts : this->m_ctx.valueLayouts;
+        auto layout = layouts.find(typeToken);
+        if (layout == layouts.end()) {
+            ValueLayout value;
+            if (!getDLL()->getValueLayout(typeToken, value, generic ? &method->genericContext : nullptr) || value.type == Type::Invalid)
+                this->m_ctx.fatalError(LogCategory::Interpreter, "Cannot access a value of type 0x%08x!", typeToken);
+
+            layout = layouts.emplace(typeToken, value).first;
+        }
+
+        return layout->second;
+    }
+
+    void Method::ldsfld(u32 fieldToken) {
+        auto &field = this->getStaticField(fieldToken);
+
+        switch (field.type) {
+            case Type::Int32:
+                this->m_ctx.push<s32>(field.type, static_cast<s32>(field.value));
+                break;
+            case Type::Int64:
+                this->m_ctx.push<s64>(field.type, static_cast<s64>(field.value));
+                break;
+            case Type::F:
+                this->m_ctx.push<double>(field.type, std::bit_cast<double>(field.value));
+                break;
+            case Type::Native_int:
+            case Type::O:
+            case Type::Pointer:
+                this->m_ctx.push<u64>(field.type, field.value);
+                break;
+            case Type::ValueType:
+                this->loadValueType(reinterpret_cast<const u8*>(field.value), this->resolveField(fieldToken).value.size);
+                break;
+            default: // Static fields that were never written to are zero initialized
+                this->m_ctx.push<s32>(Type::Int32, 0);
+                break;
+        }
+    }
+
+    void Method::ldsflda(u32 fieldToken) {
+        auto &field = this->getStaticField(fieldToken);
+
+        if (field.type == Type::ValueType)
+            this->m_ctx.push<u64>(Type::Pointer, field.value);
+        else
+            this->m_ctx.push<u64>(Type::Pointer, reinterpret_cast<u64>(&field.value));
+    }
+
+    void Method::stsfld(u32 fieldToken) {
+        auto &field = this->getStaticField(fieldToken);
+
+        if (field.type == Type::ValueType) {
+            this->storeValueType(reinterpret_cast<u8*>(field.value), this->resolveField(fieldToken).value.size);
+            return;
+        }
+
+        field.type = this->m_ctx.getTypeOnStack();
+
+        switch (field.type) {
+            case Type::Int32:
+                field.value = this->m_ctx.pop<s32>();
+                break;
+            case Type::Int64:
+                field.value = this->m_ctx.pop<s64>();
+                break;
+            case Type::F:
+                field.value = std::bit_cast<u64>(this->m_ctx.pop<double>());
+                break;
+            case Type::Native_int:
+            case Type::O:
+            case Type::Pointer:
+                field.value = this->m_ctx.pop<u64>();
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Objects and structs behind a pointer are accessed through their address, structs on the stack directly
+    void Method::ldfld(u32 fieldToken) {
+        auto &field = this->resolveField(fieldToken);
+
+        if (this->m_ctx.getTypeOnStack() == Type::ValueType) {
+            u32 size;
+            u8 *value = this->m_ctx.popValueType(size);
+
+            // A struct field takes the place of the struct it's part of, before the size word goes over its end
+            if (field.value.type == Type::ValueType) {
+                std::memmove(value, value + field.offset, field.value.size);
+                this->m_ctx.pushValueType(field.value.size);
+            } else {
+                ValueTypes::load(this->m_ctx, field.value, value + field.offset);
+            }
+
+            return;
+        }
+
+        auto object = reinterpret_cast<const u8*>(this->m_ctx.pop<u64>());
+        if (object == nullptr) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Loaded a field of a null reference!");
+
+        ValueTypes::load(this->m_ctx, field.value, object + field.offset);
+    }
+
+    void Method::ldflda(u32 fieldToken) {
+        auto &field = this->resolveField(fieldToken);
+
+        auto object = reinterpret_cast<u8*>(this->m_ctx.pop<u64>());
+        if (object == nullptr) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Took the address of a field of a null reference!");
+
+        this->m_ctx.push<u64>(Type::Pointer, reinterpret_cast<u64>(object + field.offset));
+    }
+
+    // The object sits below the value, which gets stored before the object is popped
+    void Method::stfld(u32 fieldToken) {
+        auto &field = this->resolveField(fieldToken);
+
+        u8 *object;
+        std::memcpy(&object, this->m_ctx.stackPointer - this->m_ctx.getSizeOnStack() - sizeof(u64), sizeof(object));
+        if (object == nullptr) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Stored a field of a null reference!");
+
+        ValueTypes::store(this->m_ctx, field.value, object + field.offset);
+        this->m_ctx.pop<u64>();
+    }
+
+    void Method::ldobj(u32 typeToken) {
+        auto &layout = this->resolveValueLayout(typeToken);
+
+        auto address = reinterpret_cast<const u8*>(this->m_ctx.pop<u64>());
+        if (address == nullptr) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Loaded a value through a null pointer!");
+
+        ValueTypes::load(this->m_ctx, layout, address);
+    }
+
+    void Method::stobj(u32 typeToken) {
+        auto &layout = this->resolveValueLayout(typeToken);
+
+        u8 *address;
+        std::memcpy(&address, this->m_ctx.stackPointer - this->m_ctx.getSizeOnStack() - sizeof(u64), sizeof(address));
+        if (address == nullptr) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Stored a value through a null pointer!");
+
+        ValueTypes::store(this->m_ctx, layout, address);
+        this->m_ctx.pop<u64>();
+    }
+
+    void Method::cpobj(u32 typeToken) {
+        auto &layout = this->resolveValueLayout(typeToken);
+
+        auto source = reinterpret_cast<const u8*>(this->m_ctx.pop<u64>());
+        auto destination = reinterpret_cast<u8*>(this->m_ctx.pop<u64>());
+        if (source == nullptr || destination == nullptr) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Copied a value through a null pointer!");
+
+        ValueTypes::getCopyHandler(layout.size)(destination, source, layout.size);
+    }
+
+    // Zeroes the value behind an address, which for references means null
+    void Method::initobj(u32 typeToken) {
+        auto &layout = this->resolveValueLayout(typeToken);
+
+        auto address = reinterpret_cast<u8*>(this->m_ctx.pop<u64>());
+        if (address == nullptr) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Initialized a value through a null pointer!");
+
+        std::memset(address, 0x00, layout.size);
+    }
+
+    // Strings and arrays are allocated without a type token, they're only instances of their own type and its bases
+    bool Method::isInstanceOf(u64 object, u32 classToken) {
+        auto reference = this->m_ctx.findAllocation(object);
+        if (reference == nullptr)
+            return false;
+
+        if (reference->kind == AllocationKind::Object)
+            return reference->typeToken == classToken || getDLL()->isAssignableTo(reference->typeToken, classToken);
+
+        // int[] and the like. References are all stored the same way, so any reference array matches any other
+        if (reference->kind == AllocationKind::Array && TABLE_ID(classToken) == TABLE_ID_TYPESPEC) {
+            auto typeSpec = getDLL()->getTypeSpecByIndex(TABLE_INDEX(classToken));
+            const u8 *signature = getDLL()->getBlob(typeSpec->signatureIndex);
+            const u8 *signatureEnd = signature + getDLL()->getBlobSize(typeSpec->signatureIndex);
+
+            if (signature == signatureEnd || static_cast<SignatureElementType>(*signature++) != SignatureElementType::SzArray)
+                return false;
+
+            auto &genericContext = this->m_frame->method->genericContext;
+            ValueLayout element;
+            if (!getDLL()->decodeValueLayout(signature, signatureEnd, element, genericContext.empty() ? nullptr : &genericContext))
+                element = { };
+
+            return Arrays::hasElementLayout(reinterpret_cast<const array_object_t*>(object), element);
+        }
+
+        if (TABLE_ID(classToken) != TABLE_ID_TYPEREF)
+            return false;
+
+        auto className = getDLL()->getTypeName(classToken);
+        return className == "System.Object" || className == (reference->kind == AllocationKind::String ? "System.String" : "System.Array");
+    }
+
+    // Leaves null behind if the object isn't an instance of the type
+    void Method::isinst(u32 classToken) {
+        u64 object = this->m_ctx.pop<u64>();
+
+        this->m_ctx.push<u64>(Type::O, object != 0 && this->isInstanceOf(object, classToken) ? object : 0);
+    }
+
+    // Like isinst, but the object has to be one. Null can be cast to anything
+    void Method::castclass(u32 classToken) {
+        u64 object = this->m_ctx.pop<u64>();
+
+        if (object != 0 && !this->isInstanceOf(object, classToken)) [[unlikely]]
+            throwRuntimeException("System.InvalidCastException", "Unable to cast object to type '%s'!", getDLL()->getTypeName(classToken).c_str());
+
+        this->m_ctx.push<u64>(Type::O, object);
+    }
+
+    template<typename T>
+    void Method::ldc(Type type, T num) {
+        this->m_ctx.push(type, num);
+    }
+
+    template<Method::Condition C>
+    bool Method::evaluate() {
+        Type typeB, typeA;
+        u64 b = this->popValue(typeB);
+        u64 a = this->popValue(typeA);
+
+        if (typeA == Type::F || typeB == Type::F) {
+            if (typeA != typeB)
+                this->m_ctx.fatalError(LogCategory::Interpreter, "Compare operation performed on invalid types!");
+
+            double x = std::bit_cast<double>(a);
+            double y = std::bit_cast<double>(b);
+
+            // The unordered conditions are the opposite of the inverse ordered ones, so they're true if either value is NaN
+            if constexpr (C == Condition::Equal)                        return x == y;
+            else if constexpr (C == Condition::GreaterOrEqual)          return x >= y;
+            else if constexpr (C == Condition::Greater)                 return x > y;
+            else if constexpr (C == Condition::LessOrEqual)             return x <= y;
+            else if constexpr (C == Condition::Less)                    return x < y;
+            else if constexpr (C == Condition::NotEqualUnsigned)        return !(x == y);
+            else if constexpr (C == Condition::GreaterOrEqualUnsigned)  return !(x < y);
+            else if constexpr (C == Condition::GreaterUnsigned)         return !(x <= y);
+            else if constexpr (C == Condition::LessOrEqualUnsigned)     return !(x > y);
+            else if constexpr (C == Condition::LessUnsigned)            return !(x >= y);
+        }
+
+        // popValue sign extends 32 bit values, which keeps signed comparisons right. Unsigned ones between two of
+        // them only look at the low half
+        constexpr bool isUnsigned = C >= Condition::NotEqualUnsigned;
+        if (isUnsigned && getTypeSize(typeA) == sizeof(u32) && getTypeSize(typeB) == sizeof(u32)) {
+            a = u32(a);
+            b = u32(b);
+        }
+
+        if constexpr (C == Condition::Equal)                        return a == b;
+        else if constexpr (C == Condition::GreaterOrEqual)          return s64(a) >= s64(b);
+        else if constexpr (C == Condition::Greater)                 return s64(a) > s64(b);
+        else if constexpr (C == Condition::LessOrEqual)             return s64(a) <= s64(b);
+        else if constexpr (C == Condition::Less)                    return s64(a) < s64(b);
+        else if constexpr (C == Condition::NotEqualUnsigned)        return a != b;
+        else if constexpr (C == Condition::GreaterOrEqualUnsigned)  return a >= b;
+        else if constexpr (C == Condition::GreaterUnsigned)         return a > b;
+        else if constexpr (C == Condition::LessOrEqualUnsigned)     return a <= b;
+        else if constexpr (C == Condition::LessUnsigned)            return a < b;
+    }
+
+    // Int32 results are truncated to 32 bits, everything that involves a native int or a pointer uses all 64 of them.
+    // The math is done unsigned so overflowing wraps around instead of being undefined. Pointers can only be offset,
+    // or subtracted from each other to get their distance. Bitwise operations only work on integers
+    template<Method::Operation O>
+    void Method::arithmetic() {
+        Type typeB, typeA;
+        u64 b = this->popValue(typeB);
+        u64 a = this->popValue(typeA);
+
+        bool integerA = typeA == Type::Int32 || typeA == Type::Native_int;
+        bool integerB = typeB == Type::Int32 || typeB == Type::Native_int;
+
+        constexpr bool integerOnly = O == Operation::And || O == Operation::Or || O == Operation::Xor
+            || O == Operation::DivideUnsigned || O == Operation::RemainderUnsigned;
+
+        Type resultType = Type::Invalid;
+        if (typeA == typeB && (integerA || typeA == Type::Int64 || (!integerOnly && typeA == Type::F)))
+            resultType = typeA;
+        else if (integerA && integerB)
+            resultType = Type::Native_int;
+        else if (O == Operation::Add && ((typeA == Type::Pointer && integerB) || (integerA && typeB == Type::Pointer)))
+            resultType = Type::Pointer;
+        else if (O == Operation::Subtract && typeA == Type::Pointer && integerB)
+            resultType = Type::Pointer;
+        else if (O == Operation::Subtract && typeA == Type::Pointer && typeB == Type::Pointer)
+            resultType = Type::Native_int;
+
+        if (resultType == Type::Invalid) [[unlikely]]
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Arithmetic operation performed on invalid types!");
+
+        if (resultType == Type::F) {
+            double x = std::bit_cast<double>(a);
+            double y = std::bit_cast<double>(b);
+
+            if constexpr (O == Operation::Add)              this->m_ctx.push<double>(resultType, x + y);
+            else if constexpr (O == Operation::Subtract)    this->m_ctx.push<double>(resultType, x - y);
+            else if constexpr (O == Operation::Multiply)    this->m_ctx.push<double>(resultType, x * y);
+            else if constexpr (O == Operation::Divide)      this->m_ctx.push<double>(resultType, x / y);
+            else if constexpr (O == Operation::Remainder)   this->m_ctx.push<double>(resultType, std::fmod(x, y));
+
+            return;
+        }
+
+        // Int32 operands are sign extended, so they only need to be narrowed again for the unsigned operations
+        constexpr bool division = O == Operation::Divide || O == Operation::DivideUnsigned || O == Operation::Remainder || O == Operation::RemainderUnsigned;
+        if constexpr (division) {
+            if (resultType == Type::Int32 && (O == Operation::DivideUnsigned || O == Operation::RemainderUnsigned)) {
+                a = u32(a);
+                b = u32(b);
             }
-            case TABLE_ID_MEMBERREF:
-            {
-                auto fullMethodName = getDLL()->getFullMethodName(methodToken);
-                Logger::debug("Executing native method %s", fullMethodName.c_str());
 
-                this->m_ctx.nativeFunctions[fullMethodName]();
+            if (b == 0) [[unlikely]]
+                throwRuntimeException("System.DivideByZeroException", "Attempted to divide by zero!");
+        }
+
+        u64 result;
+        if constexpr (O == Operation::Add)                      result = a + b;
+        else if constexpr (O == Operation::Subtract)            result = a - b;
+        else if constexpr (O == Operation::Multiply)            result = a * b;
+        else if constexpr (O == Operation::And)                 result = a & b;
+        else if constexpr (O == Operation::Or)                  result = a | b;
+        else if constexpr (O == Operation::Xor)                 result = a ^ b;
+        else if constexpr (O == Operation::Divide)              result = s64(b) == -1 ? 0 - a : static_cast<u64>(s64(a) / s64(b));
+        else if constexpr (O == Operation::Remainder)           result = s64(b) == -1 ? 0 : static_cast<u64>(s64(a) % s64(b));
+        else if constexpr (O == Operation::DivideUnsigned)      result = a / b;
+        else if constexpr (O == Operation::RemainderUnsigned)   result = a % b;
+
+        if (resultType == Type::Int32)
+            this->m_ctx.push<s32>(resultType, static_cast<s32>(result));
+        else
+            this->m_ctx.push<u64>(resultType, result);
+    }
+
+    template<Method::Operation O>
+    void Method::unary() {
+        Type type;
+        u64 value = this->popValue(type);
+
+        if ((type != Type::Int32 && type != Type::Int64 && type != Type::Native_int && (O == Operation::Not || type != Type::F))) [[unlikely]]
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Unary operation performed on invalid type!");
+
+        if (type == Type::F)
+            this->m_ctx.push<double>(type, -std::bit_cast<double>(value));
+        else if (type == Type::Int32)
+            this->m_ctx.push<s32>(type, static_cast<s32>(O == Operation::Negate ? 0 - value : ~value));
+        else
+            this->m_ctx.push<u64>(type, O == Operation::Negate ? 0 - value : ~value);
+    }
+
+    // The shift amount is masked to the width of the value like C# does, shifting further isn't defined
+    template<Method::Operation O>
+    void Method::shift() {
+        Type amountType, valueType;
+        u64 amount = this->popValue(amountType);
+        u64 value = this->popValue(valueType);
+
+        if ((amountType != Type::Int32 && amountType != Type::Native_int) || (valueType != Type::Int32 && valueType != Type::Int64 && valueType != Type::Native_int)) [[unlikely]]
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Shift operation performed on invalid types!");
+
+        if (valueType == Type::Int32) {
+            amount &= 31;
+
+            if constexpr (O == Operation::ShiftLeft)                this->m_ctx.push<s32>(valueType, static_cast<s32>(u32(value) << amount));
+            else if constexpr (O == Operation::ShiftRight)          this->m_ctx.push<s32>(valueType, s32(value) >> amount);
+            else if constexpr (O == Operation::ShiftRightUnsigned)  this->m_ctx.push<s32>(valueType, static_cast<s32>(u32(value) >> amount));
+        } else {
+            amount &= 63;
+
+            if constexpr (O == Operation::ShiftLeft)                this->m_ctx.push<u64>(valueType, value << amount);
+            else if constexpr (O == Operation::ShiftRight)          this->m_ctx.push<u64>(valueType, static_cast<u64>(s64(value) >> amount));
+            else if constexpr (O == Operation::ShiftRightUnsigned)  this->m_ctx.push<u64>(valueType, value >> amount);
+        }
+    }
+
+    // Targets are relative to the next instruction and were checked by the Preparer
+    template<Method::Condition C>
+    void Method::branch(s32 offset) {
+        if (this->evaluate<C>())
+            this->m_programCounter += offset;
+    }
+
+    bool Method::popCondition() {
+        Type type;
+        return this->popValue(type) != 0;
+    }
+
+    // Leaves 1 or 0 on the stack. If a brtrue or brfalse comes next, both run as a single conditional branch and the
+    // result never touches the stack. Not while instrumenting, the profiler should see every instruction
+    template<ProfilingMode Mode, Method::Condition C>
+    void Method::compare() {
+        bool result = this->evaluate<C>();
+
+        if constexpr (Mode != ProfilingMode::Instrumenting) {
+            s32 target;
+            bool taken;
+
+            switch (static_cast<OpcodePrefix>(*this->m_programCounter)) {
+                case OpcodePrefix::Brtrue_s:
+                    this->m_programCounter++;
+                    target = getNext<s8>();
+                    taken = result;
+                    break;
+                case OpcodePrefix::Brfalse_s:
+                    this->m_programCounter++;
+                    target = getNext<s8>();
+                    taken = !result;
+                    break;
+                case OpcodePrefix::Brtrue:
+                    this->m_programCounter++;
+                    target = getNext<s32>();
+                    taken = result;
+                    break;
+                case OpcodePrefix::Brfalse:
+                    this->m_programCounter++;
+                    target = getNext<s32>();
+                    taken = !result;
+                    break;
+                default:
+                    this->m_ctx.push<s32>(Type::Int32, result);
+                    return;
+            }
+
+            if constexpr (Mode != ProfilingMode::None)
+                this->m_ctx.executedInstructions++;
+
+            if (taken)
+                this->m_programCounter += target;
+        } else {
+            this->m_ctx.push<s32>(Type::Int32, result);
+        }
+    }
+
+    // The IL table already is a dense jump table and its targets were checked by the Preparer, so all that's left
+    // is one bounds check and one indexed jump
+    void Method::switchTable() {
+        u32 numTargets = getNext<u32>();
+        const u8 *targets = this->m_programCounter;
+        this->m_programCounter += numTargets * sizeof(s32);
+
+        Type type;
+        u32 value = u32(this->popValue(type));
+
+        if (value < numTargets) {
+            s32 target;
+            std::memcpy(&target, targets + value * sizeof(s32), sizeof(s32));
+            this->m_programCounter += target;
+        }
+    }
+
+    // Pushes a value loaded from memory or converted to T the way the evaluation stack represents it. Everything
+    // smaller than 4 bytes is extended to 32 bits and floats become doubles
+    template<typename T>
+    void Method::pushAs(Type type, T value) {
+        if constexpr (std::is_floating_point_v<T>)
+            this->m_ctx.push<double>(type, value);
+        else if constexpr (sizeof(T) <= sizeof(u32))
+            this->m_ctx.push<s32>(type, value);
+        else
+            this->m_ctx.push<u64>(type, value);
+    }
+
+    // Inverse of pushAs for a value returned by popValue
+    template<typename T>
+    T Method::fromValue(u64 value) {
+        if constexpr (std::is_floating_point_v<T>)
+            return static_cast<T>(std::bit_cast<double>(value));
+        else
+            return static_cast<T>(value);
+    }
+
+    void Method::dup() {
+        if (this->m_ctx.getTypeOnStack() == Type::Vector) {
+            auto value = this->m_ctx.pop<VectorValue>();
+            this->m_ctx.push<VectorValue>(Type::Vector, value);
+            this->m_ctx.push<VectorValue>(Type::Vector, value);
+            return;
+        }
+
+        // Structs are copied from right below where their copy goes, the size word included
+        if (this->m_ctx.getTypeOnStack() == Type::ValueType) {
+            u32 size = this->m_ctx.getSizeOnStack() - sizeof(u32);
+            this->loadValueType(this->m_ctx.stackPointer - size - sizeof(u32), size);
+            return;
+        }
+
+        Type type;
+        u64 value = this->popValue(type);
+
+        for (u8 i = 0; i < 2; i++) {
+            if (getTypeSize(type) == sizeof(u32))
+                this->m_ctx.push<s32>(type, s32(value));
+            else
+                this->m_ctx.push<u64>(type, value);
+        }
+    }
+
+    template<typename T>
+    void Method::ldind(Type type) {
+        auto address = reinterpret_cast<const u8*>(this->m_ctx.pop<u64>());
+        if (address == nullptr)
+            throwRuntimeException("System.NullReferenceException", "Loaded a value through a null pointer!");
+
+        T value;
+        std::memcpy(&value, address, sizeof(T));
+
+        this->pushAs<T>(type, value);
+    }
+
+    template<typename T>
+    void Method::stind() {
+        Type type;
+        T value = fromValue<T>(this->popValue(type));
+
+        auto address = reinterpret_cast<u8*>(this->m_ctx.pop<u64>());
+        if (address == nullptr)
+            throwRuntimeException("System.NullReferenceException", "Stored a value through a null pointer!");
+
+        std::memcpy(address, &value, sizeof(T));
+    }
+
+    // conv.* without overflow checks. Integers are truncated or extended the way T is, floats are rounded towards zero
+    template<typename T>
+    void Method::conv(Type type) {
+        Type sourceType;
+        u64 value = this->popValue(sourceType);
+
+        // Conversions to unsigned types zero extend
+        if (std::is_unsigned_v<T> && getTypeSize(sourceType) == sizeof(u32))
+            value = u32(value);
+
+        T result;
+        if (sourceType == Type::F)
+            result = static_cast<T>(std::bit_cast<double>(value));
+        else if constexpr (std::is_floating_point_v<T>)
+            result = static_cast<T>(s64(value));
+        else
+            result = static_cast<T>(value);
+
+        this->pushAs<T>(type, result);
+    }
+
+    // Pops an array and an index into it. Unchecked accesses were proven to be in bounds of a non-null array by the
+    // Preparer. The element size is checked either way, a mismatch would read or write past the array
+    template<bool Checked>
+    array_object_t* Method::popArrayElement(u32 &index, u16 elementSize) {
+        Type indexType;
+        s64 position = s64(this->popValue(indexType));
+        auto array = reinterpret_cast<array_object_t*>(this->m_ctx.pop<u64>());
+
+        if constexpr (Checked) {
+            if (array == nullptr) [[unlikely]]
+                throwRuntimeException("System.NullReferenceException", "Accessed an element of a null array!");
+
+            if (u64(position) >= array->length) [[unlikely]]
+                throwRuntimeException("System.IndexOutOfRangeException", "Index %lld is outside the bounds of an array of length %u!", position, array->length);
+        }
+
+        if (elementSize != 0 && array->elementSize != elementSize) [[unlikely]]
+            this->m_ctx.fatalError(LogCategory::Interpreter, "Accessed an array of %u byte elements with %u bytes!", array->elementSize, elementSize);
+
+        index = u32(position);
+        return array;
+    }
+
+    void Method::newarr(u32 elementTypeToken) {
+        Type type;
+        s64 length = s64(this->popValue(type));
+
+        if (length < 0 || length > std::numeric_limits<s32>::max())
+            throwRuntimeException("System.OverflowException", "Cannot create an array of %lld elements!", length);
+
+        // The element type of new T[] depends on the instantiation that's running
+        auto &genericContext = this->m_frame->method->genericContext;
+        auto array = Arrays::create(this->m_ctx, elementTypeToken, u32(length), genericContext.empty() ? nullptr : &genericContext);
+
+        this->m_ctx.push<u64>(Type::O, reinterpret_cast<u64>(array));
+    }
+
+    void Method::ldlen() {
+        auto array = reinterpret_cast<array_object_t*>(this->m_ctx.pop<u64>());
+
+        if (array == nullptr)
+            throwRuntimeException("System.NullReferenceException", "Took the length of a null array!");
+
+        this->m_ctx.push<u64>(Type::Native_int, array->length);
+    }
+
+    void Method::ldelema() {
+        u32 index;
+        auto array = this->popArrayElement<true>(index, 0);
+
+        this->m_ctx.push<u64>(Type::Pointer, reinterpret_cast<u64>(Arrays::getElement(array, index)));
+    }
+
+    template<typename T, bool Checked>
+    void Method::ldelem(Type type) {
+        u32 index;
+        auto array = this->popArrayElement<Checked>(index, sizeof(T));
+
+        T element;
+        std::memcpy(&element, Arrays::getData(array) + size_t(index) * sizeof(T), sizeof(T));
+
+        this->pushAs<T>(type, element);
+    }
+
+    template<typename T, bool Checked>
+    void Method::stelem() {
+        Type type;
+        u64 value = this->popValue(type);
+
+        u32 index;
+        auto array = this->popArrayElement<Checked>(index, sizeof(T));
+
+        T element = fromValue<T>(value);
+        std::memcpy(Arrays::getData(array) + size_t(index) * sizeof(T), &element, sizeof(T));
+    }
+
+    // ldelem and stelem with a type token, used for arrays of generic parameters
+    template<bool Checked>
+    void Method::ldelemAny() {
+        u32 index;
+        auto array = this->popArrayElement<Checked>(index, 0);
+        const u8 *element = Arrays::getElement(array, index);
+
+        // Structs and vectors are stored inline
+        if (array->elementType == Type::ValueType) {
+            this->loadValueType(element, array->elementSize);
+            return;
+        } else if (array->elementType == Type::Vector) {
+            VectorValue vector;
+            std::memcpy(&vector, element, sizeof(vector));
+            this->m_ctx.push<VectorValue>(Type::Vector, vector);
+            return;
+        }
+
+        u64 value = 0;
+        std::memcpy(&value, element, array->elementSize);
+
+        switch (array->elementType) {
+            case Type::Int32:
+                if (array->elementSize == sizeof(u8))
+                    value = array->elementUnsigned ? u32(u8(value)) : u32(s8(value));
+                else if (array->elementSize == sizeof(u16))
+                    value = array->elementUnsigned ? u32(u16(value)) : u32(s16(value));
+
+                this->m_ctx.push<s32>(Type::Int32, s32(value));
+                break;
+            case Type::F:
+                if (array->elementSize == sizeof(float))
+                    this->m_ctx.push<double>(Type::F, std::bit_cast<float>(u32(value)));
+                else
+                    this->m_ctx.push<double>(Type::F, std::bit_cast<double>(value));
+                break;
+            default:
+                this->m_ctx.push<u64>(array->elementType, value);
+                break;
+        }
+    }
+
+    template<bool Checked>
+    void Method::stelemAny() {
+        // The value stays where it is while the array and the index below it are popped, nothing gets pushed in between
+        if (this->m_ctx.getTypeOnStack() == Type::ValueType || this->m_ctx.getTypeOnStack() == Type::Vector) {
+            u32 size = this->m_ctx.getSizeOnStack();
+            const u8 *value;
+            if (this->m_ctx.getTypeOnStack() == Type::ValueType) {
+                value = this->m_ctx.popValueType(size);
+            } else {
+                this->m_ctx.pop<VectorValue>();
+                value = this->m_ctx.stackPointer;
+            }
+
+            u32 index;
+            auto array = this->popArrayElement<Checked>(index, size);
+            ValueTypes::getCopyHandler(size)(Arrays::getElement(array, index), value, size);
+            return;
+        }
+
+        Type type;
+        u64 value = this->popValue(type);
+
+        u32 index;
+        auto array = this->popArrayElement<Checked>(index, 0);
+
+        if (array->elementType == Type::F && array->elementSize == sizeof(float))
+            value = std::bit_cast<u32>(float(std::bit_cast<double>(value)));
+
+        std::memcpy(Arrays::getElement(array, index), &value, array->elementSize);
+    }
+
+    // Math.Min and Math.Max return NaN if either value is, and treat -0.0 as less than 0.0
+    template<typename T>
+    static T minimum(T a, T b) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (a != a || b != b)
+                return a != a ? a : b;
+            if (a == b)
+                return std::signbit(a) ? a : b;
+        }
+
+        return a < b ? a : b;
+    }
+
+    template<typename T>
+    static T maximum(T a, T b) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (a != a || b != b)
+                return a != a ? a : b;
+            if (a == b)
+                return std::signbit(a) ? b : a;
+        }
+
+        return a > b ? a : b;
+    }
+
+    // Math.Abs throws for the one negative value that has no positive counterpart
+    template<typename T>
+    static T absolute(T value) {
+        if (value == std::numeric_limits<T>::min()) [[unlikely]]
+            throwRuntimeException("System.OverflowException", "Math.Abs of the smallest %u byte integer overflowed!", u32(sizeof(T)));
+
+        return value < 0 ? -value : value;
+    }
+
+    static array_object_t* popArray(Context &ctx) {
+        auto array = reinterpret_cast<array_object_t*>(ctx.pop<u64>());
+        if (array == nullptr) [[unlikely]]
+            throwRuntimeException("System.ArgumentNullException", "Passed a null array to a bulk array operation!");
+
+        return array;
+    }
+
+    // Ranges are checked the way Array.Copy and Buffer.BlockCopy check them, in elements or bytes
+    static void checkRange(s32 start, s32 count, u64 length) {
+        if (start < 0 || count < 0 || u64(start) + u64(count) > length) [[unlikely]]
+            throwRuntimeException("System.ArgumentException", "Range of %d starting at %d is outside the bounds of an array of length %llu!", count, start, length);
+    }
+
+    // Typed stores so the compiler can turn these into wide vector stores
+    template<typename T>
+    static void fillElements(u8 *elements, u32 count, u64 value) {
+        T element;
+        std::memcpy(&element, &value, sizeof(T));
+        std::fill_n(reinterpret_cast<T*>(elements), count, element);
+    }
+
+    // S is how a T is represented on the evaluation stack
+    template<typename T, typename S = T>
+    static void applyBinary(Context &ctx, Type type, T(*operation)(T, T)) {
+        T b = T(ctx.pop<S>());
+        T a = T(ctx.pop<S>());
+        ctx.push<S>(type, S(operation(a, b)));
+    }
+
+    void Method::callIntrinsic(Intrinsic intrinsic) {
+        auto &ctx = this->m_ctx;
+
+        auto unaryDouble = [&ctx](auto operation) { ctx.push<double>(Type::F, operation(ctx.pop<double>())); };
+        auto unaryFloat = [&ctx](auto operation) { ctx.push<double>(Type::F, operation(float(ctx.pop<double>()))); };
+
+        switch (intrinsic) {
+            case Intrinsic::SqrtDouble:     unaryDouble([](double value) { return __builtin_sqrt(value); }); break;
+            case Intrinsic::SqrtFloat:      unaryFloat([](float value) { return __builtin_sqrtf(value); }); break;
+            case Intrinsic::FloorDouble:    unaryDouble([](double value) { return __builtin_floor(value); }); break;
+            case Intrinsic::FloorFloat:     unaryFloat([](float value) { return __builtin_floorf(value); }); break;
+            case Intrinsic::CeilingDouble:  unaryDouble([](double value) { return __builtin_ceil(value); }); break;
+            case Intrinsic::CeilingFloat:   unaryFloat([](float value) { return __builtin_ceilf(value); }); break;
+            case Intrinsic::AbsDouble:      unaryDouble([](double value) { return __builtin_fabs(value); }); break;
+            case Intrinsic::AbsFloat:       unaryFloat([](float value) { return __builtin_fabsf(value); }); break;
+            case Intrinsic::AbsInt8:        ctx.push<s32>(Type::Int32, absolute<s8>(s8(ctx.pop<s32>()))); break;
+            case Intrinsic::AbsInt16:       ctx.push<s32>(Type::Int32, absolute<s16>(s16(ctx.pop<s32>()))); break;
+            case Intrinsic::AbsInt32:       ctx.push<s32>(Type::Int32, absolute<s32>(ctx.pop<s32>())); break;
+            case Intrinsic::AbsInt64:       ctx.push<s64>(Type::Int64, absolute<s64>(ctx.pop<s64>())); break;
+            case Intrinsic::MinInt32:       applyBinary<s32>(ctx, Type::Int32, minimum<s32>); break;
+            case Intrinsic::MinUInt32:      applyBinary<u32, s32>(ctx, Type::Int32, minimum<u32>); break;
+            case Intrinsic::MinInt64:       applyBinary<s64>(ctx, Type::Int64, minimum<s64>); break;
+            case Intrinsic::MinUInt64:      applyBinary<u64, s64>(ctx, Type::Int64, minimum<u64>); break;
+            case Intrinsic::MinDouble:      applyBinary<double>(ctx, Type::F, minimum<double>); break;
+            case Intrinsic::MinFloat:       applyBinary<float, double>(ctx, Type::F, minimum<float>); break;
+            case Intrinsic::MaxInt32:       applyBinary<s32>(ctx, Type::Int32, maximum<s32>); break;
+            case Intrinsic::MaxUInt32:      applyBinary<u32, s32>(ctx, Type::Int32, maximum<u32>); break;
+            case Intrinsic::MaxInt64:       applyBinary<s64>(ctx, Type::Int64, maximum<s64>); break;
+            case Intrinsic::MaxUInt64:      applyBinary<u64, s64>(ctx, Type::Int64, maximum<u64>); break;
+            case Intrinsic::MaxDouble:      applyBinary<double>(ctx, Type::F, maximum<double>); break;
+            case Intrinsic::MaxFloat:       applyBinary<float, double>(ctx, Type::F, maximum<float>); break;
+
+            case Intrinsic::ArrayCopy:
+            case Intrinsic::ArrayCopyRange: {
+                s32 length = ctx.pop<s32>();
+                s32 destinationIndex = intrinsic == Intrinsic::ArrayCopyRange ? ctx.pop<s32>() : 0;
+                auto destination = popArray(ctx);
+                s32 sourceIndex = intrinsic == Intrinsic::ArrayCopyRange ? ctx.pop<s32>() : 0;
+                auto source = popArray(ctx);
+
+                // Copies that would have to convert or box elements aren't supported
+                if (source->elementSize != destination->elementSize || source->elementType != destination->elementType) [[unlikely]]
+                    this->m_ctx.fatalError(LogCategory::Interpreter, "Array.Copy between arrays of incompatible element types!");
+
+                checkRange(sourceIndex, length, source->length);
+                checkRange(destinationIndex, length, destination->length);
+
+                // Source and destination may be the same array, memmove handles the overlap
+                std::memmove(Arrays::getElement(destination, destinationIndex), Arrays::getElement(source, sourceIndex), u64(length) * source->elementSize);
+                break;
+            }
+            case Intrinsic::ArrayClear:
+            case Intrinsic::ArrayClearRange: {
+                s32 length = 0, index = 0;
+                if (intrinsic == Intrinsic::ArrayClearRange) {
+                    length = ctx.pop<s32>();
+                    index = ctx.pop<s32>();
+                }
+
+                auto array = popArray(ctx);
+                if (intrinsic == Intrinsic::ArrayClear)
+                    length = s32(array->length);
+
+                checkRange(index, length, array->length);
+                std::memset(Arrays::getElement(array, index), 0x00, u64(length) * array->elementSize);
+                break;
+            }
+            case Intrinsic::ArrayFill:
+            case Intrinsic::ArrayFillRange: {
+                s32 count = 0, index = 0;
+                if (intrinsic == Intrinsic::ArrayFillRange) {
+                    count = ctx.pop<s32>();
+                    index = ctx.pop<s32>();
+                }
 
+                Type type;
+                u64 value = this->popValue(type);
+                auto array = popArray(ctx);
+                if (intrinsic == Intrinsic::ArrayFill)
+                    count = s32(array->length);
+
+                checkRange(index, count, array->length);
+
+                if (array->elementType == Type::F && array->elementSize == sizeof(float))
+                    value = std::bit_cast<u32>(float(std::bit_cast<double>(value)));
+
+                u8 *elements = Arrays::getElement(array, index);
+                switch (array->elementSize) {
+                    case sizeof(u8):    std::memset(elements, u8(value), count); break;
+                    case sizeof(u16):   fillElements<u16>(elements, count, value); break;
+                    case sizeof(u32):   fillElements<u32>(elements, count, value); break;
+                    default:            fillElements<u64>(elements, count, value); break;
+                }
+                break;
+            }
+            case Intrinsic::BufferBlockCopy: {
+                s32 count = ctx.pop<s32>();
+                s32 destinationOffset = ctx.pop<s32>();
+                auto destination = popArray(ctx);
+                s32 sourceOffset = ctx.pop<s32>();
+                auto source = popArray(ctx);
+
+                if (source->elementType == Type::O || destination->elementType == Type::O) [[unlikely]]
+                    this->m_ctx.fatalError(LogCategory::Interpreter, "Buffer.BlockCopy only works on arrays of primitive types!");
+
+                checkRange(sourceOffset, count, u64(source->length) * source->elementSize);
+                checkRange(destinationOffset, count, u64(destination->length) * destination->elementSize);
+
+                std::memmove(Arrays::getData(destination) + destinationOffset, Arrays::getData(source) + sourceOffset, count);
                 break;
             }
+            case Intrinsic::CopyBlock:
+                cpblk();
+                break;
+            case Intrinsic::InitBlock:
+                initblk();
+                break;
+
+            default:
+                this->m_ctx.fatalError(LogCategory::Interpreter, "Unknown intrinsic %u!", u32(intrinsic));
         }
     }
 
-}
+    // Neither cares about alignment, so the unaligned. prefix needs no handling
+    void Method::cpblk() {
+        u32 size = this->m_ctx.pop<s32>();
+        auto source = reinterpret_cast<const void*>(this->m_ctx.pop<u64>());
+        auto destination = reinterpret_cast<void*>(this->m_ctx.pop<u64>());
+
+        std::memmove(destination, source, size);
+    }
+
+    void Method::initblk() {
+        u32 size = this->m_ctx.pop<s32>();
+        u8 value = this->m_ctx.pop<s32>();
+        auto address = reinterpret_cast<void*>(this->m_ctx.pop<u64>());
 
+        std::memset(address, value, size);
+    }
+
+    template<ProfilingMode Mode>
+    void Method::call(u32 methodToken) {
+        bool tailCall = this->m_tailCall;
+        this->m_tailCall = false;
+
+        PreparedMethod *preparedMethod = nullptr;
+        std::function<void()> *nativeMethod = nullptr;
+
+        switch (TABLE_ID(methodToken)) {
+            case TABLE_ID_METHODDEF:
+                preparedMethod = this->getVerifiedMethod(methodToken);
+                break;
+            case TABLE_ID_MEMBERREF:
+            case TABLE_ID_METHODSPEC: {
+                auto callee = this->resolveCallee(methodToken);
+                preparedMethod = callee.instantiation;
+                nativeMethod = callee.native;
+                break;
+            }
+            default:
+                return;
+        }
+
+        if (preparedMethod != nullptr) {
+            // The stack is sampled here rather than on every push, it's usually at its deepest right before a call
+            if (this->m_ctx.metrics != nullptr) [[unlikely]] {
+                this->m_ctx.metrics->add(Metrics::ManagedCalls);
+                this->m_ctx.metrics->raise(Metrics::StackHighWater, this->m_ctx.getUsedStackSize());
+            }
+
+            // Continues in the callee, the loop picks the caller back up once it returns. Instantiations run under
+            // the token of their generic definition
+            if (tailCall)
+                this->tailCall<Mode>(preparedMethod->token, preparedMethod);
+            else
+                this->enter<Mode>(preparedMethod->token, preparedMethod, this->m_frame, this->m_programCounter);
+
+            return;
+        }
+
+        // Natives return before the next instruction, so the tail. prefix changes nothing for them
+        if (Logger::isEnabled(LogLevel::Debug, LogCategory::Interpreter)) [[unlikely]]
+            Logger::debug(LogCategory::Interpreter, "Executing native method %s", getDLL()->getMemberRefName(methodToken));
+
+        std::chrono::steady_clock::time_point start;
+        if (this->m_ctx.metrics != nullptr) [[unlikely]] {
+            this->m_ctx.metrics->add(Metrics::NativeCalls);
+            this->m_ctx.metrics->raise(Metrics::StackHighWater, this->m_ctx.getUsedStackSize());
+            start = std::chrono::steady_clock::now();
+        }
+
+        if constexpr (Mode == ProfilingMode::Instrumenting) {
+            this->m_ctx.profiler->enterMethod(methodToken);
+            (*nativeMethod)();
+            this->m_ctx.profiler->exitMethod();
+        } else {
+            (*nativeMethod)();
+        }
+
+        if (this->m_ctx.metrics != nullptr) [[unlikely]] {
+            auto duration = std::chrono::steady_clock::now() - start;
+            this->m_ctx.metrics->observe(Metrics::NativeCallDuration, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        }
+    }
+
+    template<ProfilingMode Mode>
+    void Method::newobj(u32 methodToken) {
+        u32 typeToken;
+        size_t objSize;
+        const MethodSignature *signature;
+        const TypeLayout *layout = nullptr;
+
+        if (TABLE_ID(methodToken) == TABLE_ID_METHODDEF) {
+            u32 typeIndex = getDLL()->findTypeDefWithMethod(methodToken);
+
+            table_type_def_t *type = getDLL()->getTypeDefByIndex(typeIndex);
+
+            if (Logger::isEnabled(LogLevel::Debug, LogCategory::Interpreter)) [[unlikely]]
+                Logger::debug(LogCategory::Interpreter, "Creating instance of Type %s::%s", getDLL()->getString(type->typeNamespaceIndex), getDLL()->getString(type->typeNameIndex));
+
+            signature = &this->getVerifiedMethod(methodToken)->signature;
+
+            // Structs are constructed on the stack, their constructor gets a pointer as its this
+            if (signature->hasThis && signature->parameters[0].type == Type::Pointer) {
+                this->newValue<Mode>(methodToken, *signature, getDLL()->getTypeLayout((TABLE_ID_TYPEDEF << 24) | typeIndex));
+                return;
+            }
+
+            // Objects without fields still need an address of their own
+            objSize = std::max<size_t>(getDLL()->getObjectSize(typeIndex), 1);
+            typeToken = (TABLE_ID_TYPEDEF << 24) | typeIndex;
+        } else if (auto instantiation = this->resolveCallee(methodToken).instantiation; instantiation != nullptr) {
+            // Generic types of the program, like Box<int>. Each instantiation has a layout of its own, as the
+            // fields of a generic parameter type are as big as its type argument
+            u32 typeIndex = getDLL()->findTypeDefWithMethod(instantiation->token);
+            layout = getDLL()->getInstantiationLayout(typeIndex, instantiation->genericContext);
+
+            signature = &instantiation->signature;
+
+            if (signature->hasThis && signature->parameters[0].type == Type::Pointer) {
+                this->newValue<Mode>(methodToken, *signature, layout);
+                return;
+            }
+
+            objSize = std::max<size_t>(layout->size, 1);
+            typeToken = (TABLE_ID_TYPEDEF << 24) | typeIndex;
+        } else {
+            // Types from other assemblies are implemented by natives. Their objects only need an identity and a type
+            auto memberRef = getDLL()->getMemberRefByMetadataToken(methodToken);
+            signature = this->getNativeSignature(methodToken);
+
+            if (signature != nullptr && signature->hasThis && signature->parameters[0].type == Type::Pointer) {
+                this->newValue<Mode>(methodToken, *signature, nullptr);
+                return;
+            }
+
+            // Generic instantiations like List<int> are referenced through a TypeSpec
+            u8 parentTag = INDEX_TAG(memberRef->classIndex, MEMBER_REF_PARENT);
+            if ((parentTag != 1 && parentTag != 4) || signature == nullptr) { // TypeRef or TypeSpec
+                this->m_ctx.fatalError(LogCategory::Interpreter, "Cannot create an instance through %s!", getDLL()->getMemberRefName(methodToken));
+            }
+
+            objSize = sizeof(u64);
+            typeToken = ((parentTag == 1 ? TABLE_ID_TYPEREF : TABLE_ID_TYPESPEC) << 24) | INDEX_INDEX(memberRef->classIndex, MEMBER_REF_PARENT);
+        }
+
+        Logger::debug(LogCategory::Interpreter, "Allocating %d bytes on the heap", objSize);
+
+        u8 *newMemory = this->m_ctx.allocate(objSize, AllocationKind::Object, typeToken, layout);
+
+        // The constructor takes the new object as its this, which goes in front of the arguments that were already pushed.
+        // A second copy below that is what's left on the stack once the constructor has returned
+        u8 numCopies = signature->hasThis ? 2 : 1;
+
+        u32 parametersSize = signature->argumentsSize - (numCopies - 1) * getTypeSize(Type::O);
+        u16 numParameters = signature->getNumParameters() - (numCopies - 1);
+
+        u8 *parameters = this->m_ctx.stackPointer - parametersSize;
+        Type *parameterTypes = this->m_ctx.typeStackPointer - numParameters;
+
+        std::memmove(parameters + numCopies * getTypeSize(Type::O), parameters, parametersSize);
+        std::memmove(parameterTypes + numCopies, parameterTypes, numParameters * sizeof(Type));
+
+        for (u8 i = 0; i < numCopies; i++) {
+            std::memcpy(parameters + i * getTypeSize(Type::O), &newMemory, sizeof(newMemory));
+            parameterTypes[i] = Type::O;
+        }
+
+        this->m_ctx.stackPointer += numCopies * getTypeSize(Type::O);
+        this->m_ctx.typeStackPointer += numCopies;
+
+        call<Mode>(methodToken);
+    }
+
+    // Vectors and structs are values rather than objects. Their constructor gets a pointer to a zeroed value below its
+    // arguments, which is what's left on the stack once it has returned. Vectors are passed without a layout
+    template<ProfilingMode Mode>
+    void Method::newValue(u32 methodToken, const MethodSignature &signature, const TypeLayout *valueType) {
+        u32 parametersSize = signature.argumentsSize - getTypeSize(Type::Pointer);
+        u16 numParameters = signature.getNumParameters() - 1;
+
+        u8 *parameters = this->m_ctx.stackPointer - parametersSize;
+        Type *parameterTypes = this->m_ctx.typeStackPointer - numParameters;
+
+        u32 size = valueType != nullptr ? valueType->size : sizeof(VectorValue);
+        u32 sizeOnStack = valueType != nullptr ? size + sizeof(u32) : size;
+
+        std::memmove(parameters + sizeOnStack + sizeof(u64), parameters, parametersSize);
+        std::memmove(parameterTypes + 2, parameterTypes, numParameters * sizeof(Type));
+
+        u64 value = reinterpret_cast<u64>(parameters);
+        std::memset(parameters, 0x00, size);
+        if (valueType != nullptr)
+            std::memcpy(parameters + size, &size, sizeof(size));
+        std::memcpy(parameters + sizeOnStack, &value, sizeof(value));
+        parameterTypes[0] = valueType != nullptr ? Type::ValueType : Type::Vector;
+        parameterTypes[1] = Type::Pointer;
+
+        this->m_ctx.stackPointer += sizeOnStack + sizeof(u64);
+        this->m_ctx.typeStackPointer += 2;
+
+        call<Mode>(methodToken);
+    }
+
+}
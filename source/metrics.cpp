@@ -0,0 +1,213 @@
+#include "metrics.hpp"
+
+#include "context.hpp"
+#include "logger.hpp"
+
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace ili {
+
+    static std::atomic<u64> s_nextMetricsId = 1;
+
+    Metrics::Metrics(Context &ctx) : m_ctx(ctx), m_id(s_nextMetricsId.fetch_add(1, std::memory_order_relaxed)) {
+        this->addCounter("ili_instructions_executed_total", "IL instructions executed");
+        this->addCounter("ili_calls_total{kind=\"managed\"}", "Calls by kind of callee");
+        this->addCounter("ili_calls_total{kind=\"native\"}", "Calls by kind of callee");
+        this->addCounter("ili_calls_total{kind=\"virtual\"}", "Calls by kind of callee");
+        this->addCounter("ili_allocations_total", "Allocations on the managed heap");
+        this->addCounter("ili_allocated_bytes_total", "Bytes allocated on the managed heap");
+        this->addCounter("ili_stack_high_water_bytes", "Deepest the evaluation stack has been at a call", CounterKind::Maximum);
+        this->addCounter("ili_methods_prepared_total{thread=\"interpreter\"}", "Methods prepared by the thread that prepared them");
+        this->addCounter("ili_methods_prepared_total{thread=\"worker\"}", "Methods prepared by the thread that prepared them");
+        this->addCounter("ili_exceptions_thrown_total", "Exceptions thrown, including rethrows");
+        this->addCounter("ili_bounds_checks_eliminated_total", "Array accesses the preparer proved to be in bounds");
+        this->addCounter("ili_intrinsics_replaced_total", "Library calls the preparer replaced with intrinsics");
+        this->addCounter("ili_generic_instantiations_total", "Generic methods prepared for a new tuple of type arguments");
+
+        this->addHistogram("ili_native_call_duration_seconds", "Time spent in native bindings", 1e-9);
+    }
+
+    Metrics::~Metrics() {
+        this->stopPeriodicDumps();
+    }
+
+    Metrics::Counter Metrics::addCounter(const std::string &name, const std::string &help, CounterKind kind) {
+        std::scoped_lock lock(this->m_mutex);
+
+        if (this->m_counters.size() >= MaxCounters) {
+            Logger::error("Cannot register more than %zu counters!", MaxCounters);
+            exit(1);
+        }
+
+        this->m_counters.push_back({ name, help, kind, 1.0 });
+
+        return { u16(this->m_counters.size() - 1) };
+    }
+
+    Metrics::Histogram Metrics::addHistogram(const std::string &name, const std::string &help, double unit) {
+        std::scoped_lock lock(this->m_mutex);
+
+        if (this->m_histograms.size() >= MaxHistograms) {
+            Logger::error("Cannot register more than %zu histograms!", MaxHistograms);
+            exit(1);
+        }
+
+        this->m_histograms.push_back({ name, help, CounterKind::Counter, unit });
+
+        return { u16(this->m_histograms.size() - 1) };
+    }
+
+    Metrics::Shard* Metrics::addShard() {
+        std::scoped_lock lock(this->m_mutex);
+
+        // Shards outlive their threads so nothing counted by a thread that has finished gets lost
+        return this->m_shards.emplace_back(std::make_unique<Shard>()).get();
+    }
+
+    void Metrics::observe(Histogram histogram, u64 value) {
+        auto &shard = this->getShard();
+
+        auto &bucket = shard.buckets[histogram.index][std::min<size_t>(std::bit_width(value), NumBuckets - 1)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        auto &sum = shard.sums[histogram.index];
+        sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    u64 Metrics::getValue(Counter counter) {
+        std::scoped_lock lock(this->m_mutex);
+
+        bool maximum = this->m_counters[counter.index].kind == CounterKind::Maximum;
+
+        u64 value = 0;
+        for (auto &shard : this->m_shards) {
+            u64 shardValue = shard->counters[counter.index].load(std::memory_order_relaxed);
+            value = maximum ? std::max(value, shardValue) : value + shardValue;
+        }
+
+        return value;
+    }
+
+    Metrics::HistogramValues Metrics::getValues(Histogram histogram) {
+        std::scoped_lock lock(this->m_mutex);
+
+        HistogramValues values;
+        for (auto &shard : this->m_shards) {
+            for (size_t bucket = 0; bucket < NumBuckets; bucket++)
+                values.buckets[bucket] += shard->buckets[histogram.index][bucket].load(std::memory_order_relaxed);
+
+            values.sum += shard->sums[histogram.index].load(std::memory_order_relaxed);
+        }
+
+        for (u64 count : values.buckets)
+            values.count += count;
+
+        return values;
+    }
+
+    // The instruction count lives in the Context so the interpreter loop only has to bump a plain integer
+    void Metrics::publishInterpreterState() {
+        this->add(InstructionsExecuted, this->m_ctx.executedInstructions - this->m_publishedInstructions);
+        this->m_publishedInstructions = this->m_ctx.executedInstructions;
+
+        this->raise(StackHighWater, this->m_ctx.getUsedStackSize());
+    }
+
+    static std::string getFamilyName(const std::string &name) {
+        return name.substr(0, name.find('{'));
+    }
+
+    bool Metrics::writePrometheus(const std::string &path) {
+        this->publishInterpreterState();
+
+        // Written next to the destination and renamed over it, so a scraper never sees half a file
+        auto temporaryPath = path + ".tmp";
+        FILE *file = std::fopen(temporaryPath.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        std::vector<Descriptor> counters, histograms;
+        {
+            std::scoped_lock lock(this->m_mutex);
+            counters = this->m_counters;
+            histograms = this->m_histograms;
+        }
+
+        std::string family;
+        for (size_t i = 0; i < counters.size(); i++) {
+            auto &counter = counters[i];
+
+            if (getFamilyName(counter.name) != family) {
+                family = getFamilyName(counter.name);
+                std::fprintf(file, "# HELP %s %s\n", family.c_str(), counter.help.c_str());
+                std::fprintf(file, "# TYPE %s %s\n", family.c_str(), counter.kind == CounterKind::Counter ? "counter" : "gauge");
+            }
+
+            std::fprintf(file, "%s %llu\n", counter.name.c_str(), static_cast<unsigned long long>(this->getValue({ u16(i) })));
+        }
+
+        for (size_t i = 0; i < histograms.size(); i++) {
+            auto &histogram = histograms[i];
+            auto values = this->getValues({ u16(i) });
+
+            std::fprintf(file, "# HELP %s %s\n", histogram.name.c_str(), histogram.help.c_str());
+            std::fprintf(file, "# TYPE %s histogram\n", histogram.name.c_str());
+
+            // Buckets are cumulative. Trailing empty ones would only repeat the total
+            u64 cumulative = 0;
+            for (size_t bucket = 0; bucket + 1 < NumBuckets && cumulative < values.count; bucket++) {
+                cumulative += values.buckets[bucket];
+                std::fprintf(file, "%s_bucket{le=\"%g\"} %llu\n", histogram.name.c_str(), std::ldexp(histogram.unit, bucket), static_cast<unsigned long long>(cumulative));
+            }
+
+            std::fprintf(file, "%s_bucket{le=\"+Inf\"} %llu\n", histogram.name.c_str(), static_cast<unsigned long long>(values.count));
+            std::fprintf(file, "%s_sum %g\n", histogram.name.c_str(), double(values.sum) * histogram.unit);
+            std::fprintf(file, "%s_count %llu\n", histogram.name.c_str(), static_cast<unsigned long long>(values.count));
+        }
+
+        std::fclose(file);
+
+        return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+
+    void Metrics::setDumpPath(const std::string &path) {
+        this->m_dumpPath = path;
+    }
+
+    void Metrics::writeRequestedDump() {
+        this->m_dumpRequested.store(false, std::memory_order_relaxed);
+
+        if (!this->writePrometheus(this->m_dumpPath))
+            Logger::error("Cannot write metrics to %s!", this->m_dumpPath.c_str());
+    }
+
+    // The timer thread only asks for a dump, the values that live in the Context can only be read by the interpreter
+    void Metrics::startPeriodicDumps(u32 intervalMilliseconds) {
+        this->stopPeriodicDumps();
+
+        this->m_stopDumps = false;
+        this->m_dumpThread = std::thread([this, intervalMilliseconds] {
+            std::unique_lock lock(this->m_dumpMutex);
+
+            while (!this->m_dumpSignal.wait_for(lock, std::chrono::milliseconds(intervalMilliseconds), [this] { return this->m_stopDumps; }))
+                this->requestDump();
+        });
+    }
+
+    void Metrics::stopPeriodicDumps() {
+        if (!this->m_dumpThread.joinable())
+            return;
+
+        {
+            std::scoped_lock lock(this->m_dumpMutex);
+            this->m_stopDumps = true;
+        }
+
+        this->m_dumpSignal.notify_all();
+        this->m_dumpThread.join();
+    }
+
+}
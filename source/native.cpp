@@ -2,6 +2,11 @@
 
 #include "context.hpp"
 #include "dll.hpp"
+#include "tables.hpp"
+#include "logger.hpp"
+#include "strings.hpp"
+
+#include <charconv>
 
 
 
@@ -15,16 +20,161 @@ namespace ili {
         ctx.nativeFunctions[methodName]();
     }
 
+    // MemberRefs come first in the bindings, the MethodSpecs instantiating generic natives follow them
+    u32 NativeMethods::getBindingIndex(Context &ctx, u32 methodToken) {
+        if (TABLE_ID(methodToken) == TABLE_ID_METHODSPEC)
+            return ctx.dll->getNumTableRows(TABLE_ID_MEMBERREF) + TABLE_INDEX(methodToken) - 1;
+        else
+            return TABLE_INDEX(methodToken) - 1;
+    }
+
+    u32 NativeMethods::getBindingToken(Context &ctx, u32 index) {
+        u32 numMemberRefs = ctx.dll->getNumTableRows(TABLE_ID_MEMBERREF);
+
+        if (index >= numMemberRefs)
+            return (TABLE_ID_METHODSPEC << 24) | (index - numMemberRefs + 1);
+        else
+            return (TABLE_ID_MEMBERREF << 24) | (index + 1);
+    }
+
+    // Overloads are registered with their parameter types appended, anything else just by name. Instantiations of
+    // generic methods have their type arguments in the name and the parameters of the generic method
+    static std::function<void()>* findMethod(Context &ctx, u32 methodToken, const GenericContext *genericContext) {
+        std::string name, signature;
+        if (TABLE_ID(methodToken) == TABLE_ID_METHODSPEC) {
+            name = ctx.dll->getMethodSpecName(methodToken);
+            signature = ctx.dll->getMemberRefSignature(ctx.dll->getMethodSpecMethod(methodToken));
+        } else {
+            name = ctx.dll->getMemberRefName(methodToken);
+            signature = ctx.dll->getMemberRefSignature(methodToken);
+        }
+
+        // Only the name refers to the caller's type arguments, the signature is the one of the generic definition
+        if (genericContext != nullptr)
+            name = ctx.dll->instantiateName(name, *genericContext);
+
+        auto nativeFunction = ctx.nativeFunctions.find(name + signature);
+        if (nativeFunction == ctx.nativeFunctions.end())
+            nativeFunction = ctx.nativeFunctions.find(name);
+
+        if (nativeFunction == ctx.nativeFunctions.end())
+            ctx.fatalError(LogCategory::Native, "Unknown native method %s%s!", name.c_str(), signature.c_str());
+
+        return &nativeFunction->second;
+    }
+
+    // Bindings are resolved by name once and then stay valid as the native function map never changes afterwards.
+    // Calls from generic code are bound by the calling instantiation instead, their names depend on its type arguments
+    std::function<void()>* NativeMethods::resolveMethod(Context &ctx, u32 methodToken, const GenericContext *genericContext) {
+        if (genericContext != nullptr)
+            return findMethod(ctx, methodToken, genericContext);
+
+        u32 index = getBindingIndex(ctx, methodToken);
+
+        if (index >= ctx.nativeBindings.size())
+            ctx.nativeBindings.resize(ctx.dll->getNumTableRows(TABLE_ID_MEMBERREF) + ctx.dll->getNumTableRows(TABLE_ID_METHODSPEC), nullptr);
+
+        if (ctx.nativeBindings[index] == nullptr)
+            ctx.nativeBindings[index] = findMethod(ctx, methodToken, nullptr);
+
+        return ctx.nativeBindings[index];
+    }
+
+
+    template<typename T>
+    static void writeNumber(Context &ctx, T value) {
+        // Large enough for any integer and the shortest round-trip representation of any double
+        constexpr size_t MaxSize = 32;
+
+        char *destination = ctx.output.reserve(MaxSize);
+        ctx.output.commit(std::to_chars(destination, destination + MaxSize, value).ptr - destination);
+    }
+
+    static void writeString(Context &ctx, u64 string) {
+        // Printing null prints nothing, just like on .NET
+        if (string != 0)
+            ctx.output.write(Strings::getView(reinterpret_cast<string_object_t*>(string)));
+    }
+
+    static void writeBoolean(Context &ctx, s32 value) {
+        ctx.output.write(value != 0 ? "True" : "False");
+    }
+
+    static void writeCharacter(Context &ctx, s32 value) {
+        char16_t character = static_cast<char16_t>(value);
+        ctx.output.write(std::u16string_view(&character, 1));
+    }
+
+    // Console.Write and Console.WriteLine for every overload that can be printed without calling back into managed code
+    static void registerConsoleWrite(Context &ctx, const std::string &name, bool newLine) {
+        auto end = [&ctx, newLine] {
+            if (newLine)
+                ctx.output.writeLine();
+        };
+
+        NativeMethods::registerMethod(ctx, name + "(string)",  [&ctx, end] { writeString(ctx, ctx.pop<u64>()); end(); });
+        NativeMethods::registerMethod(ctx, name + "(int32)",   [&ctx, end] { writeNumber(ctx, ctx.pop<s32>()); end(); });
+        NativeMethods::registerMethod(ctx, name + "(uint32)",  [&ctx, end] { writeNumber(ctx, ctx.pop<u32>()); end(); });
+        NativeMethods::registerMethod(ctx, name + "(int64)",   [&ctx, end] { writeNumber(ctx, ctx.pop<s64>()); end(); });
+        NativeMethods::registerMethod(ctx, name + "(uint64)",  [&ctx, end] { writeNumber(ctx, ctx.pop<u64>()); end(); });
+        NativeMethods::registerMethod(ctx, name + "(float64)", [&ctx, end] { writeNumber(ctx, ctx.pop<double>()); end(); });
+        NativeMethods::registerMethod(ctx, name + "(float32)", [&ctx, end] { writeNumber(ctx, static_cast<float>(ctx.pop<double>())); end(); });
+        NativeMethods::registerMethod(ctx, name + "(bool)",    [&ctx, end] { writeBoolean(ctx, ctx.pop<s32>()); end(); });
+        NativeMethods::registerMethod(ctx, name + "(char)",    [&ctx, end] { writeCharacter(ctx, ctx.pop<s32>()); end(); });
+
+        if (newLine)
+            NativeMethods::registerMethod(ctx, name + "()", [&ctx] { ctx.output.writeLine(); });
+    }
 
     void NativeMethods::loadMSCORLIBLibrary(Context &ctx) {
-        registerMethod(ctx, "[mscorlib]System.Object::.ctor", []{ /* ... */ } );
-        registerMethod(ctx, "[System.Console]System.Console::WriteLine", [&ctx]{ callMethod(ctx, "[NX]NX.Console::WriteLine"); } );
+        // Natives take their arguments off the stack themselves, the base constructor only has its this to drop
+        registerMethod(ctx, "[mscorlib]System.Object::.ctor", [&ctx]{ ctx.pop<u64>(); } );
+        registerMethod(ctx, "[System.Runtime]System.Object::.ctor", [&ctx]{ ctx.pop<u64>(); } );
+
+        // Exceptions don't keep their message or inner exception yet, only their type is used to find a handler.
+        // These are the framework exceptions whose bases DLL::isAssignableTo knows about
+        constexpr static std::string_view ExceptionTypes[] = {
+            "System.Exception",
+            "System.SystemException",
+            "System.ArithmeticException",
+            "System.DivideByZeroException",
+            "System.OverflowException",
+            "System.ArgumentException",
+            "System.ArgumentNullException",
+            "System.ArgumentOutOfRangeException",
+            "System.FormatException",
+            "System.IndexOutOfRangeException",
+            "System.InvalidCastException",
+            "System.InvalidOperationException",
+            "System.NullReferenceException",
+            "System.Collections.Generic.KeyNotFoundException",
+        };
+
+        for (const std::string assembly : { "[mscorlib]", "[System.Runtime]" }) {
+            for (auto type : ExceptionTypes) {
+                std::string constructor = assembly + std::string(type) + "::.ctor";
+
+                registerMethod(ctx, constructor + "()", [&ctx]{ ctx.pop<u64>(); } );
+                registerMethod(ctx, constructor + "(string)", [&ctx]{ ctx.pop<u64>(); ctx.pop<u64>(); } );
+                registerMethod(ctx, constructor + "(string,?)", [&ctx]{ ctx.pop<u64>(); ctx.pop<u64>(); ctx.pop<u64>(); } );
+
+                // The argument exceptions also take the name of the parameter, in either order
+                if (type.starts_with("System.Argument"))
+                    registerMethod(ctx, constructor + "(string,string)", [&ctx]{ ctx.pop<u64>(); ctx.pop<u64>(); ctx.pop<u64>(); } );
+            }
+        }
+
+        registerConsoleWrite(ctx, "[System.Console]System.Console::Write", false);
+        registerConsoleWrite(ctx, "[System.Console]System.Console::WriteLine", true);
+        registerConsoleWrite(ctx, "[mscorlib]System.Console::Write", false);
+        registerConsoleWrite(ctx, "[mscorlib]System.Console::WriteLine", true);
     }
 
     void NativeMethods::loadNXLibrary(Context &ctx) {
         registerMethod(ctx, "[NX]NX.Console::WriteLine", [&ctx] {
-            printf("%s\n", ctx.dll->decodeUserString(ctx.pop<u64>()).c_str());
+            writeString(ctx, ctx.pop<u64>());
+            ctx.output.writeLine();
         });
     }
 
-}
\ No newline at end of file
+}
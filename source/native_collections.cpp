@@ -0,0 +1,600 @@
+#include "native.hpp"
+
+#include "collections.hpp"
+#include "context.hpp"
+#include "exceptions.hpp"
+#include "logger.hpp"
+#include "strings.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace ili {
+
+    // How elements are kept in a collection. Values are stored as T and travel over the evaluation stack the same
+    // way ldelem and stelem move them
+    template<typename T>
+    struct ValueElement {
+        using Storage = T;
+        using Stack = std::conditional_t<std::is_floating_point_v<T>, double, std::conditional_t<(sizeof(T) > sizeof(u32)), u64, s32>>;
+        static constexpr Type StackType = std::is_floating_point_v<T> ? Type::F : sizeof(T) > sizeof(u32) ? Type::Int64 : Type::Int32;
+        static constexpr bool IsReference = false;
+
+        static T pop(Context &ctx) { return T(ctx.pop<Stack>()); }
+        static void push(Context &ctx, T value) { ctx.push<Stack>(StackType, Stack(value)); }
+
+        // Both zeros are equal and so are all NaNs, like Equals on floats
+        static bool equals(T left, T right) {
+            if constexpr (std::is_floating_point_v<T>)
+                return left == right || (std::isnan(left) && std::isnan(right));
+            else
+                return left == right;
+        }
+
+        static u64 hash(T value) {
+            if constexpr (std::is_floating_point_v<T>) {
+                if (value == 0)
+                    return 0;
+                else if (std::isnan(value))
+                    return 1;
+                else
+                    return std::bit_cast<std::conditional_t<sizeof(T) == sizeof(u32), u32, u64>>(value);
+            } else {
+                return u64(value);
+            }
+        }
+
+        static bool less(T left, T right) {
+            // Sorting puts NaNs first
+            if constexpr (std::is_floating_point_v<T>)
+                return std::isnan(left) ? !std::isnan(right) : left < right;
+            else
+                return left < right;
+        }
+    };
+
+    // Objects don't override Equals and GetHashCode without virtual dispatch, so they're compared by identity
+    struct ReferenceElement {
+        using Storage = u64;
+        static constexpr bool IsReference = true;
+
+        static u64 pop(Context &ctx) { return ctx.pop<u64>(); }
+        static void push(Context &ctx, u64 value) { ctx.push<u64>(Type::O, value); }
+
+        static bool equals(u64 left, u64 right) { return left == right; }
+        static u64 hash(u64 value) { return value >> 3; }
+    };
+
+    // Strings are compared by value
+    struct StringElement : ReferenceElement {
+        static bool equals(u64 left, u64 right) {
+            return Strings::equals(reinterpret_cast<string_object_t*>(left), reinterpret_cast<string_object_t*>(right));
+        }
+
+        static u64 hash(u64 value) {
+            return value == 0 ? 0 : Strings::getHash(reinterpret_cast<string_object_t*>(value));
+        }
+    };
+
+    // The collection objects only hold the pointer to their storage, which gets replaced as they grow
+    template<typename Storage>
+    static Storage*& getStorage(u64 object, const char *type) {
+        if (object == 0) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Called a %s method on a null reference!", type);
+
+        return *reinterpret_cast<Storage**>(object);
+    }
+
+    static u32 popCapacity(Context &ctx, const char *type) {
+        s32 capacity = ctx.pop<s32>();
+        if (capacity < 0) [[unlikely]]
+            throwRuntimeException("System.ArgumentOutOfRangeException", "Negative %s capacity %d!", type, capacity);
+
+        return capacity;
+    }
+
+    static void checkIndex(s32 index, u32 count, const char *type) {
+        if (index < 0 || u32(index) >= count) [[unlikely]]
+            throwRuntimeException("System.ArgumentOutOfRangeException", "Index %d is outside of a %s with %u elements!", index, type, count);
+    }
+
+    // Out parameters are written the way stind writes them
+    template<typename T>
+    static void writeOut(u64 address, T value) {
+        if (address == 0) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Stored a value through a null pointer!");
+
+        std::memcpy(reinterpret_cast<void*>(address), &value, sizeof(T));
+    }
+
+    // Drops the references in vacated slots, so they don't keep objects reachable
+    template<typename E>
+    static void clearSlots(typename E::Storage *slots, u32 count) {
+        if constexpr (E::IsReference)
+            std::fill_n(slots, count, 0);
+    }
+
+    template<typename E>
+    static void registerList(Context &ctx, const std::string &type) {
+        using T = typename E::Storage;
+
+        auto getList = [](u64 object) -> list_storage_t*& { return getStorage<list_storage_t>(object, "List"); };
+        auto getElements = [](list_storage_t *list) { return reinterpret_cast<T*>(Collections::getElements(list)); };
+
+        NativeMethods::registerMethod(ctx, type + ".ctor()", [&ctx, getList] {
+            getList(ctx.pop<u64>()) = Collections::createList(ctx, sizeof(T), 0, E::IsReference);
+        });
+        NativeMethods::registerMethod(ctx, type + ".ctor(int32)", [&ctx, getList] {
+            u32 capacity = popCapacity(ctx, "List");
+            getList(ctx.pop<u64>()) = Collections::createList(ctx, sizeof(T), capacity, E::IsReference);
+        });
+
+        NativeMethods::registerMethod(ctx, type + "Add(!0)", [&ctx, getList, getElements] {
+            T value = E::pop(ctx);
+            auto &list = getList(ctx.pop<u64>());
+
+            if (list->count == list->capacity) [[unlikely]]
+                Collections::reserve(ctx, list, sizeof(T), list->count + 1);
+
+            getElements(list)[list->count++] = value;
+        });
+        NativeMethods::registerMethod(ctx, type + "Insert(int32,!0)", [&ctx, getList, getElements] {
+            T value = E::pop(ctx);
+            s32 index = ctx.pop<s32>();
+            auto &list = getList(ctx.pop<u64>());
+            checkIndex(index, list->count + 1, "List");
+
+            if (list->count == list->capacity)
+                Collections::reserve(ctx, list, sizeof(T), list->count + 1);
+
+            T *elements = getElements(list);
+            std::memmove(elements + index + 1, elements + index, (list->count - index) * sizeof(T));
+            elements[index] = value;
+            list->count++;
+        });
+
+        NativeMethods::registerMethod(ctx, type + "get_Item(int32)", [&ctx, getList, getElements] {
+            s32 index = ctx.pop<s32>();
+            auto list = getList(ctx.pop<u64>());
+            checkIndex(index, list->count, "List");
+
+            E::push(ctx, getElements(list)[index]);
+        });
+        NativeMethods::registerMethod(ctx, type + "set_Item(int32,!0)", [&ctx, getList, getElements] {
+            T value = E::pop(ctx);
+            s32 index = ctx.pop<s32>();
+            auto list = getList(ctx.pop<u64>());
+            checkIndex(index, list->count, "List");
+
+            getElements(list)[index] = value;
+        });
+        NativeMethods::registerMethod(ctx, type + "get_Count()", [&ctx, getList] {
+            ctx.push<s32>(Type::Int32, getList(ctx.pop<u64>())->count);
+        });
+        NativeMethods::registerMethod(ctx, type + "get_Capacity()", [&ctx, getList] {
+            ctx.push<s32>(Type::Int32, getList(ctx.pop<u64>())->capacity);
+        });
+
+        auto indexOf = [getElements](list_storage_t *list, T value) -> s32 {
+            T *elements = getElements(list);
+            T *found = std::find_if(elements, elements + list->count, [value](T element) { return E::equals(element, value); });
+            return found == elements + list->count ? -1 : found - elements;
+        };
+        auto removeAt = [getElements](list_storage_t *list, u32 index) {
+            T *elements = getElements(list);
+            std::memmove(elements + index, elements + index + 1, (list->count - index - 1) * sizeof(T));
+            list->count--;
+            clearSlots<E>(elements + list->count, 1);
+        };
+
+        NativeMethods::registerMethod(ctx, type + "Contains(!0)", [&ctx, getList, indexOf] {
+            T value = E::pop(ctx);
+            ctx.push<s32>(Type::Int32, indexOf(getList(ctx.pop<u64>()), value) >= 0);
+        });
+        NativeMethods::registerMethod(ctx, type + "IndexOf(!0)", [&ctx, getList, indexOf] {
+            T value = E::pop(ctx);
+            ctx.push<s32>(Type::Int32, indexOf(getList(ctx.pop<u64>()), value));
+        });
+        NativeMethods::registerMethod(ctx, type + "Remove(!0)", [&ctx, getList, indexOf, removeAt] {
+            T value = E::pop(ctx);
+            auto list = getList(ctx.pop<u64>());
+
+            s32 index = indexOf(list, value);
+            if (index >= 0)
+                removeAt(list, index);
+
+            ctx.push<s32>(Type::Int32, index >= 0);
+        });
+        NativeMethods::registerMethod(ctx, type + "RemoveAt(int32)", [&ctx, getList, removeAt] {
+            s32 index = ctx.pop<s32>();
+            auto list = getList(ctx.pop<u64>());
+            checkIndex(index, list->count, "List");
+
+            removeAt(list, index);
+        });
+        NativeMethods::registerMethod(ctx, type + "Clear()", [&ctx, getList, getElements] {
+            auto list = getList(ctx.pop<u64>());
+
+            clearSlots<E>(getElements(list), list->count);
+            list->count = 0;
+        });
+        NativeMethods::registerMethod(ctx, type + "Reverse()", [&ctx, getList, getElements] {
+            auto list = getList(ctx.pop<u64>());
+            std::reverse(getElements(list), getElements(list) + list->count);
+        });
+
+        // Strings sort by culture and objects through IComparable, neither of which can be done here
+        if constexpr (!E::IsReference) {
+            NativeMethods::registerMethod(ctx, type + "Sort()", [&ctx, getList, getElements] {
+                auto list = getList(ctx.pop<u64>());
+                std::sort(getElements(list), getElements(list) + list->count, E::less);
+            });
+        }
+    }
+
+    template<typename E>
+    static void registerQueue(Context &ctx, const std::string &type) {
+        using T = typename E::Storage;
+
+        auto getQueue = [](u64 object) -> list_storage_t*& { return getStorage<list_storage_t>(object, "Queue"); };
+        auto getElement = [](list_storage_t *queue, u32 index) -> T& {
+            index += queue->head;
+            if (index >= queue->capacity)
+                index -= queue->capacity;
+
+            return reinterpret_cast<T*>(Collections::getElements(queue))[index];
+        };
+        auto checkNotEmpty = [](list_storage_t *queue) {
+            if (queue->count == 0) [[unlikely]]
+                throwRuntimeException("System.InvalidOperationException", "Queue is empty!");
+        };
+        auto dequeue = [getElement](list_storage_t *queue) {
+            T &first = getElement(queue, 0);
+            T value = first;
+            clearSlots<E>(&first, 1);
+
+            queue->head = queue->head + 1 == queue->capacity ? 0 : queue->head + 1;
+            queue->count--;
+
+            return value;
+        };
+
+        NativeMethods::registerMethod(ctx, type + ".ctor()", [&ctx, getQueue] {
+            getQueue(ctx.pop<u64>()) = Collections::createList(ctx, sizeof(T), 0, E::IsReference);
+        });
+        NativeMethods::registerMethod(ctx, type + ".ctor(int32)", [&ctx, getQueue] {
+            u32 capacity = popCapacity(ctx, "Queue");
+            getQueue(ctx.pop<u64>()) = Collections::createList(ctx, sizeof(T), capacity, E::IsReference);
+        });
+
+        NativeMethods::registerMethod(ctx, type + "Enqueue(!0)", [&ctx, getQueue, getElement] {
+            T value = E::pop(ctx);
+            auto &queue = getQueue(ctx.pop<u64>());
+
+            if (queue->count == queue->capacity) [[unlikely]]
+                Collections::reserve(ctx, queue, sizeof(T), queue->count + 1);
+
+            getElement(queue, queue->count) = value;
+            queue->count++;
+        });
+        NativeMethods::registerMethod(ctx, type + "Dequeue()", [&ctx, getQueue, checkNotEmpty, dequeue] {
+            auto queue = getQueue(ctx.pop<u64>());
+            checkNotEmpty(queue);
+
+            E::push(ctx, dequeue(queue));
+        });
+        NativeMethods::registerMethod(ctx, type + "TryDequeue(!0&)", [&ctx, getQueue, dequeue] {
+            u64 result = ctx.pop<u64>();
+            auto queue = getQueue(ctx.pop<u64>());
+
+            bool dequeued = queue->count != 0;
+            writeOut<T>(result, dequeued ? dequeue(queue) : T());
+            ctx.push<s32>(Type::Int32, dequeued);
+        });
+        NativeMethods::registerMethod(ctx, type + "Peek()", [&ctx, getQueue, getElement, checkNotEmpty] {
+            auto queue = getQueue(ctx.pop<u64>());
+            checkNotEmpty(queue);
+
+            E::push(ctx, getElement(queue, 0));
+        });
+        NativeMethods::registerMethod(ctx, type + "get_Count()", [&ctx, getQueue] {
+            ctx.push<s32>(Type::Int32, getQueue(ctx.pop<u64>())->count);
+        });
+        NativeMethods::registerMethod(ctx, type + "Contains(!0)", [&ctx, getQueue, getElement] {
+            T value = E::pop(ctx);
+            auto queue = getQueue(ctx.pop<u64>());
+
+            bool found = false;
+            for (u32 i = 0; i < queue->count && !found; i++)
+                found = E::equals(getElement(queue, i), value);
+
+            ctx.push<s32>(Type::Int32, found);
+        });
+        NativeMethods::registerMethod(ctx, type + "Clear()", [&ctx, getQueue] {
+            auto queue = getQueue(ctx.pop<u64>());
+
+            clearSlots<E>(reinterpret_cast<T*>(Collections::getElements(queue)), queue->capacity);
+            queue->count = 0;
+            queue->head = 0;
+        });
+    }
+
+    // Linear probing over the slots of a hash_table_t, with the keys of K and values of ValueSize bytes
+    template<typename K, u8 ValueSize>
+    struct HashTable {
+        using Key = typename K::Storage;
+
+        static Key* getKeys(hash_table_t *table) { return reinterpret_cast<Key*>(Collections::getKeys(table)); }
+
+        // Fibonacci hashing spreads keys that only differ in their upper bits, like aligned addresses, over all slots
+        static u32 getHomeSlot(hash_table_t *table, Key key) {
+            return (K::hash(key) * 0x9E37'79B9'7F4A'7C15ULL) >> (64 - std::countr_zero(table->capacity));
+        }
+
+        // Slot holding the key, -1 if there is none
+        static s32 find(hash_table_t *table, Key key) {
+            auto states = Collections::getStates(table);
+            auto keys = getKeys(table);
+            u32 mask = table->capacity - 1;
+
+            // There's always an empty slot, the load factor is kept below one
+            for (u32 slot = getHomeSlot(table, key); ; slot = (slot + 1) & mask) {
+                if (states[slot] == SlotState::Empty)
+                    return -1;
+                else if (states[slot] == SlotState::Full && K::equals(keys[slot], key))
+                    return slot;
+            }
+        }
+
+        // Rebuilds the table with the given capacity, which also drops all the removed slots
+        static void resize(Context &ctx, hash_table_t *&table, u32 capacity) {
+            auto resized = Collections::createHashTable(ctx, sizeof(Key), ValueSize, capacity, table->referenceKeys, table->referenceValues);
+            auto states = Collections::getStates(table);
+            auto keys = getKeys(table);
+
+            for (u32 slot = 0; slot < table->capacity; slot++) {
+                if (states[slot] != SlotState::Full)
+                    continue;
+
+                u32 newSlot = getHomeSlot(resized, keys[slot]);
+                while (Collections::getStates(resized)[newSlot] != SlotState::Empty)
+                    newSlot = (newSlot + 1) & (resized->capacity - 1);
+
+                Collections::getStates(resized)[newSlot] = SlotState::Full;
+                getKeys(resized)[newSlot] = keys[slot];
+                std::memcpy(Collections::getValues(resized) + newSlot * ValueSize, Collections::getValues(table) + slot * ValueSize, ValueSize);
+            }
+
+            resized->count = table->count;
+            resized->used = table->count;
+            table = resized;
+        }
+
+        // Slot for the key, which is claimed for it if it isn't in the table yet
+        static u32 insert(Context &ctx, hash_table_t *&table, Key key, bool &added) {
+            s32 existing = find(table, key);
+            added = existing < 0;
+            if (!added)
+                return existing;
+
+            // Twice as many slots as entries after growing. If it's mostly removed slots, that's the same size again
+            if (!Collections::hasRoom(table))
+                resize(ctx, table, (table->count + 1) * 2);
+
+            auto states = Collections::getStates(table);
+            u32 slot = getHomeSlot(table, key);
+            while (states[slot] == SlotState::Full)
+                slot = (slot + 1) & (table->capacity - 1);
+
+            if (states[slot] == SlotState::Empty)
+                table->used++;
+
+            states[slot] = SlotState::Full;
+            getKeys(table)[slot] = key;
+            table->count++;
+
+            return slot;
+        }
+
+        static bool remove(hash_table_t *table, Key key) {
+            s32 slot = find(table, key);
+            if (slot < 0)
+                return false;
+
+            Collections::getStates(table)[slot] = SlotState::Removed;
+            clearSlots<K>(getKeys(table) + slot, 1);
+            std::memset(Collections::getValues(table) + slot * ValueSize, 0x00, ValueSize);
+            table->count--;
+
+            return true;
+        }
+
+        static void clear(hash_table_t *table) {
+            std::memset(Collections::getStates(table), 0x00, Collections::getValues(table) + table->capacity * ValueSize - reinterpret_cast<u8*>(Collections::getStates(table)));
+            table->count = 0;
+            table->used = 0;
+        }
+
+        // Room for that many entries without growing
+        static u32 getCapacityFor(u32 count) {
+            return u64(count) * 4 / 3 + 1;
+        }
+    };
+
+    template<typename K>
+    static void registerHashSet(Context &ctx, const std::string &type) {
+        using Table = HashTable<K, 0>;
+
+        auto getTable = [](u64 object) -> hash_table_t*& { return getStorage<hash_table_t>(object, "HashSet"); };
+
+        NativeMethods::registerMethod(ctx, type + ".ctor()", [&ctx, getTable] {
+            getTable(ctx.pop<u64>()) = Collections::createHashTable(ctx, sizeof(typename K::Storage), 0, 0, K::IsReference, false);
+        });
+        NativeMethods::registerMethod(ctx, type + ".ctor(int32)", [&ctx, getTable] {
+            u32 capacity = popCapacity(ctx, "HashSet");
+            getTable(ctx.pop<u64>()) = Collections::createHashTable(ctx, sizeof(typename K::Storage), 0, Table::getCapacityFor(capacity), K::IsReference, false);
+        });
+
+        NativeMethods::registerMethod(ctx, type + "Add(!0)", [&ctx, getTable] {
+            auto key = K::pop(ctx);
+
+            bool added;
+            Table::insert(ctx, getTable(ctx.pop<u64>()), key, added);
+            ctx.push<s32>(Type::Int32, added);
+        });
+        NativeMethods::registerMethod(ctx, type + "Contains(!0)", [&ctx, getTable] {
+            auto key = K::pop(ctx);
+            ctx.push<s32>(Type::Int32, Table::find(getTable(ctx.pop<u64>()), key) >= 0);
+        });
+        NativeMethods::registerMethod(ctx, type + "Remove(!0)", [&ctx, getTable] {
+            auto key = K::pop(ctx);
+            ctx.push<s32>(Type::Int32, Table::remove(getTable(ctx.pop<u64>()), key));
+        });
+        NativeMethods::registerMethod(ctx, type + "get_Count()", [&ctx, getTable] {
+            ctx.push<s32>(Type::Int32, getTable(ctx.pop<u64>())->count);
+        });
+        NativeMethods::registerMethod(ctx, type + "Clear()", [&ctx, getTable] {
+            Table::clear(getTable(ctx.pop<u64>()));
+        });
+    }
+
+    template<typename K, typename V>
+    static void registerDictionary(Context &ctx, const std::string &assembly, const std::string &key, const std::string &value) {
+        std::string type = assembly + "System.Collections.Generic.Dictionary`2<" + key + "," + value + ">::";
+
+        using Key = typename K::Storage;
+        using Value = typename V::Storage;
+        using Table = HashTable<K, sizeof(Value)>;
+
+        auto getTable = [](u64 object) -> hash_table_t*& { return getStorage<hash_table_t>(object, "Dictionary"); };
+        auto getValue = [](hash_table_t *table, u32 slot) -> Value& { return reinterpret_cast<Value*>(Collections::getValues(table))[slot]; };
+        auto popKey = [&ctx] {
+            Key key = K::pop(ctx);
+            if (K::IsReference && key == 0) [[unlikely]]
+                throwRuntimeException("System.ArgumentNullException", "Dictionary keys can't be null!");
+
+            return key;
+        };
+
+        NativeMethods::registerMethod(ctx, type + ".ctor()", [&ctx, getTable] {
+            getTable(ctx.pop<u64>()) = Collections::createHashTable(ctx, sizeof(Key), sizeof(Value), 0, K::IsReference, V::IsReference);
+        });
+        NativeMethods::registerMethod(ctx, type + ".ctor(int32)", [&ctx, getTable] {
+            u32 capacity = popCapacity(ctx, "Dictionary");
+            getTable(ctx.pop<u64>()) = Collections::createHashTable(ctx, sizeof(Key), sizeof(Value), Table::getCapacityFor(capacity), K::IsReference, V::IsReference);
+        });
+
+        NativeMethods::registerMethod(ctx, type + "Add(!0,!1)", [&ctx, getTable, getValue, popKey] {
+            Value value = V::pop(ctx);
+            Key key = popKey();
+            auto &table = getTable(ctx.pop<u64>());
+
+            bool added;
+            u32 slot = Table::insert(ctx, table, key, added);
+            if (!added) [[unlikely]]
+                throwRuntimeException("System.ArgumentException", "An item with the same key has already been added to the Dictionary!");
+
+            getValue(table, slot) = value;
+        });
+        NativeMethods::registerMethod(ctx, type + "set_Item(!0,!1)", [&ctx, getTable, getValue, popKey] {
+            Value value = V::pop(ctx);
+            Key key = popKey();
+            auto &table = getTable(ctx.pop<u64>());
+
+            bool added;
+            getValue(table, Table::insert(ctx, table, key, added)) = value;
+        });
+        NativeMethods::registerMethod(ctx, type + "get_Item(!0)", [&ctx, getTable, getValue, popKey] {
+            Key key = popKey();
+            auto table = getTable(ctx.pop<u64>());
+
+            s32 slot = Table::find(table, key);
+            if (slot < 0) [[unlikely]]
+                throwRuntimeException("System.Collections.Generic.KeyNotFoundException", "The given key was not present in the Dictionary!");
+
+            V::push(ctx, getValue(table, slot));
+        });
+        NativeMethods::registerMethod(ctx, type + "TryGetValue(!0,!1&)", [&ctx, getTable, getValue, popKey] {
+            u64 result = ctx.pop<u64>();
+            Key key = popKey();
+            auto table = getTable(ctx.pop<u64>());
+
+            s32 slot = Table::find(table, key);
+            writeOut<Value>(result, slot >= 0 ? getValue(table, slot) : Value());
+            ctx.push<s32>(Type::Int32, slot >= 0);
+        });
+        NativeMethods::registerMethod(ctx, type + "ContainsKey(!0)", [&ctx, getTable, popKey] {
+            Key key = popKey();
+            ctx.push<s32>(Type::Int32, Table::find(getTable(ctx.pop<u64>()), key) >= 0);
+        });
+        NativeMethods::registerMethod(ctx, type + "Remove(!0)", [&ctx, getTable, popKey] {
+            Key key = popKey();
+            ctx.push<s32>(Type::Int32, Table::remove(getTable(ctx.pop<u64>()), key));
+        });
+        NativeMethods::registerMethod(ctx, type + "get_Count()", [&ctx, getTable] {
+            ctx.push<s32>(Type::Int32, getTable(ctx.pop<u64>())->count);
+        });
+        NativeMethods::registerMethod(ctx, type + "Clear()", [&ctx, getTable] {
+            Table::clear(getTable(ctx.pop<u64>()));
+        });
+    }
+
+    // Dictionary values are never compared, so the instantiations only need to tell them apart by size and by how
+    // they're pushed
+    template<typename K>
+    static void registerDictionaries(Context &ctx, const std::string &assembly, const std::string &key) {
+        registerDictionary<K, ValueElement<u8>>(ctx, assembly, key, "bool");
+        registerDictionary<K, ValueElement<u16>>(ctx, assembly, key, "char");
+        registerDictionary<K, ValueElement<s8>>(ctx, assembly, key, "int8");
+        registerDictionary<K, ValueElement<u8>>(ctx, assembly, key, "uint8");
+        registerDictionary<K, ValueElement<s16>>(ctx, assembly, key, "int16");
+        registerDictionary<K, ValueElement<u16>>(ctx, assembly, key, "uint16");
+        registerDictionary<K, ValueElement<u32>>(ctx, assembly, key, "int32");
+        registerDictionary<K, ValueElement<u32>>(ctx, assembly, key, "uint32");
+        registerDictionary<K, ValueElement<u64>>(ctx, assembly, key, "int64");
+        registerDictionary<K, ValueElement<u64>>(ctx, assembly, key, "uint64");
+        registerDictionary<K, ValueElement<float>>(ctx, assembly, key, "float32");
+        registerDictionary<K, ValueElement<double>>(ctx, assembly, key, "float64");
+        registerDictionary<K, ReferenceElement>(ctx, assembly, key, "string");
+        registerDictionary<K, ReferenceElement>(ctx, assembly, key, "object");
+        registerDictionary<K, ReferenceElement>(ctx, assembly, key, "?");
+    }
+
+    // Registers every collection instantiated with the element type. Keys are hashed and compared by their bits, so
+    // signed ones share the code of their unsigned counterparts
+    template<typename E, typename K = E>
+    static void registerCollections(Context &ctx, const std::string &assembly, const std::string &element) {
+        std::string generic = assembly + "System.Collections.Generic.";
+
+        registerList<E>(ctx, generic + "List`1<" + element + ">::");
+        registerQueue<E>(ctx, generic + "Queue`1<" + element + ">::");
+        registerHashSet<K>(ctx, generic + "HashSet`1<" + element + ">::");
+        registerDictionaries<K>(ctx, assembly, element);
+    }
+
+    void NativeMethods::loadCollectionsLibrary(Context &ctx) {
+        // Framework assemblies have the collections in mscorlib, newer ones in their own reference assembly
+        for (const std::string assembly : { "[mscorlib]", "[System.Collections]" }) {
+            registerCollections<ValueElement<u8>>(ctx, assembly, "bool");
+            registerCollections<ValueElement<u16>>(ctx, assembly, "char");
+            registerCollections<ValueElement<s8>, ValueElement<u8>>(ctx, assembly, "int8");
+            registerCollections<ValueElement<u8>>(ctx, assembly, "uint8");
+            registerCollections<ValueElement<s16>, ValueElement<u16>>(ctx, assembly, "int16");
+            registerCollections<ValueElement<u16>>(ctx, assembly, "uint16");
+            registerCollections<ValueElement<s32>, ValueElement<u32>>(ctx, assembly, "int32");
+            registerCollections<ValueElement<u32>>(ctx, assembly, "uint32");
+            registerCollections<ValueElement<s64>, ValueElement<u64>>(ctx, assembly, "int64");
+            registerCollections<ValueElement<u64>>(ctx, assembly, "uint64");
+            registerCollections<ValueElement<float>>(ctx, assembly, "float32");
+            registerCollections<ValueElement<double>>(ctx, assembly, "float64");
+            registerCollections<StringElement>(ctx, assembly, "string");
+            registerCollections<ReferenceElement>(ctx, assembly, "object");
+            registerCollections<ReferenceElement>(ctx, assembly, "?");
+        }
+    }
+
+}
@@ -0,0 +1,540 @@
+#include "native.hpp"
+
+#include "context.hpp"
+#include "exceptions.hpp"
+#include "dll.hpp"
+#include "logger.hpp"
+#include "strings.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ili {
+
+    // Large enough for any integer and the shortest round-trip representation of any double
+    static constexpr size_t MaxNumberSize = 32;
+    static constexpr u32 DefaultBuilderCapacity = 16;
+
+    // Numbers formatted the way their ToString() without a format does it
+    class NumberText {
+    public:
+        template<typename T>
+        explicit NumberText(T value) {
+            if constexpr (std::is_floating_point_v<T>) {
+                if (std::isnan(value)) {
+                    this->set("NaN");
+                    return;
+                } else if (std::isinf(value)) {
+                    this->set(value < 0 ? "-Infinity" : "Infinity");
+                    return;
+                }
+            }
+
+            char text[MaxNumberSize];
+            this->m_length = std::to_chars(text, text + MaxNumberSize, value).ptr - text;
+            for (u32 i = 0; i < this->m_length; i++)
+                this->m_characters[i] = text[i] == 'e' ? u'E' : char16_t(text[i]);
+        }
+
+        std::u16string_view getView() const { return { this->m_characters, this->m_length }; }
+
+    private:
+        void set(std::string_view text) {
+            this->m_length = text.size();
+            for (u32 i = 0; i < this->m_length; i++)
+                this->m_characters[i] = text[i];
+        }
+
+        char16_t m_characters[MaxNumberSize];
+        u32 m_length = 0;
+    };
+
+    static string_object_t* popString(Context &ctx) {
+        return reinterpret_cast<string_object_t*>(ctx.pop<u64>());
+    }
+
+    // Null strings take part in concatenation and formatting as if they were empty
+    static std::u16string_view getView(string_object_t *string) {
+        return string == nullptr ? std::u16string_view(u"") : Strings::getView(string);
+    }
+
+    static string_object_t* checkThis(string_object_t *string, const char *method) {
+        if (string == nullptr) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Called String.%s on a null string!", method);
+
+        return string;
+    }
+
+    static void pushString(Context &ctx, string_object_t *string) {
+        ctx.push<u64>(Type::O, reinterpret_cast<u64>(string));
+    }
+
+    static void checkRange(s32 start, s32 length, u32 size, const char *method) {
+        if (start < 0 || length < 0 || u64(start) + u64(length) > size) [[unlikely]]
+            throwRuntimeException("System.ArgumentOutOfRangeException", "Range of %d starting at %d passed to %s is outside of a string of length %u!", length, start, method, size);
+    }
+
+    // Concatenates into a string of the final length, so nothing gets copied twice
+    static string_object_t* concat(Context &ctx, std::span<string_object_t* const> strings, std::u16string_view separator = u"") {
+        u64 length = 0;
+        for (auto string : strings)
+            length += getView(string).size();
+        if (!strings.empty())
+            length += (strings.size() - 1) * separator.size();
+
+        auto result = Strings::create(ctx, std::u16string(length, u'\0'));
+        char16_t *destination = Strings::getData(result);
+        for (size_t i = 0; i < strings.size(); i++) {
+            if (i > 0) {
+                std::memcpy(destination, separator.data(), separator.size() * sizeof(char16_t));
+                destination += separator.size();
+            }
+
+            auto view = getView(strings[i]);
+            std::memcpy(destination, view.data(), view.size() * sizeof(char16_t));
+            destination += view.size();
+        }
+
+        return result;
+    }
+
+    static std::span<string_object_t* const> getStringArray(u64 object, const char *method) {
+        auto array = reinterpret_cast<array_object_t*>(object);
+        if (array == nullptr) [[unlikely]]
+            throwRuntimeException("System.ArgumentNullException", "Passed a null array to %s!", method);
+
+        return { reinterpret_cast<string_object_t* const*>(Arrays::getData(array)), array->length };
+    }
+
+    // Composite formatting with {index[,alignment][:format]} items. Boxing isn't supported yet, so every argument
+    // that can get here is a string or null and the format part has nothing to apply to
+    static string_object_t* format(Context &ctx, string_object_t *formatString, std::span<string_object_t* const> arguments) {
+        auto text = getView(checkThis(formatString, "Format"));
+
+        auto invalidFormat = [] {
+            throwRuntimeException("System.FormatException", "Input string passed to String.Format was not in a correct format!");
+        };
+
+        std::u16string result;
+        result.reserve(text.size() + arguments.size() * 8);
+
+        for (size_t i = 0; i < text.size(); i++) {
+            char16_t character = text[i];
+
+            if (character == u'}') {
+                if (i + 1 >= text.size() || text[i + 1] != u'}')
+                    invalidFormat();
+
+                result += u'}';
+                i++;
+                continue;
+            } else if (character != u'{') {
+                result += character;
+                continue;
+            } else if (i + 1 < text.size() && text[i + 1] == u'{') {
+                result += u'{';
+                i++;
+                continue;
+            }
+
+            size_t end = text.find(u'}', i);
+            if (end == std::u16string_view::npos)
+                invalidFormat();
+
+            auto item = text.substr(i + 1, end - i - 1);
+            item = item.substr(0, item.find(u':'));
+
+            u32 index = 0;
+            s32 alignment = 0;
+            bool leftAligned = false;
+
+            size_t position = 0;
+            while (position < item.size() && item[position] == u' ')
+                position++;
+            if (position >= item.size() || item[position] < u'0' || item[position] > u'9')
+                invalidFormat();
+            for (; position < item.size() && item[position] >= u'0' && item[position] <= u'9'; position++)
+                index = index * 10 + (item[position] - u'0');
+            while (position < item.size() && item[position] == u' ')
+                position++;
+
+            if (position < item.size() && item[position] == u',') {
+                position++;
+                while (position < item.size() && item[position] == u' ')
+                    position++;
+                if (position < item.size() && item[position] == u'-') {
+                    leftAligned = true;
+                    position++;
+                }
+                for (; position < item.size() && item[position] >= u'0' && item[position] <= u'9'; position++)
+                    alignment = alignment * 10 + (item[position] - u'0');
+            }
+
+            if (index >= arguments.size())
+                throwRuntimeException("System.FormatException", "Index %u passed to String.Format is outside of the %u arguments!", index, u32(arguments.size()));
+
+            auto argument = getView(arguments[index]);
+            u32 padding = alignment > s32(argument.size()) ? alignment - argument.size() : 0;
+
+            if (!leftAligned)
+                result.append(padding, u' ');
+            result += argument;
+            if (leftAligned)
+                result.append(padding, u' ');
+
+            i = end;
+        }
+
+        return Strings::create(ctx, result);
+    }
+
+    static HeapReference& getAllocation(Context &ctx, u64 object, const char *method) {
+        if (object == 0) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Called Object.%s on a null reference!", method);
+
+        if (auto reference = ctx.findAllocation(object); reference != nullptr)
+            return *reference;
+
+        ctx.fatalError(LogCategory::Native, "Called Object.%s on something that isn't an object on the heap!", method);
+    }
+
+    static string_buffer_t*& getBuffer(u64 object) {
+        if (object == 0) [[unlikely]]
+            throwRuntimeException("System.NullReferenceException", "Called a StringBuilder method on a null reference!");
+
+        return *reinterpret_cast<string_buffer_t**>(object);
+    }
+
+    // Registers a value's ToString() and the StringBuilder.Append and interpolation handler overloads that take it
+    template<typename T, typename S = T>
+    static void registerFormattable(Context &ctx, const std::string &assembly, const std::string &typeName, const std::string &parameterName, auto text) {
+        NativeMethods::registerMethod(ctx, assembly + typeName + "::ToString()", [&ctx, text] {
+            // Called on the address of the value
+            T value;
+            std::memcpy(&value, reinterpret_cast<const void*>(ctx.pop<u64>()), sizeof(T));
+            pushString(ctx, Strings::create(ctx, text(value).getView()));
+        });
+
+        NativeMethods::registerMethod(ctx, assembly + "System.Text.StringBuilder::Append(" + parameterName + ")", [&ctx, text] {
+            auto value = T(ctx.pop<S>());
+            u64 builder = ctx.pop<u64>();
+
+            Strings::append(ctx, getBuffer(builder), text(value).getView());
+            ctx.push<u64>(Type::O, builder);
+        });
+
+        NativeMethods::registerMethod(ctx, assembly + "System.Runtime.CompilerServices.DefaultInterpolatedStringHandler::AppendFormatted<" + parameterName + ">(!!0)", [&ctx, text] {
+            auto value = T(ctx.pop<S>());
+            Strings::append(ctx, getBuffer(ctx.pop<u64>()), text(value).getView());
+        });
+    }
+
+    // Some of the formatted types are just one character
+    class CharacterText {
+    public:
+        CharacterText(char16_t character) : m_character(character) { }
+        std::u16string_view getView() const { return { &this->m_character, 1 }; }
+
+    private:
+        char16_t m_character;
+    };
+
+    static void registerStringMembers(Context &ctx, const std::string &assembly) {
+        std::string string = assembly + "System.String::";
+
+        auto registerConcat = [&](const std::string &signature, u32 numStrings) {
+            NativeMethods::registerMethod(ctx, string + "Concat" + signature, [&ctx, numStrings] {
+                string_object_t *strings[4];
+                for (u32 i = numStrings; i > 0; i--)
+                    strings[i - 1] = popString(ctx);
+
+                pushString(ctx, concat(ctx, { strings, numStrings }));
+            });
+        };
+        registerConcat("(string,string)", 2);
+        registerConcat("(string,string,string)", 3);
+        registerConcat("(string,string,string,string)", 4);
+        NativeMethods::registerMethod(ctx, string + "Concat(string[])", [&ctx] {
+            pushString(ctx, concat(ctx, getStringArray(ctx.pop<u64>(), "String.Concat")));
+        });
+
+        auto registerFormat = [&](const std::string &signature, u32 numArguments) {
+            NativeMethods::registerMethod(ctx, string + "Format" + signature, [&ctx, numArguments] {
+                string_object_t *arguments[3];
+                for (u32 i = numArguments; i > 0; i--)
+                    arguments[i - 1] = popString(ctx);
+
+                auto formatString = popString(ctx);
+                pushString(ctx, format(ctx, formatString, { arguments, numArguments }));
+            });
+        };
+        registerFormat("(string,object)", 1);
+        registerFormat("(string,object,object)", 2);
+        registerFormat("(string,object,object,object)", 3);
+        NativeMethods::registerMethod(ctx, string + "Format(string,object[])", [&ctx] {
+            auto arguments = getStringArray(ctx.pop<u64>(), "String.Format");
+            auto formatString = popString(ctx);
+            pushString(ctx, format(ctx, formatString, arguments));
+        });
+
+        NativeMethods::registerMethod(ctx, string + "Join(string,string[])", [&ctx] {
+            auto strings = getStringArray(ctx.pop<u64>(), "String.Join");
+            pushString(ctx, concat(ctx, strings, getView(popString(ctx))));
+        });
+        NativeMethods::registerMethod(ctx, string + "Join(char,string[])", [&ctx] {
+            auto strings = getStringArray(ctx.pop<u64>(), "String.Join");
+            char16_t separator = ctx.pop<s32>();
+            pushString(ctx, concat(ctx, strings, { &separator, 1 }));
+        });
+
+        NativeMethods::registerMethod(ctx, string + "get_Length()", [&ctx] {
+            ctx.push<s32>(Type::Int32, checkThis(popString(ctx), "Length")->length);
+        });
+        NativeMethods::registerMethod(ctx, string + "get_Chars(int32)", [&ctx] {
+            s32 index = ctx.pop<s32>();
+            auto self = checkThis(popString(ctx), "Chars");
+            checkRange(index, 1, self->length, "String.Chars");
+
+            ctx.push<s32>(Type::Int32, Strings::getData(self)[index]);
+        });
+        NativeMethods::registerMethod(ctx, string + "IsNullOrEmpty(string)", [&ctx] {
+            ctx.push<s32>(Type::Int32, getView(popString(ctx)).empty());
+        });
+
+        NativeMethods::registerMethod(ctx, string + "Substring(int32)", [&ctx] {
+            s32 start = ctx.pop<s32>();
+            auto self = checkThis(popString(ctx), "Substring");
+            checkRange(start, self->length - start, self->length, "String.Substring");
+
+            pushString(ctx, start == 0 ? self : Strings::create(ctx, Strings::getView(self).substr(start)));
+        });
+        NativeMethods::registerMethod(ctx, string + "Substring(int32,int32)", [&ctx] {
+            s32 length = ctx.pop<s32>();
+            s32 start = ctx.pop<s32>();
+            auto self = checkThis(popString(ctx), "Substring");
+            checkRange(start, length, self->length, "String.Substring");
+
+            pushString(ctx, start == 0 && u32(length) == self->length ? self : Strings::create(ctx, Strings::getView(self).substr(start, length)));
+        });
+
+        // All searches are ordinal, culture sensitive comparisons only differ from that for characters outside of ASCII
+        auto checkStart = [](s32 start, string_object_t *self) {
+            checkRange(start, 0, self->length, "String.IndexOf");
+            return u32(start);
+        };
+        NativeMethods::registerMethod(ctx, string + "IndexOf(char)", [&ctx] {
+            char16_t character = ctx.pop<s32>();
+            ctx.push<s32>(Type::Int32, Strings::indexOf(Strings::getView(checkThis(popString(ctx), "IndexOf")), character));
+        });
+        NativeMethods::registerMethod(ctx, string + "IndexOf(char,int32)", [&ctx, checkStart] {
+            s32 start = ctx.pop<s32>();
+            char16_t character = ctx.pop<s32>();
+            auto self = checkThis(popString(ctx), "IndexOf");
+            ctx.push<s32>(Type::Int32, Strings::indexOf(Strings::getView(self), character, checkStart(start, self)));
+        });
+        NativeMethods::registerMethod(ctx, string + "IndexOf(string)", [&ctx] {
+            auto value = checkThis(popString(ctx), "IndexOf");
+            ctx.push<s32>(Type::Int32, Strings::indexOf(Strings::getView(checkThis(popString(ctx), "IndexOf")), Strings::getView(value)));
+        });
+        NativeMethods::registerMethod(ctx, string + "IndexOf(string,int32)", [&ctx, checkStart] {
+            s32 start = ctx.pop<s32>();
+            auto value = checkThis(popString(ctx), "IndexOf");
+            auto self = checkThis(popString(ctx), "IndexOf");
+            ctx.push<s32>(Type::Int32, Strings::indexOf(Strings::getView(self), Strings::getView(value), checkStart(start, self)));
+        });
+        NativeMethods::registerMethod(ctx, string + "Contains(char)", [&ctx] {
+            char16_t character = ctx.pop<s32>();
+            ctx.push<s32>(Type::Int32, Strings::indexOf(Strings::getView(checkThis(popString(ctx), "Contains")), character) >= 0);
+        });
+        NativeMethods::registerMethod(ctx, string + "Contains(string)", [&ctx] {
+            auto value = checkThis(popString(ctx), "Contains");
+            ctx.push<s32>(Type::Int32, Strings::indexOf(Strings::getView(checkThis(popString(ctx), "Contains")), Strings::getView(value)) >= 0);
+        });
+
+        auto equals = [&ctx](bool negate) -> std::function<void()> {
+            return [&ctx, negate] {
+                auto right = popString(ctx);
+                auto left = popString(ctx);
+                ctx.push<s32>(Type::Int32, Strings::equals(left, right) != negate);
+            };
+        };
+        NativeMethods::registerMethod(ctx, string + "Equals(string)", [&ctx] {
+            auto other = popString(ctx);
+            ctx.push<s32>(Type::Int32, Strings::equals(checkThis(popString(ctx), "Equals"), other));
+        });
+        NativeMethods::registerMethod(ctx, string + "Equals(string,string)", equals(false));
+        NativeMethods::registerMethod(ctx, string + "op_Equality(string,string)", equals(false));
+        NativeMethods::registerMethod(ctx, string + "op_Inequality(string,string)", equals(true));
+        NativeMethods::registerMethod(ctx, string + "GetHashCode()", [&ctx] {
+            ctx.push<s32>(Type::Int32, s32(Strings::getHash(checkThis(popString(ctx), "GetHashCode"))));
+        });
+        NativeMethods::registerMethod(ctx, string + "ToString()", [] { });
+
+        // Overrides are called through the Object methods and there's no virtual dispatch yet, so these pick the
+        // implementation from what the object was allocated as
+        NativeMethods::registerMethod(ctx, assembly + "System.Object::ToString()", [&ctx] {
+            u64 object = ctx.pop<u64>();
+            auto &reference = getAllocation(ctx, object, "ToString");
+
+            if (reference.kind == AllocationKind::String) {
+                ctx.push<u64>(Type::O, object);
+                return;
+            }
+
+            std::string typeName = reference.kind == AllocationKind::Object ? ctx.dll->getTypeName(reference.typeToken) : "System.Array";
+            if (typeName == "System.Text.StringBuilder")
+                pushString(ctx, Strings::create(ctx, Strings::getView(getBuffer(object))));
+            else
+                pushString(ctx, Strings::createFromUTF8(ctx, typeName));
+        });
+        NativeMethods::registerMethod(ctx, assembly + "System.Object::GetHashCode()", [&ctx] {
+            u64 object = ctx.pop<u64>();
+            auto &reference = getAllocation(ctx, object, "GetHashCode");
+
+            // Nothing moves on the heap, so the address identifies everything that isn't compared by value
+            if (reference.kind == AllocationKind::String)
+                ctx.push<s32>(Type::Int32, s32(Strings::getHash(reinterpret_cast<string_object_t*>(object))));
+            else
+                ctx.push<s32>(Type::Int32, s32((object >> 3) ^ (object >> 35)));
+        });
+    }
+
+    static void registerStringBuilderMembers(Context &ctx, const std::string &assembly) {
+        std::string builder = assembly + "System.Text.StringBuilder::";
+
+        // The object only holds the pointer to its buffer
+        NativeMethods::registerMethod(ctx, builder + ".ctor()", [&ctx] {
+            getBuffer(ctx.pop<u64>()) = Strings::createBuffer(ctx, DefaultBuilderCapacity);
+        });
+        NativeMethods::registerMethod(ctx, builder + ".ctor(int32)", [&ctx] {
+            s32 capacity = ctx.pop<s32>();
+            if (capacity < 0) [[unlikely]]
+                throwRuntimeException("System.ArgumentOutOfRangeException", "Negative StringBuilder capacity %d!", capacity);
+
+            getBuffer(ctx.pop<u64>()) = Strings::createBuffer(ctx, std::max<u32>(capacity, 1));
+        });
+        NativeMethods::registerMethod(ctx, builder + ".ctor(string)", [&ctx] {
+            auto value = getView(popString(ctx));
+            auto &buffer = getBuffer(ctx.pop<u64>());
+
+            buffer = Strings::createBuffer(ctx, std::max<u32>(value.size(), DefaultBuilderCapacity));
+            Strings::append(ctx, buffer, value);
+        });
+
+        auto append = [&ctx](auto getValue) -> std::function<void()> {
+            return [&ctx, getValue] {
+                auto value = getValue();
+                u64 self = ctx.pop<u64>();
+
+                Strings::append(ctx, getBuffer(self), value.getView());
+                ctx.push<u64>(Type::O, self);
+            };
+        };
+        struct StringText {
+            std::u16string_view view;
+            std::u16string_view getView() const { return this->view; }
+        };
+
+        NativeMethods::registerMethod(ctx, builder + "Append(string)", append([&ctx] { return StringText { getView(popString(ctx)) }; }));
+        NativeMethods::registerMethod(ctx, builder + "AppendLine(string)", [&ctx] {
+            auto value = getView(popString(ctx));
+            u64 self = ctx.pop<u64>();
+
+            Strings::append(ctx, getBuffer(self), value);
+            Strings::append(ctx, getBuffer(self), u"\n");
+            ctx.push<u64>(Type::O, self);
+        });
+        NativeMethods::registerMethod(ctx, builder + "AppendLine()", append([] { return StringText { u"\n" }; }));
+        NativeMethods::registerMethod(ctx, builder + "Append(string,int32,int32)", [&ctx] {
+            s32 count = ctx.pop<s32>();
+            s32 start = ctx.pop<s32>();
+            auto value = getView(popString(ctx));
+            u64 self = ctx.pop<u64>();
+            checkRange(start, count, value.size(), "StringBuilder.Append");
+
+            Strings::append(ctx, getBuffer(self), value.substr(start, count));
+            ctx.push<u64>(Type::O, self);
+        });
+        NativeMethods::registerMethod(ctx, builder + "Append(char,int32)", [&ctx] {
+            s32 repeatCount = ctx.pop<s32>();
+            char16_t character = ctx.pop<s32>();
+            u64 self = ctx.pop<u64>();
+
+            if (repeatCount < 0) [[unlikely]]
+                throwRuntimeException("System.ArgumentOutOfRangeException", "Negative repeat count %d passed to StringBuilder.Append!", repeatCount);
+
+            Strings::append(ctx, getBuffer(self), std::u16string(repeatCount, character));
+            ctx.push<u64>(Type::O, self);
+        });
+
+        NativeMethods::registerMethod(ctx, builder + "get_Length()", [&ctx] {
+            ctx.push<s32>(Type::Int32, getBuffer(ctx.pop<u64>())->length);
+        });
+        NativeMethods::registerMethod(ctx, builder + "Clear()", [&ctx] {
+            u64 self = ctx.pop<u64>();
+            getBuffer(self)->length = 0;
+            ctx.push<u64>(Type::O, self);
+        });
+        NativeMethods::registerMethod(ctx, builder + "ToString()", [&ctx] {
+            pushString(ctx, Strings::create(ctx, Strings::getView(getBuffer(ctx.pop<u64>()))));
+        });
+
+        // Interpolated strings are built through a handler that lives in a local of the calling method. Like the
+        // StringBuilder, its only field is the pointer to its buffer
+        std::string handler = assembly + "System.Runtime.CompilerServices.DefaultInterpolatedStringHandler::";
+        NativeMethods::registerMethod(ctx, handler + ".ctor(int32,int32)", [&ctx] {
+            s32 formattedCount = ctx.pop<s32>();
+            s32 literalLength = ctx.pop<s32>();
+
+            // The same guess the runtime makes for how long the formatted values are
+            constexpr u32 FormattedLengthGuess = 11;
+            getBuffer(ctx.pop<u64>()) = Strings::createBuffer(ctx, std::max<u32>(literalLength + formattedCount * FormattedLengthGuess, 1));
+        });
+        NativeMethods::registerMethod(ctx, handler + "AppendLiteral(string)", [&ctx] {
+            auto value = getView(popString(ctx));
+            Strings::append(ctx, getBuffer(ctx.pop<u64>()), value);
+        });
+        NativeMethods::registerMethod(ctx, handler + "AppendFormatted(string)", [&ctx] {
+            auto value = getView(popString(ctx));
+            Strings::append(ctx, getBuffer(ctx.pop<u64>()), value);
+        });
+        NativeMethods::registerMethod(ctx, handler + "AppendFormatted<string>(!!0)", [&ctx] {
+            auto value = getView(popString(ctx));
+            Strings::append(ctx, getBuffer(ctx.pop<u64>()), value);
+        });
+        NativeMethods::registerMethod(ctx, handler + "ToStringAndClear()", [&ctx] {
+            auto &buffer = getBuffer(ctx.pop<u64>());
+            pushString(ctx, Strings::create(ctx, Strings::getView(buffer)));
+            buffer->length = 0;
+        });
+
+        auto number = [](auto value) { return NumberText(value); };
+        registerFormattable<s32>(ctx, assembly, "System.Int32", "int32", number);
+        registerFormattable<u32, s32>(ctx, assembly, "System.UInt32", "uint32", number);
+        registerFormattable<s64>(ctx, assembly, "System.Int64", "int64", number);
+        registerFormattable<u64>(ctx, assembly, "System.UInt64", "uint64", number);
+        registerFormattable<s16, s32>(ctx, assembly, "System.Int16", "int16", number);
+        registerFormattable<u16, s32>(ctx, assembly, "System.UInt16", "uint16", number);
+        registerFormattable<s8, s32>(ctx, assembly, "System.SByte", "int8", number);
+        registerFormattable<u8, s32>(ctx, assembly, "System.Byte", "uint8", number);
+        registerFormattable<double>(ctx, assembly, "System.Double", "float64", number);
+        registerFormattable<char16_t, s32>(ctx, assembly, "System.Char", "char", [](char16_t value) { return CharacterText(value); });
+        registerFormattable<u8, s32>(ctx, assembly, "System.Boolean", "bool", [](u8 value) {
+            return StringText { value != 0 ? u"True" : u"False" };
+        });
+
+        // Singles are kept as doubles in locals and on the stack, so there's only the Append overload
+        NativeMethods::registerMethod(ctx, builder + "Append(float32)", append([&ctx] { return NumberText(float(ctx.pop<double>())); }));
+    }
+
+    void NativeMethods::loadStringLibrary(Context &ctx) {
+        for (const std::string assembly : { "[mscorlib]", "[System.Runtime]" }) {
+            registerStringMembers(ctx, assembly);
+            registerStringBuilderMembers(ctx, assembly);
+        }
+    }
+
+}
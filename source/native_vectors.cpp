@@ -0,0 +1,640 @@
+#include "native.hpp"
+
+#include "context.hpp"
+#include "exceptions.hpp"
+#include "vectors.hpp"
+#include "arrays.hpp"
+#include "logger.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+// Vectors never cross into code outside of this file, so it doesn't matter how they'd be passed without AVX
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace ili {
+
+    bool Vectors::hasAVX2() {
+        #if defined(__x86_64__)
+            static const bool supported = __builtin_cpu_supports("avx2");
+            return supported;
+        #else
+            return false;
+        #endif
+    }
+
+    u32 Vectors::getVectorSize() {
+        return hasAVX2() ? 32 : 16;
+    }
+
+    template<typename T, size_t Size>
+    struct Lanes {
+        typedef T type __attribute__((vector_size(Size)));
+    };
+
+    // Integer lanes are added and multiplied as unsigned so they wrap around like they do in .NET
+    template<typename T>
+    using Wrapping = typename std::conditional_t<std::is_integral_v<T>, std::make_unsigned<T>, std::type_identity<T>>::type;
+
+    // Operations on GCC vector extension types, all lanes at once
+
+    struct Add              { template<typename V> static V apply(V a, V b) { return a + b; } };
+    struct Subtract         { template<typename V> static V apply(V a, V b) { return a - b; } };
+    struct Multiply         { template<typename V> static V apply(V a, V b) { return a * b; } };
+    struct Divide           { template<typename V> static V apply(V a, V b) { return a / b; } };
+    struct BitwiseAnd       { template<typename V> static V apply(V a, V b) { return a & b; } };
+    struct BitwiseOr        { template<typename V> static V apply(V a, V b) { return a | b; } };
+    struct Xor              { template<typename V> static V apply(V a, V b) { return a ^ b; } };
+    struct AndNot           { template<typename V> static V apply(V a, V b) { return a & ~b; } };
+    struct Min              { template<typename V> static V apply(V a, V b) { return a < b ? a : b; } };
+    struct Max              { template<typename V> static V apply(V a, V b) { return a > b ? a : b; } };
+    struct ShiftLeft        { template<typename V> static V apply(V a, V b) { return a << b; } };
+    struct ShiftRight       { template<typename V> static V apply(V a, V b) { return a >> b; } };
+    struct Negate           { template<typename V> static V apply(V a, V) { return -a; } };
+    struct OnesComplement   { template<typename V> static V apply(V a, V) { return ~a; } };
+    struct Abs              { template<typename V> static V apply(V a, V) { return a < 0 ? -a : a; } };
+    struct Identity         { template<typename V> static V apply(V a, V) { return a; } };
+
+    // Comparisons give a mask with all bits of a lane set where they hold
+    struct Equal            { template<typename V> static auto apply(V a, V b) { return a == b; } };
+    struct LessThan         { template<typename V> static auto apply(V a, V b) { return a < b; } };
+    struct LessOrEqual      { template<typename V> static auto apply(V a, V b) { return a <= b; } };
+    struct GreaterThan      { template<typename V> static auto apply(V a, V b) { return a > b; } };
+    struct GreaterOrEqual   { template<typename V> static auto apply(V a, V b) { return a >= b; } };
+
+    struct SquareRoot {
+        template<typename V>
+        static V apply(V a, V) {
+            for (u32 i = 0; i < sizeof(V) / sizeof(a[0]); i++)
+                a[i] = std::sqrt(a[i]);
+            return a;
+        }
+    };
+
+    // Kernels run an operation on one vector width
+
+    template<typename Op>
+    struct Lanewise {
+        template<typename T, size_t Size>
+        static void run(VectorValue &result, const VectorValue &a, const VectorValue &b) {
+            typename Lanes<T, Size>::type x, y;
+            std::memcpy(&x, a.bytes, Size);
+            std::memcpy(&y, b.bytes, Size);
+
+            auto lanes = Op::apply(x, y);
+            std::memcpy(result.bytes, &lanes, Size);
+        }
+    };
+
+    // Adds up the lanes an operation produces, Dot is the sum of a Multiply
+    template<typename Op>
+    struct Sum {
+        template<typename T, size_t Size>
+        static void run(VectorValue &result, const VectorValue &a, const VectorValue &b) {
+            typename Lanes<T, Size>::type x, y;
+            std::memcpy(&x, a.bytes, Size);
+            std::memcpy(&y, b.bytes, Size);
+
+            auto lanes = Op::apply(x, y);
+            T total = 0;
+            for (u32 i = 0; i < Size / sizeof(T); i++)
+                total += lanes[i];
+
+            std::memcpy(result.bytes, &total, sizeof(T));
+        }
+    };
+
+    // Whether a comparison holds for all or for any of the lanes
+    template<typename Op, bool All>
+    struct Test {
+        template<typename T, size_t Size>
+        static void run(VectorValue &result, const VectorValue &a, const VectorValue &b) {
+            typename Lanes<T, Size>::type x, y;
+            std::memcpy(&x, a.bytes, Size);
+            std::memcpy(&y, b.bytes, Size);
+
+            auto mask = Op::apply(x, y);
+            bool matches = All;
+            for (u32 i = 0; i < Size / sizeof(T); i++) {
+                if constexpr (All)
+                    matches &= mask[i] != 0;
+                else
+                    matches |= mask[i] != 0;
+            }
+
+            result.bytes[0] = matches;
+        }
+    };
+
+    using Kernel = void(*)(VectorValue &result, const VectorValue &a, const VectorValue &b);
+
+    // Entry points for every instruction set. Everything a kernel calls gets inlined into them so each one has its own
+    // copy compiled for that instruction set
+    template<typename K, typename T, size_t Size>
+    [[gnu::flatten]] static void runBaseline(VectorValue &result, const VectorValue &a, const VectorValue &b) {
+        K::template run<T, Size>(result, a, b);
+    }
+
+    #if defined(__x86_64__)
+        template<typename K, typename T, size_t Size>
+        [[gnu::target("avx2"), gnu::flatten]] static void runAVX2(VectorValue &result, const VectorValue &a, const VectorValue &b) {
+            K::template run<T, Size>(result, a, b);
+        }
+    #endif
+
+    // 32 byte vectors fit into a single AVX2 register if the CPU has it. Everything else runs on SSE2, which every
+    // x86_64 CPU has, with 32 byte vectors split into two halves
+    template<typename K, typename T, size_t Size>
+    static Kernel getKernel() {
+        #if defined(__x86_64__)
+            if (Size == 32 && Vectors::hasAVX2())
+                return runAVX2<K, T, Size>;
+        #endif
+
+        return runBaseline<K, T, Size>;
+    }
+
+    static VectorValue popVector(Context &ctx) {
+        if (ctx.getTypeOnStack() != Type::Vector)
+            ctx.fatalError(LogCategory::Native, "Expected a vector on the stack!");
+
+        return ctx.pop<VectorValue>();
+    }
+
+    // Scalars are held the way the evaluation stack represents them. Everything smaller than 4 bytes is extended to
+    // 32 bits and floats become doubles
+    template<typename T>
+    static T popScalar(Context &ctx) {
+        if constexpr (std::is_floating_point_v<T>)
+            return static_cast<T>(ctx.pop<double>());
+        else if constexpr (sizeof(T) <= sizeof(u32))
+            return static_cast<T>(ctx.pop<s32>());
+        else
+            return static_cast<T>(ctx.pop<u64>());
+    }
+
+    template<typename T>
+    static void pushScalar(Context &ctx, T value) {
+        if constexpr (std::is_floating_point_v<T>)
+            ctx.push<double>(Type::F, value);
+        else if constexpr (sizeof(T) <= sizeof(u32))
+            ctx.push<s32>(Type::Int32, value);
+        else
+            ctx.push<u64>(Type::Int64, value);
+    }
+
+    template<typename T, size_t Size>
+    static VectorValue broadcast(T value) {
+        VectorValue result = { };
+        for (u32 i = 0; i < Size / sizeof(T); i++)
+            std::memcpy(result.bytes + i * sizeof(T), &value, sizeof(T));
+
+        return result;
+    }
+
+    // Vectors are loaded from and stored to arrays with the same checks as the managed implementations do
+    template<typename T, size_t Size>
+    static u8* getArrayElements(u64 arrayReference, s64 index) {
+        auto array = reinterpret_cast<array_object_t*>(arrayReference);
+
+        if (array == nullptr)
+            throwRuntimeException("System.NullReferenceException", "Vector loaded from or stored to a null array!");
+
+        if (array->elementSize != sizeof(T)) {
+            Logger::error(LogCategory::Native, "Vector of %u byte elements used with an array of %u byte elements!", u32(sizeof(T)), array->elementSize);
+            exit(1);
+        }
+
+        if (index < 0 || u64(index) + Size / sizeof(T) > array->length)
+            throwRuntimeException("System.IndexOutOfRangeException", "Vector at index %lld doesn't fit into an array of %u elements!", static_cast<long long>(index), array->length);
+
+        return Arrays::getElement(array, u32(index));
+    }
+
+    static void checkLane(s32 index, u32 numLanes) {
+        if (index < 0 || u32(index) >= numLanes)
+            throwRuntimeException("System.ArgumentOutOfRangeException", "Vector lane %d is out of range, the vector has %u!", index, numLanes);
+    }
+
+    // The names a vector type and the static class with its generic helpers are registered under
+    struct VectorTypeNames {
+        std::string type;           // Generic type without its type argument, e.g. "[System.Runtime.Intrinsics]System.Runtime.Intrinsics.Vector128`1"
+        std::string helpers;        // e.g. "[System.Runtime.Intrinsics]System.Runtime.Intrinsics.Vector128"
+        std::string reinterpretPrefix;  // Vector.AsVectorInt32 and Vector128.AsInt32
+        bool hasLaneCreate;         // Create taking a value for every lane
+    };
+
+    static constexpr const char *ReinterpretedTypes[] = { "SByte", "Byte", "Int16", "UInt16", "Int32", "UInt32", "Int64", "UInt64", "Single", "Double" };
+
+    // Registers one instantiation, e.g. Vector128<int> with its operators together with the helpers of Vector128
+    // instantiated for int
+    template<typename T, size_t Size>
+    static void registerVectorType(Context &ctx, const VectorTypeNames &names, const std::string &element) {
+        using W = Wrapping<T>;
+        constexpr u32 NumLanes = Size / sizeof(T);
+
+        std::string type = names.type + "<" + element + ">::";
+        std::string helpers = names.helpers + "::";
+        std::string instantiation = "<" + element + ">";
+
+        // Signatures name vector parameters by their instantiation, e.g. System.Runtime.Intrinsics.Vector128`1<!0>.
+        // In the signatures below a '?' stands in for it
+        std::string typeName = names.type.substr(names.type.find(']') + 1);
+        auto expand = [](const std::string &signature, const std::string &vector) {
+            std::string result;
+            for (char c : signature)
+                result += c == '?' ? vector : std::string(1, c);
+            return result;
+        };
+
+        auto member = [&](const std::string &name, std::function<void()> method) {
+            NativeMethods::registerMethod(ctx, type + expand(name, typeName + "<!0>"), std::move(method));
+        };
+        auto helper = [&](const std::string &name, const std::string &signature, std::function<void()> method) {
+            NativeMethods::registerMethod(ctx, helpers + name + instantiation + expand(signature, typeName + "<!!0>"), std::move(method));
+        };
+        // Vector has non-generic overloads for some element types, these are only ever looked up for those
+        auto overload = [&](const std::string &name, const std::string &signature, std::function<void()> method) {
+            NativeMethods::registerMethod(ctx, helpers + name + expand(signature, typeName + instantiation), std::move(method));
+        };
+
+        auto binary = [&ctx](Kernel kernel) -> std::function<void()> {
+            return [&ctx, kernel] {
+                VectorValue b = popVector(ctx);
+                VectorValue a = popVector(ctx);
+
+                VectorValue result = { };
+                kernel(result, a, b);
+                ctx.push<VectorValue>(Type::Vector, result);
+            };
+        };
+        auto unary = [&ctx](Kernel kernel) -> std::function<void()> {
+            return [&ctx, kernel] {
+                VectorValue a = popVector(ctx);
+
+                VectorValue result = { };
+                kernel(result, a, a);
+                ctx.push<VectorValue>(Type::Vector, result);
+            };
+        };
+        auto withScalar = [&ctx](Kernel kernel, bool scalarFirst) -> std::function<void()> {
+            return [&ctx, kernel, scalarFirst] {
+                VectorValue a, b;
+                if (scalarFirst) {
+                    b = popVector(ctx);
+                    a = broadcast<T, Size>(popScalar<T>(ctx));
+                } else {
+                    b = broadcast<T, Size>(popScalar<T>(ctx));
+                    a = popVector(ctx);
+                }
+
+                VectorValue result = { };
+                kernel(result, a, b);
+                ctx.push<VectorValue>(Type::Vector, result);
+            };
+        };
+        auto scalar = [&ctx](Kernel kernel, bool isUnary) -> std::function<void()> {
+            return [&ctx, kernel, isUnary] {
+                VectorValue b = popVector(ctx);
+                VectorValue a = isUnary ? b : popVector(ctx);
+
+                VectorValue result = { };
+                kernel(result, a, b);
+
+                T value;
+                std::memcpy(&value, result.bytes, sizeof(T));
+                pushScalar<T>(ctx, value);
+            };
+        };
+        auto boolean = [&ctx](Kernel kernel, bool negate) -> std::function<void()> {
+            return [&ctx, kernel, negate] {
+                VectorValue b = popVector(ctx);
+                VectorValue a = popVector(ctx);
+
+                VectorValue result = { };
+                kernel(result, a, b);
+                ctx.push<s32>(Type::Int32, result.bytes[0] != negate);
+            };
+        };
+
+        // Integer division traps instead of producing a value, so the cases .NET throws for are caught up front
+        auto divide = [&ctx](Kernel kernel, bool byScalar) -> std::function<void()> {
+            return [&ctx, kernel, byScalar] {
+                VectorValue b = byScalar ? broadcast<T, Size>(popScalar<T>(ctx)) : popVector(ctx);
+                VectorValue a = popVector(ctx);
+
+                if constexpr (std::is_integral_v<T>) {
+                    for (u32 i = 0; i < NumLanes; i++) {
+                        T dividend, divisor;
+                        std::memcpy(&dividend, a.bytes + i * sizeof(T), sizeof(T));
+                        std::memcpy(&divisor, b.bytes + i * sizeof(T), sizeof(T));
+
+                        bool overflows = std::is_signed_v<T> && dividend == std::numeric_limits<T>::min() && divisor == T(-1);
+                        if (divisor == 0)
+                            throwRuntimeException("System.DivideByZeroException", "Vector division by zero!");
+                        if (overflows)
+                            throwRuntimeException("System.OverflowException", "Vector division overflowed!");
+                    }
+                }
+
+                VectorValue result = { };
+                kernel(result, a, b);
+                ctx.push<VectorValue>(Type::Vector, result);
+            };
+        };
+
+        auto loadArray = [&ctx](bool hasIndex) -> std::function<void()> {
+            return [&ctx, hasIndex] {
+                s32 index = hasIndex ? ctx.pop<s32>() : 0;
+                u64 array = ctx.pop<u64>();
+
+                VectorValue result = { };
+                std::memcpy(result.bytes, getArrayElements<T, Size>(array, index), Size);
+                ctx.push<VectorValue>(Type::Vector, result);
+            };
+        };
+        auto storeArray = [&ctx](bool hasIndex) -> std::function<void()> {
+            return [&ctx, hasIndex] {
+                s32 index = hasIndex ? ctx.pop<s32>() : 0;
+                u64 array = ctx.pop<u64>();
+                VectorValue value = popVector(ctx);
+
+                std::memcpy(getArrayElements<T, Size>(array, index), value.bytes, Size);
+            };
+        };
+        auto loadPointer = [&ctx](bool hasOffset) -> std::function<void()> {
+            return [&ctx, hasOffset] {
+                u64 offset = hasOffset ? ctx.pop<u64>() : 0;
+                auto source = reinterpret_cast<const u8*>(ctx.pop<u64>()) + offset * sizeof(T);
+
+                VectorValue result = { };
+                std::memcpy(result.bytes, source, Size);
+                ctx.push<VectorValue>(Type::Vector, result);
+            };
+        };
+        auto storePointer = [&ctx](bool hasOffset) -> std::function<void()> {
+            return [&ctx, hasOffset] {
+                u64 offset = hasOffset ? ctx.pop<u64>() : 0;
+                auto destination = reinterpret_cast<u8*>(ctx.pop<u64>()) + offset * sizeof(T);
+                VectorValue value = popVector(ctx);
+
+                std::memcpy(destination, value.bytes, Size);
+            };
+        };
+
+        // Members of the vector type. Instance methods get a pointer to the vector as their this
+
+        member("get_Count",     [&ctx] { ctx.push<s32>(Type::Int32, NumLanes); });
+        member("get_IsSupported", [&ctx] { ctx.push<s32>(Type::Int32, 1); });
+        member("get_Zero",      [&ctx] { ctx.push<VectorValue>(Type::Vector, { }); });
+        member("get_One",       [&ctx] { ctx.push<VectorValue>(Type::Vector, broadcast<T, Size>(T(1))); });
+        member("get_AllBitsSet", [&ctx] {
+            VectorValue result = { };
+            std::memset(result.bytes, 0xFF, Size);
+            ctx.push<VectorValue>(Type::Vector, result);
+        });
+
+        member(".ctor(!0)", [&ctx] {
+            VectorValue value = broadcast<T, Size>(popScalar<T>(ctx));
+            std::memcpy(reinterpret_cast<void*>(ctx.pop<u64>()), value.bytes, Size);
+        });
+        for (bool hasIndex : { false, true }) {
+            member(hasIndex ? ".ctor(!0[],int32)" : ".ctor(!0[])", [&ctx, hasIndex] {
+                s32 index = hasIndex ? ctx.pop<s32>() : 0;
+                u8 *elements = getArrayElements<T, Size>(ctx.pop<u64>(), index);
+                std::memcpy(reinterpret_cast<void*>(ctx.pop<u64>()), elements, Size);
+            });
+            member(hasIndex ? "CopyTo(!0[],int32)" : "CopyTo(!0[])", [&ctx, hasIndex] {
+                s32 index = hasIndex ? ctx.pop<s32>() : 0;
+                u8 *elements = getArrayElements<T, Size>(ctx.pop<u64>(), index);
+                std::memcpy(elements, reinterpret_cast<const void*>(ctx.pop<u64>()), Size);
+            });
+        }
+
+        member("get_Item(int32)", [&ctx] {
+            s32 index = ctx.pop<s32>();
+            auto vector = reinterpret_cast<const u8*>(ctx.pop<u64>());
+            checkLane(index, NumLanes);
+
+            T value;
+            std::memcpy(&value, vector + index * sizeof(T), sizeof(T));
+            pushScalar<T>(ctx, value);
+        });
+        member("Equals(?)", [&ctx, equals = getKernel<Test<Equal, true>, T, Size>()] {
+            VectorValue other = popVector(ctx);
+            VectorValue value;
+            std::memcpy(&value, reinterpret_cast<const void*>(ctx.pop<u64>()), sizeof(value));
+
+            VectorValue result = { };
+            equals(result, value, other);
+            ctx.push<s32>(Type::Int32, result.bytes[0]);
+        });
+
+        member("op_Addition(?,?)",      binary(getKernel<Lanewise<Add>, W, Size>()));
+        member("op_Subtraction(?,?)",   binary(getKernel<Lanewise<Subtract>, W, Size>()));
+        member("op_Multiply(?,?)",      binary(getKernel<Lanewise<Multiply>, W, Size>()));
+        member("op_Multiply(?,!0)",     withScalar(getKernel<Lanewise<Multiply>, W, Size>(), false));
+        member("op_Multiply(!0,?)",     withScalar(getKernel<Lanewise<Multiply>, W, Size>(), true));
+        member("op_Division(?,?)",      divide(getKernel<Lanewise<Divide>, T, Size>(), false));
+        member("op_Division(?,!0)",     divide(getKernel<Lanewise<Divide>, T, Size>(), true));
+        member("op_BitwiseAnd(?,?)",    binary(getKernel<Lanewise<BitwiseAnd>, u64, Size>()));
+        member("op_BitwiseOr(?,?)",     binary(getKernel<Lanewise<BitwiseOr>, u64, Size>()));
+        member("op_ExclusiveOr(?,?)",   binary(getKernel<Lanewise<Xor>, u64, Size>()));
+        member("op_OnesComplement(?)",  unary(getKernel<Lanewise<OnesComplement>, u64, Size>()));
+        member("op_UnaryNegation(?)",   unary(getKernel<Lanewise<Negate>, W, Size>()));
+        member("op_UnaryPlus(?)",       [] { });
+        member("op_Equality(?,?)",      boolean(getKernel<Test<Equal, true>, T, Size>(), false));
+        member("op_Inequality(?,?)",    boolean(getKernel<Test<Equal, true>, T, Size>(), true));
+
+        // Shift counts are masked to the width of a lane like they are for scalars
+        if constexpr (std::is_integral_v<T>) {
+            auto shift = [&ctx](Kernel kernel) -> std::function<void()> {
+                return [&ctx, kernel] {
+                    VectorValue count = broadcast<T, Size>(T(ctx.pop<s32>() & (sizeof(T) * 8 - 1)));
+                    VectorValue value = popVector(ctx);
+
+                    VectorValue result = { };
+                    kernel(result, value, count);
+                    ctx.push<VectorValue>(Type::Vector, result);
+                };
+            };
+
+            member("op_LeftShift(?,int32)",          shift(getKernel<Lanewise<ShiftLeft>, W, Size>()));
+            member("op_RightShift(?,int32)",         shift(getKernel<Lanewise<ShiftRight>, T, Size>()));
+            member("op_UnsignedRightShift(?,int32)", shift(getKernel<Lanewise<ShiftRight>, std::make_unsigned_t<T>, Size>()));
+
+            overload("ShiftLeft",               "(?,int32)", shift(getKernel<Lanewise<ShiftLeft>, W, Size>()));
+            overload("ShiftRightArithmetic",    "(?,int32)", shift(getKernel<Lanewise<ShiftRight>, T, Size>()));
+            overload("ShiftRightLogical",       "(?,int32)", shift(getKernel<Lanewise<ShiftRight>, std::make_unsigned_t<T>, Size>()));
+        }
+
+        // Generic helpers of the static class, instantiated for the element type
+
+        helper("Add",               "(?,?)",    binary(getKernel<Lanewise<Add>, W, Size>()));
+        helper("Subtract",          "(?,?)",    binary(getKernel<Lanewise<Subtract>, W, Size>()));
+        helper("Multiply",          "(?,?)",    binary(getKernel<Lanewise<Multiply>, W, Size>()));
+        helper("Multiply",          "(?,!!0)",  withScalar(getKernel<Lanewise<Multiply>, W, Size>(), false));
+        helper("Multiply",          "(!!0,?)",  withScalar(getKernel<Lanewise<Multiply>, W, Size>(), true));
+        helper("Divide",            "(?,?)",    divide(getKernel<Lanewise<Divide>, T, Size>(), false));
+        helper("Divide",            "(?,!!0)",  divide(getKernel<Lanewise<Divide>, T, Size>(), true));
+        helper("Negate",            "(?)",      unary(getKernel<Lanewise<Negate>, W, Size>()));
+        helper("Abs",               "(?)",      unary(getKernel<Lanewise<Abs>, T, Size>()));
+        helper("Min",               "(?,?)",    binary(getKernel<Lanewise<Min>, T, Size>()));
+        helper("Max",               "(?,?)",    binary(getKernel<Lanewise<Max>, T, Size>()));
+        helper("BitwiseAnd",        "(?,?)",    binary(getKernel<Lanewise<BitwiseAnd>, u64, Size>()));
+        helper("BitwiseOr",         "(?,?)",    binary(getKernel<Lanewise<BitwiseOr>, u64, Size>()));
+        helper("Xor",               "(?,?)",    binary(getKernel<Lanewise<Xor>, u64, Size>()));
+        helper("AndNot",            "(?,?)",    binary(getKernel<Lanewise<AndNot>, u64, Size>()));
+        helper("OnesComplement",    "(?)",      unary(getKernel<Lanewise<OnesComplement>, u64, Size>()));
+
+        helper("Equals",                "(?,?)", binary(getKernel<Lanewise<Equal>, T, Size>()));
+        helper("LessThan",              "(?,?)", binary(getKernel<Lanewise<LessThan>, T, Size>()));
+        helper("LessThanOrEqual",       "(?,?)", binary(getKernel<Lanewise<LessOrEqual>, T, Size>()));
+        helper("GreaterThan",           "(?,?)", binary(getKernel<Lanewise<GreaterThan>, T, Size>()));
+        helper("GreaterThanOrEqual",    "(?,?)", binary(getKernel<Lanewise<GreaterOrEqual>, T, Size>()));
+        helper("EqualsAll",             "(?,?)", boolean(getKernel<Test<Equal, true>, T, Size>(), false));
+        helper("EqualsAny",             "(?,?)", boolean(getKernel<Test<Equal, false>, T, Size>(), false));
+        helper("LessThanAll",           "(?,?)", boolean(getKernel<Test<LessThan, true>, T, Size>(), false));
+        helper("LessThanAny",           "(?,?)", boolean(getKernel<Test<LessThan, false>, T, Size>(), false));
+        helper("LessThanOrEqualAll",    "(?,?)", boolean(getKernel<Test<LessOrEqual, true>, T, Size>(), false));
+        helper("LessThanOrEqualAny",    "(?,?)", boolean(getKernel<Test<LessOrEqual, false>, T, Size>(), false));
+        helper("GreaterThanAll",        "(?,?)", boolean(getKernel<Test<GreaterThan, true>, T, Size>(), false));
+        helper("GreaterThanAny",        "(?,?)", boolean(getKernel<Test<GreaterThan, false>, T, Size>(), false));
+        helper("GreaterThanOrEqualAll", "(?,?)", boolean(getKernel<Test<GreaterOrEqual, true>, T, Size>(), false));
+        helper("GreaterThanOrEqualAny", "(?,?)", boolean(getKernel<Test<GreaterOrEqual, false>, T, Size>(), false));
+
+        std::function<void()> conditionalSelect = [&ctx, select = getKernel<Lanewise<BitwiseAnd>, u64, Size>(), selectNot = getKernel<Lanewise<AndNot>, u64, Size>(),
+                                                   combine = getKernel<Lanewise<BitwiseOr>, u64, Size>()] {
+            VectorValue right = popVector(ctx);
+            VectorValue left = popVector(ctx);
+            VectorValue mask = popVector(ctx);
+
+            VectorValue fromLeft = { }, fromRight = { }, result = { };
+            select(fromLeft, left, mask);
+            selectNot(fromRight, right, mask);
+            combine(result, fromLeft, fromRight);
+            ctx.push<VectorValue>(Type::Vector, result);
+        };
+        helper("ConditionalSelect", "(?,?,?)", conditionalSelect);
+
+        helper("Dot",   "(?,?)",    scalar(getKernel<Sum<Multiply>, W, Size>(), false));
+        helper("Sum",   "(?)",      scalar(getKernel<Sum<Identity>, W, Size>(), true));
+
+        if constexpr (std::is_floating_point_v<T>) {
+            helper("SquareRoot",    "(?)", unary(getKernel<Lanewise<SquareRoot>, T, Size>()));
+            helper("Sqrt",          "(?)", unary(getKernel<Lanewise<SquareRoot>, T, Size>()));
+        }
+
+        helper("GetElement", "(?,int32)", [&ctx] {
+            s32 index = ctx.pop<s32>();
+            VectorValue vector = popVector(ctx);
+            checkLane(index, NumLanes);
+
+            T value;
+            std::memcpy(&value, vector.bytes + index * sizeof(T), sizeof(T));
+            pushScalar<T>(ctx, value);
+        });
+        helper("WithElement", "(?,int32,!!0)", [&ctx] {
+            T value = popScalar<T>(ctx);
+            s32 index = ctx.pop<s32>();
+            VectorValue vector = popVector(ctx);
+            checkLane(index, NumLanes);
+
+            std::memcpy(vector.bytes + index * sizeof(T), &value, sizeof(T));
+            ctx.push<VectorValue>(Type::Vector, vector);
+        });
+        helper("ToScalar", "(?)", [&ctx] {
+            VectorValue vector = popVector(ctx);
+
+            T value;
+            std::memcpy(&value, vector.bytes, sizeof(T));
+            pushScalar<T>(ctx, value);
+        });
+
+        helper("Create",        "(!!0)",            [&ctx] { ctx.push<VectorValue>(Type::Vector, broadcast<T, Size>(popScalar<T>(ctx))); });
+        helper("Create",        "(!!0[])",          loadArray(false));
+        helper("Create",        "(!!0[],int32)",    loadArray(true));
+        helper("CopyTo",        "(?,!!0[])",        storeArray(false));
+        helper("CopyTo",        "(?,!!0[],int32)",  storeArray(true));
+        helper("Load",          "(!!0*)",           loadPointer(false));
+        helper("LoadAligned",   "(!!0*)",           loadPointer(false));
+        helper("LoadUnsafe",    "(!!0&)",           loadPointer(false));
+        helper("LoadUnsafe",    "(!!0&,native uint)", loadPointer(true));
+        helper("Store",         "(?,!!0*)",         storePointer(false));
+        helper("StoreAligned",  "(?,!!0*)",         storePointer(false));
+        helper("StoreUnsafe",   "(?,!!0&)",         storePointer(false));
+        helper("StoreUnsafe",   "(?,!!0&,native uint)", storePointer(true));
+
+        // Reinterpreting the lanes as another element type leaves the bits as they are
+        for (const char *reinterpretedType : ReinterpretedTypes)
+            helper(names.reinterpretPrefix + reinterpretedType, "(?)", [] { });
+
+        // Non-generic overloads. The comparisons return a mask of signed integers as wide as the lanes
+        overload("Create", "(" + element + ")", [&ctx] { ctx.push<VectorValue>(Type::Vector, broadcast<T, Size>(popScalar<T>(ctx))); });
+        overload("Equals",              "(?,?)", binary(getKernel<Lanewise<Equal>, T, Size>()));
+        overload("LessThan",            "(?,?)", binary(getKernel<Lanewise<LessThan>, T, Size>()));
+        overload("LessThanOrEqual",     "(?,?)", binary(getKernel<Lanewise<LessOrEqual>, T, Size>()));
+        overload("GreaterThan",         "(?,?)", binary(getKernel<Lanewise<GreaterThan>, T, Size>()));
+        overload("GreaterThanOrEqual",  "(?,?)", binary(getKernel<Lanewise<GreaterOrEqual>, T, Size>()));
+
+        if constexpr (std::is_floating_point_v<T>) {
+            std::string mask = typeName + (sizeof(T) == sizeof(u32) ? "<int32>" : "<int64>");
+            overload("ConditionalSelect", "(" + mask + ",?,?)", conditionalSelect);
+            overload("SquareRoot", "(?)", unary(getKernel<Lanewise<SquareRoot>, T, Size>()));
+        }
+
+        if (names.hasLaneCreate) {
+            std::string signature = "(";
+            for (u32 i = 0; i < NumLanes; i++)
+                signature += (i > 0 ? "," : "") + element;
+            signature += ")";
+
+            overload("Create", signature, [&ctx] {
+                VectorValue result = { };
+                for (u32 i = NumLanes; i > 0; i--) {
+                    T value = popScalar<T>(ctx);
+                    std::memcpy(result.bytes + (i - 1) * sizeof(T), &value, sizeof(T));
+                }
+
+                ctx.push<VectorValue>(Type::Vector, result);
+            });
+        }
+    }
+
+    template<size_t Size>
+    static void registerVectorTypes(Context &ctx, const VectorTypeNames &names) {
+        registerVectorType<s8, Size>(ctx, names, "int8");
+        registerVectorType<u8, Size>(ctx, names, "uint8");
+        registerVectorType<s16, Size>(ctx, names, "int16");
+        registerVectorType<u16, Size>(ctx, names, "uint16");
+        registerVectorType<s32, Size>(ctx, names, "int32");
+        registerVectorType<u32, Size>(ctx, names, "uint32");
+        registerVectorType<s64, Size>(ctx, names, "int64");
+        registerVectorType<u64, Size>(ctx, names, "uint64");
+        registerVectorType<float, Size>(ctx, names, "float32");
+        registerVectorType<double, Size>(ctx, names, "float64");
+    }
+
+    void NativeMethods::loadVectorLibrary(Context &ctx) {
+        VectorTypeNames vector = { "[System.Numerics.Vectors]System.Numerics.Vector`1", "[System.Numerics.Vectors]System.Numerics.Vector", "AsVector", false };
+        VectorTypeNames vector128 = { "[System.Runtime.Intrinsics]System.Runtime.Intrinsics.Vector128`1", "[System.Runtime.Intrinsics]System.Runtime.Intrinsics.Vector128", "As", true };
+        VectorTypeNames vector256 = { "[System.Runtime.Intrinsics]System.Runtime.Intrinsics.Vector256`1", "[System.Runtime.Intrinsics]System.Runtime.Intrinsics.Vector256", "As", true };
+
+        // Vector<T> is as wide as the widest vectors the CPU can work with
+        if (Vectors::getVectorSize() == 32)
+            registerVectorTypes<32>(ctx, vector);
+        else
+            registerVectorTypes<16>(ctx, vector);
+
+        registerVectorTypes<16>(ctx, vector128);
+        registerVectorTypes<32>(ctx, vector256);
+
+        registerMethod(ctx, vector.helpers + "::get_IsHardwareAccelerated", [&ctx] { ctx.push<s32>(Type::Int32, 1); });
+        registerMethod(ctx, vector128.helpers + "::get_IsHardwareAccelerated", [&ctx] { ctx.push<s32>(Type::Int32, 1); });
+        registerMethod(ctx, vector256.helpers + "::get_IsHardwareAccelerated", [&ctx] { ctx.push<s32>(Type::Int32, Vectors::hasAVX2()); });
+    }
+
+}
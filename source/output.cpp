@@ -0,0 +1,216 @@
+#include "output.hpp"
+
+#include "transcoder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <sys/uio.h>
+    #include <unistd.h>
+    #include <climits>
+#endif
+
+namespace ili {
+
+    // FileDescriptorSink
+
+    FileDescriptorSink::FileDescriptorSink(int fd, bool closeOnDestruction) : m_fd(fd), m_closeOnDestruction(closeOnDestruction) {
+
+    }
+
+    FileDescriptorSink::~FileDescriptorSink() {
+        if (this->m_closeOnDestruction) {
+        #if defined(_WIN32)
+            ::_close(this->m_fd);
+        #else
+            ::close(this->m_fd);
+        #endif
+        }
+    }
+
+    bool FileDescriptorSink::write(const OutputChunk *chunks, size_t numChunks) {
+    #if defined(_WIN32)
+        for (size_t i = 0; i < numChunks; i++) {
+            const char *data = chunks[i].data;
+            size_t remaining = chunks[i].size;
+
+            while (remaining > 0) {
+                int written = ::_write(this->m_fd, data, static_cast<unsigned>(std::min<size_t>(remaining, 0x4000'0000)));
+                if (written <= 0)
+                    return false;
+
+                data += written;
+                remaining -= written;
+            }
+        }
+
+        return true;
+    #else
+        std::vector<iovec> vectors;
+        vectors.reserve(numChunks);
+        for (size_t i = 0; i < numChunks; i++) {
+            if (chunks[i].size > 0)
+                vectors.push_back({ const_cast<char*>(chunks[i].data), chunks[i].size });
+        }
+
+        // All chunks go out with as few syscalls as possible, picking up where a partial write stopped
+        size_t current = 0;
+        while (current < vectors.size()) {
+            ssize_t written = ::writev(this->m_fd, &vectors[current], std::min<size_t>(vectors.size() - current, IOV_MAX));
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+
+            while (current < vectors.size() && static_cast<size_t>(written) >= vectors[current].iov_len) {
+                written -= vectors[current].iov_len;
+                current++;
+            }
+
+            if (current < vectors.size()) {
+                vectors[current].iov_base = static_cast<char*>(vectors[current].iov_base) + written;
+                vectors[current].iov_len -= written;
+            }
+        }
+
+        return true;
+    #endif
+    }
+
+    bool FileDescriptorSink::isInteractive() {
+    #if defined(_WIN32)
+        return ::_isatty(this->m_fd);
+    #else
+        return ::isatty(this->m_fd);
+    #endif
+    }
+
+    // MemorySink
+
+    bool MemorySink::write(const OutputChunk *chunks, size_t numChunks) {
+        for (size_t i = 0; i < numChunks; i++)
+            this->m_contents.append(chunks[i].data, chunks[i].size);
+
+        return true;
+    }
+
+    const std::string& MemorySink::getContents() {
+        return this->m_contents;
+    }
+
+    void MemorySink::clear() {
+        this->m_contents.clear();
+    }
+
+    // OutputBuffer
+
+    OutputBuffer::OutputBuffer(std::unique_ptr<OutputSink> sink, size_t capacity) : m_buffer(std::make_unique<char[]>(capacity)), m_capacity(capacity) {
+        this->setSink(sink != nullptr ? std::move(sink) : std::make_unique<FileDescriptorSink>(1));
+    }
+
+    OutputBuffer::~OutputBuffer() {
+        this->flush();
+    }
+
+    void OutputBuffer::setSink(std::unique_ptr<OutputSink> sink) {
+        // Whatever was printed so far still belongs to the old destination
+        this->flush();
+
+        this->m_sink = std::move(sink);
+        this->m_flushPolicy = this->m_sink->isInteractive() ? FlushPolicy::Line : FlushPolicy::Full;
+    }
+
+    OutputSink* OutputBuffer::getSink() {
+        return this->m_sink.get();
+    }
+
+    void OutputBuffer::setFlushPolicy(FlushPolicy policy) {
+        this->m_flushPolicy = policy;
+    }
+
+    void OutputBuffer::write(std::string_view string) {
+        if (string.size() <= this->m_capacity - this->m_size) {
+            std::memcpy(this->m_buffer.get() + this->m_size, string.data(), string.size());
+            this->m_size += string.size();
+        } else {
+            this->writeThrough(string);
+        }
+
+        if (this->m_flushPolicy == FlushPolicy::Line && std::memchr(string.data(), '\n', string.size()) != nullptr)
+            this->flush();
+    }
+
+    void OutputBuffer::write(std::u16string_view string) {
+        size_t maxSize = Transcoder::getMaxUTF8Size(string.size());
+
+        // Transcode straight into the buffer unless the string could never fit
+        if (char *destination = this->reserve(maxSize); destination != nullptr)
+            this->commit(Transcoder::utf16ToUTF8(string.data(), string.size(), destination));
+        else
+            this->writeThrough(Transcoder::toUTF8(string));
+
+        if (this->m_flushPolicy == FlushPolicy::Line && string.find(u'\n') != std::u16string_view::npos)
+            this->flush();
+    }
+
+    void OutputBuffer::write(char character) {
+        if (this->m_size == this->m_capacity)
+            this->flush();
+
+        this->m_buffer[this->m_size++] = character;
+
+        if (character == '\n')
+            this->lineCompleted();
+    }
+
+    void OutputBuffer::writeLine() {
+        this->write('\n');
+    }
+
+    char* OutputBuffer::reserve(size_t size) {
+        if (size > this->m_capacity)
+            return nullptr;
+
+        if (size > this->m_capacity - this->m_size)
+            this->flush();
+
+        return this->m_buffer.get() + this->m_size;
+    }
+
+    void OutputBuffer::commit(size_t size) {
+        this->m_size += size;
+    }
+
+    void OutputBuffer::flush() {
+        if (this->m_size == 0 || this->m_sink == nullptr)
+            return;
+
+        OutputChunk chunk = { this->m_buffer.get(), this->m_size };
+        this->m_sink->write(&chunk, 1);
+        this->m_size = 0;
+    }
+
+    // Strings that don't fit go out together with the buffered data in a single batched write
+    void OutputBuffer::writeThrough(std::string_view string) {
+        OutputChunk chunks[] = {
+            { this->m_buffer.get(), this->m_size },
+            { string.data(), string.size() }
+        };
+
+        this->m_sink->write(chunks, std::size(chunks));
+        this->m_size = 0;
+    }
+
+    void OutputBuffer::lineCompleted() {
+        if (this->m_flushPolicy == FlushPolicy::Line)
+            this->flush();
+    }
+
+}
@@ -0,0 +1,280 @@
+#include "pdb.hpp"
+
+#include "dll.hpp"
+#include "logger.hpp"
+#include "tables.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ili {
+
+    namespace {
+
+        // Signed compressed integers store the sign in the lowest bit of the unsigned encoding
+        u8 decodeCompressedSigned(const u8 *data, s32 &value) {
+            u32 encoded;
+            u8 size = DLL::decodeCompressedUnsigned(data, encoded);
+
+            value = encoded >> 1;
+            if ((encoded & 1) != 0) {
+                switch (size) {
+                    case 1: value -= 0x40;          break;
+                    case 2: value -= 0x2000;        break;
+                    default: value -= 0x1000'0000;  break;
+                }
+            }
+
+            return size;
+        }
+
+    }
+
+    bool PortablePDB::open(const std::string &path) {
+        if (!this->m_file.open(path))
+            return false;
+
+        const u8 *data = this->m_file.getData();
+        size_t size = this->m_file.getSize();
+
+        // Portable PDBs use the same metadata root as the metadata of an assembly
+        if (size < 0x20 || std::memcmp(data, "BSJB", 4) != 0) {
+            Logger::error(LogCategory::Metadata, "%s is not a portable PDB!", path.c_str());
+            this->m_file.close();
+            return false;
+        }
+
+        u32 versionLength = *reinterpret_cast<const u32*>(data + 12);
+        const u8 *currentDataPtr = data + 16 + versionLength + sizeof(u16);
+        u16 numStreams = *reinterpret_cast<const u16*>(currentDataPtr);
+        currentDataPtr += sizeof(u16);
+
+        const u8 *tildeStream = nullptr;
+        for (u16 stream = 0; stream < numStreams && currentDataPtr + 8 < data + size; stream++) {
+            u32 offset = *reinterpret_cast<const u32*>(currentDataPtr);
+            const char *name = reinterpret_cast<const char*>(currentDataPtr + 8);
+
+            if (offset < size) {
+                if (std::strcmp(name, "#~") == 0)
+                    tildeStream = data + offset;
+                else if (std::strcmp(name, "#Blob") == 0)
+                    this->m_blobHeap = data + offset;
+            }
+
+            currentDataPtr += 8 + ((std::strlen(name) + 4) & ~3);
+        }
+
+        if (tildeStream == nullptr || this->m_blobHeap == nullptr) {
+            Logger::error(LogCategory::Metadata, "PDB %s is missing the #~ or #Blob stream!", path.c_str());
+            this->m_file.close();
+            return false;
+        }
+
+        u8 heapSizes = tildeStream[6];
+        u64 validTables = *reinterpret_cast<const u64*>(tildeStream + 8);
+        this->m_wideGuidIndices = (heapSizes & 0x02) != 0;
+        this->m_wideBlobIndices = (heapSizes & 0x04) != 0;
+
+        const u8 *rows = tildeStream + 24;
+        u32 numRows[64] = { 0 };
+        for (u8 table = 0; table < 64; table++) {
+            if ((validTables & (1ULL << table)) != 0) {
+                numRows[table] = *reinterpret_cast<const u32*>(rows);
+                rows += sizeof(u32);
+            }
+        }
+
+        // Standalone PDBs only contain debug tables, Document and MethodDebugInformation come first
+        if ((validTables & ((1ULL << PDB_TABLE_ID_DOCUMENT) - 1)) != 0) {
+            Logger::error(LogCategory::Metadata, "PDB %s contains unexpected tables!", path.c_str());
+            this->m_file.close();
+            return false;
+        }
+
+        u32 guidIndexSize = this->m_wideGuidIndices ? 4 : 2;
+        u32 blobIndexSize = this->m_wideBlobIndices ? 4 : 2;
+
+        this->m_numDocuments = numRows[PDB_TABLE_ID_DOCUMENT];
+        this->m_documentRowSize = 2 * blobIndexSize + 2 * guidIndexSize;
+        this->m_documents = rows;
+
+        this->m_numMethodDebugInformation = numRows[PDB_TABLE_ID_METHOD_DEBUG_INFORMATION];
+        this->m_methodDebugInformationRowSize = (this->m_numDocuments > 0xFFFF ? 4 : 2) + blobIndexSize;
+        this->m_methodDebugInformation = this->m_documents + this->m_numDocuments * this->m_documentRowSize;
+
+        if (this->m_methodDebugInformation + this->m_numMethodDebugInformation * this->m_methodDebugInformationRowSize > data + size) {
+            Logger::error(LogCategory::Metadata, "PDB %s is truncated!", path.c_str());
+            this->m_file.close();
+            return false;
+        }
+
+        Logger::info(LogCategory::Metadata, "Loaded debug symbols from %s", path.c_str());
+
+        return true;
+    }
+
+    bool PortablePDB::isOpen() {
+        return this->m_file.isOpen();
+    }
+
+    std::optional<SourceLocation> PortablePDB::getSourceLocation(u32 methodToken, u32 ilOffset) {
+        if (!this->isOpen())
+            return std::nullopt;
+
+        auto &sequencePoints = this->getSequencePoints(methodToken);
+
+        auto sequencePoint = std::upper_bound(sequencePoints.begin(), sequencePoints.end(), ilOffset, [](u32 offset, const SequencePoint &point) {
+            return offset < point.ilOffset;
+        });
+
+        if (sequencePoint == sequencePoints.begin())
+            return std::nullopt;
+
+        sequencePoint--;
+        if (sequencePoint->line == HiddenLine)
+            return std::nullopt;
+
+        return SourceLocation { this->getDocumentName(sequencePoint->document), sequencePoint->line };
+    }
+
+    const std::vector<PortablePDB::SequencePoint>& PortablePDB::getSequencePoints(u32 methodToken) {
+        auto [entry, inserted] = this->m_sequencePoints.try_emplace(methodToken);
+        auto &sequencePoints = entry->second;
+        if (!inserted)
+            return sequencePoints;
+
+        // MethodDebugInformation rows line up with the MethodDef table of the assembly
+        u32 index = TABLE_INDEX(methodToken);
+        if (TABLE_ID(methodToken) != TABLE_ID_METHODDEF || index == 0 || index > this->m_numMethodDebugInformation)
+            return sequencePoints;
+
+        const u8 *row = this->m_methodDebugInformation + (index - 1) * this->m_methodDebugInformationRowSize;
+        bool wideDocumentIndex = this->m_numDocuments > 0xFFFF;
+        u32 document = this->readIndex(row, wideDocumentIndex);
+        u32 blobIndex = this->readIndex(row + (wideDocumentIndex ? 4 : 2), this->m_wideBlobIndices);
+
+        u32 blobSize;
+        const u8 *blob = this->getBlob(blobIndex, blobSize);
+        if (blob == nullptr || blobSize == 0)
+            return sequencePoints;
+
+        const u8 *end = blob + blobSize;
+        u32 value;
+
+        blob += DLL::decodeCompressedUnsigned(blob, value);        // Local signature
+        if (document == 0)
+            blob += DLL::decodeCompressedUnsigned(blob, document);
+
+        u32 ilOffset = 0;
+        u32 startLine = 0;
+        bool firstRecord = true;
+        bool firstVisibleRecord = true;
+
+        while (blob < end) {
+            u32 deltaOffset;
+            u8 recordHeaderSize = DLL::decodeCompressedUnsigned(blob, deltaOffset);
+            if (recordHeaderSize == 0)
+                break;
+            blob += recordHeaderSize;
+
+            // A zero offset delta after the first record switches to another document
+            if (!firstRecord && deltaOffset == 0) {
+                blob += DLL::decodeCompressedUnsigned(blob, document);
+                continue;
+            }
+
+            ilOffset += deltaOffset;
+            firstRecord = false;
+
+            u32 deltaLines;
+            blob += DLL::decodeCompressedUnsigned(blob, deltaLines);
+
+            s32 deltaColumns;
+            if (deltaLines == 0) {
+                u32 columns;
+                blob += DLL::decodeCompressedUnsigned(blob, columns);
+                deltaColumns = columns;
+            } else {
+                blob += decodeCompressedSigned(blob, deltaColumns);
+            }
+
+            if (deltaLines == 0 && deltaColumns == 0) {
+                sequencePoints.push_back({ ilOffset, document, HiddenLine });
+                continue;
+            }
+
+            if (firstVisibleRecord) {
+                blob += DLL::decodeCompressedUnsigned(blob, startLine);
+                blob += DLL::decodeCompressedUnsigned(blob, value);        // Start column
+                firstVisibleRecord = false;
+            } else {
+                s32 deltaStartLine, deltaStartColumn;
+                blob += decodeCompressedSigned(blob, deltaStartLine);
+                blob += decodeCompressedSigned(blob, deltaStartColumn);
+                startLine += deltaStartLine;
+            }
+
+            sequencePoints.push_back({ ilOffset, document, startLine });
+        }
+
+        return sequencePoints;
+    }
+
+    // Document names are stored as a separator followed by blobs holding the parts of the path
+    const std::string& PortablePDB::getDocumentName(u32 document) {
+        auto [entry, inserted] = this->m_documentNames.try_emplace(document);
+        auto &name = entry->second;
+        if (!inserted || document == 0 || document > this->m_numDocuments)
+            return name;
+
+        const u8 *row = this->m_documents + (document - 1) * this->m_documentRowSize;
+
+        u32 blobSize;
+        const u8 *blob = this->getBlob(this->readIndex(row, this->m_wideBlobIndices), blobSize);
+        if (blob == nullptr || blobSize == 0)
+            return name;
+
+        const u8 *end = blob + blobSize;
+        char separator = *blob++;
+
+        bool firstPart = true;
+        while (blob < end) {
+            u32 partIndex;
+            blob += DLL::decodeCompressedUnsigned(blob, partIndex);
+
+            if (!firstPart && separator != '\0')
+                name += separator;
+            firstPart = false;
+
+            u32 partSize;
+            const u8 *part = this->getBlob(partIndex, partSize);
+            if (part != nullptr)
+                name.append(reinterpret_cast<const char*>(part), partSize);
+        }
+
+        return name;
+    }
+
+    u32 PortablePDB::readIndex(const u8 *data, bool wide) {
+        return wide ? *reinterpret_cast<const u32*>(data) : *reinterpret_cast<const u16*>(data);
+    }
+
+    const u8* PortablePDB::getBlob(u32 index, u32 &size) {
+        const u8 *data = this->m_file.getData();
+        const u8 *blob = this->m_blobHeap + index;
+
+        if (blob >= data + this->m_file.getSize()) {
+            size = 0;
+            return nullptr;
+        }
+
+        blob += DLL::decodeCompressedUnsigned(blob, size);
+        if (blob + size > data + this->m_file.getSize()) {
+            size = 0;
+            return nullptr;
+        }
+
+        return blob;
+    }
+
+}
@@ -0,0 +1,222 @@
+#include "perf_counters.hpp"
+
+#include "logger.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace ili {
+
+    PerfCounters::~PerfCounters() {
+        this->close();
+    }
+
+    const char* PerfCounters::getEventName(PerfEvent event) {
+        switch (event) {
+            case PerfEvent::Instructions:   return "instructions";
+            case PerfEvent::Cycles:         return "cycles";
+            case PerfEvent::BranchMisses:   return "branch_misses";
+            case PerfEvent::L1DMisses:      return "l1d_misses";
+            case PerfEvent::LLCMisses:      return "llc_misses";
+            case PerfEvent::DTLBMisses:     return "dtlb_misses";
+            default:                        return "unknown";
+        }
+    }
+
+#if defined(__linux__)
+
+    namespace {
+
+        struct EventDescription {
+            u32 type;
+            u64 config;
+        };
+
+        constexpr u64 getCacheConfig(u64 cache, u64 operation, u64 result) {
+            return cache | (operation << 8) | (result << 16);
+        }
+
+        constexpr EventDescription Events[] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_HW_CACHE, getCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+            { PERF_TYPE_HW_CACHE, getCacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+            { PERF_TYPE_HW_CACHE, getCacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        };
+        static_assert(std::size(Events) == static_cast<size_t>(PerfEvent::Count));
+
+        int openEvent(const EventDescription &event, int groupFd) {
+            perf_event_attr attributes = { };
+            attributes.size = sizeof(attributes);
+            attributes.type = event.type;
+            attributes.config = event.config;
+            attributes.disabled = groupFd < 0;      // The whole group gets enabled through its leader
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            return ::syscall(SYS_perf_event_open, &attributes, 0, -1, groupFd, 0);
+        }
+
+    }
+
+    bool PerfCounters::open() {
+        this->close();
+
+        // All events are in one group so they're always scheduled together and can be read with a single syscall
+        for (size_t event = 0; event < std::size(Events); event++) {
+            int fd = openEvent(Events[event], this->m_groupFd);
+            if (fd < 0)
+                continue;
+
+            if (this->m_groupFd < 0)
+                this->m_groupFd = fd;
+
+            this->m_fds[event] = fd;
+            this->m_readIndices[event] = this->m_numOpened++;
+        }
+
+        if (this->m_groupFd < 0) {
+            Logger::error("Cannot open any hardware performance counters, check /proc/sys/kernel/perf_event_paranoid!");
+            return false;
+        }
+
+        for (size_t event = 0; event < std::size(Events); event++) {
+            if (this->m_fds[event] < 0)
+                Logger::info("Hardware counter %s isn't available", getEventName(static_cast<PerfEvent>(event)));
+        }
+
+        return true;
+    }
+
+    void PerfCounters::close() {
+        for (auto &fd : this->m_fds) {
+            if (fd >= 0 && fd != this->m_groupFd)
+                ::close(fd);
+            fd = -1;
+        }
+
+        if (this->m_groupFd >= 0)
+            ::close(this->m_groupFd);
+
+        this->m_groupFd = -1;
+        this->m_numOpened = 0;
+    }
+
+    void PerfCounters::start() {
+        if (!this->isOpen())
+            return;
+
+        ::ioctl(this->m_groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(this->m_groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void PerfCounters::stop() {
+        if (this->isOpen())
+            ::ioctl(this->m_groupFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    bool PerfCounters::read(PerfCounterValues &values) {
+        values.fill(0);
+        if (!this->isOpen())
+            return false;
+
+        // { number of events, time enabled, time running, values... }
+        u64 buffer[3 + static_cast<size_t>(PerfEvent::Count)];
+        if (::read(this->m_groupFd, buffer, sizeof(buffer)) < static_cast<ssize_t>((3 + this->m_numOpened) * sizeof(u64)))
+            return false;
+
+        u64 timeEnabled = buffer[1];
+        u64 timeRunning = buffer[2];
+
+        for (size_t event = 0; event < values.size(); event++) {
+            if (this->m_fds[event] < 0)
+                continue;
+
+            u64 value = buffer[3 + this->m_readIndices[event]];
+            if (timeRunning != 0 && timeRunning < timeEnabled)
+                value = static_cast<u64>(double(value) * double(timeEnabled) / double(timeRunning));
+
+            values[event] = value;
+        }
+
+        return true;
+    }
+
+#else
+
+    bool PerfCounters::open() {
+        Logger::error("Hardware performance counters are only supported on Linux!");
+        return false;
+    }
+
+    void PerfCounters::close() {
+
+    }
+
+    void PerfCounters::start() {
+
+    }
+
+    void PerfCounters::stop() {
+
+    }
+
+    bool PerfCounters::read(PerfCounterValues &values) {
+        values.fill(0);
+        return false;
+    }
+
+#endif
+
+    bool PerfCounters::writeReport(const std::string &path, const PerfCounterValues &values, u64 ilInstructions) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        auto get = [&](PerfEvent event) { return double(values[static_cast<size_t>(event)]); };
+
+        std::fprintf(file, "{\n");
+        for (size_t event = 0; event < values.size(); event++) {
+            if (this->isAvailable(static_cast<PerfEvent>(event)))
+                std::fprintf(file, "  \"%s\": %llu,\n", getEventName(static_cast<PerfEvent>(event)), static_cast<unsigned long long>(values[event]));
+        }
+
+        if (this->isAvailable(PerfEvent::Instructions) && this->isAvailable(PerfEvent::Cycles) && get(PerfEvent::Cycles) > 0)
+            std::fprintf(file, "  \"instructions_per_cycle\": %.4f,\n", get(PerfEvent::Instructions) / get(PerfEvent::Cycles));
+
+        if (ilInstructions > 0) {
+            // Every IL instruction goes through the dispatch loop exactly once
+            std::fprintf(file, "  \"il_instructions\": %llu,\n", static_cast<unsigned long long>(ilInstructions));
+
+            if (this->isAvailable(PerfEvent::Instructions))
+                std::fprintf(file, "  \"instructions_per_il_instruction\": %.4f,\n", get(PerfEvent::Instructions) / ilInstructions);
+            if (this->isAvailable(PerfEvent::Cycles))
+                std::fprintf(file, "  \"cycles_per_il_instruction\": %.4f,\n", get(PerfEvent::Cycles) / ilInstructions);
+            if (this->isAvailable(PerfEvent::BranchMisses))
+                std::fprintf(file, "  \"branch_misses_per_dispatch\": %.6f,\n", get(PerfEvent::BranchMisses) / ilInstructions);
+        }
+
+        // Misses per thousand instructions
+        if (this->isAvailable(PerfEvent::Instructions) && get(PerfEvent::Instructions) > 0) {
+            for (auto event : { PerfEvent::L1DMisses, PerfEvent::LLCMisses, PerfEvent::DTLBMisses }) {
+                if (this->isAvailable(event))
+                    std::fprintf(file, "  \"%s_per_kilo_instruction\": %.4f,\n", getEventName(event), get(event) * 1000.0 / get(PerfEvent::Instructions));
+            }
+        }
+
+        std::fprintf(file, "  \"counters_available\": %u\n}\n", this->m_numOpened);
+        std::fclose(file);
+
+        return true;
+    }
+
+}
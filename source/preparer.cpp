@@ -0,0 +1,826 @@
+#include "preparer.hpp"
+
+#include "context.hpp"
+#include "dll.hpp"
+#include "intrinsics.hpp"
+#include "opcode.hpp"
+#include "tables.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "vectors.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ili {
+
+    static bool isShortBranch(OpcodePrefix opcode) {
+        return (opcode >= OpcodePrefix::Br_s && opcode <= OpcodePrefix::Blt_un_s) || opcode == OpcodePrefix::Leave_s;
+    }
+
+    static bool isLongBranch(OpcodePrefix opcode) {
+        return (opcode >= OpcodePrefix::Br && opcode <= OpcodePrefix::Blt_un) || opcode == OpcodePrefix::Leave;
+    }
+
+    // Instructions that never continue with the one after them
+    static bool isUnconditionalTransfer(OpcodePrefix opcode) {
+        switch (opcode) {
+            case OpcodePrefix::Ret:
+            case OpcodePrefix::Br:
+            case OpcodePrefix::Br_s:
+            case OpcodePrefix::Thrw:
+            case OpcodePrefix::Rethrow:
+            case OpcodePrefix::Leave:
+            case OpcodePrefix::Leave_s:
+            case OpcodePrefix::Endfinally:
+            case OpcodePrefix::Endfilter:
+            case OpcodePrefix::Jmp:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Index of the argument an ldarg, ldarga or starg refers to, -1 for every other instruction
+    static s32 getArgumentIndex(OpcodePrefix opcode, const u8 *operand) {
+        switch (opcode) {
+            case OpcodePrefix::Ldarg_0:
+            case OpcodePrefix::Ldarg_1:
+            case OpcodePrefix::Ldarg_2:
+            case OpcodePrefix::Ldarg_3:
+                return u16(opcode) - u16(OpcodePrefix::Ldarg_0);
+            case OpcodePrefix::Ldarg_s:
+            case OpcodePrefix::Ldarga_s:
+            case OpcodePrefix::Starg_s:
+                return operand[0];
+            case OpcodePrefix::Ldarg:
+            case OpcodePrefix::Ldarga:
+            case OpcodePrefix::Starg: {
+                u16 index;
+                std::memcpy(&index, operand, sizeof(u16));
+                return index;
+            }
+            default:
+                return -1;
+        }
+    }
+
+    // Index of the local an ldloc, ldloca or stloc refers to, -1 for every other instruction
+    static s32 getLocalIndex(OpcodePrefix opcode, const u8 *operand) {
+        switch (opcode) {
+            case OpcodePrefix::Ldloc_0:
+            case OpcodePrefix::Ldloc_1:
+            case OpcodePrefix::Ldloc_2:
+            case OpcodePrefix::Ldloc_3:
+                return u16(opcode) - u16(OpcodePrefix::Ldloc_0);
+            case OpcodePrefix::Stloc_0:
+            case OpcodePrefix::Stloc_1:
+            case OpcodePrefix::Stloc_2:
+            case OpcodePrefix::Stloc_3:
+                return u16(opcode) - u16(OpcodePrefix::Stloc_0);
+            case OpcodePrefix::Ldloc_s:
+            case OpcodePrefix::Ldloca_s:
+            case OpcodePrefix::Stloc_s:
+                return operand[0];
+            case OpcodePrefix::Ldloc:
+            case OpcodePrefix::Ldloca:
+            case OpcodePrefix::Stloc: {
+                u16 index;
+                std::memcpy(&index, operand, sizeof(u16));
+                return index;
+            }
+            default:
+                return -1;
+        }
+    }
+
+    // Value an ldc.i4 pushes, or -1 for every other instruction and negative constants
+    static s32 getNonNegativeConstant(OpcodePrefix opcode, const u8 *operand) {
+        s32 value = -1;
+
+        if (opcode >= OpcodePrefix::Ldc_i4_0 && opcode <= OpcodePrefix::Ldc_i4_8)
+            value = u16(opcode) - u16(OpcodePrefix::Ldc_i4_0);
+        else if (opcode == OpcodePrefix::Ldc_i4_s)
+            value = s8(operand[0]);
+        else if (opcode == OpcodePrefix::Ldc_i4)
+            std::memcpy(&value, operand, sizeof(s32));
+
+        return std::max(value, -1);
+    }
+
+    static bool isLoadLocal(OpcodePrefix opcode) {
+        return (opcode >= OpcodePrefix::Ldloc_0 && opcode <= OpcodePrefix::Ldloc_3) || opcode == OpcodePrefix::Ldloc_s || opcode == OpcodePrefix::Ldloc;
+    }
+
+    static bool isStoreLocal(OpcodePrefix opcode) {
+        return (opcode >= OpcodePrefix::Stloc_0 && opcode <= OpcodePrefix::Stloc_3) || opcode == OpcodePrefix::Stloc_s || opcode == OpcodePrefix::Stloc;
+    }
+
+    static bool isElementLoad(OpcodePrefix opcode) {
+        return (opcode >= OpcodePrefix::Ldelem_i1 && opcode <= OpcodePrefix::Ldelem_ref) || opcode == OpcodePrefix::Ldelem;
+    }
+
+    static bool isElementStore(OpcodePrefix opcode) {
+        return (opcode >= OpcodePrefix::Stelem_i && opcode <= OpcodePrefix::Stelem_ref) || opcode == OpcodePrefix::Stelem;
+    }
+
+    // Values popped and pushed by the instructions that can appear between an array access and the ldloc
+    // instructions that load its array and index. False for everything else, including all control flow
+    static bool getStackEffect(OpcodePrefix opcode, u8 &pops, u8 &pushes) {
+        pops = 0;
+        pushes = 1;
+
+        if (isLoadLocal(opcode) || (opcode >= OpcodePrefix::Ldarg_0 && opcode <= OpcodePrefix::Ldarg_3) || opcode == OpcodePrefix::Ldarg_s || opcode == OpcodePrefix::Ldarg
+                || (opcode >= OpcodePrefix::Ldnull && opcode <= OpcodePrefix::Ldc_r8) || opcode == OpcodePrefix::Ldstr || opcode == OpcodePrefix::Ldsfld)
+            return true;
+
+        if (isStoreLocal(opcode) || opcode == OpcodePrefix::Pop || opcode == OpcodePrefix::Stsfld) {
+            pops = 1;
+            pushes = 0;
+            return true;
+        }
+
+        if ((opcode >= OpcodePrefix::Add && opcode <= OpcodePrefix::Shr_un) || (opcode >= OpcodePrefix::Ceq && opcode <= OpcodePrefix::Clt_un)
+                || isElementLoad(opcode) || opcode == OpcodePrefix::Ldelema) {
+            pops = 2;
+            return true;
+        }
+
+        if (opcode == OpcodePrefix::Neg || opcode == OpcodePrefix::Logical_not || (opcode >= OpcodePrefix::Conv_i1 && opcode <= OpcodePrefix::Conv_u8)
+                || (opcode >= OpcodePrefix::Conv_u2 && opcode <= OpcodePrefix::Conv_i) || opcode == OpcodePrefix::Conv_u
+                || opcode == OpcodePrefix::Ldlen || opcode == OpcodePrefix::Ldfld) {
+            pops = 1;
+            return true;
+        }
+
+        if (opcode == OpcodePrefix::Dup) {
+            pops = 1;
+            pushes = 2;
+            return true;
+        }
+
+        if (isElementStore(opcode)) {
+            pops = 3;
+            pushes = 0;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Gives a method its own copy of the IL before the first instruction in it gets rewritten
+    static void makeCodeWritable(PreparedMethod *method) {
+        if (method->ownedCode != nullptr)
+            return;
+
+        method->ownedCode = std::make_unique<u8[]>(method->codeSize);
+        std::memcpy(method->ownedCode.get(), method->code, method->codeSize);
+        method->code = method->ownedCode.get();
+    }
+
+    Preparer::Preparer(DLL *dll) : m_dll(dll), m_preparedMethods(dll->getNumTableRows(TABLE_ID_METHODDEF)) {
+        this->m_reachable.resize(this->m_preparedMethods.size(), false);
+    }
+
+    Preparer::~Preparer() {
+        this->stopBackgroundPreparation();
+
+        for (auto &preparedMethod : this->m_preparedMethods)
+            delete preparedMethod.load();
+
+        for (auto instantiatedMethod : this->m_instantiatedMethods)
+            delete instantiatedMethod;
+    }
+
+    PreparedMethod* Preparer::getPreparedMethod(u32 methodToken) {
+        if (TABLE_ID(methodToken) != TABLE_ID_METHODDEF || TABLE_INDEX(methodToken) == 0 || TABLE_INDEX(methodToken) > this->m_preparedMethods.size()) {
+            Logger::error(LogCategory::Preparer, "Invalid method token (0x%08x)!", methodToken);
+            exit(1);
+        }
+
+        u32 index = TABLE_INDEX(methodToken) - 1;
+
+        // Every call after the first one only takes this path
+        PreparedMethod *preparedMethod = this->m_preparedMethods[index].load(std::memory_order_acquire);
+        if (preparedMethod != nullptr)
+            return preparedMethod;
+
+        // Not prepared yet. Do it right here instead of waiting for a worker that might be busy with something else
+        u32 root = methodToken;
+        this->markReachable({ &root, 1 });
+
+        if (this->m_metrics != nullptr)
+            this->m_metrics->add(Metrics::InlinePreparations);
+
+        this->install(methodToken, this->prepare(methodToken));
+
+        return this->m_preparedMethods[index].load(std::memory_order_acquire);
+    }
+
+    // Instantiations are prepared on the calling thread the first time they're needed. Which instantiations share one
+    // is up to the caller
+    PreparedMethod* Preparer::prepareInstantiation(u32 methodToken, const GenericContext &genericContext) {
+        PreparedMethod *preparedMethod = this->prepare(methodToken, &genericContext);
+
+        {
+            std::scoped_lock lock(this->m_mutex);
+            this->m_instantiatedMethods.push_back(preparedMethod);
+        }
+
+        if (this->m_metrics != nullptr) {
+            this->m_metrics->add(Metrics::InlinePreparations);
+            this->m_metrics->add(Metrics::GenericInstantiations);
+        }
+
+        return preparedMethod;
+    }
+
+    void Preparer::addRoot(u32 methodToken) {
+        this->markReachable({ &methodToken, 1 });
+    }
+
+    bool Preparer::isReachable(u32 methodToken) {
+        std::scoped_lock lock(this->m_mutex);
+
+        return this->m_reachable[TABLE_INDEX(methodToken) - 1];
+    }
+
+    void Preparer::setMetrics(Metrics *metrics) {
+        this->m_metrics = metrics;
+    }
+
+    void Preparer::startBackgroundPreparation(u32 numWorkers) {
+        if (!this->m_workers.empty())
+            return;
+
+        // Leave one core for the interpreter itself
+        if (numWorkers == 0)
+            numWorkers = std::max(std::thread::hardware_concurrency(), 2U) - 1;
+
+        this->m_stopWorkers = false;
+        for (u32 i = 0; i < numWorkers; i++)
+            this->m_workers.emplace_back(&Preparer::backgroundWorker, this);
+
+        Logger::debug(LogCategory::Preparer, "Started %u preparation workers", numWorkers);
+    }
+
+    void Preparer::stopBackgroundPreparation() {
+        if (this->m_workers.empty())
+            return;
+
+        {
+            std::scoped_lock lock(this->m_mutex);
+            this->m_stopWorkers = true;
+        }
+
+        this->m_worklistSignal.notify_all();
+
+        for (auto &worker : this->m_workers)
+            worker.join();
+        this->m_workers.clear();
+    }
+
+    void Preparer::markReachable(std::span<const u32> methodTokens) {
+        std::scoped_lock lock(this->m_mutex);
+
+        for (u32 methodToken : methodTokens) {
+            u32 index = TABLE_INDEX(methodToken) - 1;
+
+            if (this->m_reachable[index])
+                continue;
+
+            this->m_reachable[index] = true;
+            this->m_reachableWorklist.push_back(methodToken);
+            this->m_worklistSignal.notify_one();
+        }
+    }
+
+    // Publishes a prepared method without taking any lock. Methods are never replaced, if a worker and the interpreter
+    // both prepared one, whoever finished last throws their copy away
+    void Preparer::install(u32 methodToken, PreparedMethod *preparedMethod) {
+        PreparedMethod *current = nullptr;
+        if (!this->m_preparedMethods[TABLE_INDEX(methodToken) - 1].compare_exchange_strong(current, preparedMethod, std::memory_order_acq_rel, std::memory_order_acquire))
+            delete preparedMethod;
+    }
+
+    PreparedMethod* Preparer::prepare(u32 methodToken, const GenericContext *genericContext) {
+        auto preparedMethod = new PreparedMethod();
+        preparedMethod->token = methodToken;
+
+        // Instantiations over value types get their signature and locals laid out for those types
+        if (genericContext != nullptr)
+            preparedMethod->genericContext = *genericContext;
+
+        bool validSignature = this->m_dll->decodeMethodSignature(methodToken, preparedMethod->signature, genericContext);
+        if (!validSignature && Logger::isEnabled(LogLevel::Debug, LogCategory::Preparer))
+            Logger::debug(LogCategory::Preparer, "Method '%s' has a signature that can't be called yet", this->m_dll->getString(this->m_dll->getMethodDefByMetadataToken(methodToken)->nameIndex));
+
+        const method_body_t *methodBody = this->m_dll->getMethodBody(methodToken);
+        if (methodBody->codeOffset == 0) {
+            Logger::debug(LogCategory::Preparer, "Method '%s' has no body", this->m_dll->getString(this->m_dll->getMethodDefByMetadataToken(methodToken)->nameIndex));
+            return preparedMethod;
+        }
+
+        preparedMethod->code = OFFSET(this->m_dll->getData(), methodBody->codeOffset);
+        preparedMethod->codeSize = methodBody->codeSize;
+        preparedMethod->maxStack = methodBody->maxStack;
+        preparedMethod->localVarSigToken = methodBody->localVarSigToken;
+
+        bool validClauses = this->m_dll->decodeExceptionClauses(methodToken, preparedMethod->exceptionClauses);
+        if (!validClauses && Logger::isEnabled(LogLevel::Debug, LogCategory::Preparer))
+            Logger::debug(LogCategory::Preparer, "Method '%s' has a malformed exception handling table", this->m_dll->getString(this->m_dll->getMethodDefByMetadataToken(methodToken)->nameIndex));
+
+        preparedMethod->verified = validSignature && validClauses && this->verify(preparedMethod) && this->layOutLocals(preparedMethod);
+
+        if (preparedMethod->verified) {
+            u32 numEliminated = this->eliminateBoundsChecks(preparedMethod);
+            u32 numReplaced = this->replaceIntrinsics(preparedMethod);
+
+            if (this->m_metrics != nullptr) {
+                this->m_metrics->add(Metrics::EliminatedBoundsChecks, numEliminated);
+                this->m_metrics->add(Metrics::ReplacedIntrinsics, numReplaced);
+            }
+        }
+
+        // Everything this method can call is reachable now, though it only gets prepared on the first
+        // call to it or when a worker gets to it
+        this->markReachable(preparedMethod->callees);
+
+        if (Logger::isEnabled(LogLevel::Debug, LogCategory::Preparer))
+            Logger::debug(LogCategory::Preparer, "Prepared method '%s' (%u bytes of IL, %u callees)", this->m_dll->getString(this->m_dll->getMethodDefByMetadataToken(methodToken)->nameIndex),
+                          preparedMethod->codeSize, u32(preparedMethod->callees.size()));
+
+        return preparedMethod;
+    }
+
+    bool Preparer::verify(PreparedMethod *method) {
+        std::vector<bool> instructionStarts(method->codeSize, false);
+        std::vector<s64> branchTargets;
+        auto lastOpcode = OpcodePrefix::Nop;
+
+        u32 offset = 0;
+        while (offset < method->codeSize) {
+            u32 instructionStart = offset;
+            instructionStarts[instructionStart] = true;
+
+            u16 opcodeValue = method->code[offset++];
+            if (opcodeValue == 0xFE) {
+                if (offset >= method->codeSize) {
+                    Logger::debug(LogCategory::Preparer, "Truncated opcode at IL_%04x", instructionStart);
+                    return false;
+                }
+
+                opcodeValue = 0xFE00 | method->code[offset++];
+            }
+
+            auto opcode = static_cast<OpcodePrefix>(opcodeValue);
+            u32 nextInstruction = offset + getOpcodeOperandSize(opcode);
+
+            // Internal opcodes may only come from the Preparer's own rewrites
+            if (isInternalOpcode(opcode)) {
+                Logger::debug(LogCategory::Preparer, "Invalid opcode 0x%02x at IL_%04x", opcodeValue, instructionStart);
+                return false;
+            }
+
+            if (nextInstruction > method->codeSize) {
+                Logger::debug(LogCategory::Preparer, "Truncated operand at IL_%04x", instructionStart);
+                return false;
+            }
+
+            if (opcode == OpcodePrefix::Swtch) {
+                u32 numTargets;
+                std::memcpy(&numTargets, &method->code[offset], sizeof(u32));
+
+                u32 jumpTable = nextInstruction;
+                if (numTargets > (method->codeSize - jumpTable) / sizeof(s32)) {
+                    Logger::debug(LogCategory::Preparer, "Truncated switch table at IL_%04x", instructionStart);
+                    return false;
+                }
+
+                nextInstruction += numTargets * sizeof(s32);
+                for (u32 i = 0; i < numTargets; i++) {
+                    s32 target;
+                    std::memcpy(&target, &method->code[jumpTable + i * sizeof(s32)], sizeof(s32));
+                    branchTargets.push_back(s64(nextInstruction) + target);
+                }
+            } else if (isShortBranch(opcode)) {
+                branchTargets.push_back(s64(nextInstruction) + s8(method->code[offset]));
+            } else if (isLongBranch(opcode)) {
+                s32 target;
+                std::memcpy(&target, &method->code[offset], sizeof(s32));
+                branchTargets.push_back(s64(nextInstruction) + target);
+            } else if (auto local = getLocalIndex(opcode, &method->code[offset]); local >= 0) {
+                // Frames only get room for the locals that are actually used
+                method->numLocals = std::max<u16>(method->numLocals, local + 1);
+            } else if (auto argument = getArgumentIndex(opcode, &method->code[offset]); argument >= 0) {
+                // Arguments are accessed without bounds checks while running
+                if (argument >= method->signature.getNumParameters()) {
+                    Logger::debug(LogCategory::Preparer, "Access to argument %d of %u at IL_%04x", argument, method->signature.getNumParameters(), instructionStart);
+                    return false;
+                }
+            } else if (opcode == OpcodePrefix::Call || opcode == OpcodePrefix::Callvirt || opcode == OpcodePrefix::Newobj
+                    || opcode == OpcodePrefix::Jmp || opcode == OpcodePrefix::Ldftn || opcode == OpcodePrefix::Ldvirtftn) {
+                u32 token;
+                std::memcpy(&token, &method->code[offset], sizeof(u32));
+
+                if (TABLE_ID(token) == TABLE_ID_METHODDEF) {
+                    if (TABLE_INDEX(token) == 0 || TABLE_INDEX(token) > this->m_preparedMethods.size()) {
+                        Logger::debug(LogCategory::Preparer, "Invalid method token 0x%08x at IL_%04x", token, instructionStart);
+                        return false;
+                    }
+
+                    method->callees.push_back(token);
+
+                    // Lay out every type the method can instantiate
+                    if (opcode == OpcodePrefix::Newobj)
+                        this->m_dll->getObjectSize(this->m_dll->findTypeDefWithMethod(token));
+                }
+
+                method->stackSlotSize = std::max(method->stackSlotSize, this->getValueWidth(method, opcode, token));
+            } else if (opcode == OpcodePrefix::Ldobj || opcode == OpcodePrefix::Ldelem || opcode == OpcodePrefix::Unbox_any
+                    || opcode == OpcodePrefix::Ldfld || opcode == OpcodePrefix::Ldsfld) {
+                u32 token;
+                std::memcpy(&token, &method->code[offset], sizeof(u32));
+
+                method->stackSlotSize = std::max(method->stackSlotSize, this->getValueWidth(method, opcode, token));
+            }
+
+            lastOpcode = opcode;
+            offset = nextInstruction;
+        }
+
+        // Execution never runs past the end of the code, which also lets the interpreter peek at the next instruction
+        if (!isUnconditionalTransfer(lastOpcode)) {
+            Logger::debug(LogCategory::Preparer, "Execution can run past the end of the code");
+            return false;
+        }
+
+        for (s64 target : branchTargets) {
+            if (target < 0 || target >= method->codeSize || !instructionStarts[target]) {
+                Logger::debug(LogCategory::Preparer, "Branch to IL_%04llx doesn't land on an instruction", target);
+                return false;
+            }
+        }
+
+        // Handlers are entered and searched without any further checks
+        auto isBoundary = [&](u32 offset) { return offset == method->codeSize || (offset < method->codeSize && instructionStarts[offset]); };
+        for (auto &clause : method->exceptionClauses) {
+            bool validFilter = clause.kind != ExceptionClauseKind::Filter || (clause.filterStart < clause.handlerStart && isBoundary(clause.filterStart));
+
+            if (clause.tryStart >= clause.tryEnd || clause.handlerStart >= clause.handlerEnd || !validFilter
+                    || !isBoundary(clause.tryStart) || !isBoundary(clause.tryEnd) || !isBoundary(clause.handlerStart) || !isBoundary(clause.handlerEnd)) {
+                Logger::debug(LogCategory::Preparer, "Exception clause protecting IL_%04x doesn't line up with the instructions", clause.tryStart);
+                return false;
+            }
+        }
+
+        std::sort(method->callees.begin(), method->callees.end());
+        method->callees.erase(std::unique(method->callees.begin(), method->callees.end()), method->callees.end());
+
+        return true;
+    }
+
+    // Room on the evaluation stack the widest value an instruction leaves there or passes on needs. Vectors and
+    // structs don't fit into the default slot
+    u32 Preparer::getValueWidth(PreparedMethod *method, OpcodePrefix opcode, u32 token) {
+        auto getWidth = [](Type type, const TypeLayout *valueType) -> u32 {
+            if (type == Type::ValueType && valueType != nullptr)
+                return valueType->size + sizeof(u32);
+
+            return getTypeSize(type);
+        };
+
+        auto genericContext = method->genericContext.empty() ? nullptr : &method->genericContext;
+
+        switch (opcode) {
+            case OpcodePrefix::Ldfld:
+            case OpcodePrefix::Ldsfld: {
+                auto field = this->m_dll->getFieldLayout(token, genericContext);
+                return field != nullptr ? getWidth(field->value.type, field->value.valueType) : 0;
+            }
+            case OpcodePrefix::Ldobj:
+            case OpcodePrefix::Ldelem:
+            case OpcodePrefix::Unbox_any: {
+                ValueLayout layout;
+                return this->m_dll->getValueLayout(token, layout, genericContext) ? getWidth(layout.type, layout.valueType) : 0;
+            }
+            default:
+                break;
+        }
+
+        // Calls from an instantiation can refer to its type arguments, those get resolved the way the interpreter does
+        u32 methodDefToken = token;
+        GenericContext calleeContext;
+        bool instantiated = TABLE_ID(token) != TABLE_ID_METHODDEF && this->m_dll->resolveInstantiation(token, genericContext, methodDefToken, calleeContext) && methodDefToken != 0;
+        if (!instantiated)
+            methodDefToken = token;
+
+        MethodSignature signature;
+        bool validSignature = instantiated ? this->m_dll->decodeMethodSignature(methodDefToken, signature, &calleeContext) : this->m_dll->decodeMethodSignature(token, signature);
+        if (!validSignature)
+            return 0;
+
+        u32 width = getWidth(signature.returnType, signature.returnValueType);
+        for (auto &parameter : signature.parameters)
+            width = std::max(width, getWidth(parameter.type, parameter.valueType));
+
+        if (opcode != OpcodePrefix::Newobj)
+            return width;
+
+        // Constructed vectors and structs are held on the stack behind the arguments, structs with the pointer passed as this
+        u32 memberRefToken = TABLE_ID(token) == TABLE_ID_METHODSPEC ? this->m_dll->getMethodSpecMethod(token) : token;
+        if (TABLE_ID(memberRefToken) == TABLE_ID_MEMBERREF && TABLE_INDEX(memberRefToken) != 0 && TABLE_INDEX(memberRefToken) <= this->m_dll->getNumTableRows(TABLE_ID_MEMBERREF)) {
+            u16 parent = this->m_dll->getMemberRefByMetadataToken(memberRefToken)->classIndex;
+            if (INDEX_TAG(parent, MEMBER_REF_PARENT) == 4 && this->m_dll->isVectorType((TABLE_ID_TYPESPEC << 24) | INDEX_INDEX(parent, MEMBER_REF_PARENT))) // TypeSpec
+                width = std::max<u32>(width, sizeof(VectorValue));
+        }
+
+        if (TABLE_ID(methodDefToken) == TABLE_ID_METHODDEF) {
+            u32 typeIndex = this->m_dll->findTypeDefWithMethod(methodDefToken);
+            auto typeLayout = this->m_dll->getTypeLayout((TABLE_ID_TYPEDEF << 24) | typeIndex);
+            if (instantiated && !calleeContext.typeArguments.empty())
+                typeLayout = this->m_dll->getInstantiationLayout(typeIndex, calleeContext);
+
+            if (typeLayout != nullptr && typeLayout->isValueType)
+                width = std::max<u32>(width, typeLayout->size + sizeof(u32) + sizeof(u64));
+        }
+
+        return width;
+    }
+
+    // Locals get a Variable each, with the values of vector and struct locals behind them as they're too wide for it
+    bool Preparer::layOutLocals(PreparedMethod *method) {
+        std::vector<Type> localTypes;
+        std::vector<const TypeLayout*> valueTypes;
+        if (!this->m_dll->decodeLocalTypes(method->localVarSigToken, localTypes, &method->genericContext, &valueTypes)) {
+            Logger::debug(LogCategory::Preparer, "Malformed local variable signature 0x%08x", method->localVarSigToken);
+            return false;
+        }
+
+        for (u16 local = 0; local < method->numLocals && local < localTypes.size(); local++) {
+            if (localTypes[local] == Type::Vector)
+                method->vectorLocals.push_back(local);
+        }
+
+        method->localsSize = method->numLocals * sizeof(Variable<u64>) + method->vectorLocals.size() * sizeof(VectorValue);
+
+        // Structs are kept 8 byte aligned, their fields are only ever accessed through memcpy
+        for (u16 local = 0; local < method->numLocals && local < localTypes.size(); local++) {
+            if (localTypes[local] != Type::ValueType)
+                continue;
+
+            method->valueTypeLocals.push_back({ local, method->localsSize });
+            method->localsSize += (valueTypes[local]->size + alignof(u64) - 1) & ~u32(alignof(u64) - 1);
+            method->stackSlotSize = std::max<u32>(method->stackSlotSize, valueTypes[local]->size + sizeof(u32));
+        }
+
+        method->localTypes = std::move(localTypes);
+        method->localTypes.resize(method->numLocals, Type::Invalid);
+        method->localLayouts = std::move(valueTypes);
+        method->localLayouts.resize(method->numLocals, nullptr);
+
+        bool vectorParameters = std::any_of(method->signature.parameters.begin(), method->signature.parameters.end(), [](auto &parameter) { return parameter.type == Type::Vector; });
+        if (!method->vectorLocals.empty() || vectorParameters || method->signature.returnType == Type::Vector)
+            method->stackSlotSize = std::max<u32>(method->stackSlotSize, sizeof(VectorValue));
+
+        for (auto &parameter : method->signature.parameters) {
+            if (parameter.type == Type::ValueType)
+                method->stackSlotSize = std::max<u32>(method->stackSlotSize, parameter.valueType->size + sizeof(u32));
+        }
+        if (method->signature.returnType == Type::ValueType)
+            method->stackSlotSize = std::max<u32>(method->stackSlotSize, method->signature.returnValueType->size + sizeof(u32));
+
+        return true;
+    }
+
+    // Rewrites element accesses inside loops of the form
+    //     for (int i = <constant >= 0>; i < array.Length; i++) ... array[i] ...
+    // into variants without null and bounds checks. That only holds if neither i nor array can change anywhere
+    // else and the loop can't be entered without going through its condition first
+    u32 Preparer::eliminateBoundsChecks(PreparedMethod *method) {
+        struct Instruction {
+            u32 offset;
+            OpcodePrefix opcode;
+            const u8 *operand;
+        };
+
+        std::vector<Instruction> instructions;
+        std::vector<s32> instructionIndices(method->codeSize + 1, -1);
+        std::vector<std::pair<u32, s64>> branches;     // Index of the instruction and the offset it branches to
+        std::vector<bool> branchTargets(method->codeSize, false);
+        std::vector<bool> addressTaken(method->numLocals, false);
+
+        // The code was verified already, so nothing here can run past its end
+        u32 offset = 0;
+        while (offset < method->codeSize) {
+            u32 instructionStart = offset;
+            u16 opcodeValue = method->code[offset++];
+            if (opcodeValue == 0xFE)
+                opcodeValue = 0xFE00 | method->code[offset++];
+
+            auto opcode = static_cast<OpcodePrefix>(opcodeValue);
+            const u8 *operand = &method->code[offset];
+            offset += getOpcodeOperandSize(opcode);
+
+            u32 index = instructions.size();
+            instructionIndices[instructionStart] = index;
+            instructions.push_back({ instructionStart, opcode, operand });
+
+            if (opcode == OpcodePrefix::Swtch) {
+                u32 numTargets;
+                std::memcpy(&numTargets, operand, sizeof(u32));
+
+                const u8 *jumpTable = &method->code[offset];
+                offset += numTargets * sizeof(s32);
+                for (u32 i = 0; i < numTargets; i++) {
+                    s32 target;
+                    std::memcpy(&target, jumpTable + i * sizeof(s32), sizeof(s32));
+                    branches.emplace_back(index, s64(offset) + target);
+                }
+            } else if (isShortBranch(opcode)) {
+                branches.emplace_back(index, s64(offset) + s8(operand[0]));
+            } else if (isLongBranch(opcode)) {
+                s32 target;
+                std::memcpy(&target, operand, sizeof(s32));
+                branches.emplace_back(index, s64(offset) + target);
+            } else if (opcode == OpcodePrefix::Ldloca_s || opcode == OpcodePrefix::Ldloca) {
+                addressTaken[getLocalIndex(opcode, operand)] = true;
+            }
+        }
+        instructionIndices[method->codeSize] = instructions.size();
+
+        for (auto [source, target] : branches)
+            branchTargets[target] = true;
+
+        auto loadsLocal = [&](u32 index, s32 local) {
+            return isLoadLocal(instructions[index].opcode) && getLocalIndex(instructions[index].opcode, instructions[index].operand) == local;
+        };
+        auto storesLocal = [&](u32 index, s32 local) {
+            return isStoreLocal(instructions[index].opcode) && getLocalIndex(instructions[index].opcode, instructions[index].operand) == local;
+        };
+
+        u32 numEliminated = 0;
+        for (u32 loopEnd = 4; loopEnd < instructions.size(); loopEnd++) {
+            auto &backEdge = instructions[loopEnd];
+            if (backEdge.opcode != OpcodePrefix::Blt_s && backEdge.opcode != OpcodePrefix::Blt)
+                continue;
+
+            // i < array.Length as the condition at the bottom of the loop
+            u32 condition = loopEnd - 4;
+            auto &loadIndex = instructions[condition];
+            auto &loadArray = instructions[condition + 1];
+            if (!isLoadLocal(loadIndex.opcode) || !isLoadLocal(loadArray.opcode)
+                    || instructions[condition + 2].opcode != OpcodePrefix::Ldlen || instructions[condition + 3].opcode != OpcodePrefix::Conv_i4)
+                continue;
+
+            s32 indexLocal = getLocalIndex(loadIndex.opcode, loadIndex.operand);
+            s32 arrayLocal = getLocalIndex(loadArray.opcode, loadArray.operand);
+            if (indexLocal == arrayLocal || addressTaken[indexLocal] || addressTaken[arrayLocal])
+                continue;
+
+            s64 bodyOffset = std::find_if(branches.begin(), branches.end(), [&](auto &branch) { return branch.first == loopEnd; })->second;
+            if (bodyOffset >= loadIndex.offset)
+                continue;
+            u32 body = instructionIndices[bodyOffset];
+
+            // i++ right before the condition, i = constant and a jump to the condition right before the body
+            u32 increment = condition - 4;
+            if (condition < body + 4 || body < 3 || !loadsLocal(increment, indexLocal) || instructions[increment + 1].opcode != OpcodePrefix::Ldc_i4_1
+                    || instructions[increment + 2].opcode != OpcodePrefix::Add || !storesLocal(increment + 3, indexLocal))
+                continue;
+
+            u32 entry = body - 1;
+            if ((instructions[entry].opcode != OpcodePrefix::Br_s && instructions[entry].opcode != OpcodePrefix::Br) || !storesLocal(entry - 1, indexLocal)
+                    || getNonNegativeConstant(instructions[entry - 2].opcode, instructions[entry - 2].operand) < 0
+                    || branchTargets[instructions[entry].offset] || branchTargets[instructions[entry - 1].offset])
+                continue;
+
+            // The only way into the loop from outside is the jump to its condition
+            u32 loopStart = instructions[body].offset;
+            u32 loopEndOffset = loopEnd + 1 < instructions.size() ? instructions[loopEnd + 1].offset : method->codeSize;
+            auto isInLoop = [&](s64 offset) { return offset >= loopStart && offset < loopEndOffset; };
+
+            bool singleEntry = std::all_of(branches.begin(), branches.end(), [&](auto &branch) {
+                return !isInLoop(branch.second) || (branch.first >= body && branch.first <= loopEnd) || (branch.first == entry && branch.second == loadIndex.offset);
+            });
+
+            // Handlers inside the loop may only be entered from a try block inside it
+            bool singleHandlerEntry = std::all_of(method->exceptionClauses.begin(), method->exceptionClauses.end(), [&](auto &clause) {
+                bool enteredInLoop = isInLoop(clause.handlerStart) || (clause.kind == ExceptionClauseKind::Filter && isInLoop(clause.filterStart));
+                return !enteredInLoop || (isInLoop(clause.tryStart) && clause.tryEnd <= loopEndOffset);
+            });
+
+            if (!singleEntry || !singleHandlerEntry)
+                continue;
+
+            bool invariant = true;
+            for (u32 i = body; i <= loopEnd; i++)
+                invariant &= (i == increment + 3 || !storesLocal(i, indexLocal)) && !storesLocal(i, arrayLocal);
+
+            if (!invariant)
+                continue;
+
+            // Between the condition and i++, 0 <= i < array.Length holds. Follow the stack from every ldloc array,
+            // ldloc i pair to the instruction that consumes them, without crossing into another basic block
+            for (u32 access = body; access + 1 < increment; access++) {
+                if (!loadsLocal(access, arrayLocal) || !loadsLocal(access + 1, indexLocal) || branchTargets[instructions[access + 1].offset])
+                    continue;
+
+                s32 depth = 2;
+                for (u32 i = access + 2; i < increment && !branchTargets[instructions[i].offset]; i++) {
+                    u8 pops, pushes;
+                    if (!getStackEffect(instructions[i].opcode, pops, pushes))
+                        break;
+
+                    if (depth - pops < 2) {
+                        bool consumesArrayAndIndex = (isElementLoad(instructions[i].opcode) && depth == 2) || (isElementStore(instructions[i].opcode) && depth == 3);
+                        if (consumesArrayAndIndex) {
+                            makeCodeWritable(method);
+                            method->ownedCode[instructions[i].offset] = u8(getUncheckedElementAccess(instructions[i].opcode));
+                            numEliminated++;
+                        }
+
+                        break;
+                    }
+
+                    depth = depth - pops + pushes;
+                }
+            }
+        }
+
+        return numEliminated;
+    }
+
+    // Turns calls to the library methods listed in Intrinsic into call.intrinsic. Both have a four byte operand, so
+    // only the opcode and the token get overwritten and every offset stays the same
+    u32 Preparer::replaceIntrinsics(PreparedMethod *method) {
+        u32 numReplaced = 0;
+
+        u32 offset = 0;
+        while (offset < method->codeSize) {
+            u32 instructionStart = offset;
+            u16 opcodeValue = method->code[offset++];
+            if (opcodeValue == 0xFE)
+                opcodeValue = 0xFE00 | method->code[offset++];
+
+            auto opcode = static_cast<OpcodePrefix>(opcodeValue);
+            u32 operand = offset;
+            offset += getOpcodeOperandSize(opcode);
+
+            if (opcode == OpcodePrefix::Swtch) {
+                u32 numTargets;
+                std::memcpy(&numTargets, &method->code[operand], sizeof(u32));
+                offset += numTargets * sizeof(s32);
+            } else if (opcode == OpcodePrefix::Call) {
+                u32 token;
+                std::memcpy(&token, &method->code[operand], sizeof(u32));
+
+                Intrinsic intrinsic = Intrinsics::find(this->m_dll, token);
+                if (intrinsic == Intrinsic::None)
+                    continue;
+
+                makeCodeWritable(method);
+                method->ownedCode[instructionStart] = u8(OpcodePrefix::Call_intrinsic);
+                std::memcpy(&method->ownedCode[operand], &intrinsic, sizeof(u32));
+                numReplaced++;
+            }
+        }
+
+        return numReplaced;
+    }
+
+    void Preparer::backgroundWorker() {
+        while (true) {
+            u32 methodToken;
+
+            {
+                std::unique_lock lock(this->m_mutex);
+                this->m_worklistSignal.wait(lock, [this] { return this->m_stopWorkers || !this->m_reachableWorklist.empty(); });
+
+                if (this->m_stopWorkers)
+                    break;
+
+                // Everything the interpreter might call next, in the order it was discovered
+                methodToken = this->m_reachableWorklist.front();
+                this->m_reachableWorklist.pop_front();
+            }
+
+            // The interpreter got to it first
+            if (this->m_preparedMethods[TABLE_INDEX(methodToken) - 1].load(std::memory_order_acquire) != nullptr)
+                continue;
+
+            // Preparation itself runs without holding any lock so all workers and the interpreter can make progress at once
+            auto preparedMethod = this->prepare(methodToken);
+
+            // Resolve the bodies of everything the method calls while still off the interpreter's thread
+            for (u32 callee : preparedMethod->callees)
+                this->m_dll->getMethodBody(callee);
+
+            if (this->m_metrics != nullptr)
+                this->m_metrics->add(Metrics::WorkerPreparations);
+
+            this->install(methodToken, preparedMethod);
+        }
+    }
+
+}
@@ -0,0 +1,211 @@
+#include "profiler.hpp"
+
+#include "dll.hpp"
+#include "opcode.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ili {
+
+    Profiler::Profiler(DLL *dll) : m_dll(dll) {
+        this->m_frames.reserve(0x100);
+        this->m_currentStack.reserve(0x100);
+    }
+
+    void Profiler::setPerfCounters(PerfCounters *counters) {
+        this->m_perfCounters = counters;
+    }
+
+    void Profiler::enterMethod(u32 token) {
+        PerfCounterValues counters = { };
+        if (this->m_perfCounters != nullptr)
+            this->m_perfCounters->read(counters);
+
+        u64 now = readTimestamp();
+
+        auto &stats = this->m_methods[token];
+        stats.calls++;
+        stats.activeCalls++;
+
+        if (!this->m_frames.empty()) {
+            auto &caller = this->m_frames.back();
+            stats.callSites[(u64(caller.token) << 32) | caller.instructionOffset]++;
+        }
+
+        this->m_frames.push_back({ token, now, 0, 0, counters, { }, NoOpcode, 0, 0, 0 });
+        this->m_currentStack.push_back(token);
+    }
+
+    void Profiler::exitMethod() {
+        u64 now = readTimestamp();
+
+        auto &frame = this->m_frames.back();
+        this->closeInstruction(frame, now);
+
+        u64 inclusiveCycles = now - frame.start;
+        u64 exclusiveCycles = inclusiveCycles - frame.childCycles;
+
+        auto &stats = this->m_methods[frame.token];
+        stats.exclusiveCycles += exclusiveCycles;
+        stats.instructions += frame.instructions;
+
+        PerfCounterValues inclusiveCounters = { };
+        if (this->m_perfCounters != nullptr) {
+            this->m_perfCounters->read(inclusiveCounters);
+
+            for (size_t event = 0; event < inclusiveCounters.size(); event++) {
+                inclusiveCounters[event] -= frame.startCounters[event];
+                stats.counters[event] += inclusiveCounters[event] - frame.childCounters[event];
+            }
+        }
+        if (--stats.activeCalls == 0)
+            stats.inclusiveCycles += inclusiveCycles;
+
+        this->m_stacks[this->m_currentStack] += exclusiveCycles;
+
+        this->m_frames.pop_back();
+        this->m_currentStack.pop_back();
+
+        // The time spent in here doesn't belong to the instruction that made the call
+        if (!this->m_frames.empty()) {
+            auto &caller = this->m_frames.back();
+            caller.childCycles += inclusiveCycles;
+            caller.instructionChildCycles += inclusiveCycles;
+
+            for (size_t event = 0; event < inclusiveCounters.size(); event++)
+                caller.childCounters[event] += inclusiveCounters[event];
+        }
+    }
+
+    std::string Profiler::getMethodName(DLL *dll, u32 token) {
+        if (TABLE_ID(token) == TABLE_ID_MEMBERREF) {
+            auto name = dll->getFullMethodName(token);
+            return name.empty() ? dll->getMemberRefName(token) : name;
+        }
+
+        if (TABLE_ID(token) == TABLE_ID_METHODSPEC)
+            return dll->getMethodSpecName(token);
+
+        auto methodDef = dll->getMethodDefByMetadataToken(token);
+        std::string name = dll->getString(methodDef->nameIndex);
+
+        if (u32 typeIndex = dll->findTypeDefWithMethod(token); typeIndex != 0) {
+            auto typeDef = dll->getTypeDefByIndex(typeIndex);
+            std::string nameSpace = dll->getString(typeDef->typeNamespaceIndex);
+            std::string typeName = dll->getString(typeDef->typeNameIndex);
+
+            name = (nameSpace.empty() ? typeName : nameSpace + "." + typeName) + "::" + name;
+        }
+
+        return name;
+    }
+
+    bool Profiler::writeReport(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        u64 totalCycles = 0;
+        for (auto &[token, stats] : this->m_methods)
+            totalCycles += stats.exclusiveCycles;
+        auto percentage = [totalCycles](u64 cycles) { return totalCycles == 0 ? 0.0 : 100.0 * double(cycles) / double(totalCycles); };
+
+        std::vector<u16> opcodes;
+        for (u16 opcode = 0; opcode < NumOpcodes; opcode++) {
+            if (this->m_opcodes[opcode].count > 0)
+                opcodes.push_back(opcode);
+        }
+        std::sort(opcodes.begin(), opcodes.end(), [this](u16 a, u16 b) { return this->m_opcodes[a].cycles > this->m_opcodes[b].cycles; });
+
+        std::fprintf(file, "Opcodes by exclusive time\n\n");
+        std::fprintf(file, "%-16s %14s %16s %12s %8s\n", "opcode", "count", "cycles", "cycles/op", "%");
+        for (u16 opcode : opcodes) {
+            auto &stats = this->m_opcodes[opcode];
+            const char *name = getOpcodeName(static_cast<OpcodePrefix>(opcode < 0x100 ? opcode : 0xFE00 | (opcode & 0xFF)));
+
+            std::fprintf(file, "%-16s %14llu %16llu %12.1f %7.2f%%\n", name,
+                         static_cast<unsigned long long>(stats.count), static_cast<unsigned long long>(stats.cycles),
+                         double(stats.cycles) / double(stats.count), percentage(stats.cycles));
+        }
+
+        std::vector<std::pair<u32, const MethodStats*>> methods;
+        for (auto &[token, stats] : this->m_methods)
+            methods.emplace_back(token, &stats);
+        std::sort(methods.begin(), methods.end(), [](auto &a, auto &b) { return a.second->exclusiveCycles > b.second->exclusiveCycles; });
+
+        std::fprintf(file, "\nMethods by exclusive time\n\n");
+        std::fprintf(file, "%-10s %10s %16s %16s %8s  %s\n", "token", "calls", "inclusive", "exclusive", "%", "method");
+        for (auto &[token, stats] : methods) {
+            std::fprintf(file, "0x%08x %10llu %16llu %16llu %7.2f%%  %s\n", token,
+                         static_cast<unsigned long long>(stats->calls), static_cast<unsigned long long>(stats->inclusiveCycles),
+                         static_cast<unsigned long long>(stats->exclusiveCycles), percentage(stats->exclusiveCycles),
+                         getMethodName(this->m_dll, token).c_str());
+
+            std::vector<std::pair<u64, u64>> callSites(stats->callSites.begin(), stats->callSites.end());
+            std::sort(callSites.begin(), callSites.end(), [](auto &a, auto &b) { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+
+            for (auto &[callSite, count] : callSites) {
+                std::fprintf(file, "%-10s %10llu    from %s+IL_%04x\n", "", static_cast<unsigned long long>(count),
+                             getMethodName(this->m_dll, callSite >> 32).c_str(), static_cast<u32>(callSite & 0xFFFF'FFFF));
+            }
+        }
+
+        if (this->m_perfCounters != nullptr)
+            this->writePerfCounterReport(file, methods);
+
+        std::fclose(file);
+
+        return true;
+    }
+
+    void Profiler::writePerfCounterReport(FILE *file, std::vector<std::pair<u32, const MethodStats*>> &methods) {
+        auto get = [](const MethodStats *stats, PerfEvent event) { return double(stats->counters[static_cast<size_t>(event)]); };
+        auto perInstruction = [](double value, u64 instructions) { return instructions == 0 ? 0.0 : value / double(instructions); };
+
+        std::sort(methods.begin(), methods.end(), [&](auto &a, auto &b) { return get(a.second, PerfEvent::Cycles) > get(b.second, PerfEvent::Cycles); });
+
+        std::fprintf(file, "\nHardware counters by method, exclusive\n\n");
+        std::fprintf(file, "%14s %14s %6s %12s %10s %10s %12s %12s %12s  %s\n", "instructions", "cycles", "IPC", "IL instrs", "instrs/IL", "bmiss/IL",
+                     "l1d misses", "llc misses", "dtlb misses", "method");
+
+        for (auto &[token, stats] : methods) {
+            double instructions = get(stats, PerfEvent::Instructions);
+            double cycles = get(stats, PerfEvent::Cycles);
+
+            std::fprintf(file, "%14.0f %14.0f %6.2f %12llu %10.2f %10.4f %12.0f %12.0f %12.0f  %s\n", instructions, cycles, cycles == 0 ? 0.0 : instructions / cycles,
+                         static_cast<unsigned long long>(stats->instructions), perInstruction(instructions, stats->instructions),
+                         perInstruction(get(stats, PerfEvent::BranchMisses), stats->instructions),
+                         get(stats, PerfEvent::L1DMisses), get(stats, PerfEvent::LLCMisses), get(stats, PerfEvent::DTLBMisses),
+                         getMethodName(this->m_dll, token).c_str());
+        }
+    }
+
+    // One line per call stack in the format flame graph tools expect: "root;caller;callee <cycles>"
+    bool Profiler::writeCollapsedStacks(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        std::unordered_map<u32, std::string> names;
+        for (auto &[stack, cycles] : this->m_stacks) {
+            std::string line;
+            for (u32 token : stack) {
+                auto [name, inserted] = names.try_emplace(token);
+                if (inserted)
+                    name->second = getMethodName(this->m_dll, token);
+
+                if (!line.empty())
+                    line += ';';
+                line += name->second;
+            }
+
+            std::fprintf(file, "%s %llu\n", line.c_str(), static_cast<unsigned long long>(cycles));
+        }
+
+        std::fclose(file);
+
+        return true;
+    }
+
+}
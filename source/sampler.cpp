@@ -0,0 +1,395 @@
+#include "sampler.hpp"
+
+#include "context.hpp"
+#include "dll.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+    #include <csignal>
+    #include <ctime>
+    #include <pthread.h>
+    #include <sys/time.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__)
+    #include <sys/syscall.h>
+
+    #if !defined(sigev_notify_thread_id)
+        #define sigev_notify_thread_id _sigev_un._tid
+    #endif
+#endif
+
+namespace ili {
+
+    std::atomic<Sampler*> Sampler::s_activeSampler = nullptr;
+
+    namespace {
+
+        // Just enough of the protobuf wire format to write pprof profiles
+        class ProtobufWriter {
+        public:
+            void writeVarint(u64 value) {
+                while (value >= 0x80) {
+                    this->m_data += static_cast<char>((value & 0x7F) | 0x80);
+                    value >>= 7;
+                }
+                this->m_data += static_cast<char>(value);
+            }
+
+            void writeVarintField(u32 field, u64 value) {
+                this->writeVarint(field << 3);
+                this->writeVarint(value);
+            }
+
+            void writeBytesField(u32 field, std::string_view bytes) {
+                this->writeVarint((field << 3) | 2);
+                this->writeVarint(bytes.size());
+                this->m_data += bytes;
+            }
+
+            void writePackedField(u32 field, const std::vector<u64> &values) {
+                ProtobufWriter packed;
+                for (u64 value : values)
+                    packed.writeVarint(value);
+
+                this->writeBytesField(field, packed.getData());
+            }
+
+            const std::string& getData() { return this->m_data; }
+
+        private:
+            std::string m_data;
+        };
+
+        // Field numbers of the pprof profile.proto messages
+        namespace pprof {
+            constexpr u32 ProfileSampleType = 1, ProfileSample = 2, ProfileLocation = 4, ProfileFunction = 5, ProfileStringTable = 6, ProfilePeriodType = 11, ProfilePeriod = 12;
+            constexpr u32 ValueTypeType = 1, ValueTypeUnit = 2;
+            constexpr u32 SampleLocationId = 1, SampleValue = 2;
+            constexpr u32 LocationId = 1, LocationAddress = 3, LocationLine = 4;
+            constexpr u32 LineFunctionId = 1, LineLine = 2;
+            constexpr u32 FunctionId = 1, FunctionName = 2, FunctionSystemName = 3, FunctionFilename = 4;
+        }
+
+        u64 getCurrentThreadId() {
+        #if defined(_WIN32)
+            return 0;
+        #else
+            return static_cast<u64>(pthread_self());
+        #endif
+        }
+
+    }
+
+    Sampler::Sampler(Context &ctx, const std::string &assemblyPath) : m_ctx(ctx), m_ring(std::make_unique<SampleRing>()) {
+        auto extension = assemblyPath.find_last_of('.');
+        auto pdbPath = (extension == std::string::npos ? assemblyPath : assemblyPath.substr(0, extension)) + ".pdb";
+
+        if (!this->m_pdb.open(pdbPath))
+            Logger::info(LogCategory::Metadata, "No debug symbols found at %s, samples won't have line numbers", pdbPath.c_str());
+    }
+
+    Sampler::~Sampler() {
+        this->stop();
+    }
+
+#if defined(_WIN32)
+
+    bool Sampler::start(u32 frequency) {
+        Logger::error("The sampling profiler isn't supported on Windows!");
+        return false;
+    }
+
+    void Sampler::stop() {
+
+    }
+
+#else
+
+    bool Sampler::start(u32 frequency) {
+        if (frequency == 0)
+            return false;
+
+        Sampler *expected = nullptr;
+        if (!s_activeSampler.compare_exchange_strong(expected, this)) {
+            Logger::error("Only one sampling profiler can be active at a time!");
+            return false;
+        }
+
+        this->m_frequency = frequency;
+        this->m_interpreterThread = getCurrentThreadId();
+
+        struct sigaction action = { };
+        action.sa_handler = handleSignal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, nullptr);
+
+        this->m_running = true;
+        this->m_aggregationThread = std::thread(&Sampler::aggregationWorker, this);
+
+        u64 interval = 1'000'000'000ULL / frequency;
+
+    #if defined(__linux__)
+        // Count CPU time of the interpreter thread only and deliver the signal right to it
+        clockid_t clock;
+        timer_t timer;
+        sigevent event = { };
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event.sigev_notify_thread_id = static_cast<pid_t>(::syscall(SYS_gettid));
+
+        if (pthread_getcpuclockid(pthread_self(), &clock) == 0 && timer_create(clock, &event, &timer) == 0) {
+            itimerspec timerSpec = { };
+            timerSpec.it_interval.tv_sec = interval / 1'000'000'000ULL;
+            timerSpec.it_interval.tv_nsec = interval % 1'000'000'000ULL;
+            timerSpec.it_value = timerSpec.it_interval;
+
+            timer_settime(timer, 0, &timerSpec, nullptr);
+            this->m_timer = timer;
+
+            return true;
+        }
+    #endif
+
+        // Process wide CPU timer. Signals that land on other threads are ignored by the handler
+        itimerval timerValue = { };
+        timerValue.it_interval.tv_sec = interval / 1'000'000'000ULL;
+        timerValue.it_interval.tv_usec = (interval % 1'000'000'000ULL) / 1000;
+        timerValue.it_value = timerValue.it_interval;
+        setitimer(ITIMER_PROF, &timerValue, nullptr);
+
+        return true;
+    }
+
+    void Sampler::stop() {
+        if (s_activeSampler.load() != this)
+            return;
+
+    #if defined(__linux__)
+        if (this->m_timer != nullptr) {
+            timer_delete(static_cast<timer_t>(this->m_timer));
+            this->m_timer = nullptr;
+        } else
+    #endif
+        {
+            itimerval timerValue = { };
+            setitimer(ITIMER_PROF, &timerValue, nullptr);
+        }
+
+        signal(SIGPROF, SIG_IGN);
+        s_activeSampler = nullptr;
+
+        this->m_running = false;
+        this->m_aggregationThread.join();
+        this->drainSamples();
+
+        if (u64 dropped = this->m_droppedSamples.load(); dropped > 0)
+            Logger::info("Dropped %llu samples because the aggregation couldn't keep up", dropped);
+    }
+
+#endif
+
+    u64 Sampler::getNumSamples() {
+        return this->m_numSamples;
+    }
+
+    u64 Sampler::getNumDroppedSamples() {
+        return this->m_droppedSamples.load();
+    }
+
+    void Sampler::handleSignal(int) {
+        Sampler *sampler = s_activeSampler.load(std::memory_order_acquire);
+        if (sampler == nullptr || sampler->m_interpreterThread != getCurrentThreadId())
+            return;
+
+        int savedErrno = errno;
+        sampler->takeSample();
+        errno = savedErrno;
+    }
+
+    // Runs inside the signal handler, so nothing in here may allocate or lock
+    void Sampler::takeSample() {
+        auto &ring = *this->m_ring;
+
+        u64 head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= SampleRing::NumSlots) {
+            this->m_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::atomic_signal_fence(std::memory_order_acquire);
+
+        auto &sample = ring.slots[head % SampleRing::NumSlots];
+        sample.depth = 0;
+        for (auto frame = this->m_ctx.currentFrame; frame != nullptr && sample.depth < MaxDepth; frame = frame->caller)
+            sample.frames[sample.depth++] = (u64(frame->methodToken) << 32) | u32(frame->programCounter - frame->code);
+
+        // Outside of any interpreted method, e.g. while loading the assembly
+        if (sample.depth == 0)
+            return;
+
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Sampler::drainSamples() {
+        auto &ring = *this->m_ring;
+
+        u64 tail = ring.tail.load(std::memory_order_relaxed);
+        u64 head = ring.head.load(std::memory_order_acquire);
+
+        for (; tail != head; tail++) {
+            auto &sample = ring.slots[tail % SampleRing::NumSlots];
+            this->m_stacks[std::vector<u64>(sample.frames, sample.frames + sample.depth)]++;
+            this->m_numSamples++;
+        }
+
+        ring.tail.store(tail, std::memory_order_release);
+    }
+
+    void Sampler::aggregationWorker() {
+        while (this->m_running.load(std::memory_order_acquire)) {
+            this->drainSamples();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    std::string Sampler::getFrameName(u64 frame) {
+        u32 token = frame >> 32;
+        std::string name = Profiler::getMethodName(this->m_ctx.dll, token);
+
+        if (auto location = this->m_pdb.getSourceLocation(token, frame & 0xFFFF'FFFF); location.has_value())
+            name += ":" + std::to_string(location->line);
+
+        return name;
+    }
+
+    // One line per call stack in the format flame graph tools expect: "root;caller;callee <samples>"
+    bool Sampler::writeCollapsedStacks(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        std::unordered_map<u64, std::string> names;
+        std::map<std::string, u64> lines;
+        for (auto &[stack, count] : this->m_stacks) {
+            std::string line;
+            for (auto frame = stack.rbegin(); frame != stack.rend(); frame++) {
+                auto [name, inserted] = names.try_emplace(*frame);
+                if (inserted)
+                    name->second = this->getFrameName(*frame);
+
+                if (!line.empty())
+                    line += ';';
+                line += name->second;
+            }
+
+            // Different IL offsets on the same lines end up being the same stack
+            lines[line] += count;
+        }
+
+        for (auto &[line, count] : lines)
+            std::fprintf(file, "%s %llu\n", line.c_str(), static_cast<unsigned long long>(count));
+
+        std::fclose(file);
+
+        return true;
+    }
+
+    bool Sampler::writeProfile(const std::string &path) {
+        std::vector<std::string> strings = { "" };
+        std::unordered_map<std::string, u64> stringIndices = { { "", 0 } };
+        auto getStringIndex = [&](const std::string &string) {
+            auto [entry, inserted] = stringIndices.try_emplace(string, strings.size());
+            if (inserted)
+                strings.push_back(string);
+            return entry->second;
+        };
+
+        ProtobufWriter profile;
+        u64 period = 1'000'000'000ULL / this->m_frequency;
+
+        // Every sample is counted once and weighted with the CPU time it stands for
+        for (auto [type, unit] : { std::pair { "samples", "count" }, std::pair { "cpu", "nanoseconds" } }) {
+            ProtobufWriter valueType;
+            valueType.writeVarintField(pprof::ValueTypeType, getStringIndex(type));
+            valueType.writeVarintField(pprof::ValueTypeUnit, getStringIndex(unit));
+            profile.writeBytesField(pprof::ProfileSampleType, valueType.getData());
+        }
+
+        std::unordered_map<u64, u64> locationIds;
+        std::unordered_map<u32, u64> functionIds;
+        for (auto &[stack, count] : this->m_stacks) {
+            std::vector<u64> locations;
+
+            for (u64 frame : stack) {
+                auto [location, newLocation] = locationIds.try_emplace(frame, locationIds.size() + 1);
+                locations.push_back(location->second);
+
+                if (!newLocation)
+                    continue;
+
+                u32 token = frame >> 32;
+                auto sourceLocation = this->m_pdb.getSourceLocation(token, frame & 0xFFFF'FFFF);
+
+                auto [function, newFunction] = functionIds.try_emplace(token, functionIds.size() + 1);
+                if (newFunction) {
+                    ProtobufWriter functionMessage;
+                    u64 name = getStringIndex(Profiler::getMethodName(this->m_ctx.dll, token));
+
+                    functionMessage.writeVarintField(pprof::FunctionId, function->second);
+                    functionMessage.writeVarintField(pprof::FunctionName, name);
+                    functionMessage.writeVarintField(pprof::FunctionSystemName, name);
+                    if (sourceLocation.has_value())
+                        functionMessage.writeVarintField(pprof::FunctionFilename, getStringIndex(sourceLocation->document));
+
+                    profile.writeBytesField(pprof::ProfileFunction, functionMessage.getData());
+                }
+
+                ProtobufWriter line;
+                line.writeVarintField(pprof::LineFunctionId, function->second);
+                if (sourceLocation.has_value())
+                    line.writeVarintField(pprof::LineLine, sourceLocation->line);
+
+                ProtobufWriter locationMessage;
+                locationMessage.writeVarintField(pprof::LocationId, location->second);
+                locationMessage.writeVarintField(pprof::LocationAddress, frame & 0xFFFF'FFFF);
+                locationMessage.writeBytesField(pprof::LocationLine, line.getData());
+
+                profile.writeBytesField(pprof::ProfileLocation, locationMessage.getData());
+            }
+
+            ProtobufWriter sample;
+            sample.writePackedField(pprof::SampleLocationId, locations);
+            sample.writePackedField(pprof::SampleValue, { count, count * period });
+            profile.writeBytesField(pprof::ProfileSample, sample.getData());
+        }
+
+        ProtobufWriter periodType;
+        periodType.writeVarintField(pprof::ValueTypeType, getStringIndex("cpu"));
+        periodType.writeVarintField(pprof::ValueTypeUnit, getStringIndex("nanoseconds"));
+        profile.writeBytesField(pprof::ProfilePeriodType, periodType.getData());
+        profile.writeVarintField(pprof::ProfilePeriod, period);
+
+        // The string table has to come last as strings are only collected while writing everything else
+        for (auto &string : strings)
+            profile.writeBytesField(pprof::ProfileStringTable, string);
+
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        std::fwrite(profile.getData().data(), 1, profile.getData().size(), file);
+        std::fclose(file);
+
+        return true;
+    }
+
+}
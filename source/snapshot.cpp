@@ -0,0 +1,305 @@
+#include "snapshot.hpp"
+
+#include "context.hpp"
+#include "dll.hpp"
+#include "native.hpp"
+#include "mapped_file.hpp"
+#include "logger.hpp"
+#include "arrays.hpp"
+#include "collections.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace ili {
+
+    static u64 alignUp(u64 value, u64 alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Calls addSlot with every slot of an allocation that holds a reference, going by its kind and layout
+    template<typename F>
+    static void forEachReferenceSlot(Context &ctx, const HeapReference &reference, F addSlot) {
+        u8 *data = reference.heapPointer;
+
+        switch (reference.kind) {
+            case AllocationKind::Object:
+            case AllocationKind::Internal: {
+                auto layout = reference.layout;
+                if (layout == nullptr && TABLE_ID(reference.typeToken) == TABLE_ID_TYPEDEF)
+                    layout = ctx.dll->getTypeLayout(reference.typeToken);
+
+                if (layout != nullptr) {
+                    for (u32 offset : layout->referenceOffsets)
+                        addSlot(data + offset);
+                } else if (reference.kind == AllocationKind::Object && reference.size >= sizeof(u64)) {
+                    // Objects of other assemblies only hold the pointer to their storage
+                    addSlot(data);
+                }
+                break;
+            }
+            case AllocationKind::Array: {
+                auto array = reinterpret_cast<array_object_t*>(data);
+                for (u32 i = 0; i < array->length; i++) {
+                    if (array->elementType == Type::O || array->elementType == Type::Pointer) {
+                        addSlot(Arrays::getElement(array, i));
+                    } else if (reference.layout != nullptr) {
+                        for (u32 offset : reference.layout->referenceOffsets)
+                            addSlot(Arrays::getElement(array, i) + offset);
+                    }
+                }
+                break;
+            }
+            case AllocationKind::List: {
+                auto list = reinterpret_cast<list_storage_t*>(data);
+                if (!list->references)
+                    break;
+
+                for (u32 i = 0; i < list->count; i++)
+                    addSlot(Collections::getElements(list) + size_t((list->head + i) % list->capacity) * sizeof(u64));
+                break;
+            }
+            case AllocationKind::HashTable: {
+                auto table = reinterpret_cast<hash_table_t*>(data);
+                for (u32 slot = 0; slot < table->capacity; slot++) {
+                    if (Collections::getStates(table)[slot] != SlotState::Full)
+                        continue;
+
+                    if (table->referenceKeys)
+                        addSlot(Collections::getKeys(table) + size_t(slot) * table->keySize);
+                    if (table->referenceValues)
+                        addSlot(Collections::getValues(table) + size_t(slot) * table->valueSize);
+                }
+                break;
+            }
+            case AllocationKind::String:
+                break;
+        }
+    }
+
+    // Whether count entries of the given size starting at offset lie within a file of fileSize bytes
+    static bool isSectionValid(u64 offset, u64 count, u64 entrySize, u64 fileSize) {
+        return offset <= fileSize && count <= (fileSize - offset) / entrySize;
+    }
+
+    bool Snapshot::capture(Context &ctx, const std::string &path) {
+        u64 heapStart = reinterpret_cast<u64>(ctx.heap);
+        u64 heapUsed = ctx.getUsedHeapSize();
+
+        // Empty objects sit right at the end of the used heap, so the end address is included as well
+        auto pointsIntoHeap = [&](u64 value) {
+            return value >= heapStart && value <= heapStart + heapUsed;
+        };
+
+        std::vector<snapshot_heap_reference_t> heapReferences;
+        std::vector<snapshot_static_t> statics;
+        std::vector<snapshot_fixup_t> fixups;
+        std::vector<u32> bindings;
+        std::vector<snapshot_interned_string_t> internedStrings;
+
+        for (auto &heapReference : ctx.heapReferences)
+            heapReferences.push_back({ static_cast<u64>(heapReference.heapPointer - ctx.heap), heapReference.size, heapReference.typeToken, heapReference.kind });
+
+        for (u64 i = 0; i < ctx.statics.size(); i++) {
+            auto &field = ctx.statics[i];
+            statics.push_back({ field.type, field.value });
+
+            if ((field.type == Type::O || field.type == Type::Pointer || field.type == Type::ValueType) && pointsIntoHeap(field.value))
+                fixups.push_back({ SnapshotRegion::Statics, i });
+        }
+
+        // Only slots that hold a reference get relocated, numbers that happen to look like a heap address stay as they are
+        for (auto &heapReference : ctx.heapReferences) {
+            forEachReferenceSlot(ctx, heapReference, [&](u8 *slot) {
+                u64 value;
+                std::memcpy(&value, slot, sizeof(u64));
+
+                if (pointsIntoHeap(value))
+                    fixups.push_back({ SnapshotRegion::Heap, static_cast<u64>(slot - ctx.heap) });
+            });
+        }
+
+        for (u32 i = 0; i < ctx.nativeBindings.size(); i++) {
+            if (ctx.nativeBindings[i] != nullptr)
+                bindings.push_back(NativeMethods::getBindingToken(ctx, i));
+        }
+
+        // Interned strings live in the heap image already, only the table pointing at them is needed
+        for (u32 i = 0; i < ctx.internedStrings.size(); i++) {
+            if (ctx.internedStrings[i] != nullptr)
+                internedStrings.push_back({ i, static_cast<u64>(reinterpret_cast<u8*>(ctx.internedStrings[i]) - ctx.heap) });
+        }
+
+        snapshot_header_t header = { 0 };
+        std::memcpy(header.magic, "ILIS", 4);
+        header.version = Snapshot::Version;
+        std::memcpy(header.mvid, ctx.dll->getMvid(), sizeof(header.mvid));
+        header.fileHash = ctx.dll->getFileHash();
+        header.heapBase = heapStart;
+        header.heapSize = ctx.heapSize;
+        header.heapUsed = heapUsed;
+        header.numHeapReferences = heapReferences.size();
+        header.numStatics = statics.size();
+        header.numFixups = fixups.size();
+        header.numBindings = bindings.size();
+        header.numInternedStrings = internedStrings.size();
+
+        header.heapReferencesOffset = sizeof(snapshot_header_t);
+        header.staticsOffset = header.heapReferencesOffset + heapReferences.size() * sizeof(snapshot_heap_reference_t);
+        header.fixupsOffset = header.staticsOffset + statics.size() * sizeof(snapshot_static_t);
+        header.bindingsOffset = header.fixupsOffset + fixups.size() * sizeof(snapshot_fixup_t);
+        header.internedStringsOffset = header.bindingsOffset + bindings.size() * sizeof(u32);
+        header.heapImageOffset = alignUp(header.internedStringsOffset + internedStrings.size() * sizeof(snapshot_interned_string_t), Snapshot::ImageAlignment);
+
+        // The heap image is padded to a full mapping granule so restoring never maps past the end of the file
+        std::vector<u8> data(header.heapImageOffset + alignUp(heapUsed, Snapshot::ImageAlignment), 0x00);
+        auto writeSection = [&data](u64 offset, const void *source, size_t size) {
+            if (size > 0)
+                std::memcpy(&data[offset], source, size);
+        };
+
+        writeSection(0, &header, sizeof(header));
+        writeSection(header.heapReferencesOffset, heapReferences.data(), heapReferences.size() * sizeof(snapshot_heap_reference_t));
+        writeSection(header.staticsOffset, statics.data(), statics.size() * sizeof(snapshot_static_t));
+        writeSection(header.fixupsOffset, fixups.data(), fixups.size() * sizeof(snapshot_fixup_t));
+        writeSection(header.bindingsOffset, bindings.data(), bindings.size() * sizeof(u32));
+        writeSection(header.internedStringsOffset, internedStrings.data(), internedStrings.size() * sizeof(snapshot_interned_string_t));
+        writeSection(header.heapImageOffset, ctx.heap, heapUsed);
+
+        std::string tempPath = path + ".tmp";
+        FILE *snapshotFile = fopen(tempPath.c_str(), "wb");
+        if (snapshotFile == nullptr) {
+            Logger::error(LogCategory::Snapshot, "Cannot create snapshot %s!", path.c_str());
+            return false;
+        }
+
+        bool written = fwrite(data.data(), 1, data.size(), snapshotFile) == data.size();
+        fclose(snapshotFile);
+
+        if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+            Logger::error(LogCategory::Snapshot, "Cannot write snapshot %s!", path.c_str());
+            std::remove(tempPath.c_str());
+            return false;
+        }
+
+        Logger::info(LogCategory::Snapshot, "Captured snapshot with %llu bytes of heap, %u fixups and %u interned strings", heapUsed, header.numFixups, header.numInternedStrings);
+
+        return true;
+    }
+
+    bool Snapshot::restore(Context &ctx, const std::string &path) {
+        MappedFile file;
+        if (!file.open(path))
+            return false;
+
+        if (file.getSize() < sizeof(snapshot_header_t))
+            return false;
+
+        auto header = reinterpret_cast<const snapshot_header_t*>(file.getData());
+
+        if (std::memcmp(header->magic, "ILIS", 4) != 0 || header->version != Snapshot::Version
+            || std::memcmp(header->mvid, ctx.dll->getMvid(), sizeof(header->mvid)) != 0 || header->fileHash != ctx.dll->getFileHash()) {
+            Logger::info(LogCategory::Snapshot, "Snapshot %s doesn't match the loaded assembly", path.c_str());
+            return false;
+        }
+
+        if (header->heapUsed > ctx.heapSize || header->numStatics != ctx.statics.size()) {
+            Logger::info(LogCategory::Snapshot, "Snapshot %s is incompatible with the current configuration", path.c_str());
+            return false;
+        }
+
+        u64 fileSize = file.getSize();
+        bool valid = isSectionValid(header->heapReferencesOffset, header->numHeapReferences, sizeof(snapshot_heap_reference_t), fileSize)
+            && isSectionValid(header->staticsOffset, header->numStatics, sizeof(snapshot_static_t), fileSize)
+            && isSectionValid(header->fixupsOffset, header->numFixups, sizeof(snapshot_fixup_t), fileSize)
+            && isSectionValid(header->bindingsOffset, header->numBindings, sizeof(u32), fileSize)
+            && isSectionValid(header->internedStringsOffset, header->numInternedStrings, sizeof(snapshot_interned_string_t), fileSize)
+            && isSectionValid(header->heapImageOffset, alignUp(header->heapUsed, Snapshot::ImageAlignment), 1, fileSize);
+
+        auto heapReferences = reinterpret_cast<const snapshot_heap_reference_t*>(file.getData() + header->heapReferencesOffset);
+        auto statics = reinterpret_cast<const snapshot_static_t*>(file.getData() + header->staticsOffset);
+        auto fixups = reinterpret_cast<const snapshot_fixup_t*>(file.getData() + header->fixupsOffset);
+        auto bindings = reinterpret_cast<const u32*>(file.getData() + header->bindingsOffset);
+        auto internedStrings = reinterpret_cast<const snapshot_interned_string_t*>(file.getData() + header->internedStringsOffset);
+
+        // Allocations have to be in the order of their addresses and everything has to point into the heap image
+        for (u32 i = 0; valid && i < header->numHeapReferences; i++) {
+            u64 start = i == 0 ? 0 : heapReferences[i - 1].offset + heapReferences[i - 1].size;
+            valid = heapReferences[i].offset >= start && heapReferences[i].offset <= header->heapUsed && heapReferences[i].size <= header->heapUsed - heapReferences[i].offset;
+        }
+
+        for (u32 i = 0; valid && i < header->numFixups; i++) {
+            if (fixups[i].region == SnapshotRegion::Heap)
+                valid = fixups[i].offset <= header->heapUsed && header->heapUsed - fixups[i].offset >= sizeof(u64);
+            else
+                valid = fixups[i].region == SnapshotRegion::Statics && fixups[i].offset < header->numStatics;
+        }
+
+        for (u32 i = 0; valid && i < header->numInternedStrings; i++)
+            valid = internedStrings[i].offset <= header->heapUsed && header->heapUsed - internedStrings[i].offset >= sizeof(string_object_t);
+
+        if (!valid) {
+            Logger::info(LogCategory::Snapshot, "Snapshot %s is corrupted", path.c_str());
+            return false;
+        }
+
+        // Map the heap image copy-on-write over the start of the heap. Pages that are never written stay
+        // shared with every other process restoring the same snapshot
+        bool mapped = false;
+#if !defined(_WIN32)
+        u64 mapSize = alignUp(header->heapUsed, sysconf(_SC_PAGESIZE));
+        if (mapSize > 0 && reinterpret_cast<u64>(ctx.heap) % sysconf(_SC_PAGESIZE) == 0 && mapSize <= ctx.heapSize) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                mapped = ::mmap(ctx.heap, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, header->heapImageOffset) != MAP_FAILED;
+                ::close(fd);
+            }
+        }
+#endif
+        if (!mapped)
+            std::memcpy(ctx.heap, file.getData() + header->heapImageOffset, header->heapUsed);
+
+        ctx.heapReferences.clear();
+        for (u32 i = 0; i < header->numHeapReferences; i++)
+            ctx.heapReferences.push_back({ ctx.heap + heapReferences[i].offset, heapReferences[i].size, heapReferences[i].kind, heapReferences[i].typeToken, nullptr });
+
+        for (u32 i = 0; i < header->numStatics; i++)
+            ctx.statics[i] = { { statics[i].type }, statics[i].value };
+
+        // When the heap ended up at the same address again nothing needs to be touched and all pages stay shared
+        u64 delta = reinterpret_cast<u64>(ctx.heap) - header->heapBase;
+        if (delta != 0) {
+            for (u32 i = 0; i < header->numFixups; i++) {
+                if (fixups[i].region == SnapshotRegion::Heap) {
+                    u64 word;
+                    std::memcpy(&word, ctx.heap + fixups[i].offset, sizeof(u64));
+                    word += delta;
+                    std::memcpy(ctx.heap + fixups[i].offset, &word, sizeof(u64));
+                } else {
+                    ctx.statics[fixups[i].offset].value += delta;
+                }
+            }
+        }
+
+        for (u32 i = 0; i < header->numBindings; i++)
+            NativeMethods::resolveMethod(ctx, bindings[i]);
+
+        ctx.internedStrings.assign(ctx.dll->getUserStringHeapSize(), nullptr);
+        for (u32 i = 0; i < header->numInternedStrings; i++) {
+            if (internedStrings[i].userStringIndex < ctx.internedStrings.size())
+                ctx.internedStrings[internedStrings[i].userStringIndex] = reinterpret_cast<string_object_t*>(ctx.heap + internedStrings[i].offset);
+        }
+
+        Logger::info(LogCategory::Snapshot, "Restored snapshot with %llu bytes of heap%s", header->heapUsed, mapped ? " (mapped)" : "");
+
+        return true;
+    }
+
+}
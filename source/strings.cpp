@@ -0,0 +1,183 @@
+#include "strings.hpp"
+
+#include "context.hpp"
+#include "dll.hpp"
+#include "logger.hpp"
+#include "transcoder.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define ILI_STRINGS_SSE2
+    #include <immintrin.h>
+#endif
+
+namespace ili {
+
+    string_object_t* Strings::create(Context &ctx, std::u16string_view value) {
+        auto string = reinterpret_cast<string_object_t*>(ctx.allocate(sizeof(string_object_t) + (value.size() + 1) * sizeof(char16_t), AllocationKind::String));
+
+        string->length = value.size();
+        if (!value.empty())
+            std::memcpy(getData(string), value.data(), value.size() * sizeof(char16_t));
+
+        return string;
+    }
+
+    string_object_t* Strings::createFromUTF8(Context &ctx, std::string_view value) {
+        return create(ctx, Transcoder::toUTF16(value));
+    }
+
+    string_object_t* Strings::intern(Context &ctx, u32 userStringToken) {
+        u32 index = userStringToken & 0x00FF'FFFF;
+
+        if (ctx.internedStrings.empty())
+            ctx.internedStrings.resize(ctx.dll->getUserStringHeapSize(), nullptr);
+
+        if (index >= ctx.internedStrings.size())
+            ctx.fatalError(LogCategory::Interpreter, "Invalid user string token (0x%08x)!", userStringToken);
+
+        auto &internedString = ctx.internedStrings[index];
+        if (internedString == nullptr) {
+            // The #US blob ends with an extra byte flagging strings that contain special characters
+            auto userString = ctx.dll->getUserString(userStringToken);
+            u32 length = userString.empty() ? 0 : (userString.size() - 1) / sizeof(char16_t);
+
+            std::u16string value(length, u'\0');
+            if (length > 0)
+                std::memcpy(value.data(), userString.data(), length * sizeof(char16_t));
+
+            internedString = create(ctx, value);
+            getHash(internedString);
+        }
+
+        return internedString;
+    }
+
+    char16_t* Strings::getData(string_object_t *string) {
+        return reinterpret_cast<char16_t*>(reinterpret_cast<u8*>(string) + sizeof(string_object_t));
+    }
+
+    std::u16string_view Strings::getView(string_object_t *string) {
+        return { getData(string), string->length };
+    }
+
+    u32 Strings::getHash(string_object_t *string) {
+        if (string->hash != 0)
+            return string->hash;
+
+        // FNV-1a over the UTF-16 code units. 0 marks a hash that wasn't computed yet so it's never returned
+        u32 hash = 0x811C'9DC5;
+        for (char16_t character : getView(string)) {
+            hash ^= character;
+            hash *= 0x0100'0193;
+        }
+
+        if (hash == 0)
+            hash = 1;
+
+        string->hash = hash;
+
+        return hash;
+    }
+
+    std::string Strings::toUTF8(string_object_t *string) {
+        return Transcoder::toUTF8(getView(string));
+    }
+
+    bool Strings::equals(string_object_t *left, string_object_t *right) {
+        if (left == right)
+            return true;
+        if (left == nullptr || right == nullptr || left->length != right->length)
+            return false;
+
+        // Hashes that were computed already rule out most strings that differ without looking at them
+        if (left->hash != 0 && right->hash != 0 && left->hash != right->hash)
+            return false;
+
+        return std::memcmp(getData(left), getData(right), left->length * sizeof(char16_t)) == 0;
+    }
+
+    s32 Strings::indexOf(std::u16string_view string, char16_t character, u32 start) {
+        size_t index = start;
+
+    #if defined(ILI_STRINGS_SSE2)
+        // Eight code units at a time, the mask has two bits set for every one that matches
+        const __m128i needle = _mm_set1_epi16(static_cast<short>(character));
+        for (; index + 8 <= string.size(); index += 8) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(string.data() + index));
+            u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi16(block, needle));
+
+            if (mask != 0)
+                return s32(index + std::countr_zero(mask) / sizeof(char16_t));
+        }
+    #endif
+
+        for (; index < string.size(); index++) {
+            if (string[index] == character)
+                return s32(index);
+        }
+
+        return -1;
+    }
+
+    s32 Strings::indexOf(std::u16string_view string, std::u16string_view value, u32 start) {
+        if (value.empty())
+            return start <= string.size() ? s32(start) : -1;
+
+        // Find candidates by their first code unit and only compare the rest for those
+        u32 index = start;
+        while (index + value.size() <= string.size()) {
+            s32 candidate = indexOf(string.substr(0, string.size() - value.size() + 1), value[0], index);
+            if (candidate < 0)
+                return -1;
+
+            if (std::memcmp(string.data() + candidate + 1, value.data() + 1, (value.size() - 1) * sizeof(char16_t)) == 0)
+                return candidate;
+
+            index = candidate + 1;
+        }
+
+        return -1;
+    }
+
+    string_buffer_t* Strings::createBuffer(Context &ctx, u32 capacity) {
+        auto buffer = reinterpret_cast<string_buffer_t*>(ctx.allocate(sizeof(string_buffer_t) + capacity * sizeof(char16_t)));
+        buffer->capacity = capacity;
+
+        return buffer;
+    }
+
+    char16_t* Strings::getData(string_buffer_t *buffer) {
+        return reinterpret_cast<char16_t*>(reinterpret_cast<u8*>(buffer) + sizeof(string_buffer_t));
+    }
+
+    std::u16string_view Strings::getView(string_buffer_t *buffer) {
+        return { getData(buffer), buffer->length };
+    }
+
+    void Strings::append(Context &ctx, string_buffer_t *&buffer, std::u16string_view value) {
+        u64 length = u64(buffer->length) + value.size();
+
+        if (length > buffer->capacity) {
+            // Nothing ever gets freed, so growing geometrically only pays off while the buffer can't grow in place
+            u32 capacity = u32(std::max<u64>(length, u64(buffer->capacity) * 2));
+
+            if (ctx.extend(reinterpret_cast<u8*>(buffer), sizeof(string_buffer_t) + length * sizeof(char16_t))) {
+                buffer->capacity = u32(length);
+            } else {
+                auto newBuffer = createBuffer(ctx, capacity);
+                newBuffer->length = buffer->length;
+                std::memcpy(getData(newBuffer), getData(buffer), buffer->length * sizeof(char16_t));
+
+                buffer = newBuffer;
+            }
+        }
+
+        std::memcpy(getData(buffer) + buffer->length, value.data(), value.size() * sizeof(char16_t));
+        buffer->length = u32(length);
+    }
+
+}
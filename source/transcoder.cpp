@@ -0,0 +1,383 @@
+#include "transcoder.hpp"
+
+#include <atomic>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define ILI_TRANSCODER_X86
+    #include <immintrin.h>
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define ILI_TARGET_AVX2
+    #else
+        #define ILI_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace ili {
+
+    static constexpr char16_t ReplacementCharacter = 0xFFFD;
+
+    // Scalar code point steps, shared by all kernels for everything that isn't plain ASCII
+
+    static inline void encodeUTF8(const char16_t *source, size_t length, size_t &in, char *destination, size_t &out) {
+        u32 codePoint = source[in++];
+
+        if (codePoint < 0x80) {
+            destination[out++] = static_cast<char>(codePoint);
+            return;
+        }
+
+        if (codePoint < 0x800) {
+            destination[out++] = static_cast<char>(0xC0 | (codePoint >> 6));
+            destination[out++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+            return;
+        }
+
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF && in < length && source[in] >= 0xDC00 && source[in] <= 0xDFFF) {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (source[in++] - 0xDC00);
+
+            destination[out++] = static_cast<char>(0xF0 | (codePoint >> 18));
+            destination[out++] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            destination[out++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            destination[out++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+            return;
+        }
+
+        if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+            codePoint = ReplacementCharacter;
+
+        destination[out++] = static_cast<char>(0xE0 | (codePoint >> 12));
+        destination[out++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        destination[out++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+
+    static inline bool isContinuation(const u8 *source, size_t length, size_t index) {
+        return index < length && (source[index] & 0xC0) == 0x80;
+    }
+
+    static inline void decodeUTF8(const u8 *source, size_t length, size_t &in, char16_t *destination, size_t &out) {
+        u8 lead = source[in];
+
+        if (lead < 0x80) {
+            destination[out++] = lead;
+            in++;
+            return;
+        }
+
+        if (lead >= 0xC2 && lead <= 0xDF && isContinuation(source, length, in + 1)) {
+            destination[out++] = ((lead & 0x1F) << 6) | (source[in + 1] & 0x3F);
+            in += 2;
+            return;
+        }
+
+        if ((lead & 0xF0) == 0xE0 && isContinuation(source, length, in + 1) && isContinuation(source, length, in + 2)) {
+            u32 codePoint = ((lead & 0x0F) << 12) | ((source[in + 1] & 0x3F) << 6) | (source[in + 2] & 0x3F);
+
+            // Overlong encodings and encoded surrogates are invalid
+            if (codePoint >= 0x800 && (codePoint < 0xD800 || codePoint > 0xDFFF)) {
+                destination[out++] = codePoint;
+                in += 3;
+                return;
+            }
+        }
+
+        if (lead >= 0xF0 && lead <= 0xF4 && isContinuation(source, length, in + 1) && isContinuation(source, length, in + 2) && isContinuation(source, length, in + 3)) {
+            u32 codePoint = ((lead & 0x07) << 18) | ((source[in + 1] & 0x3F) << 12) | ((source[in + 2] & 0x3F) << 6) | (source[in + 3] & 0x3F);
+
+            if (codePoint >= 0x10000 && codePoint <= 0x10FFFF) {
+                codePoint -= 0x10000;
+                destination[out++] = 0xD800 | (codePoint >> 10);
+                destination[out++] = 0xDC00 | (codePoint & 0x3FF);
+                in += 4;
+                return;
+            }
+        }
+
+        destination[out++] = ReplacementCharacter;
+        in++;
+    }
+
+    // Scalar kernels
+
+    static size_t utf16ToUTF8Scalar(const char16_t *source, size_t length, char *destination) {
+        size_t in = 0, out = 0;
+
+        while (in < length)
+            encodeUTF8(source, length, in, destination, out);
+
+        return out;
+    }
+
+    static size_t utf8ToUTF16Scalar(const char *source, size_t length, char16_t *destination) {
+        auto bytes = reinterpret_cast<const u8*>(source);
+        size_t in = 0, out = 0;
+
+        while (in < length)
+            decodeUTF8(bytes, length, in, destination, out);
+
+        return out;
+    }
+
+#if defined(ILI_TRANSCODER_X86)
+
+    // Runs of non-ASCII characters are handled by the scalar steps, the vector loops pick up again right after them
+    static inline void encodeNonASCIIRun(const char16_t *source, size_t length, size_t &in, char *destination, size_t &out) {
+        do {
+            encodeUTF8(source, length, in, destination, out);
+        } while (in < length && source[in] >= 0x80);
+    }
+
+    static inline void decodeNonASCIIRun(const u8 *source, size_t length, size_t &in, char16_t *destination, size_t &out) {
+        do {
+            decodeUTF8(source, length, in, destination, out);
+        } while (in < length && source[in] >= 0x80);
+    }
+
+    // SSE2 kernels. Each block of 16 characters is converted as if it was pure ASCII. If it wasn't, only the ASCII
+    // prefix is kept and the scalar steps take over from the first other character. The destination sizes required
+    // by Transcoder always leave room for the full block store
+
+    static size_t utf16ToUTF8SSE2(const char16_t *source, size_t length, char *destination) {
+        const __m128i nonASCIIMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+        const __m128i zero = _mm_setzero_si128();
+        size_t in = 0, out = 0;
+
+        while (in + 16 <= length) {
+            __m128i low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + in));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + in + 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + out), _mm_packus_epi16(low, high));
+
+            __m128i isASCIILow  = _mm_cmpeq_epi16(_mm_and_si128(low, nonASCIIMask), zero);
+            __m128i isASCIIHigh = _mm_cmpeq_epi16(_mm_and_si128(high, nonASCIIMask), zero);
+            u32 asciiMask = _mm_movemask_epi8(_mm_packs_epi16(isASCIILow, isASCIIHigh));
+
+            if (asciiMask == 0xFFFF) {
+                in += 16;
+                out += 16;
+            } else {
+                u32 prefix = std::countr_one(asciiMask);
+                in += prefix;
+                out += prefix;
+                encodeNonASCIIRun(source, length, in, destination, out);
+            }
+        }
+
+        while (in < length)
+            encodeUTF8(source, length, in, destination, out);
+
+        return out;
+    }
+
+    static size_t utf8ToUTF16SSE2(const char *source, size_t length, char16_t *destination) {
+        auto bytes = reinterpret_cast<const u8*>(source);
+        const __m128i zero = _mm_setzero_si128();
+        size_t in = 0, out = 0;
+
+        while (in + 16 <= length) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + in));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + out), _mm_unpacklo_epi8(block, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + out + 8), _mm_unpackhi_epi8(block, zero));
+
+            u32 nonASCIIMask = _mm_movemask_epi8(block);
+
+            if (nonASCIIMask == 0) {
+                in += 16;
+                out += 16;
+            } else {
+                u32 prefix = std::countr_zero(nonASCIIMask);
+                in += prefix;
+                out += prefix;
+                decodeNonASCIIRun(bytes, length, in, destination, out);
+            }
+        }
+
+        while (in < length)
+            decodeUTF8(bytes, length, in, destination, out);
+
+        return out;
+    }
+
+    // AVX2 kernels, same approach with 32 characters per block
+
+    ILI_TARGET_AVX2 static size_t utf16ToUTF8AVX2(const char16_t *source, size_t length, char *destination) {
+        const __m256i nonASCIIMask = _mm256_set1_epi16(static_cast<short>(0xFF80));
+        const __m256i zero = _mm256_setzero_si256();
+        size_t in = 0, out = 0;
+
+        while (in + 32 <= length) {
+            __m256i low  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + in));
+            __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + in + 16));
+
+            // Packing works within each 128 bit lane, so the middle quadwords need to be swapped afterwards
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0b11'01'10'00);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + out), packed);
+
+            __m256i isASCIILow  = _mm256_cmpeq_epi16(_mm256_and_si256(low, nonASCIIMask), zero);
+            __m256i isASCIIHigh = _mm256_cmpeq_epi16(_mm256_and_si256(high, nonASCIIMask), zero);
+            u32 asciiMask = _mm256_movemask_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16(isASCIILow, isASCIIHigh), 0b11'01'10'00));
+
+            if (asciiMask == 0xFFFF'FFFF) {
+                in += 32;
+                out += 32;
+            } else {
+                u32 prefix = std::countr_one(asciiMask);
+                in += prefix;
+                out += prefix;
+                encodeNonASCIIRun(source, length, in, destination, out);
+            }
+        }
+
+        return out + utf16ToUTF8SSE2(source + in, length - in, destination + out);
+    }
+
+    ILI_TARGET_AVX2 static size_t utf8ToUTF16AVX2(const char *source, size_t length, char16_t *destination) {
+        auto bytes = reinterpret_cast<const u8*>(source);
+        size_t in = 0, out = 0;
+
+        while (in + 32 <= length) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + in));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + out), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(block)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + out + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(block, 1)));
+
+            u32 nonASCIIMask = _mm256_movemask_epi8(block);
+
+            if (nonASCIIMask == 0) {
+                in += 32;
+                out += 32;
+            } else {
+                u32 prefix = std::countr_zero(nonASCIIMask);
+                in += prefix;
+                out += prefix;
+                decodeNonASCIIRun(bytes, length, in, destination, out);
+            }
+        }
+
+        return out + utf8ToUTF16SSE2(source + in, length - in, destination + out);
+    }
+
+    static bool isAVX2Supported() {
+    #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // The OS also has to save the upper halves of the YMM registers
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x06) != 0x06)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    #else
+        return __builtin_cpu_supports("avx2");
+    #endif
+    }
+
+#endif
+
+    // Dispatch
+
+    struct TranscodeKernels {
+        TranscodeKernel kernel;
+        size_t (*utf16ToUTF8)(const char16_t*, size_t, char*);
+        size_t (*utf8ToUTF16)(const char*, size_t, char16_t*);
+    };
+
+    static TranscodeKernels getKernels(TranscodeKernel kernel) {
+        switch (kernel) {
+        #if defined(ILI_TRANSCODER_X86)
+            case TranscodeKernel::AVX2:
+                return { TranscodeKernel::AVX2, utf16ToUTF8AVX2, utf8ToUTF16AVX2 };
+            case TranscodeKernel::SSE2:
+                return { TranscodeKernel::SSE2, utf16ToUTF8SSE2, utf8ToUTF16SSE2 };
+        #endif
+            default:
+                return { TranscodeKernel::Scalar, utf16ToUTF8Scalar, utf8ToUTF16Scalar };
+        }
+    }
+
+    static bool isKernelSupported(TranscodeKernel kernel) {
+        switch (kernel) {
+        #if defined(ILI_TRANSCODER_X86)
+            case TranscodeKernel::AVX2:
+                return isAVX2Supported();
+            case TranscodeKernel::SSE2:
+                return true;    // Part of the x86-64 baseline
+        #endif
+            case TranscodeKernel::Scalar:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static std::atomic<const TranscodeKernels*> s_activeKernels = nullptr;
+
+    static const TranscodeKernels* getActiveKernels() {
+        auto kernels = s_activeKernels.load(std::memory_order_acquire);
+
+        if (kernels == nullptr) {
+            static const TranscodeKernels bestKernels = getKernels(isKernelSupported(TranscodeKernel::AVX2) ? TranscodeKernel::AVX2 :
+                                                                   isKernelSupported(TranscodeKernel::SSE2) ? TranscodeKernel::SSE2 : TranscodeKernel::Scalar);
+            kernels = &bestKernels;
+            s_activeKernels.store(kernels, std::memory_order_release);
+        }
+
+        return kernels;
+    }
+
+    size_t Transcoder::utf16ToUTF8(const char16_t *source, size_t length, char *destination) {
+        return getActiveKernels()->utf16ToUTF8(source, length, destination);
+    }
+
+    size_t Transcoder::utf8ToUTF16(const char *source, size_t length, char16_t *destination) {
+        return getActiveKernels()->utf8ToUTF16(source, length, destination);
+    }
+
+    std::string Transcoder::toUTF8(std::u16string_view string) {
+        std::string result(getMaxUTF8Size(string.size()), '\0');
+        result.resize(utf16ToUTF8(string.data(), string.size(), result.data()));
+
+        return result;
+    }
+
+    std::u16string Transcoder::toUTF16(std::string_view string) {
+        std::u16string result(getMaxUTF16Size(string.size()), u'\0');
+        result.resize(utf8ToUTF16(string.data(), string.size(), result.data()));
+
+        return result;
+    }
+
+    TranscodeKernel Transcoder::getKernel() {
+        return getActiveKernels()->kernel;
+    }
+
+    bool Transcoder::forceKernel(TranscodeKernel kernel) {
+        if (!isKernelSupported(kernel))
+            return false;
+
+        static const TranscodeKernels forcedKernels[] = {
+            getKernels(TranscodeKernel::Scalar),
+            getKernels(TranscodeKernel::SSE2),
+            getKernels(TranscodeKernel::AVX2)
+        };
+
+        s_activeKernels.store(&forcedKernels[static_cast<u8>(kernel)], std::memory_order_release);
+
+        return true;
+    }
+
+    const char* Transcoder::getKernelName(TranscodeKernel kernel) {
+        switch (kernel) {
+            case TranscodeKernel::Scalar:   return "scalar";
+            case TranscodeKernel::SSE2:     return "sse2";
+            case TranscodeKernel::AVX2:     return "avx2";
+            default:                        return "unknown";
+        }
+    }
+
+}
@@ -0,0 +1,114 @@
+#include "value_types.hpp"
+
+#include "context.hpp"
+#include "vectors.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+namespace ili {
+
+    template<u32 Size>
+    static void copyFixedSize(void *destination, const void *source, u32) {
+        std::memcpy(destination, source, Size);
+    }
+
+    static void copyAnySize(void *destination, const void *source, u32 size) {
+        std::memcpy(destination, source, size);
+    }
+
+    template<u32... Sizes>
+    static constexpr std::array<CopyHandler, sizeof...(Sizes)> makeCopyHandlers(std::integer_sequence<u32, Sizes...>) {
+        return { &copyFixedSize<Sizes>... };
+    }
+
+    static constexpr auto CopyHandlers = makeCopyHandlers(std::make_integer_sequence<u32, ValueTypes::MaxSpecializedSize + 1>());
+
+    CopyHandler ValueTypes::getCopyHandler(u32 size) {
+        return size < CopyHandlers.size() ? CopyHandlers[size] : &copyAnySize;
+    }
+
+    // Fields of packed structs and elements of byte buffers don't have to be aligned
+    template<typename T>
+    static T readValue(const u8 *address) {
+        T value;
+        std::memcpy(&value, address, sizeof(T));
+
+        return value;
+    }
+
+    void ValueTypes::load(Context &ctx, const ValueLayout &layout, const u8 *address) {
+        switch (layout.elementType) {
+            case SignatureElementType::I1:
+                ctx.push<s32>(Type::Int32, readValue<s8>(address));
+                break;
+            case SignatureElementType::Boolean:
+            case SignatureElementType::U1:
+                ctx.push<s32>(Type::Int32, readValue<u8>(address));
+                break;
+            case SignatureElementType::I2:
+                ctx.push<s32>(Type::Int32, readValue<s16>(address));
+                break;
+            case SignatureElementType::Char:
+            case SignatureElementType::U2:
+                ctx.push<s32>(Type::Int32, readValue<u16>(address));
+                break;
+            case SignatureElementType::I4:
+            case SignatureElementType::U4:
+                ctx.push<s32>(Type::Int32, readValue<s32>(address));
+                break;
+            case SignatureElementType::R4:
+                ctx.push<double>(Type::F, readValue<float>(address));
+                break;
+            case SignatureElementType::R8:
+                ctx.push<double>(Type::F, readValue<double>(address));
+                break;
+            case SignatureElementType::ValueType:
+                if (layout.type == Type::Vector)
+                    ctx.push<VectorValue>(Type::Vector, readValue<VectorValue>(address));
+                else
+                    layout.valueType->copy(ctx.pushValueType(layout.size), address, layout.size);
+                break;
+            default:
+                ctx.push<u64>(layout.type, readValue<u64>(address));
+                break;
+        }
+    }
+
+    void ValueTypes::store(Context &ctx, const ValueLayout &layout, u8 *address) {
+        Type type = ctx.getTypeOnStack();
+
+        if (layout.elementType == SignatureElementType::ValueType) {
+            if (layout.type == Type::Vector && type == Type::Vector) {
+                auto value = ctx.pop<VectorValue>();
+                std::memcpy(address, &value, sizeof(value));
+                return;
+            }
+
+            u32 size;
+            const u8 *value = ctx.popValueType(size);
+            if (size != layout.size)
+                ctx.fatalError(LogCategory::Interpreter, "Stored a %u byte struct into %u bytes!", size, layout.size);
+
+            layout.valueType->copy(address, value, size);
+            return;
+        }
+
+        u64 value;
+        if (getTypeSize(type) == sizeof(u32))
+            value = static_cast<u64>(static_cast<s64>(ctx.pop<s32>()));
+        else
+            value = ctx.pop<u64>();
+
+        // Little endian, the low bytes of the value are what narrower integers keep
+        if (layout.elementType == SignatureElementType::R4) {
+            float single = float(std::bit_cast<double>(value));
+            std::memcpy(address, &single, sizeof(single));
+        } else {
+            std::memcpy(address, &value, layout.size);
+        }
+    }
+
+}